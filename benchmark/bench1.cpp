@@ -26,6 +26,7 @@ along with this program.  If not, see <https://www.gnu.org/licenses/>.
 #include "devices/memctrl/mpc106.h"
 #include <thirdparty/loguru/loguru.hpp>
 #include <debugger/debugger.h>
+#include <utils/profiler.h>
 
 #if defined(PPC_BENCHMARKS)
 void ppc_exception_handler(Except_Type exception_type, uint32_t srr1_bits) {
@@ -61,6 +62,9 @@ int main(int argc, char** argv) {
     loguru::g_stderr_verbosity = 0;
     loguru::init(argc, argv);
 
+    // the CPU registers its profiles there
+    gProfilerObj.reset(new Profiler());
+
     MPC106* grackle_obj = new MPC106;
 
     /* we need some RAM */
@@ -0,0 +1,678 @@
+/*
+DingusPPC - The Experimental PowerPC Macintosh emulator
+Copyright (C) 2018-25 divingkatae and maximum
+                      (theweirdo)     spatium
+
+(Contact divingkatae#1017 or powermax#2286 on Discord for more info)
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+/** @file CPU benchmark suite.
+
+    Runs a set of small guest kernels on the interpreter, each stressing
+    a different part of it, and reports the number of executed guest
+    instructions per second. The results can be saved as JSON and
+    compared against a previous run to catch performance regressions
+    and changes in the computed results.
+
+    Unlike bench1 this is linked against the regular CPU objects so
+    exceptions are delivered to guest handlers.
+ */
+
+#include "cpu/ppc/ppcemu.h"
+#include "cpu/ppc/ppcmmu.h"
+#include "devices/memctrl/mpc106.h"
+#include <thirdparty/loguru/loguru.hpp>
+#include <utils/profiler.h>
+#include <CLI11.hpp>
+
+#include <chrono>
+#include <cinttypes>
+#include <cstdio>
+#include <fstream>
+#include <map>
+#include <string>
+#include <vector>
+
+// guest memory layout
+constexpr uint32_t STOP_ADDR = 0x3000;   // execution stops here
+constexpr uint32_t CODE_ADDR = 0x4000;
+constexpr uint32_t SRC_ADDR  = 0x10000;  // kernel input data
+constexpr uint32_t DST_ADDR  = 0x30000;  // kernel output data
+constexpr uint32_t BUF_SIZE  = 0x20000;
+constexpr uint32_t HTAB_ADDR = 0x100000; // 64 KB hashed page table
+constexpr uint32_t RAM_SIZE  = 0x200000;
+constexpr uint32_t BAD_EA    = 0x800000; // not covered by the page table
+
+/** Minimal assembler for the benchmark kernels. */
+class PPCAsm {
+public:
+    PPCAsm(uint32_t org) { this->org = org; };
+
+    uint32_t here() { return this->org + (uint32_t)this->code.size() * 4; };
+
+    void emit(uint32_t insn) { this->code.push_back(insn); };
+
+    void set_org(uint32_t addr) {
+        this->org = addr;
+        this->code.clear();
+    };
+
+    void commit() {
+        for (size_t i = 0; i < this->code.size(); i++)
+            mmu_write_vmem<uint32_t>(0, this->org + (uint32_t)i * 4, this->code[i]);
+    };
+
+    // D-form
+    void d(int op, int rt, int ra, int16_t imm) {
+        emit((op << 26) | (rt << 21) | (ra << 16) | (uint16_t)imm);
+    };
+    void addi(int rt, int ra, int16_t si)   { d(14, rt, ra, si); };
+    void addis(int rt, int ra, int16_t si)  { d(15, rt, ra, si); };
+    void ori(int ra, int rs, uint16_t ui)   { d(24, rs, ra, ui); };
+    void xori(int ra, int rs, uint16_t ui)  { d(26, rs, ra, ui); };
+    void andi_(int ra, int rs, uint16_t ui) { d(28, rs, ra, ui); };
+    void cmpwi(int crf, int ra, int16_t si) { d(11, crf << 2, ra, si); };
+    void lwz(int rt, int16_t ofs, int ra)   { d(32, rt, ra, ofs); };
+    void lbz(int rt, int16_t ofs, int ra)   { d(34, rt, ra, ofs); };
+    void stw(int rs, int16_t ofs, int ra)   { d(36, rs, ra, ofs); };
+    void stb(int rs, int16_t ofs, int ra)   { d(38, rs, ra, ofs); };
+    void lhz(int rt, int16_t ofs, int ra)   { d(40, rt, ra, ofs); };
+    void sth(int rs, int16_t ofs, int ra)   { d(44, rs, ra, ofs); };
+    void lmw(int rt, int16_t ofs, int ra)   { d(46, rt, ra, ofs); };
+    void stmw(int rs, int16_t ofs, int ra)  { d(47, rs, ra, ofs); };
+
+    void lis_ori(int rt, uint32_t val) {
+        addis(rt, 0, (int16_t)(val >> 16));
+        ori(rt, rt, val & 0xFFFF);
+    };
+
+    // X/XO-form, register operands in assembly order
+    void x(int rt, int ra, int rb, int xo) {
+        emit((31 << 26) | (rt << 21) | (ra << 16) | (rb << 11) | (xo << 1));
+    };
+    void add(int rt, int ra, int rb)    { x(rt, ra, rb, 266); };
+    void subf(int rt, int ra, int rb)   { x(rt, ra, rb, 40); };
+    void mullw(int rt, int ra, int rb)  { x(rt, ra, rb, 235); };
+    void divwu(int rt, int ra, int rb)  { x(rt, ra, rb, 459); };
+    void and_(int ra, int rs, int rb)   { x(rs, ra, rb, 28); };
+    void or_(int ra, int rs, int rb)    { x(rs, ra, rb, 444); };
+    void xor_(int ra, int rs, int rb)   { x(rs, ra, rb, 316); };
+    void nor(int ra, int rs, int rb)    { x(rs, ra, rb, 124); };
+    void slw(int ra, int rs, int rb)    { x(rs, ra, rb, 24); };
+    void srw(int ra, int rs, int rb)    { x(rs, ra, rb, 536); };
+    void cntlzw(int ra, int rs)         { x(rs, ra, 0, 26); };
+    void srawi(int ra, int rs, int sh)  { x(rs, ra, sh, 824); };
+    void cmpw(int crf, int ra, int rb)  { x(crf << 2, ra, rb, 0); };
+    void lswi(int rt, int ra, int nb)   { x(rt, ra, nb, 597); };
+    void stswi(int rs, int ra, int nb)  { x(rs, ra, nb, 725); };
+    void mfmsr(int rt)                  { x(rt, 0, 0, 83); };
+    void mtmsr(int rs)                  { x(rs, 0, 0, 146); };
+    void mfspr(int rt, int spr)         { x(rt, spr & 0x1F, spr >> 5, 339); };
+    void mtspr(int spr, int rs)         { x(rs, spr & 0x1F, spr >> 5, 467); };
+
+    void rlwinm(int ra, int rs, int sh, int mb, int me) {
+        emit((21 << 26) | (rs << 21) | (ra << 16) | (sh << 11) | (mb << 6) | (me << 1));
+    };
+
+    // A-form floating-point
+    void fa(int xo, int frt, int fra, int frb, int frc) {
+        emit((63 << 26) | (frt << 21) | (fra << 16) | (frb << 11) | (frc << 6) | (xo << 1));
+    };
+    void fadd(int frt, int fra, int frb)    { fa(21, frt, fra, frb, 0); };
+    void fsub(int frt, int fra, int frb)    { fa(20, frt, fra, frb, 0); };
+    void fdiv(int frt, int fra, int frb)    { fa(18, frt, fra, frb, 0); };
+    void fmul(int frt, int fra, int frc)    { fa(25, frt, fra, 0, frc); };
+    void fmadd(int frt, int fra, int frc, int frb) { fa(29, frt, fra, frb, frc); };
+    void fctiwz(int frt, int frb)           { emit((63 << 26) | (frt << 21) | (frb << 11) | (15 << 1)); };
+    void stfd(int frs, int16_t ofs, int ra) { d(54, frs, ra, ofs); };
+
+    // branches, targets are absolute guest addresses
+    void bc(int bo, int bi, uint32_t target) {
+        emit((16 << 26) | (bo << 21) | (bi << 16) | ((target - here()) & 0xFFFC));
+    };
+    void bdnz(uint32_t target)  { bc(16, 0, target); };
+    void ba(uint32_t target)    { emit((18 << 26) | (target & 0x03FFFFFC) | 2); };
+    void blr()                  { emit(0x4E800020); };
+    void rfi()                  { emit(0x4C000064); };
+    void sc()                   { emit(0x44000002); };
+
+    // forward branches, resolved by fixup()
+    uint32_t b_fwd(bool lk = false) {
+        uint32_t pos = here();
+        emit((18 << 26) | lk);
+        return pos;
+    };
+    uint32_t bc_fwd(int bo, int bi) {
+        uint32_t pos = here();
+        emit((16 << 26) | (bo << 21) | (bi << 16));
+        return pos;
+    };
+    void fixup(uint32_t pos) {
+        uint32_t& insn = this->code[(pos - this->org) >> 2];
+        insn |= (here() - pos) & ((insn >> 26) == 18 ? 0x03FFFFFC : 0xFFFC);
+    };
+
+private:
+    uint32_t                org;
+    std::vector<uint32_t>   code;
+};
+
+// BO/BI values for conditional branches on CR0
+enum { BO_TRUE = 12, BO_FALSE = 4, CR0_LT = 0, CR0_GT = 1, CR0_EQ = 2 };
+
+//================================ Machine state ==============================
+static void set_msr(uint32_t new_msr) {
+    ppc_msr_did_change(ppc_state.msr, new_msr, false);
+    mmu_change_mode();
+}
+
+static void set_dbat0(uint32_t upper, uint32_t lower) {
+    ppc_state.spr[537] = lower;
+    dbat_update(537);
+    ppc_state.spr[536] = upper;
+    dbat_update(536);
+}
+
+static void add_pte(uint32_t ea, uint32_t pa) {
+    uint32_t vsid = ppc_state.sr[ea >> 28] & 0x00FFFFFF;
+    uint32_t hash = (vsid & 0x7FFFF) ^ ((ea >> 12) & 0xFFFF);
+    uint32_t pteg = HTAB_ADDR | ((hash & 0x3FF) << 6);
+
+    for (uint32_t pte = pteg; pte < pteg + 64; pte += 8) {
+        if (!(mmu_read_vmem<uint32_t>(0, pte) & 0x80000000U)) {
+            mmu_write_vmem<uint32_t>(0, pte + 4, (pa & 0xFFFFF000U) | 2);  // PP = RW
+            mmu_write_vmem<uint32_t>(0, pte, 0x80000000U | (vsid << 7) | ((ea >> 22) & 0x3F));
+            return;
+        }
+    }
+
+    ABORT_F("PTEG for EA 0x%08X is full", ea);
+}
+
+// Identity-maps both data buffers through the page table. Translation must be off.
+static void setup_page_table() {
+    for (uint32_t addr = HTAB_ADDR; addr < HTAB_ADDR + 0x10000; addr += 4)
+        mmu_write_vmem<uint32_t>(0, addr, 0);
+
+    for (int sr = 0; sr < 16; sr++)
+        ppc_state.sr[sr] = sr;
+    ppc_state.spr[SPR::SDR1] = HTAB_ADDR; // HTABMASK = 0
+    mmu_pat_ctx_changed();
+
+    for (uint32_t addr = SRC_ADDR; addr < DST_ADDR + BUF_SIZE; addr += PPC_PAGE_SIZE)
+        add_pte(addr, addr);
+}
+
+static void fill_source_data() {
+    uint32_t val = 0xCAFEBABE;
+    for (uint32_t addr = SRC_ADDR; addr < SRC_ADDR + BUF_SIZE; addr += 4) {
+        val = val * 1664525 + 1013904223;
+        mmu_write_vmem<uint32_t>(0, addr, val);
+    }
+}
+
+static void install_vectors() {
+    PPCAsm a(0);
+
+    // unexpected exceptions end the run, the kernel result will be wrong
+    for (uint32_t vec = 0x100; vec < STOP_ADDR; vec += 0x100) {
+        a.set_org(vec);
+        a.ba(STOP_ADDR);
+        a.commit();
+    }
+
+    // DSI: skip the faulting instruction
+    a.set_org(0x300);
+    a.mfspr(29, SPR::SRR0);
+    a.addi(29, 29, 4);
+    a.mtspr(SPR::SRR0, 29);
+    a.addi(3, 3, 1);
+    a.rfi();
+    a.commit();
+
+    // FPU unavailable: enable FP in the interrupted context
+    a.set_org(0x800);
+    a.mfspr(29, SPR::SRR1);
+    a.ori(29, 29, MSR::FP);
+    a.mtspr(SPR::SRR1, 29);
+    a.addi(3, 3, 1);
+    a.rfi();
+    a.commit();
+
+    // system call
+    a.set_org(0xC00);
+    a.addi(3, 3, 1);
+    a.rfi();
+    a.commit();
+}
+
+//================================ Kernels ====================================
+typedef struct {
+    const char* name;
+    const char* desc;
+    void (*gen)(PPCAsm& a);     // kernel code ending with a jump to STOP_ADDR
+    void (*prepare)();          // per-run setup of registers and MMU state
+} BenchKernel;
+
+static void gen_int_alu(PPCAsm& a) {
+    uint32_t loop = a.here();
+    a.add(3, 3, 4);
+    a.rlwinm(5, 4, 13, 0, 31);
+    a.xor_(4, 4, 5);
+    a.mullw(6, 3, 4);
+    a.srawi(7, 6, 3);
+    a.subf(3, 7, 3);
+    a.ori(9, 4, 1);
+    a.divwu(8, 3, 9);
+    a.and_(10, 8, 4);
+    a.or_(11, 10, 6);
+    a.nor(12, 11, 3);
+    a.cntlzw(13, 12);
+    a.slw(14, 4, 13);
+    a.srw(15, 12, 13);
+    a.add(3, 3, 14);
+    a.xor_(3, 3, 15);
+    a.addi(4, 4, 0x2345);
+    a.bdnz(loop);
+    a.ba(STOP_ADDR);
+}
+
+static void gen_branchy(PPCAsm& a) {
+    a.lis_ori(10, 1664525);
+    a.lis_ori(11, 1013904223);
+
+    uint32_t loop = a.here();
+    a.mullw(4, 4, 10);
+    a.add(4, 4, 11);
+
+    a.andi_(5, 4, 0x100);
+    uint32_t skip1 = a.bc_fwd(BO_TRUE, CR0_EQ);
+    a.addi(3, 3, 1);
+    a.fixup(skip1);
+
+    a.andi_(5, 4, 0x2000);
+    uint32_t skip2 = a.bc_fwd(BO_FALSE, CR0_EQ);
+    uint32_t call = a.b_fwd(true);
+    a.fixup(skip2);
+
+    a.cmpw(0, 4, 3);
+    uint32_t skip3 = a.bc_fwd(BO_TRUE, CR0_LT);
+    a.xori(3, 3, 0x55);
+    a.fixup(skip3);
+
+    a.rlwinm(5, 4, 8, 24, 31);
+    a.cmpwi(0, 5, 0x80);
+    uint32_t skip4 = a.bc_fwd(BO_TRUE, CR0_GT);
+    a.addi(3, 3, 7);
+    a.fixup(skip4);
+
+    a.bdnz(loop);
+    a.ba(STOP_ADDR);
+
+    a.fixup(call);
+    a.addi(3, 3, 3);
+    a.blr();
+}
+
+static void gen_fp_arith(PPCAsm& a) {
+    uint32_t loop = a.here();
+    a.fmadd(0, 0, 2, 1);        // f0 = f0 * 0.5 + 1.0
+    a.fmul(4, 0, 3);
+    a.fsub(5, 4, 1);
+    a.fdiv(6, 5, 0);
+    a.fadd(7, 7, 6);
+    a.fadd(7, 7, 0);
+    a.bdnz(loop);
+
+    a.fctiwz(8, 7);
+    a.stfd(8, 0, 21);
+    a.lwz(3, 4, 21);
+    a.ba(STOP_ADDR);
+}
+
+static void gen_load_store(PPCAsm& a) {
+    uint32_t loop = a.here();
+    a.add(27, 20, 25);
+    a.lwz(5, 0, 27);
+    a.lwz(6, 4, 27);
+    a.lhz(7, 8, 27);
+    a.lbz(8, 12, 27);
+    a.add(3, 3, 5);
+    a.xor_(3, 3, 6);
+    a.add(3, 3, 7);
+    a.add(3, 3, 8);
+    a.add(28, 21, 25);
+    a.stw(3, 0, 28);
+    a.stw(5, 4, 28);
+    a.sth(6, 8, 28);
+    a.stb(7, 12, 28);
+    a.addi(25, 25, 16);
+    a.rlwinm(25, 25, 0, 15, 27); // wrap around at BUF_SIZE
+    a.bdnz(loop);
+    a.ba(STOP_ADDR);
+}
+
+static void gen_string_multiple(PPCAsm& a) {
+    // lmw/stmw transfer r24..r31, pointers and offset must stay below
+    uint32_t loop = a.here();
+    a.add(16, 20, 15);
+    a.add(17, 21, 15);
+    a.lmw(24, 0, 16);
+    a.stmw(24, 0, 17);
+    a.addi(16, 16, 32);
+    a.addi(17, 17, 32);
+    a.lswi(5, 16, 19);
+    a.stswi(5, 17, 19);
+    a.add(3, 3, 31);
+    a.xor_(3, 3, 9);
+    a.addi(15, 15, 64);
+    a.rlwinm(15, 15, 0, 15, 25); // wrap around at BUF_SIZE
+    a.bdnz(loop);
+    a.ba(STOP_ADDR);
+}
+
+static void gen_syscall(PPCAsm& a) {
+    uint32_t loop = a.here();
+    a.sc();
+    a.add(4, 4, 3);
+    a.bdnz(loop);
+    a.ba(STOP_ADDR);
+}
+
+static void gen_dsi(PPCAsm& a) {
+    uint32_t loop = a.here();
+    a.lwz(5, 0, 24);            // faults, skipped by the handler
+    a.lwz(6, 0, 20);
+    a.add(3, 3, 6);
+    a.addi(20, 20, 4);
+    a.bdnz(loop);
+    a.ba(STOP_ADDR);
+}
+
+static void gen_fp_toggle(PPCAsm& a) {
+    uint32_t loop = a.here();
+    a.mfmsr(5);
+    a.rlwinm(5, 5, 0, 19, 17);  // clear MSR[FP]
+    a.mtmsr(5);
+    a.fadd(1, 1, 2);            // traps, handler turns FP back on
+    a.fadd(1, 1, 2);
+    a.bdnz(loop);
+    a.ba(STOP_ADDR);
+}
+
+static void prep_common(uint32_t msr, uint32_t iterations) {
+    set_msr(msr);
+    for (int reg = 0; reg < 32; reg++)
+        ppc_state.gpr[reg] = 0;
+    ppc_state.gpr[4]  = 0x12345678;
+    ppc_state.gpr[20] = SRC_ADDR;
+    ppc_state.gpr[21] = DST_ADDR;
+    ppc_state.gpr[24] = BAD_EA;
+    ppc_state.spr[SPR::CTR] = iterations;
+    ppc_state.pc = CODE_ADDR;
+}
+
+static void prep_int_alu()      { prep_common(0, 100000); }
+static void prep_branchy()      { prep_common(0, 100000); }
+static void prep_ldst_real()    { prep_common(0, 100000); }
+static void prep_string()       { prep_common(0, 100000); }
+static void prep_syscall()      { prep_common(0, 100000); }
+static void prep_fp_toggle()    { prep_common(0, 50000); }
+
+static void prep_fp_arith() {
+    prep_common(MSR::FP, 100000);
+    ppc_state.fpr[0].dbl64_r = 0.0;
+    ppc_state.fpr[1].dbl64_r = 1.0;
+    ppc_state.fpr[2].dbl64_r = 0.5;
+    ppc_state.fpr[3].dbl64_r = 3.0;
+    ppc_state.fpr[7].dbl64_r = 0.0;
+}
+
+static void prep_ldst_bat() {
+    prep_common(0, 100000);
+    set_dbat0((0xF << 2) | 3, 2);   // 2 MB at 0, supervisor & user RW
+    set_msr(MSR::DR);
+}
+
+static void prep_ldst_pt() {
+    prep_common(0, 100000);
+    set_dbat0(0, 0);
+    set_msr(MSR::DR);
+}
+
+static void prep_dsi() {
+    prep_common(0, 30000);
+    set_dbat0(0, 0);
+    set_msr(MSR::DR);
+}
+
+static const BenchKernel kernels[] = {
+    {"int_alu",     "integer arithmetic and logic",             gen_int_alu,         prep_int_alu},
+    {"branchy",     "data-dependent branches and calls",        gen_branchy,         prep_branchy},
+    {"fp_arith",    "floating-point arithmetic",                gen_fp_arith,        prep_fp_arith},
+    {"ldst_real",   "loads/stores, translation off",            gen_load_store,      prep_ldst_real},
+    {"ldst_bat",    "loads/stores, BAT translation",            gen_load_store,      prep_ldst_bat},
+    {"ldst_pt",     "loads/stores, page table translation",     gen_load_store,      prep_ldst_pt},
+    {"string_mult", "lmw/stmw and lswi/stswi copies",           gen_string_multiple, prep_string},
+    {"exc_syscall", "system call round trips",                  gen_syscall,         prep_syscall},
+    {"exc_dsi",     "DSI exceptions on unmapped pages",         gen_dsi,             prep_dsi},
+    {"fp_toggle",   "lazy FPU switching through MSR[FP]",       gen_fp_toggle,       prep_fp_toggle},
+};
+
+//================================ Reporting ==================================
+typedef struct {
+    std::string name;
+    uint64_t    insns;
+    uint64_t    best_ns;
+    double      mips;
+    uint32_t    result;
+} BenchResult;
+
+static bool write_json(const std::string& path, const std::vector<BenchResult>& results) {
+    std::ofstream out(path);
+    if (!out) {
+        LOG_F(ERROR, "Could not create %s", path.c_str());
+        return false;
+    }
+
+    char buf[256];
+
+    // one kernel per line so that baselines can be read back easily
+    out << "{\n  \"kernels\": [\n";
+    for (size_t i = 0; i < results.size(); i++) {
+        const BenchResult& r = results[i];
+        std::snprintf(buf, sizeof(buf),
+            "    {\"name\": \"%s\", \"insns\": %llu, \"best_ns\": %llu, "
+            "\"mips\": %.2f, \"result\": \"0x%08X\"}%s\n",
+            r.name.c_str(), (unsigned long long)r.insns, (unsigned long long)r.best_ns,
+            r.mips, r.result, i + 1 < results.size() ? "," : "");
+        out << buf;
+    }
+    out << "  ]\n}\n";
+
+    return true;
+}
+
+static bool read_baseline(const std::string& path, std::map<std::string, BenchResult>& baseline) {
+    std::ifstream in(path);
+    if (!in) {
+        LOG_F(ERROR, "Could not open baseline %s", path.c_str());
+        return false;
+    }
+
+    std::string line;
+    while (std::getline(in, line)) {
+        BenchResult r = {};
+        char name[64];
+        if (std::sscanf(line.c_str(),
+                " {\"name\": \"%63[^\"]\", \"insns\": %" SCNu64 ", \"best_ns\": %" SCNu64
+                ", \"mips\": %lf, \"result\": \"0x%" SCNx32 "\"",
+                name, &r.insns, &r.best_ns, &r.mips, &r.result) == 5) {
+            r.name = name;
+            if (r.mips <= 0.0) {
+                LOG_F(ERROR, "Baseline %s: invalid MIPS value for %s", path.c_str(), name);
+                return false;
+            }
+            baseline[r.name] = r;
+        }
+    }
+
+    if (baseline.empty()) {
+        LOG_F(ERROR, "Baseline %s contains no results", path.c_str());
+        return false;
+    }
+
+    return true;
+}
+
+int main(int argc, char** argv) {
+    CLI::App app("DingusPPC CPU benchmark suite");
+
+    std::string json_path, baseline_path, filter;
+    int         num_samples   = 10;
+    double      max_slowdown  = 5.0;
+    bool        list_kernels  = false;
+
+    app.add_option("-o,--json", json_path, "Write results to the specified JSON file");
+    app.add_option("-b,--baseline", baseline_path,
+        "Compare against results from a previous run")->check(CLI::ExistingFile);
+    app.add_option("-t,--threshold", max_slowdown,
+        "Maximum allowed slowdown against the baseline in percent (default is 5)");
+    app.add_option("-n,--samples", num_samples,
+        "Number of timed runs per kernel, the fastest one counts (default is 10)")
+        ->check(CLI::PositiveNumber);
+    app.add_option("-f,--filter", filter, "Only run kernels whose name contains this string");
+    app.add_flag("-l,--list", list_kernels, "List available kernels and exit");
+
+    CLI11_PARSE(app, argc, argv);
+
+    if (list_kernels) {
+        for (auto& k : kernels)
+            std::printf("%-12s %s\n", k.name, k.desc);
+        return 0;
+    }
+
+    /* initialize logging */
+    loguru::g_preamble_date    = false;
+    loguru::g_preamble_time    = false;
+    loguru::g_preamble_thread  = false;
+
+    loguru::g_stderr_verbosity = 0;
+    loguru::init(argc, argv);
+
+    std::map<std::string, BenchResult> baseline;
+    if (!baseline_path.empty() && !read_baseline(baseline_path, baseline))
+        return 1;
+
+    // the CPU registers its profiles there
+    gProfilerObj.reset(new Profiler());
+
+    MPC106* grackle_obj = new MPC106;
+
+    if (!grackle_obj->add_ram_region(0, RAM_SIZE)) {
+        LOG_F(ERROR, "Could not create RAM region");
+        delete(grackle_obj);
+        return -1;
+    }
+
+    constexpr uint64_t tbr_freq = 16705000;
+
+    ppc_cpu_init(grackle_obj, PPC_VER::MPC750, false, tbr_freq);
+
+    // exceptions are vectored to low memory, no interrupts please
+    set_msr(0);
+
+    install_vectors();
+    fill_source_data();
+    setup_page_table();
+
+    std::vector<BenchResult> results;
+    int failures = 0;
+
+    std::printf("%-12s %12s %12s %10s %10s\n", "kernel", "insns", "best ns", "MIPS", "result");
+
+    for (auto& k : kernels) {
+        if (!filter.empty() && std::string(k.name).find(filter) == std::string::npos)
+            continue;
+
+        // translation must be off while loading code
+        set_msr(0);
+        PPCAsm a(CODE_ADDR);
+        k.gen(a);
+        a.commit();
+
+        BenchResult r = {k.name, 0, UINT64_MAX, 0.0, 0};
+        bool consistent = true;
+
+        // the first run warms up caches and provides the reference result
+        for (int i = -1; i < num_samples; i++) {
+            k.prepare();
+            power_on = true;
+
+            uint64_t start_insns = g_icycles;
+            auto start_time      = std::chrono::steady_clock::now();
+            ppc_exec_until(STOP_ADDR);
+            auto end_time        = std::chrono::steady_clock::now();
+            uint64_t elapsed     = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                   end_time - start_time).count();
+
+            if (i < 0) {
+                r.insns  = g_icycles - start_insns;
+                r.result = ppc_state.gpr[3];
+            } else {
+                r.best_ns   = std::min(r.best_ns, elapsed);
+                consistent &= r.result == ppc_state.gpr[3];
+            }
+        }
+
+        r.mips = r.best_ns ? r.insns * 1000.0 / r.best_ns : 0.0;
+        results.push_back(r);
+
+        std::printf("%-12s %12llu %12llu %10.2f 0x%08X", k.name, (unsigned long long)r.insns,
+                    (unsigned long long)r.best_ns, r.mips, r.result);
+
+        if (!consistent) {
+            std::printf("  NONDETERMINISTIC");
+            failures++;
+        }
+
+        auto it = baseline.find(r.name);
+        if (it != baseline.end()) {
+            double change = (r.mips / it->second.mips - 1.0) * 100.0;
+            std::printf("  %+6.1f%%", change);
+            if (r.result != it->second.result) {
+                std::printf("  RESULT MISMATCH (was 0x%08X)", it->second.result);
+                failures++;
+            } else if (change < -max_slowdown) {
+                std::printf("  REGRESSION");
+                failures++;
+            }
+        } else if (!baseline.empty()) {
+            // a kernel without baseline would never be checked for regressions
+            std::printf("  NOT IN BASELINE");
+            failures++;
+        }
+
+        std::printf("\n");
+    }
+
+    if (!json_path.empty() && !write_json(json_path, results))
+        failures++;
+
+    delete(grackle_obj);
+
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,177 @@
+/*
+DingusPPC - The Experimental PowerPC Macintosh emulator
+Copyright (C) 2018-25 divingkatae and maximum
+                      (theweirdo)     spatium
+
+(Contact divingkatae#1017 or powermax#2286 on Discord for more info)
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+/** @file Host independent part of the event manager: input event queue
+    and host task queue. */
+
+#include <core/hostevents.h>
+#include <loguru.hpp>
+
+#include <condition_variable>
+#include <utility>
+
+void EventManager::queue_input(const KeyboardEvent& ke) {
+    InputEvent ie;
+    ie.type = INPUT_EVENT_KEYBOARD;
+    ie.kbd  = ke;
+    this->queue_input(ie);
+}
+
+void EventManager::queue_input(const MouseEvent& me) {
+    InputEvent ie;
+    ie.type  = INPUT_EVENT_MOUSE;
+    ie.mouse = me;
+    this->queue_input(ie);
+}
+
+void EventManager::queue_input(const GamepadEvent& ge) {
+    InputEvent ie;
+    ie.type    = INPUT_EVENT_GAMEPAD;
+    ie.gamepad = ge;
+    this->queue_input(ie);
+}
+
+static inline bool is_mouse_motion(const InputEvent& ie) {
+    return ie.type == INPUT_EVENT_MOUSE && ie.mouse.flags == MOUSE_EVENT_MOTION;
+}
+
+// Events whose loss would leave the guest with a stuck key or button.
+static inline bool must_deliver(const InputEvent& ie) {
+    switch (ie.type) {
+    case INPUT_EVENT_KEYBOARD:
+        return ie.kbd.flags == KEYBOARD_EVENT_UP;
+    case INPUT_EVENT_MOUSE:
+        return ie.mouse.flags == MOUSE_EVENT_BUTTON;
+    case INPUT_EVENT_GAMEPAD:
+        return ie.gamepad.flags == GAMEPAD_EVENT_UP;
+    }
+    return false;
+}
+
+// Folds the movement of next into prev, both must be mouse motion events.
+static inline void merge_motion(MouseEvent& prev, const MouseEvent& next) {
+    prev.xrel += next.xrel;
+    prev.yrel += next.yrel;
+    prev.xabs  = next.xabs;
+    prev.yabs  = next.yabs;
+}
+
+void EventManager::flush_input_backlog() {
+    while (!this->input_backlog.empty() && this->input_queue.push(this->input_backlog.front()))
+        this->input_backlog.pop_front();
+}
+
+void EventManager::queue_input(const InputEvent& ie) {
+    // keep the order: nothing may overtake events waiting in the backlog
+    this->flush_input_backlog();
+    if (this->input_backlog.empty() && this->input_queue.push(ie))
+        return;
+
+    if (is_mouse_motion(ie) && !this->input_backlog.empty() &&
+        is_mouse_motion(this->input_backlog.back())) {
+        merge_motion(this->input_backlog.back().mouse, ie.mouse);
+    } else if (this->input_backlog.size() < INPUT_BACKLOG_SIZE || must_deliver(ie)) {
+        this->input_backlog.push_back(ie);
+    } else {
+        this->events_dropped++;
+        LOG_F(9, "EventManager: input backlog full, event dropped");
+    }
+}
+
+void EventManager::post_host_task(host_task task) {
+    if (!this->host_loop_active || this->is_host_thread()) {
+        task();
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lk(this->task_mtx);
+        this->host_tasks.push_back(std::move(task));
+    }
+    this->wake_host();
+}
+
+void EventManager::run_host_task(host_task task) {
+    if (!this->host_loop_active || this->is_host_thread()) {
+        task();
+        return;
+    }
+
+    std::mutex              done_mtx;
+    std::condition_variable done_cv;
+    bool                    done = false;
+
+    this->post_host_task([&]() {
+        task();
+        std::lock_guard<std::mutex> lk(done_mtx);
+        done = true;
+        done_cv.notify_one();
+    });
+
+    std::unique_lock<std::mutex> lk(done_mtx);
+    done_cv.wait(lk, [&] { return done; });
+}
+
+void EventManager::run_host_tasks() {
+    std::vector<host_task> tasks;
+
+    this->host_wake_pending = false;
+    {
+        std::lock_guard<std::mutex> lk(this->task_mtx);
+        tasks.swap(this->host_tasks);
+    }
+    for (auto& task : tasks)
+        task();
+}
+
+void EventManager::emit_window_event(const WindowEvent& we) {
+    std::lock_guard<std::mutex> lk(this->window_mtx);
+    this->_window_signal.emit(we);
+}
+
+void EventManager::dispatch_events() {
+    InputEvent  batch[32];
+    size_t      count;
+
+    while ((count = this->input_queue.pop(batch, 32)) != 0) {
+        for (size_t i = 0; i < count; i++) {
+            InputEvent& ie = batch[i];
+
+            switch (ie.type) {
+            case INPUT_EVENT_KEYBOARD:
+                this->_keyboard_signal.emit(ie.kbd);
+                break;
+            case INPUT_EVENT_MOUSE:
+                // the host may report many small movements between two ADB polls,
+                // deliver a run of them as one movement ending at the last position
+                while (is_mouse_motion(ie) && i + 1 < count && is_mouse_motion(batch[i + 1]))
+                    merge_motion(ie.mouse, batch[++i].mouse);
+                this->_mouse_signal.emit(ie.mouse);
+                break;
+            case INPUT_EVENT_GAMEPAD:
+                this->_gamepad_signal.emit(ie.gamepad);
+                break;
+            }
+        }
+    }
+
+    // perform post-processing
+    this->_post_signal.emit();
+}
@@ -23,8 +23,15 @@ along with this program.  If not, see <https://www.gnu.org/licenses/>.
 #define EVENT_MANAGER_H
 
 #include <core/coresignal.h>
+#include <core/spscring.h>
 
+#include <atomic>
 #include <cinttypes>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
 
 class WindowEvent {
 public:
@@ -114,6 +121,30 @@ public:
     uint8_t button;
 };
 
+enum : uint8_t {
+    INPUT_EVENT_KEYBOARD,
+    INPUT_EVENT_MOUSE,
+    INPUT_EVENT_GAMEPAD,
+};
+
+/** Input event queued by the host event pump for the emulated devices. */
+struct InputEvent {
+    uint8_t type;
+    union {
+        KeyboardEvent   kbd;
+        MouseEvent      mouse;
+        GamepadEvent    gamepad;
+    };
+};
+
+/** Size of the input queue. Events arriving while it's full wait in a host
+    side backlog where mouse motion is merged. Only presses are dropped once
+    the backlog is full too, releases are always kept so no key gets stuck. */
+constexpr int INPUT_QUEUE_SIZE   = 256;
+constexpr int INPUT_BACKLOG_SIZE = 256;
+
+typedef std::function<void()> host_task;
+
 class EventManager {
 public:
     static EventManager* get_instance() {
@@ -123,10 +154,30 @@ public:
         return event_manager;
     };
 
-    void poll_events(uint32_t kbd_locale);
+    // Host side: runs emu_func on a new thread while the calling (main)
+    // thread handles host events and host tasks. Window events are handled
+    // right away, input events are queued for dispatch_events().
+    // Returns once emu_func has returned.
+    void run_host_loop(uint32_t kbd_locale, std::function<void()> emu_func);
+
+    // Emulator side: delivers queued input events to the emulated devices
+    // and runs the post handlers (ADB autopoll). Never calls into the host
+    // windowing layer.
+    void dispatch_events();
+
+    // Host windowing calls must be made on the host thread. These run task
+    // there, right away when called on the host thread itself or when no
+    // host loop is running. run_host_task() waits for the task to finish.
+    void post_host_task(host_task task);
+    void run_host_task(host_task task);
+    bool is_host_thread() const {
+        return this->host_loop_active && std::this_thread::get_id() == this->host_thread_id;
+    }
 
+    // window handlers are called on the host thread
     template <typename T>
     void add_window_handler(T *inst, void (T::*func)(const WindowEvent&)) {
+        std::lock_guard<std::mutex> lk(this->window_mtx);
         _window_signal.connect_method(inst, func);
     }
 
@@ -151,9 +202,13 @@ public:
     }
 
     void disconnect_handlers() {
-        _window_signal.disconnect_all();
+        {
+            std::lock_guard<std::mutex> lk(this->window_mtx);
+            _window_signal.disconnect_all();
+        }
         _mouse_signal.disconnect_all();
         _keyboard_signal.disconnect_all();
+        _gamepad_signal.disconnect_all();
         _post_signal.disconnect_all();
     }
 
@@ -164,7 +219,29 @@ public:
 
 private:
     static EventManager* event_manager;
-    EventManager() {}; // private constructor to implement a singleton
+    EventManager() : input_queue(INPUT_QUEUE_SIZE) {}; // private constructor to implement a singleton
+
+    void pump_events(uint32_t kbd_locale);
+    void emit_window_event(const WindowEvent& we);
+    void run_host_tasks();
+    void wake_host();
+
+    void queue_input(const KeyboardEvent& ke);
+    void queue_input(const MouseEvent& me);
+    void queue_input(const GamepadEvent& ge);
+    void queue_input(const InputEvent& ie);
+    void flush_input_backlog();
+
+    SpscRing<InputEvent>    input_queue;
+    std::deque<InputEvent>  input_backlog; // host thread only
+
+    std::mutex              window_mtx; // guards _window_signal
+
+    std::atomic<bool>       host_loop_active{false};
+    std::thread::id         host_thread_id;
+    std::atomic<bool>       host_wake_pending{false};
+    std::mutex              task_mtx;
+    std::vector<host_task>  host_tasks;
 
     CoreSignal<const WindowEvent&>     _window_signal;
     CoreSignal<const MouseEvent&>      _mouse_signal;
@@ -173,6 +250,7 @@ private:
     CoreSignal<>                       _post_signal;
 
     uint64_t    events_captured = 0;
+    uint64_t    events_dropped = 0;
     uint64_t    unhandled_events = 0;
     uint64_t    key_downs = 0;
     uint64_t    key_ups = 0;
@@ -26,15 +26,62 @@ along with this program.  If not, see <https://www.gnu.org/licenses/>.
 #include <loguru.hpp>
 #include <SDL.h>
 
+#include <atomic>
+#include <thread>
+#include <utility>
+
 EventManager* EventManager::event_manager;
 
+// SDL user event used to wake the host loop when tasks are posted
+static Uint32 host_wake_event = (Uint32)-1;
+
 static int get_sdl_event_key_code(const SDL_KeyboardEvent& event, uint32_t kbd_locale);
 static void toggle_mouse_grab(const SDL_KeyboardEvent &event);
 
-void EventManager::poll_events(uint32_t kbd_locale) {
+void EventManager::run_host_loop(uint32_t kbd_locale, std::function<void()> emu_func) {
+    std::atomic<bool> emu_done{false};
+
+    if (host_wake_event == (Uint32)-1)
+        host_wake_event = SDL_RegisterEvents(1);
+
+    this->host_thread_id   = std::this_thread::get_id();
+    this->host_loop_active = true;
+
+    std::thread emu_thread([&]() {
+        emu_func();
+        emu_done = true;
+        this->wake_host();
+    });
+
+    while (!emu_done) {
+        // poll more often while events wait for room in the input queue
+        SDL_WaitEventTimeout(nullptr, this->input_backlog.empty() ? 10 : 1);
+        this->pump_events(kbd_locale);
+        this->run_host_tasks();
+        this->flush_input_backlog();
+    }
+
+    emu_thread.join();
+    this->host_loop_active = false;
+    this->run_host_tasks();
+}
+
+void EventManager::wake_host() {
+    if (this->host_wake_pending.exchange(true))
+        return;
+
+    SDL_Event event{};
+    event.type = host_wake_event;
+    SDL_PushEvent(&event);
+}
+
+void EventManager::pump_events(uint32_t kbd_locale) {
     SDL_Event event;
 
     while (SDL_PollEvent(&event)) {
+        if (event.type == host_wake_event)
+            continue;
+
         events_captured++;
 
         switch (event.type) {
@@ -47,7 +94,7 @@ void EventManager::poll_events(uint32_t kbd_locale) {
                 WindowEvent we{};
                 we.sub_type  = event.window.event;
                 we.window_id = event.window.windowID;
-                this->_window_signal.emit(we);
+                this->emit_window_event(we);
             }
             break;
 
@@ -59,7 +106,7 @@ void EventManager::poll_events(uint32_t kbd_locale) {
                     if (event.type == SDL_KEYUP) {
                         toggle_mouse_grab(event.key);
                     }
-                    return;
+                    break;
                 }
                 // Control-S: scale quality
                 if (event.key.keysym.sym == SDLK_s && SDL_GetModState() & KMOD_LCTRL) {
@@ -67,9 +114,9 @@ void EventManager::poll_events(uint32_t kbd_locale) {
                         WindowEvent we{};
                         we.sub_type  = WINDOW_SCALE_QUALITY_TOGGLE;
                         we.window_id = event.window.windowID;
-                        this->_window_signal.emit(we);
+                        this->emit_window_event(we);
                     }
-                    return;
+                    break;
                 }
                 int key_code = get_sdl_event_key_code(event.key, kbd_locale);
                 if (key_code != -1) {
@@ -87,7 +134,7 @@ void EventManager::poll_events(uint32_t kbd_locale) {
                         ke.flags = SDL_GetModState() & KMOD_CAPS ?
                             KEYBOARD_EVENT_DOWN : KEYBOARD_EVENT_UP;
                     }
-                    this->_keyboard_signal.emit(ke);
+                    this->queue_input(ke);
                 } else {
                     LOG_F(WARNING, "Unknown key %x pressed", event.key.keysym.sym);
                 }
@@ -101,7 +148,7 @@ void EventManager::poll_events(uint32_t kbd_locale) {
                 me.xabs  = event.motion.x;
                 me.yabs  = event.motion.y;
                 me.flags = MOUSE_EVENT_MOTION;
-                this->_mouse_signal.emit(me);
+                this->queue_input(me);
             }
             break;
 
@@ -118,7 +165,7 @@ void EventManager::poll_events(uint32_t kbd_locale) {
                 me.xabs  = event.button.x;
                 me.yabs  = event.button.y;
                 me.flags = MOUSE_EVENT_BUTTON;
-                this->_mouse_signal.emit(me);
+                this->queue_input(me);
             }
             break;
 
@@ -135,7 +182,7 @@ void EventManager::poll_events(uint32_t kbd_locale) {
                 me.xabs  = event.button.x;
                 me.yabs  = event.button.y;
                 me.flags = MOUSE_EVENT_BUTTON;
-                this->_mouse_signal.emit(me);
+                this->queue_input(me);
             }
             break;
 
@@ -158,7 +205,7 @@ void EventManager::poll_events(uint32_t kbd_locale) {
                 }
                 ge.gamepad_id = event.cbutton.which;
                 ge.flags = GAMEPAD_EVENT_DOWN;
-                this->_gamepad_signal.emit(ge);
+                this->queue_input(ge);
             }
             break;
 
@@ -181,7 +228,7 @@ void EventManager::poll_events(uint32_t kbd_locale) {
                 }
                 ge.gamepad_id = event.cbutton.which;
                 ge.flags = GAMEPAD_EVENT_UP;
-                this->_gamepad_signal.emit(ge);
+                this->queue_input(ge);
             }
             break;
 
@@ -189,9 +236,6 @@ void EventManager::poll_events(uint32_t kbd_locale) {
             unhandled_events++;
         }
     }
-
-    // perform post-processing
-    this->_post_signal.emit();
 }
 
 
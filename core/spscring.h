@@ -0,0 +1,113 @@
+/*
+DingusPPC - The Experimental PowerPC Macintosh emulator
+Copyright (C) 2018-25 divingkatae and maximum
+                      (theweirdo)     spatium
+
+(Contact divingkatae#1017 or powermax#2286 on Discord for more info)
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+/** Lock-free single-producer single-consumer ring buffer.
+
+    Exactly one thread may push and exactly one thread may pop at any time.
+    Resizing and clearing require both sides to be quiescent.
+ */
+
+#ifndef SPSC_RING_H
+#define SPSC_RING_H
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <memory>
+
+template <typename T>
+class SpscRing {
+public:
+    SpscRing(size_t capacity = 0) { this->resize(capacity); }
+    ~SpscRing() = default;
+
+    // Allocates storage for at least the given number of elements.
+    void resize(size_t capacity) {
+        size_t size = 1;
+        while (size < capacity)
+            size <<= 1;
+        this->buf  = std::unique_ptr<T[]>(new T[size]);
+        this->mask = size - 1;
+        this->clear();
+    }
+
+    void clear() {
+        this->head.store(0, std::memory_order_relaxed);
+        this->tail.store(0, std::memory_order_relaxed);
+    }
+
+    size_t capacity() const { return this->mask + 1; }
+
+    // Number of elements ready to be popped.
+    size_t size() const {
+        return this->head.load(std::memory_order_acquire) -
+               this->tail.load(std::memory_order_acquire);
+    }
+
+    // Number of elements that can be pushed without overwriting.
+    size_t space() const { return this->capacity() - this->size(); }
+
+    // Producer side: appends up to count elements, returns the number appended.
+    size_t push(const T* data, size_t count) {
+        size_t wr = this->head.load(std::memory_order_relaxed);
+        size_t rd = this->tail.load(std::memory_order_acquire);
+
+        count = std::min(count, this->capacity() - (wr - rd));
+
+        size_t pos   = wr & this->mask;
+        size_t first = std::min(count, this->capacity() - pos);
+        std::copy(data, data + first, &this->buf[pos]);
+        std::copy(data + first, data + count, &this->buf[0]);
+
+        this->head.store(wr + count, std::memory_order_release);
+        return count;
+    }
+
+    bool push(const T& item) { return this->push(&item, 1) == 1; }
+
+    // Consumer side: removes up to count elements, returns the number removed.
+    size_t pop(T* data, size_t count) {
+        size_t rd = this->tail.load(std::memory_order_relaxed);
+        size_t wr = this->head.load(std::memory_order_acquire);
+
+        count = std::min(count, wr - rd);
+
+        size_t pos   = rd & this->mask;
+        size_t first = std::min(count, this->capacity() - pos);
+        std::copy(&this->buf[pos], &this->buf[pos] + first, data);
+        std::copy(&this->buf[0], &this->buf[0] + (count - first), data + first);
+
+        this->tail.store(rd + count, std::memory_order_release);
+        return count;
+    }
+
+    bool pop(T& item) { return this->pop(&item, 1) == 1; }
+
+private:
+    std::unique_ptr<T[]>    buf;
+    size_t                  mask = 0;
+
+    // free-running indices, kept on separate cache lines
+    alignas(64) std::atomic<size_t> head{0}; // next element to write
+    alignas(64) std::atomic<size_t> tail{0}; // next element to read
+};
+
+#endif // SPSC_RING_H
@@ -147,7 +147,6 @@ private:
 
     std::atomic<uint32_t> id{0};
 
-    // FIXME: Do we need this? It gets written in main thread and read in audio thread.
     bool cb_active = false; // true if a timer callback is executing
 };
 
@@ -0,0 +1,151 @@
+/*
+DingusPPC - The Experimental PowerPC Macintosh emulator
+Copyright (C) 2018-25 divingkatae and maximum
+                      (theweirdo)     spatium
+
+(Contact divingkatae#1017 or powermax#2286 on Discord for more info)
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+/** @file Instruction breakpoints and data watchpoints. */
+
+#include "ppcbreakpoints.h"
+#include "ppcemu.h"
+#include "ppcmmu.h"
+#include <loguru.hpp>
+
+#include <algorithm>
+#include <unordered_map>
+
+static std::set<uint32_t>                   breakpoints;
+static std::vector<PPCWatchpoint>           watchpoints;
+
+// number of breakpoints/watched ranges per page
+static std::unordered_map<uint32_t, int>    bp_pages;
+static std::unordered_map<uint32_t, int>    watch_pages;
+
+static void ref_page(std::unordered_map<uint32_t, int>& pages, uint32_t page_addr) {
+    // drop stale translations so the TLB picks up the page tag on refill
+    if (!pages[page_addr]++)
+        tlb_flush_entry(page_addr);
+}
+
+static void unref_page(std::unordered_map<uint32_t, int>& pages, uint32_t page_addr) {
+    auto it = pages.find(page_addr);
+    if (it != pages.end() && !--it->second) {
+        pages.erase(it);
+        tlb_flush_entry(page_addr);
+    }
+}
+
+static void for_each_page(const PPCWatchpoint& wp, void (*fn)(std::unordered_map<uint32_t, int>&,
+                                                              uint32_t)) {
+    uint32_t last_page = (wp.addr + wp.size - 1) & PPC_PAGE_MASK;
+    for (uint32_t page = wp.addr & PPC_PAGE_MASK; ; page += PPC_PAGE_SIZE) {
+        fn(watch_pages, page);
+        if (page == last_page)
+            break;
+    }
+}
+
+bool ppc_add_breakpoint(uint32_t addr) {
+    addr &= ~3;
+    if (!breakpoints.insert(addr).second)
+        return false;
+    ref_page(bp_pages, addr & PPC_PAGE_MASK);
+    return true;
+}
+
+bool ppc_remove_breakpoint(uint32_t addr) {
+    addr &= ~3;
+    if (!breakpoints.erase(addr))
+        return false;
+    unref_page(bp_pages, addr & PPC_PAGE_MASK);
+    return true;
+}
+
+bool ppc_add_watchpoint(uint32_t addr, uint32_t size, uint8_t type) {
+    if (!size || !(type & WATCH_ACCESS) || addr + (size - 1) < addr)
+        return false;
+
+    PPCWatchpoint wp = {addr, size, type};
+    watchpoints.push_back(wp);
+    for_each_page(wp, ref_page);
+    return true;
+}
+
+bool ppc_remove_watchpoint(uint32_t addr) {
+    auto it = std::find_if(watchpoints.begin(), watchpoints.end(),
+                           [addr](const PPCWatchpoint& wp) { return wp.addr == addr; });
+    if (it == watchpoints.end())
+        return false;
+
+    for_each_page(*it, unref_page);
+    watchpoints.erase(it);
+    return true;
+}
+
+void ppc_clear_breakpoints() {
+    while (!breakpoints.empty())
+        ppc_remove_breakpoint(*breakpoints.begin());
+    while (!watchpoints.empty())
+        ppc_remove_watchpoint(watchpoints.front().addr);
+}
+
+const std::set<uint32_t>& ppc_get_breakpoints() {
+    return breakpoints;
+}
+
+const std::vector<PPCWatchpoint>& ppc_get_watchpoints() {
+    return watchpoints;
+}
+
+bool ppc_page_has_breakpoints(uint32_t page_addr) {
+    return !bp_pages.empty() && bp_pages.count(page_addr);
+}
+
+bool ppc_page_is_watched(uint32_t page_addr) {
+    return !watch_pages.empty() && watch_pages.count(page_addr);
+}
+
+bool ppc_breakpoint_hit(uint32_t addr) {
+    if (!breakpoints.count(addr))
+        return false;
+
+    LOG_F(INFO, "Breakpoint hit at 0x%08X", addr);
+    power_on = false;
+    power_off_reason = po_enter_debugger;
+    return true;
+}
+
+uint32_t ppc_next_breakpoint(uint32_t addr, uint32_t limit) {
+    auto it = breakpoints.lower_bound(addr);
+    return (it != breakpoints.end() && *it < limit) ? *it : limit;
+}
+
+void ppc_watch_check(uint32_t addr, uint32_t size, bool is_write) {
+    uint8_t access = is_write ? WATCH_WRITE : WATCH_READ;
+
+    for (auto& wp : watchpoints) {
+        if ((wp.type & access) && addr < wp.addr + wp.size && wp.addr < addr + size) {
+            LOG_F(INFO, "Watchpoint 0x%08X hit: %s of %d bytes at 0x%08X, PC=0x%08X",
+                  wp.addr, is_write ? "write" : "read", size, addr, ppc_state.pc);
+            // stop once the current instruction has been completed
+            power_on = false;
+            power_off_reason = po_enter_debugger;
+            return;
+        }
+    }
+}
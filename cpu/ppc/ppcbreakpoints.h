@@ -0,0 +1,69 @@
+/*
+DingusPPC - The Experimental PowerPC Macintosh emulator
+Copyright (C) 2018-25 divingkatae and maximum
+                      (theweirdo)     spatium
+
+(Contact divingkatae#1017 or powermax#2286 on Discord for more info)
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+/** @file Instruction breakpoints and data watchpoints.
+
+    Both work on effective addresses. Pages containing a breakpoint are
+    tagged in the ITLB so the interpreter only inspects instruction
+    addresses within those pages. Pages containing a watched range are
+    tagged in the DTLB and kept out of the primary DTLB so that only
+    accesses to them go through the checking path.
+
+    A hit stops execution and drops into the debugger; watchpoints stop
+    after the accessing instruction has been completed.
+ */
+
+#ifndef PPC_BREAKPOINTS_H
+#define PPC_BREAKPOINTS_H
+
+#include <cinttypes>
+#include <set>
+#include <vector>
+
+enum WatchType : uint8_t {
+    WATCH_READ   = 1 << 0,
+    WATCH_WRITE  = 1 << 1,
+    WATCH_ACCESS = WATCH_READ | WATCH_WRITE,
+};
+
+typedef struct {
+    uint32_t    addr;
+    uint32_t    size;
+    uint8_t     type;
+} PPCWatchpoint;
+
+// debugger interface
+extern bool ppc_add_breakpoint(uint32_t addr);
+extern bool ppc_remove_breakpoint(uint32_t addr);
+extern bool ppc_add_watchpoint(uint32_t addr, uint32_t size, uint8_t type);
+extern bool ppc_remove_watchpoint(uint32_t addr);
+extern void ppc_clear_breakpoints();
+extern const std::set<uint32_t>& ppc_get_breakpoints();
+extern const std::vector<PPCWatchpoint>& ppc_get_watchpoints();
+
+// interpreter/MMU interface, called on slow paths only
+extern bool ppc_page_has_breakpoints(uint32_t page_addr);
+extern bool ppc_page_is_watched(uint32_t page_addr);
+extern bool ppc_breakpoint_hit(uint32_t addr);
+extern uint32_t ppc_next_breakpoint(uint32_t addr, uint32_t limit);
+extern void ppc_watch_check(uint32_t addr, uint32_t size, bool is_write);
+
+#endif // PPC_BREAKPOINTS_H
@@ -35,8 +35,6 @@ along with this program.  If not, see <https://www.gnu.org/licenses/>.
 // Uncomment this to have a more graceful approach to illegal opcodes
 //#define ILLEGAL_OP_SAFE 1
 
-//#define CPU_PROFILING // enable CPU profiling
-
 /** type of compiler used during execution */
 enum EXEC_MODE:uint32_t {
     interpreter     = 0,
@@ -338,18 +336,18 @@ extern bool is_deterministic;
 // Important Addressing Integers
 extern uint32_t ppc_next_instruction_address;
 
+// Number of instructions executed so far, drives the virtual clock
+extern uint64_t g_icycles;
+
 inline uint32_t ppc_read_instruction(const uint8_t* ptr) {
     return READ_DWORD_BE_A(ptr);
 }
 
-// Profiling Stats
-#ifdef CPU_PROFILING
-extern uint64_t num_executed_instrs;
+// Profiling Stats, counted only while profiling_enabled is set
 extern uint64_t num_supervisor_instrs;
 extern uint64_t num_int_loads;
 extern uint64_t num_int_stores;
 extern uint64_t exceptions_processed;
-#endif
 
 // instruction enums
 typedef enum {
@@ -413,6 +411,7 @@ extern void ppc_mmu_init();
 void ppc_illegalop(uint32_t opcode);
 void ppc_assert_int();
 void ppc_release_int();
+void ppc_request_events(); // process pending events after the current instruction
 
 void initialize_ppc_opcode_table();
 
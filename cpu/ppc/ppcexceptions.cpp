@@ -24,6 +24,8 @@ along with this program.  If not, see <https://www.gnu.org/licenses/>.
 #include <loguru.hpp>
 #include "ppcemu.h"
 #include "ppcmmu.h"
+#include "ppctrace.h"
+#include <utils/profiler.h>
 
 #include <setjmp.h>
 #include <stdexcept>
@@ -33,9 +35,7 @@ jmp_buf exc_env; /* Global exception environment. */
 
 #if !defined(PPC_TESTS) && !defined(PPC_BENCHMARKS)
 void ppc_exception_handler(Except_Type exception_type, uint32_t srr1_bits) {
-#ifdef CPU_PROFILING
-    exceptions_processed++;
-#endif
+    PROF_INC(exceptions_processed);
 
     switch (exception_type) {
     case Except_Type::EXC_SYSTEM_RESET:
@@ -129,6 +129,8 @@ void ppc_exception_handler(Except_Type exception_type, uint32_t srr1_bits) {
 
     exec_flags = EXEF_EXCEPTION;
 
+    ppc_trace_exception(ppc_next_instruction_address, ppc_state.spr[SPR::SRR0]);
+
     // perform context synchronization for recoverable exceptions
     if (exception_type != Except_Type::EXC_MACHINE_CHECK &&
         exception_type != Except_Type::EXC_SYSTEM_RESET) {
@@ -20,10 +20,13 @@ along with this program.  If not, see <https://www.gnu.org/licenses/>.
 */
 
 #include <core/timermanager.h>
+#include <devices/common/hwinterrupt.h>
 #include <loguru.hpp>
+#include "ppcbreakpoints.h"
 #include "ppcemu.h"
 #include "ppcmmu.h"
 #include "ppcdisasm.h"
+#include "ppctrace.h"
 
 #include <algorithm>
 #include <chrono>
@@ -69,8 +72,8 @@ SetPRS ppc_state;
 uint32_t ppc_next_instruction_address;    // Used for branching, setting up the NIA
 
 unsigned exec_flags; // execution control flags
-// FIXME: exec_timer is read by main thread ppc_main_opcode;
-// written by audio dbdma DMAChannel::update_irq .. add_immediate_timer
+// exec_timer is read by the interpreter loop after each instruction,
+// it may be set from other threads via ppc_request_events()
 volatile bool exec_timer;
 bool int_pin = false; // interrupt request pin state: true - asserted
 bool dec_exception_pending = false;
@@ -100,17 +103,16 @@ uint32_t dec_wr_value;      // last value written to the DEC register
 uint32_t rtc_lo;            // MPC601 RTC lower, counts nanoseconds
 uint32_t rtc_hi;            // MPC601 RTC upper, counts seconds
 
-#ifdef CPU_PROFILING
-
 /* global variables for lightweight CPU profiling */
-uint64_t num_executed_instrs;
 uint64_t num_supervisor_instrs;
 uint64_t num_int_loads;
 uint64_t num_int_stores;
 uint64_t exceptions_processed;
-#ifdef CPU_PROFILING_OPS
-std::unordered_map<uint32_t, uint64_t> num_opcodes;
-#endif
+
+/* executed instructions counted per slot of the opcode dispatch table */
+static uint64_t num_opcodes[64 * 2048];
+/* first instruction seen in each slot, the slot index lacks bits 11...25 */
+static uint32_t slot_opcodes[64 * 2048];
 
 #include "utils/profiler.h"
 #include <memory>
@@ -122,6 +124,22 @@ public:
     void populate_variables(std::vector<ProfileVar>& vars) {
         vars.clear();
 
+        // Several dispatch slots belong to the same instruction
+        // so op counts are summed up by mnemonic.
+        uint64_t num_executed_instrs = 0;
+        std::map<std::string, uint64_t> op_counts;
+        PPCDisasmContext ctx;
+        ctx.instr_addr = 0;
+        ctx.simplified = false;
+        for (uint32_t slot = 0; slot < 64 * 2048; slot++) {
+            if (!num_opcodes[slot])
+                continue;
+            num_executed_instrs += num_opcodes[slot];
+            ctx.instr_code = slot_opcodes[slot];
+            auto op_name = disassemble_single(&ctx);
+            op_counts[op_name.substr(0, op_name.find(' '))] += num_opcodes[slot];
+        }
+
         vars.push_back({.name = "Executed Instructions Total",
                         .format = ProfileVarFmt::DEC,
                         .value = num_executed_instrs});
@@ -143,16 +161,8 @@ public:
                         .value = exceptions_processed});
 
         // Generate top N op counts with readable names.
-#ifdef CPU_PROFILING_OPS
-        PPCDisasmContext ctx;
-        ctx.instr_addr = 0;
-        ctx.simplified = false;
-        std::vector<std::pair<std::string, uint64_t>> op_name_counts;
-        for (const auto& pair : num_opcodes) {
-            ctx.instr_code = pair.first;
-            auto op_name = disassemble_single(&ctx);
-            op_name_counts.emplace_back(op_name, pair.second);
-        }
+        std::vector<std::pair<std::string, uint64_t>> op_name_counts(op_counts.begin(),
+                                                                     op_counts.end());
         size_t top_ops_size = std::min(op_name_counts.size(), size_t(20));
         std::partial_sort(
             op_name_counts.begin(), op_name_counts.begin() + top_ops_size, op_name_counts.end(),
@@ -167,23 +177,17 @@ public:
                             .value = pair.second,
                             .count_total = num_executed_instrs});
         }
-#endif
     };
 
     void reset() {
-        num_executed_instrs = 0;
         num_supervisor_instrs = 0;
         num_int_loads = 0;
         num_int_stores = 0;
         exceptions_processed = 0;
-#ifdef CPU_PROFILING_OPS
-        num_opcodes.clear();
-#endif
+        std::memset(num_opcodes, 0, sizeof(num_opcodes));
     };
 };
 
-#endif
-
 /** Opcode lookup table, indexed by
     primary opcode (bits 0...5) and modifier (bits 21...31). */
 static PPCOpcode OpcodeGrabber[64 * 2048];
@@ -239,18 +243,21 @@ void ppc_release_int() {
     int_pin = false;
 }
 
+void ppc_request_events() {
+    exec_timer = true;
+}
+
 /** Opcode decoding functions. */
 
 /* Dispatch using primary and modifier opcode */
 void ppc_main_opcode(PPCOpcode *opcodeGrabber, uint32_t opcode)
 {
-#ifdef CPU_PROFILING
-    num_executed_instrs++;
-#if defined(CPU_PROFILING_OPS)
-    num_opcodes[opcode]++;
-#endif
-#endif
-    opcodeGrabber[(opcode >> 15 & 0x1F800) | (opcode & 0x7FF)](opcode);
+    uint32_t slot = (opcode >> 15 & 0x1F800) | (opcode & 0x7FF);
+    if (profiling_enabled) [[unlikely]] {
+        if (!num_opcodes[slot]++)
+            slot_opcodes[slot] = opcode;
+    }
+    opcodeGrabber[slot](opcode);
 }
 
 static long long cpu_now_ns() {
@@ -274,6 +281,7 @@ uint64_t get_virt_time_ns()
 static uint64_t process_events()
 {
     exec_timer = false;
+    InterruptCtrl::deliver_posted_ints();
     uint64_t slice_ns = TimerManager::get_instance()->process_timers();
     if (slice_ns == 0) {
         // execute 25.000 cycles
@@ -296,12 +304,15 @@ typedef enum {
 } ppc_exec_type_t;
 
 // inner interpreter loop
-template <ppc_exec_type_t exec_type>
+// the tracing variant records each instruction, see ppctrace.h
+template <ppc_exec_type_t exec_type, bool trace = false>
 static void ppc_exec_inner(uint32_t start_addr, uint32_t size)
 {
     uint64_t max_cycles = 0;
     uint32_t page_start, eb_start, eb_end = 0;
     uint32_t opcode;
+    uint16_t page_flags;
+    bool bp_page = false;
     PPCOpcode* opcode_grabber = ppc_opcode_grabber;
     uint8_t* pc_real;
 
@@ -317,11 +328,24 @@ static void ppc_exec_inner(uint32_t start_addr, uint32_t size)
             page_start = eb_start & PPC_PAGE_MASK;
             eb_end     = page_start + PPC_PAGE_SIZE - 1;
             exec_flags = 0;
-            pc_real    = mmu_translate_imem(eb_start);
+            pc_real    = mmu_translate_imem(eb_start, nullptr, &page_flags);
+
+            // pages with breakpoints are split into blocks ending at
+            // the next breakpoint so the check is done once per block
+            bp_page = !!(page_flags & TLBFlags::PAGE_BREAKPOINT);
+            if (bp_page) [[unlikely]] {
+                if (ppc_breakpoint_hit(eb_start))
+                    break;
+                eb_end = ppc_next_breakpoint(eb_start, eb_end);
+            }
         }
 
         opcode = ppc_read_instruction(pc_real);
+        if (trace)
+            ppc_trace_insn(ppc_state.pc, opcode);
         ppc_main_opcode(opcode_grabber, opcode);
+        if (trace)
+            ppc_trace_deltas();
         if (g_icycles++ >= max_cycles || exec_timer) [[unlikely]]
             max_cycles = process_events();
 
@@ -331,12 +355,11 @@ static void ppc_exec_inner(uint32_t start_addr, uint32_t size)
             }
             // define next execution block
             eb_start = ppc_next_instruction_address;
-            if (!(exec_flags & EXEF_RFI) && (eb_start & PPC_PAGE_MASK) == page_start) {
+            if (!(exec_flags & EXEF_RFI) && (eb_start & PPC_PAGE_MASK) == page_start &&
+                !bp_page) {
                 pc_real += (int)eb_start - (int)ppc_state.pc;
             } else {
-                page_start = eb_start & PPC_PAGE_MASK;
-                eb_end = page_start + PPC_PAGE_SIZE - 1;
-                pc_real = mmu_translate_imem(eb_start);
+                eb_end = 0; // let the loop head define a new block
             }
             ppc_state.pc = eb_start;
             exec_flags = 0;
@@ -355,6 +378,7 @@ static void ppc_exec_inner(uint32_t start_addr, uint32_t size)
 
 // inner interpreter loop
 template void ppc_exec_inner<main>(uint32_t start_addr, uint32_t size);
+template void ppc_exec_inner<main, true>(uint32_t start_addr, uint32_t size);
 
 // outer interpreter loop
 void ppc_exec()
@@ -366,7 +390,10 @@ void ppc_exec()
     }
 
     while (power_on) {
-        ppc_exec_inner<main>(0, 0);
+        if (ppc_trace_active())
+            ppc_exec_inner<main, true>(0, 0);
+        else
+            ppc_exec_inner<main>(0, 0);
     }
 }
 
@@ -399,6 +426,7 @@ void ppc_exec_single()
 
 // inner interpreter loop
 template void ppc_exec_inner<until>(uint32_t start_addr, uint32_t size);
+template void ppc_exec_inner<until, true>(uint32_t start_addr, uint32_t size);
 
 // outer interpreter loop
 void ppc_exec_until(volatile uint32_t goal_addr) {
@@ -409,7 +437,10 @@ void ppc_exec_until(volatile uint32_t goal_addr) {
     }
 
     while (power_on) {
-        ppc_exec_inner<until>(goal_addr, 0);
+        if (ppc_trace_active())
+            ppc_exec_inner<until, true>(goal_addr, 0);
+        else
+            ppc_exec_inner<until>(goal_addr, 0);
         if (ppc_state.pc == goal_addr)
             break;
     }
@@ -865,10 +896,8 @@ void ppc_cpu_init(MemCtrlBase* mem_ctrl, uint32_t cpu_version, bool do_include_6
     /* redirect code execution to reset vector */
     ppc_state.pc = 0xFFF00100;
 
-#ifdef CPU_PROFILING
     gProfilerObj->register_profile("PPC_CPU",
         std::unique_ptr<BaseProfile>(new CPUProfile()));
-#endif
 }
 
 static map<string, int> SPRName2Num = {
@@ -24,17 +24,17 @@ along with this program.  If not, see <https://www.gnu.org/licenses/>.
 #include <devices/memctrl/memctrlbase.h>
 #include <devices/common/mmiodevice.h>
 #include <memaccess.h>
+#include <utils/profiler.h>
+#include "ppcbreakpoints.h"
 #include "ppcemu.h"
 #include "ppcmmu.h"
 
 #include <array>
 #include <cinttypes>
 #include <loguru.hpp>
+#include <memory>
 #include <stdexcept>
 
-//#define MMU_PROFILING // uncomment this to enable MMU profiling
-//#define TLB_PROFILING // uncomment this to enable SoftTLB profiling
-
 /* pointer to exception handler to be called when a MMU exception is occurred. */
 void (*mmu_exception_handler)(Except_Type exception_type, uint32_t srr1_bits);
 
@@ -46,8 +46,6 @@ std::function<void(uint32_t bat_reg)> dbat_update;
 PPC_BAT_entry ibat_array[4] = {{0}};
 PPC_BAT_entry dbat_array[4] = {{0}};
 
-#ifdef MMU_PROFILING
-
 /* global variables for lightweight MMU profiling */
 uint64_t    dmem_reads_total   = 0; // counts reads from data memory
 uint64_t    iomem_reads_total  = 0; // counts I/O memory reads
@@ -61,10 +59,6 @@ uint64_t    unaligned_writes   = 0; // counts unaligned writes
 uint64_t    unaligned_crossp_r = 0; // counts unaligned crosspage reads
 uint64_t    unaligned_crossp_w = 0; // counts unaligned crosspage writes
 
-#endif // MMU_PROFILING
-
-#ifdef TLB_PROFILING
-
 /* global variables for lightweight SoftTLB profiling */
 uint64_t    num_primary_itlb_hits   = 0; // number of hits in the primary ITLB
 uint64_t    num_secondary_itlb_hits = 0; // number of hits in the secondary ITLB
@@ -74,8 +68,6 @@ uint64_t    num_secondary_dtlb_hits = 0; // number of hits in the secondary DTLB
 uint64_t    num_dtlb_refills        = 0; // number of DTLB refills
 uint64_t    num_entry_replacements  = 0; // number of entry replacements
 
-#endif // TLB_PROFILING
-
 /** remember recently used physical memory regions for quicker translation. */
 AddressMapEntry last_read_area;
 AddressMapEntry last_write_area;
@@ -115,9 +107,7 @@ static BATResult mpc601_block_address_translation(uint32_t la)
 
             prot = access_conv[(key << 2) | bat_entry->prot];
 
-#ifdef MMU_PROFILING
-            bat_transl_total++;
-#endif
+            PROF_INC(bat_transl_total);
 
             // logical to physical translation
             pa = bat_entry->phys_hi | (la & ~bat_entry->hi_mask);
@@ -152,9 +142,7 @@ static BATResult ppc_block_address_translation(uint32_t la)
         if ((bat_entry->access & access_bits) != 0 && ((la & bat_entry->hi_mask) == bat_entry->bepi)) {
             bat_hit = true;
 
-#ifdef MMU_PROFILING
-            bat_transl_total++;
-#endif
+            PROF_INC(bat_transl_total);
             // logical to physical translation
             pa = bat_entry->phys_hi | (la & ~bat_entry->hi_mask);
             prot = bat_entry->prot;
@@ -234,6 +222,8 @@ static PATResult page_address_translation(uint32_t la, bool is_instr_fetch,
     unsigned key, pp;
     uint8_t* pte_addr;
 
+    PROF_INC(ptab_transl_total);
+
     sr_val = ppc_state.sr[(la >> 28) & 0x0F];
     if (sr_val & 0x80000000) {
         // check for 601-specific memory-forced I/O segments
@@ -469,9 +459,7 @@ static TLBEntry* tlb2_target_entry(uint32_t gp_va)
         tlb_entry[3].lru_bits  = 0x3;
         return &tlb_entry[3];
     } else { // no free entries, replace an existing one according with the hLRU policy
-#ifdef TLB_PROFILING
-        num_entry_replacements++;
-#endif
+        PROF_INC(num_entry_replacements);
         if (tlb_entry[0].lru_bits == 0) {
             // update LRU bits
             tlb_entry[0].lru_bits  = 0x3;
@@ -548,6 +536,8 @@ static TLBEntry* itlb2_refill(uint32_t guest_va)
         tlb_entry = tlb2_target_entry<TLBType::ITLB>(tag);
         tlb_entry->tag = tag;
         tlb_entry->flags = flags | TLBFlags::PAGE_MEM;
+        if (ppc_page_has_breakpoints(tag))
+            tlb_entry->flags |= TLBFlags::PAGE_BREAKPOINT;
         tlb_entry->host_va_offs_r = (int64_t)rgn_desc->mem_ptr - guest_va +
                                     (phys_addr - rgn_desc->start);
         tlb_entry->phys_tag = phys_addr & ~0xFFFUL;
@@ -633,6 +623,8 @@ static TLBEntry* dtlb2_refill(uint32_t guest_va, int is_write, bool is_dbg = fal
                 tlb_entry->host_va_offs_w = tlb_entry->host_va_offs_r;
             }
         }
+        if (ppc_page_is_watched(tag))
+            tlb_entry->flags |= TLBFlags::PAGE_WATCHED;
         tlb_entry->phys_tag = phys_addr & ~0xFFFUL;
         return tlb_entry;
     } else {
@@ -695,40 +687,32 @@ static inline TLBEntry* lookup_secondary_tlb(uint32_t guest_va, uint32_t tag) {
     return tlb_entry;
 }
 
-uint8_t *mmu_translate_imem(uint32_t vaddr, uint32_t *paddr)
+uint8_t *mmu_translate_imem(uint32_t vaddr, uint32_t *paddr, uint16_t *flags)
 {
     TLBEntry *tlb1_entry, *tlb2_entry;
     uint8_t *host_va;
 
-#ifdef MMU_PROFILING
-    exec_reads_total++;
-#endif
+    PROF_INC(exec_reads_total);
 
     const uint32_t tag = vaddr & ~0xFFFUL;
 
     // look up guest virtual address in the primary ITLB
     tlb1_entry = &pCurITLB1[(vaddr >> PPC_PAGE_SIZE_BITS) & tlb_size_mask];
     if (tlb1_entry->tag == tag) { // primary ITLB hit -> fast path
-#ifdef TLB_PROFILING
-        num_primary_itlb_hits++;
-#endif
+        PROF_INC(num_primary_itlb_hits);
         host_va = (uint8_t *)(tlb1_entry->host_va_offs_r + vaddr);
     } else {
         // primary ITLB miss -> look up address in the secondary ITLB
         tlb2_entry = lookup_secondary_tlb<TLBType::ITLB>(vaddr, tag);
         if (tlb2_entry == nullptr) {
-#ifdef TLB_PROFILING
-            num_itlb_refills++;
-#endif
+            PROF_INC(num_itlb_refills);
             // secondary ITLB miss ->
             // perform full address translation and refill the secondary ITLB
             tlb2_entry = itlb2_refill(vaddr);
         }
-#ifdef TLB_PROFILING
         else {
-            num_secondary_itlb_hits++;
+            PROF_INC(num_secondary_itlb_hits);
         }
-#endif
         // refill the primary ITLB
         tlb1_entry->tag = tag;
         tlb1_entry->flags = tlb2_entry->flags;
@@ -739,6 +723,8 @@ uint8_t *mmu_translate_imem(uint32_t vaddr, uint32_t *paddr)
 
     if (paddr)
         *paddr = tlb1_entry->phys_tag | (vaddr & 0xFFFUL);
+    if (flags)
+        *flags = tlb1_entry->flags;
 
     return host_va;
 }
@@ -995,17 +981,13 @@ inline T mmu_read_vmem(uint32_t opcode, uint32_t guest_va)
     // look up guest virtual address in the primary TLB
     tlb1_entry = &pCurDTLB1[(guest_va >> PPC_PAGE_SIZE_BITS) & tlb_size_mask];
     if (tlb1_entry->tag == tag) { // primary TLB hit -> fast path
-#ifdef TLB_PROFILING
-        num_primary_dtlb_hits++;
-#endif
+        PROF_INC(num_primary_dtlb_hits);
         host_va = (uint8_t *)(tlb1_entry->host_va_offs_r + guest_va);
     } else {
         // primary TLB miss -> look up address in the secondary TLB
         tlb2_entry = lookup_secondary_tlb<TLBType::DTLB>(guest_va, tag);
         if (tlb2_entry == nullptr) {
-#ifdef TLB_PROFILING
-            num_dtlb_refills++;
-#endif
+            PROF_INC(num_dtlb_refills);
             // secondary TLB miss ->
             // perform full address translation and refill the secondary TLB
             tlb2_entry = dtlb2_refill(guest_va, 0);
@@ -1013,20 +995,22 @@ inline T mmu_read_vmem(uint32_t opcode, uint32_t guest_va)
                 return (T)UnmappedVal;
             }
         }
-#ifdef TLB_PROFILING
         else {
-            num_secondary_dtlb_hits++;
+            PROF_INC(num_secondary_dtlb_hits);
         }
-#endif
+
+        // watched pages are kept out of the primary TLB
+        // so every guest access to them ends up here
+        if ((tlb2_entry->flags & TLBFlags::PAGE_WATCHED) && opcode != NO_OPCODE)
+            ppc_watch_check(guest_va, sizeof(T), false);
 
         if (tlb2_entry->flags & TLBFlags::PAGE_MEM) { // is it a real memory region?
             // refill the primary TLB
-            *tlb1_entry = *tlb2_entry;
-            host_va = (uint8_t *)(tlb1_entry->host_va_offs_r + guest_va);
+            if (!(tlb2_entry->flags & TLBFlags::PAGE_WATCHED))
+                *tlb1_entry = *tlb2_entry;
+            host_va = (uint8_t *)(tlb2_entry->host_va_offs_r + guest_va);
         } else { // otherwise, it's an access to a memory-mapped device
-#ifdef MMU_PROFILING
-            iomem_reads_total++;
-#endif
+            PROF_INC(iomem_reads_total);
             if (sizeof(T) == 8) {
                 if (guest_va & 3)
                     ppc_alignment_exception(opcode, guest_va);
@@ -1050,9 +1034,7 @@ inline T mmu_read_vmem(uint32_t opcode, uint32_t guest_va)
         }
     }
 
-#ifdef MMU_PROFILING
-    dmem_reads_total++;
-#endif
+    PROF_INC(dmem_reads_total);
 
     // handle unaligned memory accesses
     if (sizeof(T) > 1 && (guest_va & (sizeof(T) - 1))) {
@@ -1089,9 +1071,7 @@ inline void mmu_write_vmem(uint32_t opcode, uint32_t guest_va, T value)
     // look up guest virtual address in the primary TLB
     tlb1_entry = &pCurDTLB1[(guest_va >> PPC_PAGE_SIZE_BITS) & tlb_size_mask];
     if (tlb1_entry->tag == tag) { // primary TLB hit -> fast path
-#ifdef TLB_PROFILING
-        num_primary_dtlb_hits++;
-#endif
+        PROF_INC(num_primary_dtlb_hits);
         if (!(tlb1_entry->flags & TLBFlags::PAGE_WRITABLE)) {
             ppc_state.spr[SPR::DSISR] = 0x08000000 | (1 << 25);
             ppc_state.spr[SPR::DAR]   = guest_va;
@@ -1113,9 +1093,7 @@ inline void mmu_write_vmem(uint32_t opcode, uint32_t guest_va, T value)
         // primary TLB miss -> look up address in the secondary TLB
         tlb2_entry = lookup_secondary_tlb<TLBType::DTLB>(guest_va, tag);
         if (tlb2_entry == nullptr) {
-#ifdef TLB_PROFILING
-            num_dtlb_refills++;
-#endif
+            PROF_INC(num_dtlb_refills);
             // secondary TLB miss ->
             // perform full address translation and refill the secondary TLB
             tlb2_entry = dtlb2_refill(guest_va, 1);
@@ -1123,11 +1101,9 @@ inline void mmu_write_vmem(uint32_t opcode, uint32_t guest_va, T value)
                 return;
             }
         }
-#ifdef TLB_PROFILING
         else {
-            num_secondary_dtlb_hits++;
+            PROF_INC(num_secondary_dtlb_hits);
         }
-#endif
 
         if (!(tlb2_entry->flags & TLBFlags::PAGE_WRITABLE)) {
             ppc_state.spr[SPR::DSISR] = 0x08000000 | (1 << 25);
@@ -1141,14 +1117,16 @@ inline void mmu_write_vmem(uint32_t opcode, uint32_t guest_va, T value)
             tlb2_entry->flags |= TLBFlags::PTE_SET_C;
         }
 
+        if ((tlb2_entry->flags & TLBFlags::PAGE_WATCHED) && opcode != NO_OPCODE)
+            ppc_watch_check(guest_va, sizeof(T), true);
+
         if (tlb2_entry->flags & TLBFlags::PAGE_MEM) { // is it a real memory region?
             // refill the primary TLB
-            *tlb1_entry = *tlb2_entry;
-            host_va = (uint8_t *)(tlb1_entry->host_va_offs_w + guest_va);
+            if (!(tlb2_entry->flags & TLBFlags::PAGE_WATCHED))
+                *tlb1_entry = *tlb2_entry;
+            host_va = (uint8_t *)(tlb2_entry->host_va_offs_w + guest_va);
         } else { // otherwise, it's an access to a memory-mapped device
-#ifdef MMU_PROFILING
-            iomem_writes_total++;
-#endif
+            PROF_INC(iomem_writes_total);
             if (sizeof(T) == 8) {
                 if (guest_va & 3)
                     ppc_alignment_exception(opcode, guest_va);
@@ -1168,9 +1146,7 @@ inline void mmu_write_vmem(uint32_t opcode, uint32_t guest_va, T value)
         }
     }
 
-#ifdef MMU_PROFILING
-    dmem_writes_total++;
-#endif
+    PROF_INC(dmem_writes_total);
 
     // handle unaligned memory accesses
     if (sizeof(T) > 1 && (guest_va & (sizeof(T) - 1))) {
@@ -1214,9 +1190,7 @@ static T read_unaligned(uint32_t opcode, uint32_t guest_va, uint8_t *host_va)
 
     // is it a misaligned cross-page read?
     if ((sizeof(T) > 1) && ((guest_va & 0xFFF) + sizeof(T)) > 0x1000) {
-#ifdef MMU_PROFILING
-        unaligned_crossp_r++;
-#endif
+        PROF_INC(unaligned_crossp_r);
         // Break such a memory access into multiple, bytewise accesses.
         // Because such accesses suffer a performance penalty, they will be
         // presumably very rare so don't waste time optimizing the code below.
@@ -1224,9 +1198,7 @@ static T read_unaligned(uint32_t opcode, uint32_t guest_va, uint8_t *host_va)
             result = (result << 8) | mmu_read_vmem<uint8_t>(opcode, guest_va);
         }
     } else {
-#ifdef MMU_PROFILING
-        unaligned_reads++;
-#endif
+        PROF_INC(unaligned_reads);
         switch(sizeof(T)) {
             case 1:
                 return *host_va;
@@ -1257,9 +1229,7 @@ static void write_unaligned(uint32_t opcode, uint32_t guest_va, uint8_t *host_va
 
     // is it a misaligned cross-page write?
     if ((sizeof(T) > 1) && ((guest_va & 0xFFF) + sizeof(T)) > 0x1000) {
-#ifdef MMU_PROFILING
-        unaligned_crossp_w++;
-#endif
+        PROF_INC(unaligned_crossp_w);
         // Break such a memory access into multiple, bytewise accesses.
         // Because such accesses suffer a performance penalty, they will be
         // presumably very rare so don't waste time optimizing the code below.
@@ -1270,9 +1240,7 @@ static void write_unaligned(uint32_t opcode, uint32_t guest_va, uint8_t *host_va
             mmu_write_vmem<uint8_t>(opcode, guest_va, (value >> shift) & 0xFF);
         }
     } else {
-#ifdef MMU_PROFILING
-        unaligned_writes++;
-#endif
+        PROF_INC(unaligned_writes);
         switch(sizeof(T)) {
             case 1:
                 *host_va = value;
@@ -1297,11 +1265,6 @@ template void write_unaligned<uint64_t>(uint32_t opcode, uint32_t guest_va, uint
 
 
 /* MMU profiling. */
-#ifdef MMU_PROFILING
-
-#include "utils/profiler.h"
-#include <memory>
-
 class MMUProfile : public BaseProfile {
 public:
     MMUProfile() : BaseProfile("PPC_MMU") {};
@@ -1368,14 +1331,8 @@ public:
         unaligned_crossp_w = 0;
     };
 };
-#endif
 
 /* SoftTLB profiling. */
-#ifdef TLB_PROFILING
-
-#include "utils/profiler.h"
-#include <memory>
-
 class TLBProfile : public BaseProfile {
 public:
     TLBProfile() : BaseProfile("PPC:MMU:TLB") {};
@@ -1413,13 +1370,15 @@ public:
     };
 
     void reset() {
+        num_primary_itlb_hits   = 0;
+        num_secondary_itlb_hits = 0;
+        num_itlb_refills        = 0;
         num_primary_dtlb_hits   = 0;
         num_secondary_dtlb_hits = 0;
         num_dtlb_refills        = 0;
-        num_entry_replacements = 0;
+        num_entry_replacements  = 0;
     };
 };
-#endif
 
 uint64_t mem_read_dbg(uint32_t virt_addr, uint32_t size) {
     uint32_t save_dsisr, save_dar;
@@ -1538,7 +1497,8 @@ bool mmu_translate_dbg(uint32_t guest_va, uint32_t &guest_pa) {
                     }
                 }
 
-                if (tlb2_entry->flags & TLBFlags::PAGE_MEM) { // is it a real memory region?
+                if ((tlb2_entry->flags & (TLBFlags::PAGE_MEM | TLBFlags::PAGE_WATCHED)) ==
+                    TLBFlags::PAGE_MEM) { // is it a real memory region?
                     // refill the primary TLB
                     *tlb1_entry = *tlb2_entry;
                 }
@@ -1562,6 +1522,67 @@ bool mmu_translate_dbg(uint32_t guest_va, uint32_t &guest_pa) {
     return is_mapped;
 }
 
+uint8_t *mmu_peek_mem(uint32_t guest_va) {
+    // Neither TLBs nor PTEs are updated and no exceptions are raised so
+    // profilers can look at guest memory without changing guest state.
+    // MMIO is never touched.
+    const uint32_t tag = guest_va & ~0xFFFUL;
+
+    TLBEntry *tlb_entry = &pCurDTLB1[(guest_va >> PPC_PAGE_SIZE_BITS) & tlb_size_mask];
+    if (tlb_entry->tag != tag) {
+        tlb_entry = &pCurDTLB2[((guest_va >> PPC_PAGE_SIZE_BITS) & tlb_size_mask) * TLB2_WAYS];
+        int way = 0;
+        while (way < TLB2_WAYS && tlb_entry[way].tag != tag)
+            way++;
+        tlb_entry = way < TLB2_WAYS ? &tlb_entry[way] : nullptr;
+    }
+    if (tlb_entry) {
+        if (!(tlb_entry->flags & TLBFlags::PAGE_MEM))
+            return nullptr;
+        return (uint8_t *)(tlb_entry->host_va_offs_r + guest_va);
+    }
+
+    uint32_t phys_addr = guest_va;
+
+    if (ppc_state.msr & MSR::DR) {
+        BATResult bat_res = is_601 ? mpc601_block_address_translation(guest_va) :
+                                     ppc_block_address_translation<BATType::DBAT>(guest_va);
+        if (bat_res.hit) {
+            if (!bat_res.prot)
+                return nullptr;
+            phys_addr = bat_res.phys;
+        } else {
+            uint32_t sr_val = ppc_state.sr[(guest_va >> 28) & 0x0F];
+            if (sr_val & 0x80000000) // I/O controller interface segment
+                return nullptr;
+
+            uint32_t page_index = (guest_va >> 12) & 0xFFFF;
+            uint32_t pteg_hash1 = (sr_val & 0x7FFFF) ^ page_index;
+            uint32_t vsid       = sr_val & 0x0FFFFFF;
+            uint8_t* pte_addr;
+
+            if (!search_pteg(calc_pteg_addr(pteg_hash1), &pte_addr, vsid, page_index, 0) &&
+                !search_pteg(calc_pteg_addr(~pteg_hash1), &pte_addr, vsid, page_index, 1))
+                return nullptr;
+
+            uint32_t pte_word2 = READ_DWORD_BE_A(pte_addr + 4);
+            unsigned msr_pr    = !!(ppc_state.msr & MSR::PR);
+            unsigned key       = (((sr_val >> 29) & 1) & msr_pr) |
+                                 (((sr_val >> 30) & 1) & (msr_pr ^ 1));
+            if (key && !(pte_word2 & 3))
+                return nullptr;
+
+            phys_addr = (pte_word2 & 0xFFFFF000) | (guest_va & 0xFFF);
+        }
+    }
+
+    AddressMapEntry* rgn_desc = mem_ctrl_instance->find_range(phys_addr);
+    if (!rgn_desc || !(rgn_desc->type & (RT_ROM | RT_RAM)))
+        return nullptr;
+
+    return rgn_desc->mem_ptr + (phys_addr - rgn_desc->start);
+}
+
 template <std::size_t N>
 static void invalidate_tlb_entries(std::array<TLBEntry, N> &tlb) {
     for (auto &tlb_el : tlb) {
@@ -1610,13 +1631,9 @@ void ppc_mmu_init()
 
     mmu_change_mode();
 
-#ifdef MMU_PROFILING
     gProfilerObj->register_profile("PPC:MMU",
         std::unique_ptr<BaseProfile>(new MMUProfile()));
-#endif
 
-#ifdef TLB_PROFILING
     gProfilerObj->register_profile("PPC:MMU:TLB",
-    std::unique_ptr<BaseProfile>(new TLBProfile()));
-#endif
+        std::unique_ptr<BaseProfile>(new TLBProfile()));
 }
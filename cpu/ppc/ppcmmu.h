@@ -114,6 +114,8 @@ enum TLBFlags : uint16_t {
     TLBE_FROM_PAT = 1 << 4, // TLB entry has been translated with PAT
     PAGE_WRITABLE = 1 << 5, // page is writable
     PTE_SET_C     = 1 << 6, // tells if C bit of the PTE needs to be updated
+    PAGE_BREAKPOINT = 1 << 7, // ITLB only: page contains instruction breakpoints
+    PAGE_WATCHED  = 1 << 8, // DTLB only: page is covered by a watchpoint
 };
 
 extern std::function<void(uint32_t bat_reg)> ibat_update;
@@ -127,8 +129,10 @@ extern void tlb_flush_entry(uint32_t ea);
 
 extern uint64_t mem_read_dbg(uint32_t virt_addr, uint32_t size);
 extern void mem_write_dbg(uint32_t virt_addr, uint64_t value, int size);
-uint8_t *mmu_translate_imem(uint32_t vaddr, uint32_t *paddr = nullptr);
+uint8_t *mmu_translate_imem(uint32_t vaddr, uint32_t *paddr = nullptr, uint16_t *flags = nullptr);
 bool mmu_translate_dbg(uint32_t guest_va, uint32_t &guest_pa);
+// side-effect-free data translation, returns nullptr unless backed by host memory
+uint8_t *mmu_peek_mem(uint32_t guest_va);
 
 template <class T>
 extern T mmu_read_vmem(uint32_t opcode, uint32_t guest_va);
@@ -26,6 +26,7 @@ along with this program.  If not, see <https://www.gnu.org/licenses/>.
 #include "ppcemu.h"
 #include "ppcmacros.h"
 #include "ppcmmu.h"
+#include <utils/profiler.h>
 #include <cinttypes>
 #include <vector>
 
@@ -729,9 +730,7 @@ void dppc_interpreter::ppc_mfcr(uint32_t opcode) {
 }
 
 void dppc_interpreter::ppc_mtsr(uint32_t opcode) {
-#ifdef CPU_PROFILING
-    num_supervisor_instrs++;
-#endif
+    PROF_INC(num_supervisor_instrs);
     if (ppc_state.msr & MSR::PR) {
         ppc_exception_handler(Except_Type::EXC_PROGRAM, Exc_Cause::NOT_ALLOWED);
     }
@@ -744,9 +743,7 @@ void dppc_interpreter::ppc_mtsr(uint32_t opcode) {
 }
 
 void dppc_interpreter::ppc_mtsrin(uint32_t opcode) {
-#ifdef CPU_PROFILING
-    num_supervisor_instrs++;
-#endif
+    PROF_INC(num_supervisor_instrs);
     if (ppc_state.msr & MSR::PR) {
         ppc_exception_handler(Except_Type::EXC_PROGRAM, Exc_Cause::NOT_ALLOWED);
     }
@@ -759,9 +756,7 @@ void dppc_interpreter::ppc_mtsrin(uint32_t opcode) {
 }
 
 void dppc_interpreter::ppc_mfsr(uint32_t opcode) {
-#ifdef CPU_PROFILING
-    num_supervisor_instrs++;
-#endif
+    PROF_INC(num_supervisor_instrs);
     if (ppc_state.msr & MSR::PR) {
         ppc_exception_handler(Except_Type::EXC_PROGRAM, Exc_Cause::NOT_ALLOWED);
     }
@@ -771,9 +766,7 @@ void dppc_interpreter::ppc_mfsr(uint32_t opcode) {
 }
 
 void dppc_interpreter::ppc_mfsrin(uint32_t opcode) {
-#ifdef CPU_PROFILING
-    num_supervisor_instrs++;
-#endif
+    PROF_INC(num_supervisor_instrs);
     if (ppc_state.msr & MSR::PR) {
         ppc_exception_handler(Except_Type::EXC_PROGRAM, Exc_Cause::NOT_ALLOWED);
     }
@@ -783,9 +776,7 @@ void dppc_interpreter::ppc_mfsrin(uint32_t opcode) {
 }
 
 void dppc_interpreter::ppc_mfmsr(uint32_t opcode) {
-#ifdef CPU_PROFILING
-    num_supervisor_instrs++;
-#endif
+    PROF_INC(num_supervisor_instrs);
     if (ppc_state.msr & MSR::PR) {
         ppc_exception_handler(Except_Type::EXC_PROGRAM, Exc_Cause::NOT_ALLOWED);
     }
@@ -794,9 +785,7 @@ void dppc_interpreter::ppc_mfmsr(uint32_t opcode) {
 }
 
 void dppc_interpreter::ppc_mtmsr(uint32_t opcode) {
-#ifdef CPU_PROFILING
-    num_supervisor_instrs++;
-#endif
+    PROF_INC(num_supervisor_instrs);
     if (ppc_state.msr & MSR::PR) {
         ppc_exception_handler(Except_Type::EXC_PROGRAM, Exc_Cause::NOT_ALLOWED);
     }
@@ -904,9 +893,7 @@ void dppc_interpreter::ppc_mfspr(uint32_t opcode) {
     uint32_t ref_spr = (reg_b << 5) | reg_a;
 
     if (ref_spr & 0x10) {
-#ifdef CPU_PROFILING
-        num_supervisor_instrs++;
-#endif
+        PROF_INC(num_supervisor_instrs);
         if (ppc_state.msr & MSR::PR) {
             ppc_exception_handler(Except_Type::EXC_PROGRAM, Exc_Cause::NOT_ALLOWED);
         }
@@ -956,9 +943,7 @@ void dppc_interpreter::ppc_mtspr(uint32_t opcode) {
     uint32_t ref_spr = (reg_b << 5) | reg_a;
 
     if (ref_spr & 0x10) {
-#ifdef CPU_PROFILING
-        num_supervisor_instrs++;
-#endif
+        PROF_INC(num_supervisor_instrs);
         if (ppc_state.msr & MSR::PR) {
             ppc_exception_handler(Except_Type::EXC_PROGRAM, Exc_Cause::NOT_ALLOWED);
         }
@@ -1375,9 +1360,7 @@ void dppc_interpreter::ppc_crxor(uint32_t opcode) {
 // Processor MGMT Fns.
 
 void dppc_interpreter::ppc_rfi(uint32_t opcode) {
-#ifdef CPU_PROFILING
-    num_supervisor_instrs++;
-#endif
+    PROF_INC(num_supervisor_instrs);
     if (ppc_state.msr & MSR::PR) {
         ppc_exception_handler(Except_Type::EXC_PROGRAM, Exc_Cause::NOT_ALLOWED);
         return;
@@ -1469,9 +1452,7 @@ void dppc_interpreter::ppc_dcbf(uint32_t opcode) {
 }
 
 void dppc_interpreter::ppc_dcbi(uint32_t opcode) {
-#ifdef CPU_PROFILING
-    num_supervisor_instrs++;
-#endif
+    PROF_INC(num_supervisor_instrs);
     /* placeholder */
     if (ppc_state.msr & MSR::PR) {
         ppc_exception_handler(Except_Type::EXC_PROGRAM, Exc_Cause::NOT_ALLOWED);
@@ -1512,9 +1493,7 @@ void dppc_interpreter::ppc_dcbz(uint32_t opcode) {
 
 template <class T>
 void dppc_interpreter::ppc_st(uint32_t opcode) {
-#ifdef CPU_PROFILING
-    num_int_stores++;
-#endif
+    PROF_INC(num_int_stores);
     ppc_grab_regssa(opcode);
     uint32_t ea = int32_t(int16_t(opcode));
     ea += reg_a ? ppc_result_a : 0;
@@ -1527,9 +1506,7 @@ template void dppc_interpreter::ppc_st<uint32_t>(uint32_t opcode);
 
 template <class T>
 void dppc_interpreter::ppc_stx(uint32_t opcode) {
-#ifdef CPU_PROFILING
-    num_int_stores++;
-#endif
+    PROF_INC(num_int_stores);
     ppc_grab_regssab(opcode);
     uint32_t ea = ppc_result_b + (reg_a ? ppc_result_a : 0);
     mmu_write_vmem<T>(opcode, ea, ppc_result_d);
@@ -1541,9 +1518,7 @@ template void dppc_interpreter::ppc_stx<uint32_t>(uint32_t opcode);
 
 template <class T>
 void dppc_interpreter::ppc_stu(uint32_t opcode) {
-#ifdef CPU_PROFILING
-    num_int_stores++;
-#endif
+    PROF_INC(num_int_stores);
     ppc_grab_regssa(opcode);
 
     if (reg_a != 0) {
@@ -1564,9 +1539,7 @@ template void dppc_interpreter::ppc_stu<uint32_t>(uint32_t opcode);
 
 template <class T>
 void dppc_interpreter::ppc_stux(uint32_t opcode) {
-#ifdef CPU_PROFILING
-    num_int_stores++;
-#endif
+    PROF_INC(num_int_stores);
     ppc_grab_regssab(opcode);
 
     if (reg_a != 0) {
@@ -1584,9 +1557,7 @@ template void dppc_interpreter::ppc_stux<uint16_t>(uint32_t opcode);
 template void dppc_interpreter::ppc_stux<uint32_t>(uint32_t opcode);
 
 void dppc_interpreter::ppc_sthbrx(uint32_t opcode) {
-#ifdef CPU_PROFILING
-    num_int_stores++;
-#endif
+    PROF_INC(num_int_stores);
     ppc_grab_regssab(opcode);
     uint32_t ea = ppc_result_b + (reg_a ? ppc_result_a : 0);
     ppc_result_d = uint32_t(BYTESWAP_16(uint16_t(ppc_result_d)));
@@ -1594,9 +1565,7 @@ void dppc_interpreter::ppc_sthbrx(uint32_t opcode) {
 }
 
 void dppc_interpreter::ppc_stwcx(uint32_t opcode) {
-#ifdef CPU_PROFILING
-    num_int_stores++;
-#endif
+    PROF_INC(num_int_stores);
     ppc_grab_regssab(opcode);
     uint32_t ea = (reg_a == 0) ? ppc_result_b : (ppc_result_a + ppc_result_b);
     ppc_state.cr &= 0x0FFFFFFFUL; // clear CR0
@@ -1609,9 +1578,7 @@ void dppc_interpreter::ppc_stwcx(uint32_t opcode) {
 }
 
 void dppc_interpreter::ppc_stwbrx(uint32_t opcode) {
-#ifdef CPU_PROFILING
-    num_int_stores++;
-#endif
+    PROF_INC(num_int_stores);
     ppc_grab_regssab(opcode);
     uint32_t ea = ppc_result_b + (reg_a ? ppc_result_a : 0);
     ppc_result_d          = BYTESWAP_32(ppc_result_d);
@@ -1619,9 +1586,7 @@ void dppc_interpreter::ppc_stwbrx(uint32_t opcode) {
 }
 
 void dppc_interpreter::ppc_stmw(uint32_t opcode) {
-#ifdef CPU_PROFILING
-    num_int_stores++;
-#endif
+    PROF_INC(num_int_stores);
     ppc_grab_regssa_stmw(opcode);
     uint32_t ea = int32_t(int16_t(opcode));
     ea += reg_a ? ppc_result_a : 0;
@@ -1639,9 +1604,7 @@ void dppc_interpreter::ppc_stmw(uint32_t opcode) {
 
 template <class T>
 void dppc_interpreter::ppc_lz(uint32_t opcode) {
-#ifdef CPU_PROFILING
-    num_int_loads++;
-#endif
+    PROF_INC(num_int_loads);
     ppc_grab_regsda(opcode);
     uint32_t ea = int32_t(int16_t(opcode));
     ea += reg_a ? ppc_result_a : 0;
@@ -1655,9 +1618,7 @@ template void dppc_interpreter::ppc_lz<uint32_t>(uint32_t opcode);
 
 template <class T>
 void dppc_interpreter::ppc_lzu(uint32_t opcode) {
-#ifdef CPU_PROFILING
-    num_int_loads++;
-#endif
+    PROF_INC(num_int_loads);
     ppc_grab_regsda(opcode);
     uint32_t ea = int32_t(int16_t(opcode));
     if ((reg_a != reg_d) && reg_a != 0) {
@@ -1677,9 +1638,7 @@ template void dppc_interpreter::ppc_lzu<uint32_t>(uint32_t opcode);
 
 template <class T>
 void dppc_interpreter::ppc_lzx(uint32_t opcode) {
-#ifdef CPU_PROFILING
-    num_int_loads++;
-#endif
+    PROF_INC(num_int_loads);
     ppc_grab_regsdab(opcode);
     uint32_t ea = ppc_result_b + (reg_a ? ppc_result_a : 0);
     uint32_t ppc_result_d = mmu_read_vmem<T>(opcode, ea);
@@ -1692,9 +1651,7 @@ template void dppc_interpreter::ppc_lzx<uint32_t>(uint32_t opcode);
 
 template <class T>
 void dppc_interpreter::ppc_lzux(uint32_t opcode) {
-#ifdef CPU_PROFILING
-    num_int_loads++;
-#endif
+    PROF_INC(num_int_loads);
     ppc_grab_regsdab(opcode);
     if ((reg_a != reg_d) && reg_a != 0) {
         uint32_t ea = ppc_result_a + ppc_result_b;
@@ -1712,9 +1669,7 @@ template void dppc_interpreter::ppc_lzux<uint16_t>(uint32_t opcode);
 template void dppc_interpreter::ppc_lzux<uint32_t>(uint32_t opcode);
 
 void dppc_interpreter::ppc_lha(uint32_t opcode) {
-#ifdef CPU_PROFILING
-    num_int_loads++;
-#endif
+    PROF_INC(num_int_loads);
     ppc_grab_regsda(opcode);
     uint32_t ea = int32_t(int16_t(opcode));
     ea += (reg_a ? ppc_result_a : 0);
@@ -1723,9 +1678,7 @@ void dppc_interpreter::ppc_lha(uint32_t opcode) {
 }
 
 void dppc_interpreter::ppc_lhau(uint32_t opcode) {
-#ifdef CPU_PROFILING
-    num_int_loads++;
-#endif
+    PROF_INC(num_int_loads);
     ppc_grab_regsda(opcode);
     if ((reg_a != reg_d) && reg_a != 0) {
         uint32_t ea = int32_t(int16_t(opcode));
@@ -1740,9 +1693,7 @@ void dppc_interpreter::ppc_lhau(uint32_t opcode) {
 }
 
 void dppc_interpreter::ppc_lhaux(uint32_t opcode) {
-#ifdef CPU_PROFILING
-    num_int_loads++;
-#endif
+    PROF_INC(num_int_loads);
     ppc_grab_regsdab(opcode);
     if ((reg_a != reg_d) && reg_a != 0) {
         uint32_t ea = ppc_result_a + ppc_result_b;
@@ -1757,9 +1708,7 @@ void dppc_interpreter::ppc_lhaux(uint32_t opcode) {
 }
 
 void dppc_interpreter::ppc_lhax(uint32_t opcode) {
-#ifdef CPU_PROFILING
-    num_int_loads++;
-#endif
+    PROF_INC(num_int_loads);
     ppc_grab_regsdab(opcode);
     uint32_t ea = ppc_result_b + (reg_a ? ppc_result_a : 0);
     int16_t val = mmu_read_vmem<uint16_t>(opcode, ea);
@@ -1767,9 +1716,7 @@ void dppc_interpreter::ppc_lhax(uint32_t opcode) {
 }
 
 void dppc_interpreter::ppc_lhbrx(uint32_t opcode) {
-#ifdef CPU_PROFILING
-    num_int_loads++;
-#endif
+    PROF_INC(num_int_loads);
     ppc_grab_regsdab(opcode);
     uint32_t ea = ppc_result_b + (reg_a ? ppc_result_a : 0);
     uint32_t ppc_result_d = uint32_t(BYTESWAP_16(mmu_read_vmem<uint16_t>(opcode, ea)));
@@ -1777,9 +1724,7 @@ void dppc_interpreter::ppc_lhbrx(uint32_t opcode) {
 }
 
 void dppc_interpreter::ppc_lwbrx(uint32_t opcode) {
-#ifdef CPU_PROFILING
-    num_int_loads++;
-#endif
+    PROF_INC(num_int_loads);
     ppc_grab_regsdab(opcode);
     uint32_t ea = ppc_result_b + (reg_a ? ppc_result_a : 0);
     uint32_t ppc_result_d = BYTESWAP_32(mmu_read_vmem<uint32_t>(opcode, ea));
@@ -1787,9 +1732,7 @@ void dppc_interpreter::ppc_lwbrx(uint32_t opcode) {
 }
 
 void dppc_interpreter::ppc_lwarx(uint32_t opcode) {
-#ifdef CPU_PROFILING
-    num_int_loads++;
-#endif
+    PROF_INC(num_int_loads);
     // Placeholder - Get the reservation of memory implemented!
     ppc_grab_regsdab(opcode);
     uint32_t ea = ppc_result_b + (reg_a ? ppc_result_a : 0);
@@ -1799,9 +1742,7 @@ void dppc_interpreter::ppc_lwarx(uint32_t opcode) {
 }
 
 void dppc_interpreter::ppc_lmw(uint32_t opcode) {
-#ifdef CPU_PROFILING
-    num_int_loads++;
-#endif
+    PROF_INC(num_int_loads);
     ppc_grab_regsda(opcode);
     uint32_t ea = int32_t(int16_t(opcode));
     ea += (reg_a ? ppc_result_a : 0);
@@ -1814,9 +1755,7 @@ void dppc_interpreter::ppc_lmw(uint32_t opcode) {
 }
 
 void dppc_interpreter::ppc_lswi(uint32_t opcode) {
-#ifdef CPU_PROFILING
-    num_int_loads++;
-#endif
+    PROF_INC(num_int_loads);
     ppc_grab_regsda(opcode);
     uint32_t ea = reg_a ? ppc_result_a : 0;
     uint32_t grab_inb              = (opcode >> 11) & 0x1F;
@@ -1850,9 +1789,7 @@ void dppc_interpreter::ppc_lswi(uint32_t opcode) {
 }
 
 void dppc_interpreter::ppc_lswx(uint32_t opcode) {
-#ifdef CPU_PROFILING
-    num_int_loads++;
-#endif
+    PROF_INC(num_int_loads);
     ppc_grab_regsdab(opcode);
 
 /*
@@ -1892,9 +1829,7 @@ void dppc_interpreter::ppc_lswx(uint32_t opcode) {
 }
 
 void dppc_interpreter::ppc_stswi(uint32_t opcode) {
-#ifdef CPU_PROFILING
-    num_int_stores++;
-#endif
+    PROF_INC(num_int_stores);
     ppc_grab_regssash_stswi(opcode);
     uint32_t ea = reg_a ? ppc_result_a : 0;
     uint32_t grab_inb = rot_sh ? rot_sh : 32;
@@ -1927,9 +1862,7 @@ void dppc_interpreter::ppc_stswi(uint32_t opcode) {
 }
 
 void dppc_interpreter::ppc_stswx(uint32_t opcode) {
-#ifdef CPU_PROFILING
-    num_int_stores++;
-#endif
+    PROF_INC(num_int_stores);
     ppc_grab_regssab_stswx(opcode);
     uint32_t ea = ppc_result_b + (reg_a ? ppc_result_a : 0);
     uint32_t grab_inb = ppc_state.spr[SPR::XER] & 127;
@@ -2002,9 +1935,7 @@ void dppc_interpreter::ppc_ecowx(uint32_t opcode) {
 // TLB Instructions
 
 void dppc_interpreter::ppc_tlbie(uint32_t opcode) {
-#ifdef CPU_PROFILING
-    num_supervisor_instrs++;
-#endif
+    PROF_INC(num_supervisor_instrs);
     if (ppc_state.msr & MSR::PR) {
         ppc_exception_handler(Except_Type::EXC_PROGRAM, Exc_Cause::NOT_ALLOWED);
         return;
@@ -2014,9 +1945,7 @@ void dppc_interpreter::ppc_tlbie(uint32_t opcode) {
 }
 
 void dppc_interpreter::ppc_tlbia(uint32_t opcode) {
-#ifdef CPU_PROFILING
-    num_supervisor_instrs++;
-#endif
+    PROF_INC(num_supervisor_instrs);
     /* placeholder */
     if (ppc_state.msr & MSR::PR) {
         ppc_exception_handler(Except_Type::EXC_PROGRAM, Exc_Cause::NOT_ALLOWED);
@@ -2027,23 +1956,17 @@ void dppc_interpreter::ppc_tlbia(uint32_t opcode) {
 }
 
 void dppc_interpreter::ppc_tlbld(uint32_t opcode) {
-#ifdef CPU_PROFILING
-    num_supervisor_instrs++;
-#endif
+    PROF_INC(num_supervisor_instrs);
     /* placeholder */
 }
 
 void dppc_interpreter::ppc_tlbli(uint32_t opcode) {
-#ifdef CPU_PROFILING
-    num_supervisor_instrs++;
-#endif
+    PROF_INC(num_supervisor_instrs);
     /* placeholder */
 }
 
 void dppc_interpreter::ppc_tlbsync(uint32_t opcode) {
-#ifdef CPU_PROFILING
-    num_supervisor_instrs++;
-#endif
+    PROF_INC(num_supervisor_instrs);
     /* placeholder */
     if (ppc_state.msr & MSR::PR) {
         ppc_exception_handler(Except_Type::EXC_PROGRAM, Exc_Cause::NOT_ALLOWED);
@@ -0,0 +1,280 @@
+/*
+DingusPPC - The Experimental PowerPC Macintosh emulator
+Copyright (C) 2018-25 divingkatae and maximum
+                      (theweirdo)     spatium
+
+(Contact divingkatae#1017 or powermax#2286 on Discord for more info)
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+/** @file Statistical guest code profiler. */
+
+#include "ppcsampler.h"
+#include "ppcemu.h"
+#include "ppcmmu.h"
+#include <core/timermanager.h>
+#include <memaccess.h>
+#include <loguru.hpp>
+
+#include <algorithm>
+#include <cctype>
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <map>
+#include <sstream>
+#include <unordered_map>
+#include <vector>
+
+// frames larger than that are assumed to be a broken back-chain
+#define MAX_FRAME_SIZE  0x100000
+
+// addresses further away from the nearest symbol aren't attributed to it
+#define MAX_FUNC_SIZE   0x10000
+
+enum SampleMode : uint32_t {
+    MODE_REAL = 0,
+    MODE_SUPERVISOR,
+    MODE_USER,
+};
+
+static const char* mode_names[] = {"[real]", "[supervisor]", "[user]"};
+
+static uint64_t interval_ns = 0;
+static int      max_depth   = 32;
+static uint32_t timer_id    = 0;
+static bool     running     = false;
+static bool     configured  = false;    // start with each machine run
+
+// sample key: mode, PC, LR (0 if redundant), return addresses innermost first
+static std::map<std::vector<uint32_t>, uint64_t> samples;
+static uint64_t                                  num_samples = 0;
+
+static std::map<uint32_t, std::string>           symbols;
+
+//================================ Sampling ===================================
+static void take_sample() {
+    static std::vector<uint32_t> key;
+
+    key.clear();
+    key.push_back(!(ppc_state.msr & MSR::IR) ? MODE_REAL :
+                  (ppc_state.msr & MSR::PR)  ? MODE_USER : MODE_SUPERVISOR);
+    key.push_back(ppc_state.pc);
+    key.push_back(ppc_state.spr[SPR::LR]);
+
+    uint32_t fp = ppc_state.gpr[1];
+
+    // the stack is only read through side-effect-free translations so
+    // sampling neither touches MMIO nor changes the guest's TLB/PTE state
+    for (int depth = 0; depth < max_depth && !(fp & 3); depth++) {
+        uint8_t* host_ptr = mmu_peek_mem(fp);
+        if (!host_ptr)
+            break;
+        uint32_t next = READ_DWORD_BE_A(host_ptr);
+        if ((next & 3) || next <= fp || next - fp > MAX_FRAME_SIZE)
+            break;
+        if (!(host_ptr = mmu_peek_mem(next + 8)))
+            break;
+        uint32_t ret = READ_DWORD_BE_A(host_ptr);
+        if (!ret || (ret & 3))
+            break;
+        key.push_back(ret);
+        fp = next;
+    }
+
+    // LR is only useful for leaf functions that haven't saved it yet
+    if (key.size() > 3 && key[3] == key[2])
+        key[2] = 0;
+
+    samples[key]++;
+    num_samples++;
+}
+
+void ppc_sampler_configure(uint64_t interval, int depth) {
+    configured  = interval != 0;
+    interval_ns = interval;
+    max_depth   = depth;
+}
+
+bool ppc_sampler_configured() {
+    return configured;
+}
+
+void ppc_sampler_start(uint64_t interval) {
+    if (running)
+        return;
+
+    if (interval)
+        interval_ns = interval;
+    else if (!interval_ns)
+        interval_ns = USECS_TO_NSECS(1000);
+
+    timer_id = TimerManager::get_instance()->add_cyclic_timer(interval_ns, take_sample);
+    running  = true;
+
+    LOG_F(INFO, "Sampler: started, interval %llu ns, max depth %d",
+          (unsigned long long)interval_ns, max_depth);
+}
+
+void ppc_sampler_stop() {
+    if (!running)
+        return;
+
+    TimerManager::get_instance()->cancel_timer(timer_id);
+    running = false;
+
+    LOG_F(INFO, "Sampler: stopped, %llu samples collected", (unsigned long long)num_samples);
+}
+
+bool ppc_sampler_running() {
+    return running;
+}
+
+void ppc_sampler_reset() {
+    samples.clear();
+    num_samples = 0;
+}
+
+//================================ Symbols ====================================
+static bool parse_sym_addr(const std::string& tok, uint32_t& addr) {
+    size_t start = 0;
+
+    if (tok.size() > 2 && tok[0] == '0' && (tok[1] == 'x' || tok[1] == 'X'))
+        start = 2;
+    else if (tok.size() != 8)
+        return false;
+
+    if (tok.size() == start || tok.size() - start > 8)
+        return false;
+
+    for (size_t i = start; i < tok.size(); i++)
+        if (!std::isxdigit((unsigned char)tok[i]))
+            return false;
+
+    addr = (uint32_t)std::stoul(tok.substr(start), nullptr, 16);
+    return true;
+}
+
+bool ppc_sampler_load_symbols(const std::string& path) {
+    std::ifstream in(path);
+    if (!in) {
+        LOG_F(ERROR, "Sampler: could not open symbol map %s", path.c_str());
+        return false;
+    }
+
+    std::string line;
+    int count = 0;
+
+    while (std::getline(in, line)) {
+        std::istringstream ss(line);
+        std::vector<std::string> toks;
+        std::string tok;
+
+        while (ss >> tok)
+            toks.push_back(tok);
+
+        if (toks.size() < 2 || toks[0][0] == '#' || toks[0][0] == ';')
+            continue;
+
+        uint32_t addr;
+        if (parse_sym_addr(toks[0], addr))
+            symbols[addr] = toks.back();     // ADDR [TYPE] NAME
+        else if (parse_sym_addr(toks.back(), addr))
+            symbols[addr] = toks[0];         // NAME ADDR
+        else
+            continue;
+
+        count++;
+    }
+
+    LOG_F(INFO, "Sampler: loaded %d symbols from %s", count, path.c_str());
+    return true;
+}
+
+static std::string sym_name(uint32_t addr) {
+    auto it = symbols.upper_bound(addr);
+
+    // the next symbol ends a function, the distance caps the last one
+    // so that ROM or other code without symbols doesn't get attributed
+    if (it != symbols.begin() && addr - std::prev(it)->first < MAX_FUNC_SIZE)
+        return std::prev(it)->second;
+
+    char buf[16];
+    std::snprintf(buf, sizeof(buf), "0x%08X", addr);
+    return buf;
+}
+
+//================================ Output =====================================
+bool ppc_sampler_write_folded(const std::string& path) {
+    std::map<std::string, uint64_t> stacks;
+
+    for (auto& [key, count] : samples) {
+        std::string stack = mode_names[key[0]];
+        std::string leaf  = sym_name(key[1]);
+
+        for (size_t i = key.size() - 1; i > 2; i--)
+            stack += ";" + sym_name(key[i]);
+
+        if (key[2]) {
+            std::string caller = sym_name(key[2]);
+            if (caller != leaf)
+                stack += ";" + caller;
+        }
+
+        stack += ";" + leaf;
+        stacks[stack] += count;
+    }
+
+    std::ofstream out(path);
+    if (!out) {
+        LOG_F(ERROR, "Sampler: could not create %s", path.c_str());
+        return false;
+    }
+
+    for (auto& [stack, count] : stacks)
+        out << stack << " " << count << "\n";
+
+    LOG_F(INFO, "Sampler: %llu samples in %zu stacks written to %s",
+          (unsigned long long)num_samples, stacks.size(), path.c_str());
+    return true;
+}
+
+void ppc_sampler_print_summary(int top_n) {
+    std::unordered_map<std::string, uint64_t> self;
+    uint64_t modes[3] = {};
+
+    for (auto& [key, count] : samples) {
+        self[sym_name(key[1])] += count;
+        modes[key[0]] += count;
+    }
+
+    std::vector<std::pair<std::string, uint64_t>> top(self.begin(), self.end());
+    std::sort(top.begin(), top.end(), [](const auto& a, const auto& b) {
+        return a.second > b.second;
+    });
+
+    std::printf("%llu samples, %s\n", (unsigned long long)num_samples,
+                running ? "sampling" : "stopped");
+    if (!num_samples)
+        return;
+
+    for (uint32_t mode = MODE_REAL; mode <= MODE_USER; mode++)
+        std::printf("  %-14s %5.1f%%\n", mode_names[mode], modes[mode] * 100.0 / num_samples);
+
+    std::printf("Top functions by self samples:\n");
+    for (int i = 0; i < top_n && i < (int)top.size(); i++)
+        std::printf("  %-40s %10llu %5.1f%%\n", top[i].first.c_str(),
+                    (unsigned long long)top[i].second, top[i].second * 100.0 / num_samples);
+}
@@ -0,0 +1,66 @@
+/*
+DingusPPC - The Experimental PowerPC Macintosh emulator
+Copyright (C) 2018-25 divingkatae and maximum
+                      (theweirdo)     spatium
+
+(Contact divingkatae#1017 or powermax#2286 on Discord for more info)
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+/** @file Statistical guest code profiler.
+
+    A cyclic timer periodically records the guest PC, LR, the return
+    addresses found by following the stack back-chain and the current
+    MMU mode. The timer runs on emulated time so sampling is driven by
+    the instruction counter in deterministic mode.
+
+    The back-chain walk assumes the AIX-style linkage area used by
+    Mac OS where the saved LR lives at offset 8 of the caller's frame.
+
+    Samples are kept as raw addresses and resolved when written out so
+    symbol maps may be loaded at any time. A symbol map is a text file
+    with one symbol per line, either "ADDR [TYPE] NAME" (nm style) or
+    "NAME ADDR" (MacsBug style). Addresses are hexadecimal and must be
+    either 0x prefixed or exactly eight digits long. Lines starting with
+    '#' or ';' are ignored.
+ */
+
+#ifndef PPC_SAMPLER_H
+#define PPC_SAMPLER_H
+
+#include <cinttypes>
+#include <string>
+
+// Sets the sampling parameters and arms the sampler for each machine run.
+extern void ppc_sampler_configure(uint64_t interval_ns, int max_depth);
+extern bool ppc_sampler_configured();
+
+// Starts sampling every interval_ns nanoseconds of emulated time,
+// zero keeps the previous/configured interval.
+extern void ppc_sampler_start(uint64_t interval_ns = 0);
+extern void ppc_sampler_stop();
+extern bool ppc_sampler_running();
+extern void ppc_sampler_reset();
+
+extern bool ppc_sampler_load_symbols(const std::string& path);
+
+// Writes samples in the folded stack format understood by flamegraph.pl
+// and speedscope: "mode;outermost;...;innermost count" per line.
+extern bool ppc_sampler_write_folded(const std::string& path);
+
+// Prints the functions with the most samples to stdout.
+extern void ppc_sampler_print_summary(int top_n = 20);
+
+#endif // PPC_SAMPLER_H
@@ -0,0 +1,239 @@
+/*
+DingusPPC - The Experimental PowerPC Macintosh emulator
+Copyright (C) 2018-25 divingkatae and maximum
+                      (theweirdo)     spatium
+
+(Contact divingkatae#1017 or powermax#2286 on Discord for more info)
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+/** @file Binary execution trace recorder and decoder. */
+
+#include "ppctrace.h"
+#include "ppcdisasm.h"
+#include <loguru.hpp>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <vector>
+
+PPCTrace ppc_trace;
+
+static std::string trace_path;
+static size_t      trace_map_size;
+
+//============================ Buffer management ==============================
+#ifdef _WIN32
+
+// No file mapping here, the buffer is written out when the trace is closed.
+static void* trace_map(const std::string& path, size_t size) {
+    return std::calloc(1, size);
+}
+
+static void trace_unmap(void* base, size_t size) {
+    FILE* out = std::fopen(trace_path.c_str(), "wb");
+    if (out) {
+        std::fwrite(base, 1, size, out);
+        std::fclose(out);
+    } else {
+        LOG_F(ERROR, "Trace: could not write %s", trace_path.c_str());
+    }
+    std::free(base);
+}
+
+#else
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+static void* trace_map(const std::string& path, size_t size) {
+    int fd = open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0)
+        return nullptr;
+
+    if (ftruncate(fd, size)) {
+        close(fd);
+        return nullptr;
+    }
+
+    void* base = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+
+    return base == MAP_FAILED ? nullptr : base;
+}
+
+static void trace_unmap(void* base, size_t size) {
+    munmap(base, size);
+}
+
+#endif // _WIN32
+
+//=============================== Recording ===================================
+bool ppc_trace_open(const std::string& path, uint32_t num_recs, uint32_t gpr_mask,
+                    uint32_t start_pc, uint32_t stop_pc, uint64_t max_insns) {
+    ppc_trace_close();
+
+    if (!num_recs) {
+        LOG_F(ERROR, "Trace: buffer size must be non-zero");
+        return false;
+    }
+
+    trace_path     = path;
+    trace_map_size = sizeof(TraceFileHeader) + size_t(num_recs) * TRACE_REC_SIZE;
+
+    void* base = trace_map(path, trace_map_size);
+    if (!base) {
+        LOG_F(ERROR, "Trace: could not create %s", path.c_str());
+        return false;
+    }
+
+    ppc_trace.hdr  = static_cast<TraceFileHeader*>(base);
+    ppc_trace.ring = reinterpret_cast<uint32_t*>(ppc_trace.hdr + 1);
+
+    std::memcpy(ppc_trace.hdr->magic, TRACE_MAGIC, sizeof(ppc_trace.hdr->magic));
+    ppc_trace.hdr->rec_size = TRACE_REC_SIZE;
+    ppc_trace.hdr->num_recs = num_recs;
+    ppc_trace.hdr->head     = 0;
+    ppc_trace.hdr->gpr_mask = gpr_mask;
+
+    ppc_trace.num_recs   = num_recs;
+    ppc_trace.wr_pos     = 0;
+    ppc_trace.gpr_mask   = gpr_mask;
+    ppc_trace.start_pc   = start_pc;
+    ppc_trace.stop_pc    = stop_pc;
+    ppc_trace.insns_left = max_insns;
+    ppc_trace.state      = TRACE_ARMED;
+
+    LOG_F(INFO, "Trace: recording up to %u records into %s", num_recs, path.c_str());
+
+    // without a start address, recording begins right away
+    if (start_pc == 0xFFFFFFFFUL)
+        ppc_trace_begin();
+
+    return true;
+}
+
+void ppc_trace_close() {
+    if (ppc_trace.state == TRACE_OFF)
+        return;
+
+    LOG_F(INFO, "Trace: %llu records written to %s",
+          (unsigned long long)ppc_trace.hdr->head, trace_path.c_str());
+
+    ppc_trace.state = TRACE_OFF;
+    trace_unmap(ppc_trace.hdr, trace_map_size);
+    ppc_trace.hdr  = nullptr;
+    ppc_trace.ring = nullptr;
+}
+
+void ppc_trace_begin() {
+    // initial register values so that deltas start from a known state
+    ppc_trace.state    = TRACE_RECORDING;
+    ppc_trace.last_msr = ppc_state.msr;
+    ppc_trace_put(TRACE_REC_MSR, ppc_state.msr);
+
+    for (int reg = 0; reg < 32; reg++) {
+        ppc_trace.last_gpr[reg] = ppc_state.gpr[reg];
+        if (ppc_trace.gpr_mask & (1U << reg))
+            ppc_trace_put((reg << 2) | TRACE_REC_GPR, ppc_state.gpr[reg]);
+    }
+
+    LOG_F(INFO, "Trace: recording started at PC=0x%08X", ppc_state.pc);
+}
+
+void ppc_trace_end() {
+    ppc_trace.state = TRACE_DONE;
+    LOG_F(INFO, "Trace: recording stopped at PC=0x%08X", ppc_state.pc);
+}
+
+//================================ Decoding ===================================
+static const char* exc_name(uint32_t vector) {
+    switch (vector & 0xFFFFF) {
+    case 0x0100: return "system reset";
+    case 0x0200: return "machine check";
+    case 0x0300: return "DSI";
+    case 0x0400: return "ISI";
+    case 0x0500: return "external interrupt";
+    case 0x0600: return "alignment";
+    case 0x0700: return "program";
+    case 0x0800: return "FPU unavailable";
+    case 0x0900: return "decrementer";
+    case 0x0C00: return "system call";
+    case 0x0D00: return "trace";
+    default:     return "unknown";
+    }
+}
+
+bool ppc_trace_decode(const std::string& path, uint64_t max_recs) {
+    std::ifstream in(path, std::ios::binary);
+    if (!in) {
+        LOG_F(ERROR, "Trace: could not open %s", path.c_str());
+        return false;
+    }
+
+    TraceFileHeader hdr;
+    if (!in.read(reinterpret_cast<char*>(&hdr), sizeof(hdr)) ||
+        std::memcmp(hdr.magic, TRACE_MAGIC, sizeof(hdr.magic)) ||
+        hdr.rec_size != TRACE_REC_SIZE || !hdr.num_recs) {
+        LOG_F(ERROR, "Trace: %s is not a valid trace file", path.c_str());
+        return false;
+    }
+
+    std::vector<uint32_t> ring(size_t(hdr.num_recs) * 2);
+    in.read(reinterpret_cast<char*>(ring.data()), ring.size() * sizeof(uint32_t));
+    if (!in) {
+        LOG_F(ERROR, "Trace: %s is truncated", path.c_str());
+        return false;
+    }
+
+    uint64_t avail = std::min<uint64_t>(hdr.head, hdr.num_recs);
+    uint64_t count = std::min(avail, max_recs);
+    uint64_t first = hdr.head - count;
+
+    printf("%llu records written, showing last %llu\n",
+           (unsigned long long)hdr.head, (unsigned long long)count);
+
+    PPCDisasmContext ctx;
+    ctx.simplified = true;
+
+    for (uint64_t seq = first; seq < hdr.head; seq++) {
+        const uint32_t* rec = &ring[(seq % hdr.num_recs) * 2];
+
+        switch (rec[0] & 3) {
+        case TRACE_REC_INSN:
+            // disassemble_single advances instr_addr
+            ctx.instr_addr = rec[0] & ~3;
+            ctx.instr_code = rec[1];
+            printf("%08X: %08X  %s\n", rec[0] & ~3, rec[1], disassemble_single(&ctx).c_str());
+            break;
+        case TRACE_REC_GPR:
+            printf("                    r%d = 0x%08X\n", rec[0] >> 2, rec[1]);
+            break;
+        case TRACE_REC_MSR:
+            printf("                    msr = 0x%08X\n", rec[1]);
+            break;
+        case TRACE_REC_EXC:
+            printf("*** %s exception, vector 0x%08X, SRR0=0x%08X\n",
+                   exc_name(rec[0] & ~3), rec[0] & ~3, rec[1]);
+            break;
+        }
+    }
+
+    return true;
+}
@@ -0,0 +1,160 @@
+/*
+DingusPPC - The Experimental PowerPC Macintosh emulator
+Copyright (C) 2018-25 divingkatae and maximum
+                      (theweirdo)     spatium
+
+(Contact divingkatae#1017 or powermax#2286 on Discord for more info)
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+/** @file Binary execution trace.
+
+    The trace is a file-backed ring of fixed-size records preceded by
+    TraceFileHeader. Each record consists of two 32-bit words in host byte
+    order. The two least significant bits of the first word select the
+    record type, the remaining bits carry a 4-byte aligned address or a
+    register number:
+
+    TRACE_REC_INSN  PC                  | opcode
+    TRACE_REC_GPR   (reg << 2)          | new register value
+    TRACE_REC_MSR   0                   | new MSR value
+    TRACE_REC_EXC   exception vector    | SRR0
+
+    Instruction records are written before the instruction is executed so
+    the instruction causing a crash is always the last one recorded.
+    GPR and MSR records are written after the instruction changing them.
+
+    The file is mapped into memory so its contents survive a crash of
+    the emulator itself.
+ */
+
+#ifndef PPC_TRACE_H
+#define PPC_TRACE_H
+
+#include "ppcemu.h"
+
+#include <bit>
+#include <cinttypes>
+#include <string>
+
+#define TRACE_MAGIC     "DPPCTRC1"
+#define TRACE_REC_SIZE  8
+
+enum TraceRecType : uint32_t {
+    TRACE_REC_INSN = 0,
+    TRACE_REC_GPR  = 1,
+    TRACE_REC_MSR  = 2,
+    TRACE_REC_EXC  = 3,
+};
+
+struct TraceFileHeader {
+    char        magic[8];
+    uint32_t    rec_size;
+    uint32_t    num_recs;   // ring capacity in records
+    uint64_t    head;       // total number of records written so far
+    uint32_t    gpr_mask;   // GPRs being tracked
+    uint32_t    reserved[9];
+};
+
+enum TraceState : int {
+    TRACE_OFF = 0,  // no trace buffer
+    TRACE_ARMED,    // waiting for the start address
+    TRACE_RECORDING,
+    TRACE_DONE,     // stop condition reached, buffer kept
+};
+
+typedef struct {
+    TraceState          state = TRACE_OFF;
+    TraceFileHeader*    hdr;
+    uint32_t*           ring;
+    uint32_t            num_recs;
+    uint32_t            wr_pos;
+    uint32_t            start_pc;
+    uint32_t            stop_pc;
+    uint64_t            insns_left;
+
+    // shadow state for detecting register changes
+    uint32_t            gpr_mask;
+    uint32_t            last_gpr[32];
+    uint32_t            last_msr;
+} PPCTrace;
+
+extern PPCTrace ppc_trace;
+
+// Creates a trace file holding up to num_recs records. Recording starts
+// once start_pc is reached (any address if start_pc is 0xFFFFFFFF) and stops
+// at stop_pc or after max_insns instructions, whatever comes first.
+extern bool ppc_trace_open(const std::string& path, uint32_t num_recs, uint32_t gpr_mask,
+                           uint32_t start_pc = 0xFFFFFFFFUL, uint32_t stop_pc = 0xFFFFFFFFUL,
+                           uint64_t max_insns = UINT64_MAX);
+extern void ppc_trace_close();
+extern void ppc_trace_begin();
+extern void ppc_trace_end();
+
+// Prints the last max_recs records from a trace file to stdout.
+extern bool ppc_trace_decode(const std::string& path, uint64_t max_recs);
+
+static inline bool ppc_trace_active() {
+    return ppc_trace.state == TRACE_ARMED || ppc_trace.state == TRACE_RECORDING;
+}
+
+static inline void ppc_trace_put(uint32_t w0, uint32_t w1) {
+    uint32_t* rec = &ppc_trace.ring[ppc_trace.wr_pos * 2];
+    rec[0] = w0;
+    rec[1] = w1;
+    if (++ppc_trace.wr_pos >= ppc_trace.num_recs)
+        ppc_trace.wr_pos = 0;
+    ppc_trace.hdr->head++;
+}
+
+static inline void ppc_trace_insn(uint32_t pc, uint32_t opcode) {
+    if (ppc_trace.state != TRACE_RECORDING) [[unlikely]] {
+        if (ppc_trace.state != TRACE_ARMED || pc != ppc_trace.start_pc)
+            return;
+        ppc_trace_begin();
+    }
+
+    if (pc == ppc_trace.stop_pc || !ppc_trace.insns_left--) [[unlikely]] {
+        ppc_trace_end();
+        return;
+    }
+
+    ppc_trace_put(pc | TRACE_REC_INSN, opcode);
+}
+
+static inline void ppc_trace_deltas() {
+    if (ppc_trace.state != TRACE_RECORDING)
+        return;
+
+    if (ppc_state.msr != ppc_trace.last_msr) [[unlikely]] {
+        ppc_trace.last_msr = ppc_state.msr;
+        ppc_trace_put(TRACE_REC_MSR, ppc_state.msr);
+    }
+
+    for (uint32_t mask = ppc_trace.gpr_mask; mask; mask &= mask - 1) {
+        int reg = std::countr_zero(mask);
+        if (ppc_state.gpr[reg] != ppc_trace.last_gpr[reg]) {
+            ppc_trace.last_gpr[reg] = ppc_state.gpr[reg];
+            ppc_trace_put((reg << 2) | TRACE_REC_GPR, ppc_state.gpr[reg]);
+        }
+    }
+}
+
+static inline void ppc_trace_exception(uint32_t vector, uint32_t srr0) {
+    if (ppc_trace.state == TRACE_RECORDING)
+        ppc_trace_put((vector & ~3) | TRACE_REC_EXC, srr0);
+}
+
+#endif // PPC_TRACE_H
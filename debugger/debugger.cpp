@@ -19,9 +19,11 @@ You should have received a copy of the GNU General Public License
 along with this program.  If not, see <https://www.gnu.org/licenses/>.
 */
 
+#include <cpu/ppc/ppcbreakpoints.h>
 #include <cpu/ppc/ppcdisasm.h>
 #include <cpu/ppc/ppcemu.h>
 #include <cpu/ppc/ppcmmu.h>
+#include <cpu/ppc/ppcsampler.h>
 #include <debugger/debugger.h>
 #include <devices/common/hwinterrupt.h>
 #include <devices/common/ofnvram.h>
@@ -77,6 +79,13 @@ static void show_help() {
     cout << "  ni             -- shortcut for next" << endl;
     cout << "  until X        -- execute until address X is reached" << endl;
     cout << "  go             -- exit debugger and continue emulator execution" << endl;
+    cout << "  break [X]      -- set instruction breakpoint at address X" << endl;
+    cout << "                    break with no arguments lists all breakpoints" << endl;
+    cout << "                    and watchpoints" << endl;
+    cout << "  watch [T] X [N] -- stop on accesses to N bytes at address X" << endl;
+    cout << "                    T can be r(read), w(write, default) or rw" << endl;
+    cout << "  delete [X]     -- delete breakpoint or watchpoint at address X" << endl;
+    cout << "                    delete with no arguments deletes all of them" << endl;
     cout << "  regs           -- dump content of the GPRs" << endl;
     cout << "  fregs          -- dump content of the FPRs" << endl;
     cout << "  mregs          -- dump content of the MMU registers" << endl;
@@ -94,6 +103,17 @@ static void show_help() {
     cout << "                    supported subcommands:" << endl;
     cout << "                    'show' - show profile report" << endl;
     cout << "                    'reset' - reset profile variables" << endl;
+    cout << "                    'on'/'off' - enable/disable counting" << endl;
+    cout << "                    'list' - list available profiles" << endl;
+    cout << "                    'json' - save all profiles to file N" << endl;
+    cout << "  sample C A     -- run subcommand C of the guest code sampler" << endl;
+    cout << "                    supported subcommands:" << endl;
+    cout << "                    'on' - start sampling every A us (default 1000)" << endl;
+    cout << "                    'off' - stop sampling" << endl;
+    cout << "                    'show' - show A functions with most samples" << endl;
+    cout << "                    'reset' - discard collected samples" << endl;
+    cout << "                    'syms' - load symbol map from file A" << endl;
+    cout << "                    'save' - write folded stacks to file A" << endl;
 #ifdef PROFILER
     cout << "  profiler       -- show stats related to the processor" << endl;
 #endif
@@ -540,6 +560,30 @@ static void mysig_handler(int signum)
 }
 #endif
 
+static void list_breakpoints() {
+    if (ppc_get_breakpoints().empty() && ppc_get_watchpoints().empty()) {
+        cout << "No breakpoints or watchpoints." << endl;
+        return;
+    }
+
+    for (uint32_t addr : ppc_get_breakpoints())
+        cout << "break  0x" << hex << uppercase << setw(8) << setfill('0') << addr << endl;
+
+    for (auto& wp : ppc_get_watchpoints()) {
+        cout << "watch  0x" << hex << uppercase << setw(8) << setfill('0') << wp.addr
+             << dec << " " << wp.size << " bytes, "
+             << (wp.type == WATCH_ACCESS ? "rw" : (wp.type == WATCH_READ ? "r" : "w")) << endl;
+    }
+    cout << dec << setfill(' ');
+}
+
+// Executes the instruction at PC if there is a breakpoint
+// so resuming doesn't stop at the same place again.
+static void step_over_breakpoint() {
+    if (ppc_get_breakpoints().count(ppc_state.pc))
+        ppc_exec_single();
+}
+
 static void delete_prompt() {
 #ifndef _WIN32
     // move up, carriage return (move to column 0), erase from cursor to end of line
@@ -676,6 +720,7 @@ void DppcDebugger::enter_debugger() {
             power_off_reason = po_restart;
         } else if (cmd == "profile") {
             cmd = "";
+            sub_cmd = profile_name = "";
             ss >> sub_cmd;
             ss >> profile_name;
 
@@ -683,9 +728,48 @@ void DppcDebugger::enter_debugger() {
                 gProfilerObj->print_profile(profile_name);
             } else if (sub_cmd == "reset") {
                 gProfilerObj->reset_profile(profile_name);
+            } else if (sub_cmd == "on" || sub_cmd == "off") {
+                profiling_enabled = sub_cmd == "on";
+                cout << "Profiling " << (profiling_enabled ? "enabled" : "disabled") << endl;
+            } else if (sub_cmd == "list") {
+                gProfilerObj->list_profiles();
+            } else if (sub_cmd == "json") {
+                if (profile_name.empty())
+                    cout << "profile json: no file name specified." << endl;
+                else if (gProfilerObj->export_json(profile_name))
+                    cout << "Profiles saved to " << profile_name << endl;
             } else {
                 cout << "Unknown/empty subcommand " << sub_cmd << endl;
             }
+        } else if (cmd == "sample") {
+            cmd = "";
+            sub_cmd = expr_str = "";
+            ss >> sub_cmd;
+            ss >> expr_str;
+
+            try {
+                if (sub_cmd == "on") {
+                    ppc_sampler_start(expr_str.empty() ? 0 :
+                                      std::stoull(expr_str, NULL, 0) * 1000);
+                } else if (sub_cmd == "off") {
+                    ppc_sampler_stop();
+                } else if (sub_cmd == "show") {
+                    ppc_sampler_print_summary(expr_str.empty() ? 20 : std::stoi(expr_str, NULL, 0));
+                } else if (sub_cmd == "reset") {
+                    ppc_sampler_reset();
+                } else if (sub_cmd == "syms" || sub_cmd == "save") {
+                    if (expr_str.empty())
+                        cout << "sample " << sub_cmd << ": no file name specified." << endl;
+                    else if (sub_cmd == "syms")
+                        ppc_sampler_load_symbols(expr_str);
+                    else
+                        ppc_sampler_write_folded(expr_str);
+                } else {
+                    cout << "Unknown/empty subcommand " << sub_cmd << endl;
+                }
+            } catch (std::logic_error& exc) { // invalid_argument or out_of_range
+                cout << "sample " << sub_cmd << ": invalid number " << expr_str << endl;
+            }
         }
         else if (cmd == "regs") {
             cmd = "";
@@ -757,7 +841,7 @@ void DppcDebugger::enter_debugger() {
                 if (cmd_repeat) {
                     delete_prompt();
                 }
-                for (; --count >= 0;) {
+                for (; --count >= 0 && power_on;) {
                     addr = ppc_state.pc;
                     ppc_exec_single();
                 }
@@ -765,6 +849,7 @@ void DppcDebugger::enter_debugger() {
         } else if (cmd == "next" || cmd == "ni") {
             addr_str = "PC";
             addr     = static_cast<uint32_t>(get_reg(addr_str) + 4);
+            step_over_breakpoint();
             ppc_exec_until(addr);
         } else if (cmd == "until") {
             if (cmd_repeat) {
@@ -781,6 +866,7 @@ void DppcDebugger::enter_debugger() {
                     exec_until_68k(addr);
 #endif
                 } else {
+                    step_over_breakpoint();
                     ppc_exec_until(addr);
                 }
             } catch (invalid_argument& exc) {
@@ -789,7 +875,65 @@ void DppcDebugger::enter_debugger() {
         } else if (cmd == "go") {
             cmd = "";
             power_on = true;
+            step_over_breakpoint();
             ppc_exec();
+        } else if (cmd == "break") {
+            cmd = "";
+            addr_str = "";
+            ss >> addr_str;
+            if (addr_str.empty()) {
+                list_breakpoints();
+                continue;
+            }
+            try {
+                addr = str2addr(addr_str);
+                if (!ppc_add_breakpoint(addr))
+                    cout << "Breakpoint already set." << endl;
+            } catch (invalid_argument& exc) {
+                cout << exc.what() << endl;
+            }
+        } else if (cmd == "watch") {
+            cmd = "";
+            uint8_t watch_type = WATCH_WRITE;
+            uint32_t watch_size = 4;
+            expr_str = "";
+            ss >> expr_str;
+            if (expr_str == "r" || expr_str == "w" || expr_str == "rw") {
+                watch_type = expr_str == "r" ? WATCH_READ :
+                             expr_str == "w" ? WATCH_WRITE : WATCH_ACCESS;
+                expr_str = "";
+                ss >> expr_str;
+            }
+            if (expr_str.empty()) {
+                cout << "watch: not enough arguments specified." << endl;
+                continue;
+            }
+            try {
+                addr = str2addr(expr_str);
+                expr_str = "";
+                ss >> expr_str;
+                if (!expr_str.empty())
+                    watch_size = str2num(expr_str);
+                if (!ppc_add_watchpoint(addr, watch_size, watch_type))
+                    cout << "Invalid watchpoint range." << endl;
+            } catch (invalid_argument& exc) {
+                cout << exc.what() << endl;
+            }
+        } else if (cmd == "delete") {
+            cmd = "";
+            addr_str = "";
+            ss >> addr_str;
+            if (addr_str.empty()) {
+                ppc_clear_breakpoints();
+                continue;
+            }
+            try {
+                addr = str2addr(addr_str);
+                if (!ppc_remove_breakpoint(addr) && !ppc_remove_watchpoint(addr))
+                    cout << "No breakpoint or watchpoint at that address." << endl;
+            } catch (invalid_argument& exc) {
+                cout << exc.what() << endl;
+            }
         } else if (cmd == "disas" || cmd == "da") {
             expr_str = "";
             ss >> expr_str;
@@ -26,7 +26,9 @@ along with this program.  If not, see <https://www.gnu.org/licenses/>.
 #include <devices/common/ata/idechannel.h>
 #include <loguru.hpp>
 
+#include <algorithm>
 #include <cinttypes>
+#include <cstring>
 
 using namespace ata_interface;
 
@@ -113,17 +115,10 @@ void AtaBaseDevice::write(const uint8_t reg_addr, const uint16_t value) {
             this->chunk_cnt -= 2;
             if (this->chunk_cnt <= 0) {
                 this->post_xfer_action();
-                this->xfer_cnt -= this->chunk_size;
-                if (this->xfer_cnt <= 0) { // transfer complete?
-                    this->xfer_cnt = 0;
-                    this->r_status &= ~DRQ;
-                    this->r_status &= ~BSY;
-                    this->update_intrq(1);
-                } else {
-                    this->cur_data_ptr = this->data_ptr;
-                    this->chunk_cnt = std::min(this->xfer_cnt, this->chunk_size);
-                    this->signal_data_ready();
-                }
+                // BSY set by post_xfer_action means the device is still
+                // processing the block and will call data_block_written() later
+                if (!(this->r_status & BSY))
+                    this->data_block_written();
             }
         }
         break;
@@ -148,6 +143,7 @@ void AtaBaseDevice::write(const uint8_t reg_addr, const uint16_t value) {
     case ATA_Reg::COMMAND:
         this->r_command = value;
         if (is_selected() || this->r_command == DIAGNOSTICS) {
+            this->abort_dma_xfer();
             perform_command();
         }
         break;
@@ -159,6 +155,20 @@ void AtaBaseDevice::write(const uint8_t reg_addr, const uint16_t value) {
     }
 }
 
+void AtaBaseDevice::data_block_written() {
+    this->xfer_cnt -= this->chunk_size;
+    if (this->xfer_cnt <= 0) { // transfer complete?
+        this->xfer_cnt = 0;
+        this->r_status &= ~DRQ;
+        this->r_status &= ~BSY;
+        this->update_intrq(1);
+    } else {
+        this->cur_data_ptr = this->data_ptr;
+        this->chunk_cnt = std::min(this->xfer_cnt, this->chunk_size);
+        this->signal_data_ready();
+    }
+}
+
 void AtaBaseDevice::device_control(const uint8_t new_ctrl) {
     // perform ATA Soft Reset if requested
     if ((this->r_dev_ctrl ^ new_ctrl) & SRST) {
@@ -198,3 +208,83 @@ void AtaBaseDevice::signal_data_ready() {
     this->r_status &= ~BSY;
     this->update_intrq(1);
 }
+
+bool AtaBaseDevice::is_dma_capable() const {
+    return this->host_obj && this->host_obj->is_dma_capable();
+}
+
+void AtaBaseDevice::start_dma_xfer(uint8_t *buf, int xfer_size, bool to_host) {
+    this->dma_ptr     = buf;
+    this->dma_cnt     = xfer_size;
+    this->dma_to_host = to_host;
+
+    this->r_status |= DRQ;
+    this->r_status &= ~BSY;
+
+    // the transfer proceeds as soon as the DMA engine gets to it,
+    // the DMA engine is already busy with us if we're called from xfer_from/xfer_to
+    if (!this->in_dma_xfer)
+        this->host_obj->signal_dma_ready();
+}
+
+// abandons any unfinished DMA transfer when a new command arrives
+void AtaBaseDevice::abort_dma_xfer() {
+    this->dma_ptr = nullptr;
+    this->post_dma_action = nullptr;
+}
+
+void AtaBaseDevice::dma_xfer_done() {
+    this->dma_ptr = nullptr;
+    this->r_status &= ~DRQ;
+
+    if (this->post_dma_action) {
+        auto action = std::move(this->post_dma_action);
+        this->post_dma_action = nullptr;
+        action();
+    } else {
+        this->r_status &= ~BSY;
+        this->update_intrq(1);
+    }
+}
+
+int AtaBaseDevice::xfer_from(uint8_t *buf, int len) {
+    // a completed DMA phase may start the next one right away
+    // so keep going until the DMA buffer is full
+    this->in_dma_xfer = true;
+
+    while (len && this->dma_ptr && this->dma_to_host) {
+        int count = std::min(len, this->dma_cnt);
+        std::memcpy(buf, this->dma_ptr, count);
+        this->dma_ptr += count;
+        this->dma_cnt -= count;
+        buf += count;
+        len -= count;
+
+        if (!this->dma_cnt)
+            this->dma_xfer_done();
+    }
+
+    this->in_dma_xfer = false;
+
+    return len;
+}
+
+int AtaBaseDevice::xfer_to(uint8_t *buf, int len) {
+    this->in_dma_xfer = true;
+
+    while (len && this->dma_ptr && !this->dma_to_host) {
+        int count = std::min(len, this->dma_cnt);
+        std::memcpy(this->dma_ptr, buf, count);
+        this->dma_ptr += count;
+        this->dma_cnt -= count;
+        buf += count;
+        len -= count;
+
+        if (!this->dma_cnt)
+            this->dma_xfer_done();
+    }
+
+    this->in_dma_xfer = false;
+
+    return len;
+}
@@ -70,12 +70,21 @@ public:
         return BYTESWAP_16(*this->data_ptr++);
     }
 
+    // bus master DMA
+    int xfer_from(uint8_t *buf, int len) override;
+    int xfer_to(uint8_t *buf, int len) override;
+
 protected:
     bool is_selected() const {
         return ((this->r_dev_head >> 4) & 1) == this->my_dev_id;
     }
 
     void prepare_xfer(int xfer_size, int block_size);
+    void data_block_written();
+    void start_dma_xfer(uint8_t *buf, int xfer_size, bool to_host);
+    void dma_xfer_done();
+    void abort_dma_xfer();
+    bool is_dma_capable() const;
 
     uint8_t my_dev_id = 0; // my IDE device ID configured by the host
     uint8_t device_type = ata_interface::DEVICE_TYPE_UNKNOWN;
@@ -105,6 +114,17 @@ protected:
     int         chunk_size      = 0;
 
     std::function<void()> post_xfer_action = nullptr;
+
+    // bus master DMA state
+    uint8_t     *dma_ptr        = nullptr;
+    int         dma_cnt         = 0;
+    bool        dma_to_host     = false;
+    uint8_t     mwdma_mode      = 0; // selected multiword DMA mode bitmask
+    bool        in_dma_xfer     = false;
+
+    // invoked after the last DMA data byte has been transferred,
+    // the command is completed immediately if not set
+    std::function<void()> post_dma_action = nullptr;
 };
 
 #endif // ATA_BASE_DEVICE_H
@@ -163,6 +163,10 @@ public:
 
     virtual int  get_device_id() = 0;
     virtual void pdiag_callback() {};
+
+    // bus master DMA, both return the number of bytes not transferred
+    virtual int xfer_from(uint8_t *buf, int len) { return len; };
+    virtual int xfer_to(uint8_t *buf, int len) { return len; };
 };
 
 /** Dummy ATA device. */
@@ -38,6 +38,17 @@ using namespace ata_interface;
 AtaHardDisk::AtaHardDisk(std::string name) : AtaBaseDevice(name, DEVICE_TYPE_ATA) {
 }
 
+AtaHardDisk::~AtaHardDisk() {
+    if (this->flush_timer_id)
+        TimerManager::get_instance()->cancel_timer(this->flush_timer_id);
+
+    // don't pull the rug from under outstanding I/O jobs
+    if (DiskIoWorker* io_worker = DiskIoWorker::get_instance_if_running()) {
+        io_worker->cancel_completions(this);
+        io_worker->wait_idle();
+    }
+}
+
 int AtaHardDisk::device_postinit() {
     std::string hdd_config = GET_STR_PROP("hdd_config");
     if (hdd_config.empty()) {
@@ -57,15 +68,20 @@ int AtaHardDisk::device_postinit() {
     auto bus_obj = dynamic_cast<IdeChannel*>(gMachineObj->get_comp_by_name(bus_id));
     bus_obj->register_device(dev_num, this);
 
-    this->insert_image(hdd_image_path);
+    this->insert_image(hdd_image_path, GET_STR_PROP("hdd_overlay"));
 
     return 0;
 }
 
-void AtaHardDisk::insert_image(std::string filename) {
-    if (!this->hdd_img.open(filename)) {
-        ABORT_F("%s: could not open image file \"%s\"", this->name.c_str(),
-                filename.c_str());
+void AtaHardDisk::insert_image(std::string filename, std::string overlay) {
+    if (overlay.empty()) {
+        if (!this->hdd_img.open(filename)) {
+            ABORT_F("%s: could not open image file \"%s\"", this->name.c_str(),
+                    filename.c_str());
+        }
+    } else if (!this->hdd_img.open_overlay(filename, overlay)) {
+        ABORT_F("%s: could not open image file \"%s\" with overlay \"%s\"",
+                this->name.c_str(), filename.c_str(), overlay.c_str());
     }
 
     this->img_size = this->hdd_img.size();
@@ -76,6 +92,23 @@ void AtaHardDisk::insert_image(std::string filename) {
                 filename.c_str());
     }
     this->calc_chs_params();
+    this->seek_model.set_total_blocks(this->total_sectors);
+
+    uint32_t cache_mb      = GET_INT_PROP("hdd_cache_size");
+    bool     write_through = GET_BIN_PROP("hdd_write_through");
+
+    this->hdd_img.set_cache((uint64_t)cache_mb << 20, write_through);
+
+    // the cache serializes the flush with the I/O jobs of the device
+    uint32_t flush_ms = GET_INT_PROP("hdd_flush_ms");
+    if (flush_ms && cache_mb && !write_through && !this->flush_timer_id) {
+        this->flush_timer_id = TimerManager::get_instance()->add_cyclic_timer(
+            MSECS_TO_NSECS(flush_ms), [this]() {
+                DiskIoWorker::get_instance()->post([this]() {
+                    this->hdd_img.flush();
+                });
+        });
+    }
 }
 
 int AtaHardDisk::perform_command() {
@@ -102,7 +135,8 @@ int AtaHardDisk::perform_command() {
     case READ_SECTOR_NR: {
             uint16_t sec_count = this->r_sect_count ? this->r_sect_count : 256;
             int      xfer_size = sec_count * ATA_HD_SEC_SIZE;
-            uint64_t offset    = this->get_lba() * ATA_HD_SEC_SIZE;
+            uint64_t lba       = this->get_lba();
+            uint64_t offset    = lba * ATA_HD_SEC_SIZE;
             uint32_t ints_size = ATA_HD_SEC_SIZE;
             if (this->r_command == READ_MULTIPLE) {
                 if (!this->sectors_per_int) {
@@ -113,11 +147,20 @@ int AtaHardDisk::perform_command() {
                 }
                 ints_size *= this->sectors_per_int;
             }
-            hdd_img.read(buffer, offset, xfer_size);
-            this->data_ptr = (uint16_t *)this->buffer;
-            // those commands should generate IRQ for each sector
-            this->prepare_xfer(xfer_size, ints_size);
-            this->signal_data_ready();
+            auto data_ready = [this, xfer_size, ints_size]() {
+                this->data_ptr = (uint16_t *)this->buffer;
+                // those commands should generate IRQ for each sector
+                this->prepare_xfer(xfer_size, ints_size);
+                this->signal_data_ready();
+            };
+            // the device stays BSY until asynchronous I/O is completed
+            if (!DiskIoWorker::get_instance()->submit(this,
+                [this, offset, xfer_size]() {
+                    this->hdd_img.read(this->buffer, offset, xfer_size);
+                },
+                this->seek_model.access_time(lba, sec_count, ATA_HD_SEC_SIZE),
+                data_ready))
+                data_ready();
         }
         break;
     case WRITE_MULTIPLE:
@@ -141,13 +184,70 @@ int AtaHardDisk::perform_command() {
             this->prepare_xfer(xfer_size, ints_size);
             this->post_xfer_action = [this]() {
                 uint64_t write_len = (this->cur_data_ptr - this->data_ptr) * sizeof(this->data_ptr[0]);
-                this->hdd_img.write(this->data_ptr, this->cur_fpos, write_len);
+                uint64_t write_pos = this->cur_fpos;
                 this->cur_fpos += write_len;
+                if (DiskIoWorker::get_instance()->submit(this,
+                    [this, write_pos, write_len]() {
+                        this->hdd_img.write(this->data_ptr, write_pos, write_len);
+                    },
+                    this->seek_model.access_time(write_pos / ATA_HD_SEC_SIZE,
+                        uint32_t(write_len / ATA_HD_SEC_SIZE), ATA_HD_SEC_SIZE),
+                    [this]() {
+                        this->r_status &= ~BSY;
+                        this->data_block_written();
+                    })) {
+                    // hold off the host until the block has been written
+                    this->r_status |= BSY;
+                    this->r_status &= ~DRQ;
+                }
             };
             this->r_status |= DRQ;
             this->r_status &= ~BSY;
         }
         break;
+    case READ_DMA:
+    case WRITE_DMA: {
+            if (!this->is_dma_capable()) {
+                LOG_F(ERROR, "%s: DMA isn't supported by the host", this->name.c_str());
+                this->r_error  |= ABRT;
+                this->r_status |= ERR;
+                this->r_status &= ~BSY;
+                this->update_intrq(1);
+                break;
+            }
+            uint16_t sec_count = this->r_sect_count ? this->r_sect_count : 256;
+            uint32_t xfer_size = sec_count * ATA_HD_SEC_SIZE;
+            uint64_t lba       = this->get_lba();
+            uint64_t offset    = lba * ATA_HD_SEC_SIZE;
+            uint64_t delay     = this->seek_model.access_time(lba, sec_count, ATA_HD_SEC_SIZE);
+            if (this->r_command == READ_DMA) {
+                // sector data goes straight from the buffer into guest memory
+                auto data_ready = [this, xfer_size]() {
+                    this->start_dma_xfer((uint8_t *)this->buffer, xfer_size, true);
+                };
+                if (!DiskIoWorker::get_instance()->submit(this,
+                    [this, offset, xfer_size]() {
+                        this->hdd_img.read(this->buffer, offset, xfer_size);
+                    }, delay, data_ready))
+                    data_ready();
+            } else {
+                auto write_done = [this]() {
+                    this->r_status &= ~BSY;
+                    this->update_intrq(1);
+                };
+                // the device stays BSY until the image has been updated
+                this->post_dma_action = [this, offset, xfer_size, delay, write_done]() {
+                    this->r_status |= BSY;
+                    if (!DiskIoWorker::get_instance()->submit(this,
+                        [this, offset, xfer_size]() {
+                            this->hdd_img.write(this->buffer, offset, xfer_size);
+                        }, delay, write_done))
+                        write_done();
+                };
+                this->start_dma_xfer((uint8_t *)this->buffer, xfer_size, false);
+            }
+        }
+        break;
     case DIAGNOSTICS:
         this->r_error = 1; // device 0 passed, device 1 passed or not present
         this->device_set_signature();
@@ -180,9 +280,17 @@ int AtaHardDisk::perform_command() {
         this->r_status &= ~BSY;
         this->update_intrq(1);
         break;
-    case FLUSH_CACHE: // used by the XNU kernel driver
-        this->r_status &= ~(BSY | DRQ | ERR);
-        this->update_intrq(1);
+    case FLUSH_CACHE: { // used by the XNU kernel driver
+            auto flush_done = [this]() {
+                this->r_status &= ~(BSY | DRQ | ERR);
+                this->update_intrq(1);
+            };
+            if (!DiskIoWorker::get_instance()->submit(this,
+                [this]() {
+                    this->hdd_img.flush();
+                }, 0, flush_done))
+                flush_done();
+        }
         break;
     case IDENTIFY_DEVICE:
         this->prepare_identify_info();
@@ -203,6 +311,7 @@ int AtaHardDisk::perform_command() {
             case 4:
                 LOG_F(INFO, "%s: Multiword DMA mode set to 0x%X", this->name.c_str(),
                       this->r_sect_count & 7);
+                this->mwdma_mode = 1 << (this->r_sect_count & 7);
                 break;
             default:
                 LOG_F(ERROR, "%s: unsupported transfer mode 0x%X", this->name.c_str(),
@@ -239,6 +348,12 @@ void AtaHardDisk::prepare_identify_info() {
     buf_ptr[ 0] = 0x0040; // ATA device, non-removable media, non-removable drive
     buf_ptr[49] = 0x0200; // report LBA support
 
+    // report multiword DMA modes 0-2 if the host is capable of bus mastering
+    if (this->is_dma_capable()) {
+        buf_ptr[49] |= 0x0100;
+        buf_ptr[63]  = (this->mwdma_mode << 8) | 0x0007;
+    }
+
     // Maximum number of logical sectors per data block that the device supports
     // for READ_MULTIPLE/WRITE_MULTIPLE commands.
     buf_ptr[47] = 0x8000 | SECTORS_PER_INT;
@@ -326,9 +441,10 @@ done:
           heads, sectors);
 }
 
-static const PropMap AtaHardDisk_Properties = {
+static const PropMap AtaHardDisk_Properties = add_hdd_cache_props({
     {"hdd_img", new StrProperty("")},
-};
+    {"hdd_overlay", new StrProperty("")},
+});
 
 static const DeviceDescription AtaHardDisk_Descriptor = {
     AtaHardDisk::create, {}, AtaHardDisk_Properties
@@ -25,6 +25,7 @@ along with this program.  If not, see <https://www.gnu.org/licenses/>.
 #define ATA_HARD_DISK_H
 
 #include <devices/common/ata/atabasedevice.h>
+#include <devices/storage/diskioworker.h>
 #include <utils/imgfile.h>
 
 #include <string>
@@ -43,7 +44,7 @@ class AtaHardDisk : public AtaBaseDevice
 {
 public:
     AtaHardDisk(std::string name);
-    ~AtaHardDisk() = default;
+    ~AtaHardDisk();
 
     static std::unique_ptr<HWComponent> create() {
         return std::unique_ptr<AtaHardDisk>(new AtaHardDisk("ATA-HD"));
@@ -51,7 +52,7 @@ public:
 
     int device_postinit() override;
 
-    void insert_image(std::string filename);
+    void insert_image(std::string filename, std::string overlay = "");
     int perform_command() override;
 
 protected:
@@ -61,6 +62,8 @@ protected:
 
 private:
     ImgFile     hdd_img;
+    DiskSeekModel seek_model;
+    uint32_t    flush_timer_id = 0;
     uint64_t    img_size = 0;
     uint32_t    total_sectors = 0;
     uint64_t    cur_fpos = 0;
@@ -132,6 +132,7 @@ void AtapiBaseDevice::write(const uint8_t reg_addr, const uint16_t value) {
     case ATA_Reg::COMMAND:
         this->r_command = value;
         if (is_selected() || this->r_command == DIAGNOSTICS) {
+            this->abort_dma_xfer();
             perform_command();
         }
         break;
@@ -166,6 +167,12 @@ int AtapiBaseDevice::perform_command() {
         std::memset(this->data_buf, 0, 512);
         this->data_buf[0] = 0xC0;
         this->data_buf[1] = 0x85;
+        // report multiword DMA modes 0-2 if the host is capable of bus mastering
+        if (this->is_dma_capable()) {
+            this->data_buf[99]  = 0x01; // word 49: DMA supported
+            this->data_buf[126] = 0x07;
+            this->data_buf[127] = this->mwdma_mode;
+        }
         this->data_ptr = (uint16_t *)this->data_buf;
         this->xfer_cnt = 512;
         this->status_expected = false;
@@ -176,6 +183,8 @@ int AtapiBaseDevice::perform_command() {
         case 3: // set transfer mode
             LOG_F(INFO, "%s: xfer_type=0x%X, mode=0x%X", this->name.c_str(),
                 this->r_sect_count >> 3, this->r_sect_count & 7);
+            if ((this->r_sect_count >> 3) == 4) // multiword DMA
+                this->mwdma_mode = 1 << (this->r_sect_count & 7);
             break;
         default:
             LOG_F(ERROR, "%s: unsupported subcommand 0x%X in SET_FEATURES",
@@ -194,9 +203,30 @@ int AtapiBaseDevice::perform_command() {
     return 0;
 }
 
+bool AtapiBaseDevice::is_dma_xfer() {
+    return this->r_command == ATAPI_PACKET && (this->r_features & ATAPI_Features::DMA) &&
+           this->is_dma_capable();
+}
+
 void AtapiBaseDevice::data_out_phase() {
     this->r_int_reason |= ATAPI_Int_Reason::IO; // device->host
     this->r_int_reason &= ~ATAPI_Int_Reason::CoD; // data
+
+    if (this->is_dma_xfer()) {
+        // the whole transfer completes with a single interrupt in the status phase
+        this->post_dma_action = [this]() {
+            if (this->data_available()) {
+                this->r_status |= BSY;
+                this->request_data();
+                this->data_out_phase();
+            } else {
+                this->present_status();
+            }
+        };
+        this->start_dma_xfer((uint8_t *)this->data_ptr, this->xfer_cnt, true);
+        return;
+    }
+
     this->signal_data_ready();
 }
 
@@ -51,6 +51,14 @@ public:
     virtual void present_status();
 
 protected:
+    // data phase of the current packet command uses bus master DMA
+    bool is_dma_xfer();
+
+    // maximum data phase length, the byte count limit applies to PIO only
+    uint32_t max_xfer_len() {
+        return this->is_dma_xfer() ? UINT32_MAX : this->r_byte_count;
+    }
+
     uint8_t     r_int_reason;
     uint16_t    r_byte_count;
     bool        status_expected = false;
@@ -88,7 +88,7 @@ void AtapiCdrom::perform_packet_command() {
         if (!xfer_len) {
             this->present_status();
         } else {
-            this->xfer_cnt = std::min((uint32_t)this->r_byte_count, xfer_len);
+            this->xfer_cnt = std::min(this->max_xfer_len(), xfer_len);
             this->data_ptr = (uint16_t*)this->data_buf;
             this->status_good();
             this->data_out_phase();
@@ -127,7 +127,7 @@ void AtapiCdrom::perform_packet_command() {
         if (!xfer_len) {
             this->present_status();
         } else {
-            this->xfer_cnt = std::min((uint32_t)this->r_byte_count, xfer_len);
+            this->xfer_cnt = std::min(this->max_xfer_len(), xfer_len);
             this->data_ptr = (uint16_t*)this->data_buf;
             this->data_out_phase();
         }
@@ -157,11 +157,8 @@ void AtapiCdrom::perform_packet_command() {
     case ScsiCommand::READ_6:
         lba      = this->cmd_pkt[1] << 16 | READ_WORD_BE_U(&this->cmd_pkt[2]);
         xfer_len = this->cmd_pkt[4];
-        if (this->r_features & ATAPI_Features::DMA) {
-            LOG_F(WARNING, "ATAPI DMA transfer requsted");
-        }
         this->set_fpos(lba);
-        this->xfer_cnt = this->read_begin(xfer_len, this->r_byte_count);
+        this->xfer_cnt = this->read_begin(xfer_len, this->max_xfer_len());
         this->r_byte_count = this->xfer_cnt;
         this->data_ptr = (uint16_t*)this->data_cache.get();
         this->status_good();
@@ -170,11 +167,8 @@ void AtapiCdrom::perform_packet_command() {
     case ScsiCommand::READ_10:
         lba      = READ_DWORD_BE_U(&this->cmd_pkt[2]);
         xfer_len = READ_WORD_BE_U(&this->cmd_pkt[7]);
-        if (this->r_features & ATAPI_Features::DMA) {
-            LOG_F(WARNING, "ATAPI DMA transfer requsted");
-        }
         this->set_fpos(lba);
-        this->xfer_cnt = this->read_begin(xfer_len, this->r_byte_count);
+        this->xfer_cnt = this->read_begin(xfer_len, this->max_xfer_len());
         this->r_byte_count = this->xfer_cnt;
         this->data_ptr = (uint16_t*)this->data_cache.get();
         this->status_good();
@@ -183,11 +177,8 @@ void AtapiCdrom::perform_packet_command() {
     case ScsiCommand::READ_12:
         lba      = READ_DWORD_BE_U(&this->cmd_pkt[2]);
         xfer_len = READ_DWORD_BE_U(&this->cmd_pkt[6]);
-        if (this->r_features & ATAPI_Features::DMA) {
-            LOG_F(WARNING, "ATAPI DMA transfer requsted");
-        }
         this->set_fpos(lba);
-        this->xfer_cnt = this->read_begin(xfer_len, this->r_byte_count);
+        this->xfer_cnt = this->read_begin(xfer_len, this->max_xfer_len());
         this->r_byte_count = this->xfer_cnt;
         this->data_ptr = (uint16_t*)this->data_cache.get();
         this->status_good();
@@ -210,7 +201,9 @@ void AtapiCdrom::perform_packet_command() {
                 this->cmd_pkt[6], this->cmd_pkt[7], this->cmd_pkt[8], this->cmd_pkt[9], this->cmd_pkt[10], this->cmd_pkt[11]
             );
         if (this->r_features & ATAPI_Features::DMA) {
-            LOG_F(WARNING, "ATAPI DMA transfer requsted");
+            // sector areas are assembled by get_data() so fall back to PIO
+            LOG_F(WARNING, "%s: READ_CD via DMA not supported, using PIO", this->name.c_str());
+            this->r_features &= ~ATAPI_Features::DMA;
         }
         this->set_fpos(lba);
         this->sector_areas = cmd_pkt[9];
@@ -21,10 +21,14 @@ along with this program.  If not, see <https://www.gnu.org/licenses/>.
 
 /** @file CMD646U2 PCI Ultra ATA controller emulation. */
 
+#include <core/bitops.h>
+#include <cpu/ppc/ppcmmu.h>
 #include <devices/common/ata/cmd646.h>
 #include <devices/deviceregistry.h>
+#include <endianswap.h>
 #include <loguru.hpp>
 #include <machines/machinebase.h>
+#include <memaccess.h>
 
 CmdIdeCtrl::CmdIdeCtrl() : PCIDevice("cmd-ide") {
     this->supports_types(HWCompType::PCI_DEV | HWCompType::IDE_HOST);
@@ -64,6 +68,15 @@ CmdIdeCtrl::CmdIdeCtrl() : PCIDevice("cmd-ide") {
         LOG_F(INFO, "CmdAta1 INTRQ updated to %d", intrq_state);
         this->update_irq(1, intrq_state);
     });
+
+    // wire bus master DMA engines to both channels
+    this->bm_dma[0] = std::unique_ptr<IdeBusMaster>(new IdeBusMaster("CmdAta0-BM"));
+    this->bm_dma[0]->connect(this->ch0);
+    this->ch0->connect(this->bm_dma[0].get());
+
+    this->bm_dma[1] = std::unique_ptr<IdeBusMaster>(new IdeBusMaster("CmdAta1-BM"));
+    this->bm_dma[1]->connect(this->ch1);
+    this->ch1->connect(this->bm_dma[1].get());
 }
 
 uint32_t CmdIdeCtrl::pci_cfg_read(uint32_t reg_offs, AccessDetails &details) {
@@ -115,7 +128,7 @@ bool CmdIdeCtrl::pci_io_read(uint32_t offset, uint32_t size, uint32_t* res) {
     } else if ((offset & ~3) == this->io_bases[3]) {
         *res = this->ch1->read((offset & 3) + DEV_CTRL_BLK_OFFSET, size);
     } else if ((offset & ~0xF) == this->io_bases[4]) {
-        *res = this->read_bus_master_reg(offset & 0xF);
+        *res = BYTESWAP_SIZED(this->read_bus_master_reg(offset & 0xF, size), size);
     } else {
         *res = 0xFFFFFFFFUL;
         return false;
@@ -134,7 +147,7 @@ bool CmdIdeCtrl::pci_io_write(uint32_t offset, uint32_t value, uint32_t size) {
     } else if ((offset & ~3) == this->io_bases[3]) {
         this->ch1->write((offset & 3) + DEV_CTRL_BLK_OFFSET, value, size);
     } else if ((offset & ~0xF) == this->io_bases[4]) {
-        this->write_bus_master_reg(offset & 0xF, value & 0xFFU);
+        this->write_bus_master_reg(offset & 0xF, BYTESWAP_SIZED(value, size), size);
     } else
         return false;
 
@@ -183,11 +196,34 @@ void CmdIdeCtrl::write_config_reg(uint32_t reg_offset, uint8_t val) {
     }
 }
 
-uint8_t CmdIdeCtrl::read_bus_master_reg(const uint8_t reg_offset) {
+// registers of the standard PCI IDE bus master interface, replicated per channel
+static inline bool is_bm_channel_reg(const uint8_t reg_offset) {
+    uint8_t ch_reg = reg_offset & 7;
+    return ch_reg == BMIDECR0 || ch_reg == BMIDESR0 || ch_reg >= DTPR0;
+}
+
+uint32_t CmdIdeCtrl::read_bus_master_reg(const uint8_t reg_offset, const int size) {
+    uint32_t value = 0;
+
+    // wide accesses span several consecutive byte registers
+    for (int i = 0; i < size && reg_offset + i < 0x10; i++)
+        value |= this->read_bus_master_byte(reg_offset + i) << (i * 8);
+
+    return value;
+}
+
+uint8_t CmdIdeCtrl::read_bus_master_byte(const uint8_t reg_offset) {
     switch(reg_offset) {
     case MRDMODE:
         return this->mrdmode;
+    case UDIDETCR0:
+        return this->udma_time_cr;
+    case BMIDECR1 + 1:
+    case BMIDECR1 + 3:
+        return 0; // unimplemented secondary channel registers, hit by wide reads
     default:
+        if (is_bm_channel_reg(reg_offset))
+            return this->bm_dma[reg_offset >> 3]->read(reg_offset & 7, 1);
         LOG_F(ERROR, "%s: unimplemented bus master reg at 0x%X", this->name.c_str(),
               reg_offset);
     }
@@ -195,7 +231,22 @@ uint8_t CmdIdeCtrl::read_bus_master_reg(const uint8_t reg_offset) {
     return 0;
 }
 
-void CmdIdeCtrl::write_bus_master_reg(const uint8_t reg_offset, const uint8_t val) {
+void CmdIdeCtrl::write_bus_master_reg(const uint8_t reg_offset, const uint32_t val,
+                                      const int size) {
+    // the descriptor table pointer is updated as a whole
+    if ((reg_offset & 7) >= DTPR0) {
+        this->bm_dma[reg_offset >> 3]->write(reg_offset & 7, val, size);
+        return;
+    }
+
+    // wide accesses span several consecutive byte registers, the command
+    // register goes last so a transfer started by it sees the new status
+    for (int i = size - 1; i >= 0; i--)
+        if (reg_offset + i < 0x10)
+            this->write_bus_master_byte(reg_offset + i, (val >> (i * 8)) & 0xFF);
+}
+
+void CmdIdeCtrl::write_bus_master_byte(const uint8_t reg_offset, const uint8_t val) {
     switch(reg_offset) {
     case MRDMODE:
         if (val & BM_CH0_INT)
@@ -213,7 +264,14 @@ void CmdIdeCtrl::write_bus_master_reg(const uint8_t reg_offset, const uint8_t va
     case UDIDETCR0:
         this->udma_time_cr = val;
         break;
+    case BMIDECR1 + 1:
+    case BMIDECR1 + 3:
+        break; // unimplemented secondary channel registers, hit by wide writes
     default:
+        if (is_bm_channel_reg(reg_offset)) {
+            this->bm_dma[reg_offset >> 3]->write(reg_offset & 7, val, 1);
+            break;
+        }
         LOG_F(ERROR, "%s: unimplemented bus master reg at 0x%X", this->name.c_str(),
               reg_offset);
     }
@@ -222,15 +280,136 @@ void CmdIdeCtrl::write_bus_master_reg(const uint8_t reg_offset, const uint8_t va
 void CmdIdeCtrl::update_irq(const int ch_num, const uint8_t irq_level) {
     bool forward_irq = !(this->mrdmode & (ch_num ? BM_BLOCK_CH1_INT : BM_BLOCK_CH0_INT));
 
-    if (irq_level)
+    if (irq_level) {
         this->mrdmode |= ch_num ? BM_CH1_INT : BM_CH0_INT;
-    else
+        this->bm_dma[ch_num]->set_intr();
+    } else
         this->mrdmode &= ~(ch_num ? BM_CH1_INT : BM_CH0_INT);
 
     if (!irq_level || forward_irq)
         this->pci_interrupt(irq_level);
 }
 
+uint32_t IdeBusMaster::read(const uint8_t reg_offset, const int size) {
+    switch (reg_offset) {
+    case BMIDECR0:
+        return this->cmd;
+    case BMIDESR0:
+        return this->status;
+    default:
+        if (reg_offset >= DTPR0)
+            return extract_bits<uint32_t>(this->prd_table, (reg_offset & 3) * 8, size * 8);
+        LOG_F(ERROR, "%s: reading unknown register at 0x%X", this->name.c_str(),
+              reg_offset);
+    }
+
+    return 0;
+}
+
+void IdeBusMaster::write(const uint8_t reg_offset, const uint32_t value, const int size) {
+    switch (reg_offset) {
+    case BMIDECR0:
+        if ((value & BM_CMD_START) && !(this->cmd & BM_CMD_START)) {
+            this->cmd = value & (BM_CMD_START | BM_CMD_WRITE);
+            this->start();
+        } else if (!(value & BM_CMD_START)) {
+            // stopping the engine aborts the transfer in progress
+            this->cmd = value & BM_CMD_WRITE;
+            this->status &= ~BM_STAT_ACTIVE;
+        }
+        break;
+    case BMIDESR0:
+        // INTR and ERROR are cleared by writing 1s
+        this->status &= ~(value & (BM_STAT_ERROR | BM_STAT_INTR));
+        this->status = (this->status & ~(BM_STAT_DRV0_DMA | BM_STAT_DRV1_DMA)) |
+                       (value & (BM_STAT_DRV0_DMA | BM_STAT_DRV1_DMA));
+        break;
+    default:
+        if (reg_offset >= DTPR0) {
+            insert_bits<uint32_t>(this->prd_table, value, (reg_offset & 3) * 8, size * 8);
+            this->prd_table &= ~3;
+            break;
+        }
+        LOG_F(ERROR, "%s: writing unknown register at 0x%X", this->name.c_str(),
+              reg_offset);
+    }
+}
+
+void IdeBusMaster::start() {
+    this->cur_prd  = this->prd_table;
+    this->xfer_len = 0;
+    this->last_prd = false;
+    this->status  |= BM_STAT_ACTIVE;
+
+    this->process_prds();
+}
+
+bool IdeBusMaster::fetch_prd() {
+    MapDmaResult res = mmu_map_dma_mem(this->cur_prd, PRD_SIZE, false);
+    if (!res.host_va) {
+        LOG_F(ERROR, "%s: invalid PRD address 0x%X", this->name.c_str(), this->cur_prd);
+        return false;
+    }
+
+    uint32_t addr  = READ_DWORD_LE_A(res.host_va);
+    uint32_t count = READ_WORD_LE_A(res.host_va + 4);
+    uint16_t flags = READ_WORD_LE_A(res.host_va + 6);
+
+    this->cur_prd += PRD_SIZE;
+    this->last_prd = !!(flags & PRD_EOT);
+    this->xfer_len = count ? count : 0x10000;
+
+    // physical regions never cross a 64KB boundary so they're contiguous in host memory
+    res = mmu_map_dma_mem(addr & ~1, this->xfer_len, false);
+    if (!res.host_va) {
+        LOG_F(ERROR, "%s: invalid DMA buffer address 0x%X", this->name.c_str(), addr);
+        return false;
+    }
+    this->xfer_ptr = res.host_va;
+
+    return true;
+}
+
+void IdeBusMaster::process_prds() {
+    if (this->dev_obj == nullptr)
+        return;
+
+    this->xfer_dir = (this->cmd & BM_CMD_WRITE) ? DMA_DIR_FROM_DEV : DMA_DIR_TO_DEV;
+
+    while (this->status & BM_STAT_ACTIVE) {
+        if (!this->xfer_len) {
+            if (this->last_prd) {
+                // PRD table exhausted
+                this->status &= ~BM_STAT_ACTIVE;
+                break;
+            }
+            if (!this->fetch_prd()) {
+                this->status &= ~BM_STAT_ACTIVE;
+                this->status |= BM_STAT_ERROR;
+                break;
+            }
+        }
+
+        // move as much data as the device has ready
+        int left;
+        if (this->xfer_dir == DMA_DIR_FROM_DEV)
+            left = this->dev_obj->xfer_from(this->xfer_ptr, this->xfer_len);
+        else
+            left = this->dev_obj->xfer_to(this->xfer_ptr, this->xfer_len);
+
+        this->xfer_ptr += this->xfer_len - left;
+        this->xfer_len  = left;
+
+        if (left)
+            break; // wait for DATA_AVAIL from the device
+    }
+}
+
+void IdeBusMaster::notify(DmaMsg msg) {
+    if (msg == DmaMsg::DATA_AVAIL && (this->status & BM_STAT_ACTIVE))
+        this->process_prds();
+}
+
 static const DeviceDescription CmdIde_Descriptor = {
     CmdIdeCtrl::create, {}, {}
 };
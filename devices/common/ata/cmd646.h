@@ -24,12 +24,15 @@ along with this program.  If not, see <https://www.gnu.org/licenses/>.
 #ifndef CMD646_IDE_H
 #define CMD646_IDE_H
 
+#include <devices/common/dmacore.h>
 #include <devices/common/hwcomponent.h>
 #include <devices/common/hwinterrupt.h>
 #include <devices/common/ata/idechannel.h>
 #include <devices/common/pci/pcidevice.h>
 
+#include <cinttypes>
 #include <memory>
+#include <string>
 
 constexpr auto DEV_ID_CMD646 = 0x646;
 constexpr auto MY_DEV_CLASS  = 0x010180;    // mass storage | IDE controller | IDE master
@@ -50,8 +53,35 @@ enum {
 
 /** CMD646 bus master registers. */
 enum {
+    BMIDECR0    = 0, // bus master command register, primary channel
     MRDMODE     = 1, // misnomer, contains interrupt control/status bits (CMD646U2 specific)
+    BMIDESR0    = 2, // bus master status register, primary channel
     UDIDETCR0   = 3, // Ultra DMA timing control register (CMD646U2 specific)
+    DTPR0       = 4, // descriptor table pointer, primary channel
+    BMIDECR1    = 8, // bus master command register, secondary channel
+    BMIDESR1    = 0xA, // bus master status register, secondary channel
+    DTPR1       = 0xC, // descriptor table pointer, secondary channel
+};
+
+/** Bit definitions for the bus master command register. */
+enum {
+    BM_CMD_START = 1 << 0,
+    BM_CMD_WRITE = 1 << 3, // transfer direction: 1 - device to memory
+};
+
+/** Bit definitions for the bus master status register. */
+enum {
+    BM_STAT_ACTIVE    = 1 << 0,
+    BM_STAT_ERROR     = 1 << 1,
+    BM_STAT_INTR      = 1 << 2,
+    BM_STAT_DRV0_DMA  = 1 << 5,
+    BM_STAT_DRV1_DMA  = 1 << 6,
+};
+
+/** Physical region descriptor (PRD) fields. */
+enum {
+    PRD_SIZE = 8,
+    PRD_EOT  = 0x8000, // end of table flag
 };
 
 /** Bit definitions for the MRDMODE register. */
@@ -62,6 +92,39 @@ enum {
     BM_BLOCK_CH1_INT = 1 << 5,
 };
 
+/** PCI IDE bus master DMA engine, one per channel. */
+class IdeBusMaster : public DmaChannel {
+public:
+    IdeBusMaster(const std::string name) { this->name = name; };
+    ~IdeBusMaster() = default;
+
+    uint32_t read(const uint8_t reg_offset, const int size);
+    void     write(const uint8_t reg_offset, const uint32_t value, const int size);
+
+    // called when the attached IDE channel raises its interrupt
+    void set_intr() { this->status |= BM_STAT_INTR; };
+
+    // DmaChannel methods
+    void notify(DmaMsg msg) override;
+
+private:
+    void start();
+    void process_prds();
+    bool fetch_prd();
+
+    std::string name;
+
+    uint8_t     cmd         = 0;
+    uint8_t     status      = 0;
+    uint32_t    prd_table   = 0; // descriptor table pointer
+    uint32_t    cur_prd     = 0; // address of the next PRD to fetch
+
+    // current PRD state
+    uint8_t*    xfer_ptr    = nullptr;
+    uint32_t    xfer_len    = 0;
+    bool        last_prd    = false;
+};
+
 class CmdIdeCtrl : public PCIDevice {
 public:
     CmdIdeCtrl();
@@ -82,8 +145,10 @@ private:
     void    notify_bar_change(int bar_num);
     uint8_t read_config_reg(uint32_t reg_offset);
     void    write_config_reg(uint32_t reg_offset, uint8_t val);
-    uint8_t read_bus_master_reg(const uint8_t reg_offset);
-    void    write_bus_master_reg(const uint8_t reg_offset, const uint8_t val);
+    uint32_t read_bus_master_reg(const uint8_t reg_offset, const int size);
+    uint8_t  read_bus_master_byte(const uint8_t reg_offset);
+    void     write_bus_master_reg(const uint8_t reg_offset, const uint32_t val, const int size);
+    void     write_bus_master_byte(const uint8_t reg_offset, const uint8_t val);
     void    update_irq(const int ch_num, const uint8_t irq_level);
 
     // on reset, programming interface defaults to
@@ -95,6 +160,8 @@ private:
     IdeChannel *ch0 = nullptr;
     IdeChannel *ch1 = nullptr;
 
+    std::unique_ptr<IdeBusMaster> bm_dma[2];
+
     // unknown default, set it to 2 clocks (60 ns)
     uint8_t     addr_setup_time_0 = 0x40; // address setup time for drive 0
     uint8_t     addr_setup_time_1 = 0x40; // address setup time for drive 1
@@ -25,6 +25,7 @@ along with this program.  If not, see <https://www.gnu.org/licenses/>.
 #define IDE_CHANNEL_H
 
 #include <devices/common/ata/atadefs.h>
+#include <devices/common/dmacore.h>
 #include <devices/common/hwcomponent.h>
 #include <devices/common/hwinterrupt.h>
 
@@ -33,7 +34,7 @@ along with this program.  If not, see <https://www.gnu.org/licenses/>.
 #include <memory>
 #include <string>
 
-class IdeChannel : public HWComponent
+class IdeChannel : public HWComponent, public DmaDevice
 {
 public:
     IdeChannel(const std::string name);
@@ -60,6 +61,25 @@ public:
         this->irq_callback(intrq_state);
     }
 
+    // DmaDevice methods
+    int xfer_from(uint8_t *buf, int len) override {
+        return this->devices[this->cur_dev]->xfer_from(buf, len);
+    }
+
+    int xfer_to(uint8_t *buf, int len) override {
+        return this->devices[this->cur_dev]->xfer_to(buf, len);
+    }
+
+    bool is_dma_capable() const {
+        return this->channel_obj != nullptr;
+    }
+
+    // tell the DMA engine that the selected device is ready for transfer
+    void signal_dma_ready() {
+        if (this->channel_obj)
+            this->channel_obj->notify(DmaMsg::DATA_AVAIL);
+    }
+
 protected:
     std::function<void(const uint8_t intrq_state)> irq_callback = nullptr;
 
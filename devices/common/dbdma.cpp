@@ -21,7 +21,6 @@ along with this program.  If not, see <https://www.gnu.org/licenses/>.
 
 /** @file Descriptor-based direct memory access emulation. */
 
-#include <core/timermanager.h>
 #include <cpu/ppc/ppcmmu.h>
 #include <devices/common/dbdma.h>
 #include <devices/common/dmacore.h>
@@ -289,11 +288,9 @@ void DMAChannel::update_irq() {
                 }
             }
             if (cond) {
-                if (int_ctrl) {
-                    TimerManager::get_instance()->add_immediate_timer([this] {
-                        this->int_ctrl->ack_dma_int(this->irq_id, 1);
-                    });
-                } else
+                if (int_ctrl)
+                    this->int_ctrl->post_dma_int(this->irq_id, 1);
+                else
                     LOG_F(ERROR, "%s Interrupt ignored", this->get_name().c_str());
             }
         }
@@ -427,9 +424,15 @@ void DMAChannel::xfer_from_device() {
 
     this->xfer_dir = DMA_DIR_FROM_DEV;
 
-    if (!this->dev_obj->xfer_from(this->queue_data, this->queue_len)) {
+    // devices return the number of bytes they couldn't transfer yet
+    int left = this->dev_obj->xfer_from(this->queue_data, this->queue_len);
+    if (!left) {
         this->queue_len = 0;
         this->finish_cmd();
+    } else {
+        this->queue_data += this->queue_len - left;
+        this->res_count  += this->queue_len - left;
+        this->queue_len   = left;
     }
 
     this->interpret_cmd();
@@ -441,14 +444,45 @@ void DMAChannel::xfer_to_device() {
 
     this->xfer_dir = DMA_DIR_TO_DEV;
 
-    if (!this->dev_obj->xfer_to(this->queue_data, this->queue_len)) {
+    int left = this->dev_obj->xfer_to(this->queue_data, this->queue_len);
+    if (!left) {
         this->queue_len = 0;
         this->finish_cmd();
+    } else {
+        this->queue_data += this->queue_len - left;
+        this->res_count  += this->queue_len - left;
+        this->queue_len   = left;
     }
 
     this->interpret_cmd();
 }
 
+void DMAChannel::notify(DmaMsg msg) {
+    if (msg != DmaMsg::DATA_AVAIL)
+        return;
+
+    // nothing to do if the channel doesn't wait for device data
+    if (!this->is_in_active() || !this->cmd_in_progress || !this->queue_len)
+        return;
+
+    switch (this->cur_cmd) {
+    case DBDMA_Cmd::OUTPUT_MORE:
+    case DBDMA_Cmd::OUTPUT_LAST:
+        this->xfer_to_device();
+        break;
+    case DBDMA_Cmd::INPUT_MORE:
+    case DBDMA_Cmd::INPUT_LAST:
+        this->xfer_from_device();
+        break;
+    }
+
+    // proceed with the DBDMA program until the next data transfer is queued
+    while (!this->cmd_in_progress && !(this->ch_stat & CH_STAT_DEAD) &&
+           (this->ch_stat & CH_STAT_ACTIVE)) {
+               this->interpret_cmd();
+    }
+}
+
 DmaPullResult DMAChannel::pull_data(uint32_t req_len, uint32_t *avail_len, uint8_t **p_data)
 {
     *avail_len = 0;
@@ -550,6 +584,46 @@ void DMAChannel::end_push_data() {
     this->interpret_cmd();
 }
 
+uint8_t* DMAChannel::get_in_buf(uint32_t *buf_len) {
+    *buf_len = 0;
+
+    if (this->ch_stat & CH_STAT_DEAD || !(this->ch_stat & CH_STAT_ACTIVE))
+        return nullptr;
+
+    // interpret DBDMA program until we get buffer to fill in or become idle
+    while ((this->ch_stat & CH_STAT_ACTIVE) && !this->queue_len) {
+        this->interpret_cmd();
+    }
+
+    if (!this->queue_len || (this->cur_cmd != DBDMA_Cmd::INPUT_MORE &&
+                             this->cur_cmd != DBDMA_Cmd::INPUT_LAST))
+        return nullptr;
+
+    *buf_len = this->queue_len;
+    return this->queue_data;
+}
+
+void DMAChannel::end_in_packet(uint32_t len) {
+    if (!this->cmd_in_progress)
+        return;
+
+    len = std::min(len, this->queue_len);
+    this->queue_data += len;
+    this->res_count  += len;
+    this->queue_len  -= len;
+
+    // a packet ends the current command early, resCount reports
+    // the unused part of its buffer
+    this->finish_cmd();
+    this->queue_len = 0;
+
+    // proceed with the DBDMA program until the next buffer is queued
+    while (!this->cmd_in_progress && !(this->ch_stat & CH_STAT_DEAD) &&
+           (this->ch_stat & CH_STAT_ACTIVE)) {
+               this->interpret_cmd();
+    }
+}
+
 bool DMAChannel::is_out_active() {
     if (this->ch_stat & CH_STAT_DEAD || !(this->ch_stat & CH_STAT_ACTIVE)) {
         return false;
@@ -123,6 +123,16 @@ public:
     void            end_pull_data();
     void            end_push_data();
 
+    // packet-oriented transfers used by network controllers
+    bool            is_last_cmd() {
+        return this->cur_cmd == DBDMA_Cmd::OUTPUT_LAST || this->cur_cmd == DBDMA_Cmd::INPUT_LAST;
+    }
+    uint8_t*        get_in_buf(uint32_t *buf_len);
+    void            end_in_packet(uint32_t len);
+
+    // DmaChannel methods
+    void notify(DmaMsg msg) override;
+
     void register_dma_int(InterruptCtrl* int_ctrl_obj, uint64_t irq_id) {
         this->int_ctrl = int_ctrl_obj;
         this->irq_id   = irq_id;
@@ -111,7 +111,7 @@ public:
     ~DmaChannel() = default;
 
     void connect(DmaDevice *dev_obj) { this->dev_obj = dev_obj; };
-    void notify(DmaMsg msg) {};
+    virtual void notify(DmaMsg msg) {};
 
 protected:
     DmaDevice*  dev_obj  = nullptr;
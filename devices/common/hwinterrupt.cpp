@@ -0,0 +1,72 @@
+/*
+DingusPPC - The Experimental PowerPC Macintosh emulator
+Copyright (C) 2018-25 divingkatae and maximum
+                      (theweirdo)     spatium
+
+(Contact divingkatae#1017 or powermax#2286 on Discord for more info)
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+/** @file Deferred delivery of interrupt line changes. */
+
+#include <cpu/ppc/ppcemu.h>
+#include <devices/common/hwinterrupt.h>
+
+InterruptCtrl*      InterruptCtrl::first_ctrl = nullptr;
+std::atomic<bool>   InterruptCtrl::ints_posted{false};
+
+// Controllers are created and destroyed along with the machine,
+// never while the CPU thread delivers interrupts.
+InterruptCtrl::InterruptCtrl() {
+    this->next_ctrl  = first_ctrl;
+    first_ctrl       = this;
+}
+
+InterruptCtrl::~InterruptCtrl() {
+    for (InterruptCtrl** p = &first_ctrl; *p; p = &(*p)->next_ctrl) {
+        if (*p == this) {
+            *p = this->next_ctrl;
+            break;
+        }
+    }
+}
+
+void InterruptCtrl::post_dma_int(uint64_t irq_id, uint8_t irq_line_state) {
+    // the level must be visible before the line is marked as changed
+    if (irq_line_state)
+        this->dma_state.fetch_or(irq_id, std::memory_order_relaxed);
+    else
+        this->dma_state.fetch_and(~irq_id, std::memory_order_relaxed);
+
+    this->dma_changed.fetch_or(irq_id, std::memory_order_release);
+    ints_posted.store(true, std::memory_order_release);
+
+    ppc_request_events();
+}
+
+void InterruptCtrl::deliver_all() {
+    // lines posted after this point keep the flag set for the next round
+    ints_posted.exchange(false, std::memory_order_acq_rel);
+
+    for (InterruptCtrl* ctrl = first_ctrl; ctrl; ctrl = ctrl->next_ctrl) {
+        // only the latest level of each changed line is delivered
+        uint64_t changed = ctrl->dma_changed.exchange(0, std::memory_order_acquire);
+        uint64_t state   = ctrl->dma_state.load(std::memory_order_relaxed);
+        for (; changed; changed &= changed - 1) {
+            uint64_t irq_id = changed & (~changed + 1);
+            ctrl->ack_dma_int(irq_id, !!(state & irq_id));
+        }
+    }
+}
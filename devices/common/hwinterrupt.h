@@ -22,6 +22,7 @@ along with this program.  If not, see <https://www.gnu.org/licenses/>.
 #ifndef HW_INTERRUPT_H
 #define HW_INTERRUPT_H
 
+#include <atomic>
 #include <cinttypes>
 
 //#define DEBUG_CPU_INT // uncomment this to enable hacks for debugging HW interrupts
@@ -95,11 +96,18 @@ enum IntSrc : uint32_t {
     VBL,
 };
 
-/** Base class for interrupt controllers. */
+/** Base class for interrupt controllers.
+
+    Besides acknowledging interrupts directly, DMA engines may post
+    interrupt line changes. Posted changes are collected in per-controller
+    masks and applied by the CPU thread before it executes the next
+    instruction. Posting is lock-free, allocation-free and may be done
+    from any thread.
+ */
 class InterruptCtrl {
 public:
-    InterruptCtrl() = default;
-    virtual ~InterruptCtrl() = default;
+    InterruptCtrl();
+    virtual ~InterruptCtrl();
 
     // register interrupt sources for a device
     virtual uint64_t register_dev_int(IntSrc src_id) = 0;
@@ -108,6 +116,25 @@ public:
     // acknowledge HW interrupt
     virtual void ack_int(uint64_t irq_id, uint8_t irq_line_state)     = 0;
     virtual void ack_dma_int(uint64_t irq_id, uint8_t irq_line_state) = 0;
+
+    // post DMA interrupt line changes for deferred delivery
+    void post_dma_int(uint64_t irq_id, uint8_t irq_line_state);
+
+    // apply posted changes of all controllers, CPU thread only
+    static void deliver_posted_ints() {
+        if (ints_posted.load(std::memory_order_relaxed))
+            deliver_all();
+    };
+
+private:
+    static void deliver_all();
+
+    std::atomic<uint64_t>   dma_state{0};       // requested line levels
+    std::atomic<uint64_t>   dma_changed{0};     // lines with pending changes
+    InterruptCtrl*          next_ctrl = nullptr;
+
+    static InterruptCtrl*       first_ctrl;
+    static std::atomic<bool>    ints_posted;
 };
 
 typedef struct {
@@ -211,8 +211,41 @@ void PCIBase::set_bar_value(int bar_num, uint32_t value)
             break;
     }
 
-    if (value != 0xFFFFFFFFUL) // don't notify the device during BAR sizing
+    if (value != 0xFFFFFFFFUL) { // don't notify the device during BAR sizing
+        this->update_io_bar(bar_num);
         this->pci_notify_bar_change(bar_num);
+    }
+}
+
+void PCIBase::update_io_bar(int bar_num)
+{
+    uint32_t size_mask;
+
+    switch (bars_typ[bar_num]) {
+    case PCIBarType::Io_16_Bit:
+        size_mask = 0xFFFFU;
+        break;
+    case PCIBarType::Io_32_Bit:
+        size_mask = 0xFFFFFFFFUL;
+        break;
+    default:
+        return;
+    }
+
+    uint32_t io_addr = this->bars[bar_num] & ~3;
+    uint32_t io_size = (~(this->bars_cfg[bar_num] & ~3) + 1) & size_mask;
+
+    if (io_addr == this->io_bars_mapped[bar_num] || !this->host_instance)
+        return;
+
+    // address zero means the BAR hasn't been assigned yet
+    if (this->io_bars_mapped[bar_num])
+        this->host_instance->pci_unregister_io_region(this->io_bars_mapped[bar_num],
+                                                      io_size, this);
+    if (io_addr)
+        this->host_instance->pci_register_io_region(io_addr, io_size, this);
+
+    this->io_bars_mapped[bar_num] = io_addr;
 }
 
 void PCIBase::finish_config_bars()
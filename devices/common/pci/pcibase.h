@@ -147,7 +147,9 @@ protected:
     void map_exp_rom_mem();
     void unmap_exp_rom_mem();
 
-    PCIHost*    host_instance; // host bridge instance to call back
+    void update_io_bar(int bar_num);
+
+    PCIHost*    host_instance = nullptr; // host bridge instance to call back
 
     // PCI configuration space state (type 0, 1, and 2)
     uint16_t    vendor_id;
@@ -168,6 +170,7 @@ protected:
     uint32_t    bars[6] = { 0 };     // BARs (base address registers)
     uint32_t    bars_cfg[6] = { 0 }; // configuration values for BARs
     PCIBarType  bars_typ[6] = { PCIBarType::Unused }; // types for BARs
+    uint32_t    io_bars_mapped[6] = { 0 }; // I/O addresses decoded by the host for BARs
 
     // PCI configuration space state (type 0 and 1)
     uint32_t    exp_bar_cfg  = 0;    // expansion ROM configuration
@@ -135,6 +135,7 @@ void PCIBridge::pci_cfg_write(uint32_t reg_offs, uint32_t value, AccessDetails &
         this->pci_wr_sec_status(value >> 16);
         this->pci_wr_io_limit(value >> 8);
         this->pci_wr_io_base(value & 0xFFU);
+        this->update_io_window();
         break;
     case PCI_CFG_MEMORY_BASE:
         this->pci_wr_memory_limit(value >> 16);
@@ -153,6 +154,7 @@ void PCIBridge::pci_cfg_write(uint32_t reg_offs, uint32_t value, AccessDetails &
     case PCI_CFG_IO_BASE_UPPER16:
         this->pci_wr_io_limit_upper16(value >> 16);
         this->pci_wr_io_base_upper16(value & 0xFFFFU);
+        this->update_io_window();
         break;
     case PCI_CFG_BRIDGE_ROM_ADDRESS:
         this->pci_wr_exp_rom_bar(value);
@@ -184,3 +186,22 @@ bool PCIBridge::pci_io_write(uint32_t offset, uint32_t value, uint32_t size)
 
     return this->pci_io_write_loop(offset, size, value);
 }
+
+void PCIBridge::update_io_window()
+{
+    uint32_t start = this->io_base_32;
+    uint32_t size  = this->io_limit_32 > start ? this->io_limit_32 - start : 0;
+
+    if (start == this->io_window_start && size == this->io_window_size)
+        return;
+
+    // let the upstream host forward accesses within the window to this bridge
+    if (this->io_window_size)
+        this->host_instance->pci_unregister_io_region(this->io_window_start,
+                                                      this->io_window_size, this);
+    if (size)
+        this->host_instance->pci_register_io_region(start, size, this);
+
+    this->io_window_start = start;
+    this->io_window_size  = size;
+}
@@ -74,6 +74,8 @@ public:
     std::function<void(uint16_t)>   pci_wr_io_limit_upper16;
 
 protected:
+    void update_io_window();
+
     // PCI configuration space state
     uint8_t     io_base = 0;
     uint8_t     io_limit = 0;
@@ -103,6 +105,10 @@ protected:
     uint64_t    memory_limit_32 = 0;
     uint64_t    pref_mem_base_64 = 0;
     uint64_t    pref_mem_limit_64 = 0;
+
+    // I/O window currently decoded by the upstream host
+    uint32_t    io_window_start = 0;
+    uint32_t    io_window_size = 0;
 };
 
 #endif /* PCI_BRIDGE_H */
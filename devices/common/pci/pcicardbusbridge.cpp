@@ -140,17 +140,17 @@ uint32_t PCICardbusBridge::pci_cfg_read(uint32_t reg_offs, AccessDetails &detail
     case PCI_CFG_CB_MEMORY_LIMIT_0:
         return this->pci_rd_memory_limit_0();
     case PCI_CFG_CB_MEMORY_BASE_1:
-        return this->pci_rd_memory_base_0();
+        return this->pci_rd_memory_base_1();
     case PCI_CFG_CB_MEMORY_LIMIT_1:
-        return this->pci_rd_memory_limit_0();
+        return this->pci_rd_memory_limit_1();
     case PCI_CFG_CB_IO_BASE_0:
         return this->pci_rd_io_base_0();
     case PCI_CFG_CB_IO_LIMIT_0:
         return this->pci_rd_io_limit_0();
     case PCI_CFG_CB_IO_BASE_1:
-        return this->pci_rd_io_base_0();
+        return this->pci_rd_io_base_1();
     case PCI_CFG_CB_IO_LIMIT_1:
-        return this->pci_rd_io_limit_0();
+        return this->pci_rd_io_limit_1();
     case PCI_CFG_CB_SUBSYSTEM_IDS:
         return (this->subsys_id << 16) | (this->subsys_vndr);
     case PCI_CFG_CB_LEGACY_MODE_BASE:
@@ -176,22 +176,26 @@ void PCICardbusBridge::pci_cfg_write(uint32_t reg_offs, uint32_t value, AccessDe
         this->pci_wr_memory_limit_0(value);
         break;
     case PCI_CFG_CB_MEMORY_BASE_1:
-        this->pci_wr_memory_base_0(value);
+        this->pci_wr_memory_base_1(value);
         break;
     case PCI_CFG_CB_MEMORY_LIMIT_1:
-        this->pci_wr_memory_limit_0(value);
+        this->pci_wr_memory_limit_1(value);
         break;
     case PCI_CFG_CB_IO_BASE_0:
         this->pci_wr_io_base_0(value);
+        this->update_io_windows();
         break;
     case PCI_CFG_CB_IO_LIMIT_0:
         this->pci_wr_io_limit_0(value);
+        this->update_io_windows();
         break;
     case PCI_CFG_CB_IO_BASE_1:
-        this->pci_wr_io_base_0(value);
+        this->pci_wr_io_base_1(value);
+        this->update_io_windows();
         break;
     case PCI_CFG_CB_IO_LIMIT_1:
-        this->pci_wr_io_limit_0(value);
+        this->pci_wr_io_limit_1(value);
+        this->update_io_windows();
         break;
 /*
     case PCI_CFG_CB_LEGACY_MODE_BASE:
@@ -219,5 +223,27 @@ bool PCICardbusBridge::pci_io_write(uint32_t offset, uint32_t value, uint32_t si
     if ((offset < this->io_base_0_32 || offset + size >= this->io_limit_0_32) &&
         (offset < this->io_base_1_32 || offset + size >= this->io_limit_1_32)
     ) return false;
-    return this->pci_io_read_loop(offset, size, value);
+    return this->pci_io_write_loop(offset, size, value);
+}
+
+void PCICardbusBridge::update_io_windows()
+{
+    uint32_t starts[2] = { this->io_base_0_32, this->io_base_1_32 };
+    uint32_t limits[2] = { this->io_limit_0_32, this->io_limit_1_32 };
+
+    for (int i = 0; i < 2; i++) {
+        uint32_t size = limits[i] > starts[i] ? limits[i] - starts[i] : 0;
+
+        if (starts[i] == this->io_window_start[i] && size == this->io_window_size[i])
+            continue;
+
+        if (this->io_window_size[i])
+            this->host_instance->pci_unregister_io_region(this->io_window_start[i],
+                                                          this->io_window_size[i], this);
+        if (size)
+            this->host_instance->pci_register_io_region(starts[i], size, this);
+
+        this->io_window_start[i] = starts[i];
+        this->io_window_size[i]  = size;
+    }
 }
@@ -77,6 +77,8 @@ public:
     std::function<void(uint32_t)>    pci_wr_io_limit_1;
 
 protected:
+    void update_io_windows();
+
     // PCI configuration space state
     uint32_t    memory_base_0 = 0;
     uint32_t    memory_limit_0 = 0;
@@ -107,6 +109,10 @@ protected:
     uint32_t    io_limit_0_32 = 0;
     uint32_t    io_base_1_32 = 0;
     uint32_t    io_limit_1_32 = 0;
+
+    // I/O windows currently decoded by the upstream host
+    uint32_t    io_window_start[2] = { 0 };
+    uint32_t    io_window_size[2] = { 0 };
 };
 
 #endif /* PCI_CARDBUSBRIDGE_H */
@@ -29,7 +29,9 @@ along with this program.  If not, see <https://www.gnu.org/licenses/>.
 #include <endianswap.h>
 #include <loguru.hpp>
 
+#include <algorithm>
 #include <cinttypes>
+#include <cstring>
 #include <cpu/ppc/ppcemu.h>
 
 bool PCIHost::pci_register_device(int dev_fun_num, PCIBase* dev_instance)
@@ -59,10 +61,6 @@ bool PCIHost::pci_register_device(int dev_fun_num, PCIBase* dev_instance)
         dev_instance->set_multi_function(true);
     }
 
-    if (dev_instance->supports_io_space()) {
-        this->io_space_devs.push_back(dev_instance);
-    }
-
     PCIBridgeBase *bridge = dynamic_cast<PCIBridgeBase*>(dev_instance);
     if (bridge) {
         this->bridge_devs.push_back(bridge);
@@ -87,6 +85,11 @@ void PCIHost::pci_unregister_device(int dev_fun_num)
     );
 
     this->dev_map.erase(dev_fun_num);
+
+    // stop decoding I/O addresses for the removed device
+    this->io_ranges.erase(std::remove_if(this->io_ranges.begin(), this->io_ranges.end(),
+        [=](const PciIoRange& rng) { return rng.dev == dev_instance; }), this->io_ranges.end());
+    this->rebuild_io_decode();
     gMachineObj->remove_device(dev_instance); // calls destructor of dev_instance since it is a unique_ptr in the device_map.
 }
 
@@ -106,6 +109,68 @@ bool PCIHost::pci_unregister_mmio_region(uint32_t start_addr, uint32_t size, PCI
     return mem_ctrl->remove_mmio_region(start_addr, size, obj);
 }
 
+void PCIHost::pci_register_io_region(uint32_t start_addr, uint32_t size, PCIBase* obj)
+{
+    if (!size)
+        return;
+
+    // I/O resources are dword granular
+    uint32_t end_addr = (start_addr + size + 3) & ~3;
+    start_addr &= ~3;
+
+    // later registrations take precedence over overlapping ones
+    this->io_ranges.push_back({start_addr, end_addr, obj});
+    this->rebuild_io_decode();
+}
+
+void PCIHost::pci_unregister_io_region(uint32_t start_addr, uint32_t size, PCIBase* obj)
+{
+    uint32_t end_addr = (start_addr + size + 3) & ~3;
+    start_addr &= ~3;
+
+    auto it = std::find_if(this->io_ranges.begin(), this->io_ranges.end(),
+        [=](const PciIoRange& rng) {
+            return rng.start == start_addr && rng.end == end_addr && rng.dev == obj;
+        });
+
+    if (it != this->io_ranges.end()) {
+        this->io_ranges.erase(it);
+        this->rebuild_io_decode();
+    }
+}
+
+void PCIHost::rebuild_io_decode()
+{
+    this->io_decode_devs.assign(1, nullptr);
+    std::memset(this->io_decode.get(), 0, PCI_IO_DECODE_SIZE >> 2);
+
+    for (auto& rng : this->io_ranges) {
+        if (rng.start >= PCI_IO_DECODE_SIZE)
+            continue;
+
+        auto it = std::find(this->io_decode_devs.begin(), this->io_decode_devs.end(), rng.dev);
+        uint8_t idx = it - this->io_decode_devs.begin();
+        if (it == this->io_decode_devs.end()) {
+            if (this->io_decode_devs.size() > 255)
+                ABORT_F("PCIHost: too many devices in I/O space");
+            this->io_decode_devs.push_back(rng.dev);
+        }
+
+        uint32_t end = std::min<uint32_t>(rng.end, PCI_IO_DECODE_SIZE);
+        for (uint32_t port = rng.start; port < end; port += 4)
+            this->io_decode[port >> 2] = idx;
+    }
+}
+
+PCIBase* PCIHost::pci_io_decode_high(uint32_t offset)
+{
+    for (auto it = this->io_ranges.rbegin(); it != this->io_ranges.rend(); ++it) {
+        if (offset >= it->start && offset < it->end)
+            return it->dev;
+    }
+    return nullptr;
+}
+
 void PCIHost::attach_pci_device(const std::string& dev_name, int slot_id)
 {
     this->attach_pci_device(dev_name, slot_id, "");
@@ -195,30 +260,22 @@ bool PCIHost::register_pci_int(PCIBase* dev_instance) {
 
 bool PCIHost::pci_io_read_loop(uint32_t offset, int size, uint32_t &res)
 {
-    for (auto& dev : this->io_space_devs) {
-        if (dev->pci_io_read(offset, size, &res)) {
-            return true;
-        }
-    }
-    return false;
+    PCIBase* dev = this->pci_io_decode(offset);
+    return dev && dev->pci_io_read(offset, size, &res);
 }
 
 bool PCIHost::pci_io_write_loop(uint32_t offset, int size, uint32_t value)
 {
-    for (auto& dev : this->io_space_devs) {
-        if (dev->pci_io_write(offset, value, size)) {
-            return true;
-        }
-    }
-    return false;
+    PCIBase* dev = this->pci_io_decode(offset);
+    return dev && dev->pci_io_write(offset, value, size);
 }
 
 uint32_t PCIHost::pci_io_read_broadcast(uint32_t offset, int size)
 {
     uint32_t res;
 
-    // broadcast I/O request to devices that support I/O space
-    // until a device returns true that means "request accepted"
+    // forward I/O request to the device decoding that address,
+    // it returns true that means "request accepted"
     if (pci_io_read_loop(offset, size, res))
         return res;
 
@@ -236,8 +293,8 @@ uint32_t PCIHost::pci_io_read_broadcast(uint32_t offset, int size)
 
 void PCIHost::pci_io_write_broadcast(uint32_t offset, int size, uint32_t value)
 {
-    // broadcast I/O request to devices that support I/O space
-    // until a device returns true that means "request accepted"
+    // forward I/O request to the device decoding that address,
+    // it returns true that means "request accepted"
     if (pci_io_write_loop(offset, size, value))
         return;
 
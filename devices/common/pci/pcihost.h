@@ -27,6 +27,7 @@ along with this program.  If not, see <https://www.gnu.org/licenses/>.
 #include <endianswap.h>
 
 #include <cinttypes>
+#include <memory>
 #include <string>
 #include <unordered_map>
 #include <vector>
@@ -50,20 +51,30 @@ typedef struct AccessDetails {
 
 #define DEV_FUN(dev_num,fun_num) (((dev_num) << 3) | (fun_num))
 
+class PCIBase;
+class PCIBridgeBase;
+
 typedef struct {
     const char *    slot_name;
     int             dev_fun_num;
     IntSrc          int_src;
 } PciIrqMap;
 
-class PCIBase;
-class PCIBridgeBase;
+/** I/O space window claimed by a device or a bridge. */
+typedef struct {
+    uint32_t    start;
+    uint32_t    end;    // last port + 1
+    PCIBase*    dev;
+} PciIoRange;
+
+/** Size of the I/O space decoded by a lookup table, ranges above it are searched. */
+#define PCI_IO_DECODE_SIZE  0x10000
 
 class PCIHost {
 public:
     PCIHost() {
         this->dev_map.clear();
-        io_space_devs.clear();
+        io_ranges.clear();
     };
     ~PCIHost() = default;
 
@@ -73,6 +84,9 @@ public:
     virtual bool pci_register_mmio_region(uint32_t start_addr, uint32_t size, PCIBase* obj);
     virtual bool pci_unregister_mmio_region(uint32_t start_addr, uint32_t size, PCIBase* obj);
 
+    virtual void pci_register_io_region(uint32_t start_addr, uint32_t size, PCIBase* obj);
+    virtual void pci_unregister_io_region(uint32_t start_addr, uint32_t size, PCIBase* obj);
+
     virtual void attach_pci_device(const std::string& dev_name, int slot_id);
     PCIBase *attach_pci_device(const std::string& dev_name, int slot_id,
                                const std::string& dev_suffix);
@@ -98,11 +112,25 @@ public:
     virtual InterruptCtrl *get_interrupt_controller();
 
 protected:
+    PCIBase* pci_io_decode(uint32_t offset) {
+        if (offset < PCI_IO_DECODE_SIZE)
+            return this->io_decode_devs[this->io_decode[offset >> 2]];
+        return this->pci_io_decode_high(offset);
+    };
+
+    PCIBase* pci_io_decode_high(uint32_t offset);
+    void     rebuild_io_decode();
+
     std::unordered_map<int, PCIBase*> dev_map;
-    std::vector<PCIBase*>             io_space_devs;
     std::vector<PCIBridgeBase*>       bridge_devs;
     std::vector<PciIrqMap>            my_irq_map;
 
+    // decoded I/O space: every dword of the low I/O space holds an index
+    // into io_decode_devs, index 0 means no device responds
+    std::vector<PciIoRange>           io_ranges;
+    std::vector<PCIBase*>             io_decode_devs = { nullptr };
+    std::unique_ptr<uint8_t[]>        io_decode{new uint8_t[PCI_IO_DECODE_SIZE >> 2]()};
+
     InterruptCtrl   *int_ctrl = nullptr;
 };
 
@@ -296,6 +296,7 @@ void MeshController::report_error(const int error) {
 
 static const PropMap Mesh_properties = {
     {"hdd_img2", new StrProperty("")},
+    {"hdd_overlay2", new StrProperty("")},
     {"cdr_img2", new StrProperty("")},
 };
 
@@ -27,6 +27,7 @@ along with this program.  If not, see <https://www.gnu.org/licenses/>.
 #include <devices/common/hwinterrupt.h>
 #include <devices/common/scsi/sc53c94.h>
 #include <devices/deviceregistry.h>
+#include <devices/storage/diskioworker.h>
 #include <loguru.hpp>
 #include <machines/machinebase.h>
 
@@ -770,7 +771,7 @@ int Sc53C94::xfer_from(uint8_t *buf, int len) {
         }
     }
 
-    if (this->bus_obj->pull_data(this->target_id, buf, this->xfer_count)) {
+    if (this->bus_obj->pull_data_dma(this->target_id, buf, this->xfer_count)) {
         this->xfer_count = 0;
         this->status |= STAT_TC; // signal zero transfer count
         this->cur_state = SeqState::XFER_END;
@@ -790,7 +791,7 @@ int Sc53C94::xfer_to(uint8_t *buf, int len) {
     // For simplicity, the code below transfers the whole chunk at once.
     // This can be broken into smaller chunks later if desired.
     if (this->cur_bus_phase == ScsiPhase::DATA_OUT) {
-        if (this->bus_obj->push_data(this->target_id, buf, len)) {
+        if (this->bus_obj->push_data_dma(this->target_id, buf, len)) {
             this->xfer_count -= len;
             if (!this->xfer_count) {
                 this->status |= STAT_TC; // signal zero transfer count
@@ -818,10 +819,11 @@ int Sc53C94::xfer_to(uint8_t *buf, int len) {
     return len;
 }
 
-static const PropMap Sc53C94_properties = {
+static const PropMap Sc53C94_properties = add_hdd_cache_props({
     {"hdd_img", new StrProperty("")},
+    {"hdd_overlay", new StrProperty("")},
     {"cdr_img", new StrProperty("")},
-};
+});
 
 static const DeviceDescription Sc53C94_Descriptor = {
     Sc53C94::create, {}, Sc53C94_properties
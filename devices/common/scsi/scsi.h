@@ -114,9 +114,10 @@ enum ScsiCommand : uint8_t {
     READ_10                      = 0x28,
     WRITE_10                     = 0x2A,
     VERIFY_10                    = 0x2F,
-    READ_LONG_10                 = 0x35,
+    SYNCHRONIZE_CACHE_10         = 0x35,
     WRITE_BUFFER                 = 0x3B,
     READ_BUFFER                  = 0x3C,
+    READ_LONG_10                 = 0x3E,
     MODE_SENSE_10                = 0x5A,
     READ_12                      = 0xA8,
 
@@ -189,8 +190,19 @@ public:
     virtual int  xfer_data();
     virtual int  send_data(uint8_t* dst_ptr, int count);
     virtual int  rcv_data(const uint8_t* src_ptr, const int count);
+
+    // Bulk data phase transfers between the target and a DMA buffer in guest
+    // memory. Devices may move data straight between their backing store and
+    // the DMA buffer here, the default implementation uses the data buffer.
+    virtual int  send_data_dma(uint8_t* dst_ptr, int count) {
+        return this->send_data(dst_ptr, count);
+    };
+    virtual int  rcv_data_dma(const uint8_t* src_ptr, const int count) {
+        return this->rcv_data(src_ptr, count);
+    };
     virtual bool check_lun();
     void illegal_command(const uint8_t* cmd);
+    void resume_phase(const int new_phase);
 
     virtual bool prepare_data() = 0;
     virtual bool get_more_data() = 0;
@@ -220,6 +232,8 @@ protected:
     int         sksv;
     int         field;
 
+    bool        io_pending = false; // asynchronous I/O in progress
+
     bool        last_selection_has_atention = false;
     uint8_t     last_selection_message = 0;
     ScsiBus*    bus_obj;
@@ -278,6 +292,9 @@ public:
     void disconnect(int dev_id);
     bool pull_data(const int id, uint8_t* dst_ptr, const int size);
     bool push_data(const int id, const uint8_t* src_ptr, const int size);
+    // same as above for host adapters transferring data to/from DMA buffers
+    bool pull_data_dma(const int id, uint8_t* dst_ptr, const int size);
+    bool push_data_dma(const int id, const uint8_t* src_ptr, const int size);
     int  target_xfer_data();
     void target_next_step();
     bool negotiate_xfer(int& bytes_in, int& bytes_out);
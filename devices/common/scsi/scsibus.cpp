@@ -284,6 +284,38 @@ bool ScsiBus::push_data(const int id, const uint8_t* src_ptr, const int size)
     return true;
 }
 
+bool ScsiBus::pull_data_dma(const int id, uint8_t* dst_ptr, const int size)
+{
+    if (dst_ptr == nullptr || !size) {
+        return false;
+    }
+
+    if (!this->devices[id]->send_data_dma(dst_ptr, size)) {
+        LOG_F(ERROR, "%s: error while transferring T->I data!", this->get_name().c_str());
+        return false;
+    }
+
+    return true;
+}
+
+bool ScsiBus::push_data_dma(const int id, const uint8_t* src_ptr, const int size)
+{
+    if (!this->devices[id]) {
+        LOG_F(ERROR, "%s: no device %d for push_data_dma %d bytes",
+              this->get_name().c_str(), id, size);
+        return false;
+    }
+
+    if (!this->devices[id]->rcv_data_dma(src_ptr, size)) {
+        if (size) {
+            LOG_F(ERROR, "%s: error while transferring I->T data!", this->get_name().c_str());
+            return false;
+        }
+    }
+
+    return true;
+}
+
 int ScsiBus::target_xfer_data() {
     return this->devices[this->target_id]->xfer_data();
 }
@@ -328,7 +360,13 @@ void ScsiBus::attach_scsi_devices(const std::string bus_suffix)
     image_path = GET_STR_PROP("hdd_img" + bus_suffix);
     if (!image_path.empty()) {
         std::istringstream image_stream(image_path);
+        // optional overlays are matched to the images by their position
+        std::istringstream overlay_stream(GET_STR_PROP("hdd_overlay" + bus_suffix));
+        std::string overlay_path;
         while (std::getline(image_stream, path, ':')) {
+            if (!std::getline(overlay_stream, overlay_path, ':'))
+                overlay_path.clear();
+
             // do two passes because we skip ID 3.
             for (scsi_id = 0; scsi_id < SCSI_MAX_DEVS * 2 && (scsi_id == 3 ||
                  this->devices[scsi_id % SCSI_MAX_DEVS]); scsi_id++) {}
@@ -341,7 +379,7 @@ void ScsiBus::attach_scsi_devices(const std::string bus_suffix)
                 gMachineObj->add_device(scsi_device_name,
                                         std::unique_ptr<ScsiHardDisk>(scsi_device));
                 this->register_device(scsi_id, scsi_device);
-                scsi_device->insert_image(path);
+                scsi_device->insert_image(path, overlay_path);
             }
             else {
                 LOG_F(ERROR, "%s: Too many devices. HDD \"%s\" was not added.",
@@ -241,7 +241,7 @@ int ScsiBusController::xfer_from(uint8_t *buf, int len) {
 
     int dma_bytes = std::min(this->to_xfer, len);
 
-    if (this->bus_obj->pull_data(this->dst_id, buf, dma_bytes)) {
+    if (this->bus_obj->pull_data_dma(this->dst_id, buf, dma_bytes)) {
         this->to_xfer -= dma_bytes;
         if (this->to_xfer <= 0) {
             this->xfer_count = this->to_xfer;
@@ -75,7 +75,9 @@ void ScsiDevice::next_step()
             if (this->post_xfer_action != nullptr) {
                 this->post_xfer_action();
             }
-            this->switch_phase(ScsiPhase::STATUS);
+            // status will be reported by resume_phase() once I/O completes
+            if (!this->io_pending)
+                this->switch_phase(ScsiPhase::STATUS);
         }
         break;
     case ScsiPhase::DATA_IN:
@@ -110,6 +112,24 @@ void ScsiDevice::next_step()
     }
 }
 
+/** Continue with a command after deferred I/O has been completed. */
+void ScsiDevice::resume_phase(const int new_phase)
+{
+    int old_phase = this->cur_phase;
+
+    this->io_pending = false;
+    this->switch_phase(new_phase);
+
+    // do what next_step() would have done after process_command()
+    if (old_phase == ScsiPhase::COMMAND) {
+        if (this->prepare_data()) {
+            this->bus_obj->assert_ctrl_line(this->scsi_id, SCSI_CTRL_REQ);
+        } else {
+            ABORT_F("ScsiDevice: prepare_data() failed");
+        }
+    }
+}
+
 void ScsiDevice::prepare_xfer(ScsiBus* bus_obj, int& bytes_in, int& bytes_out)
 {
     this->cur_phase = bus_obj->current_phase();
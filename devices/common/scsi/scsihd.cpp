@@ -39,11 +39,28 @@ ScsiHardDisk::ScsiHardDisk(std::string name, int my_id) : ScsiDevice(name, my_id
     this->data_buf = this->data_buf_obj.get();
 }
 
-void ScsiHardDisk::insert_image(std::string filename) {
+ScsiHardDisk::~ScsiHardDisk() {
+    if (this->flush_timer_id)
+        TimerManager::get_instance()->cancel_timer(this->flush_timer_id);
+
+    // don't pull the rug from under outstanding I/O jobs
+    if (DiskIoWorker* io_worker = DiskIoWorker::get_instance_if_running()) {
+        io_worker->cancel_completions(this);
+        io_worker->wait_idle();
+    }
+}
+
+void ScsiHardDisk::insert_image(std::string filename, std::string overlay) {
     //We don't want to store everything in memory, but
     //we want to keep the hard disk available.
-    if (!this->disk_img.open(filename))
-        ABORT_F("%s: could not open image file %s", this->name.c_str(), filename.c_str());
+    if (overlay.empty()) {
+        if (!this->disk_img.open(filename))
+            ABORT_F("%s: could not open image file %s", this->name.c_str(), filename.c_str());
+    } else {
+        if (!this->disk_img.open_overlay(filename, overlay))
+            ABORT_F("%s: could not open image file %s with overlay %s",
+                    this->name.c_str(), filename.c_str(), overlay.c_str());
+    }
 
     this->img_size = this->disk_img.size();
     uint64_t tb = (this->img_size + this->sector_size - 1) / this->sector_size;
@@ -51,6 +68,23 @@ void ScsiHardDisk::insert_image(std::string filename) {
     if (this->total_blocks < 0 || tb != this->total_blocks) {
         ABORT_F("%s: file size is too large", this->name.c_str());
     }
+    this->seek_model.set_total_blocks(this->total_blocks);
+
+    uint32_t cache_mb      = GET_INT_PROP("hdd_cache_size");
+    bool     write_through = GET_BIN_PROP("hdd_write_through");
+
+    this->disk_img.set_cache((uint64_t)cache_mb << 20, write_through);
+
+    // the cache serializes the flush with the I/O jobs of the device
+    uint32_t flush_ms = GET_INT_PROP("hdd_flush_ms");
+    if (flush_ms && cache_mb && !write_through && !this->flush_timer_id) {
+        this->flush_timer_id = TimerManager::get_instance()->add_cyclic_timer(
+            MSECS_TO_NSECS(flush_ms), [this]() {
+                DiskIoWorker::get_instance()->post([this]() {
+                    this->disk_img.flush();
+                });
+        });
+    }
 }
 
 void ScsiHardDisk::process_command() {
@@ -58,6 +92,7 @@ void ScsiHardDisk::process_command() {
 
     this->pre_xfer_action  = nullptr;
     this->post_xfer_action = nullptr;
+    this->direct_xfer      = false;
 
     // assume successful command execution
     this->status = ScsiStatus::GOOD;
@@ -110,6 +145,9 @@ void ScsiHardDisk::process_command() {
         lba = READ_DWORD_BE_U(&cmd[2]);
         this->write(lba, READ_WORD_BE_U(&cmd[7]), 10);
         break;
+    case ScsiCommand::SYNCHRONIZE_CACHE_10:
+        this->sync_cache();
+        break;
     case ScsiCommand::READ_BUFFER:
         read_buffer();
         break;
@@ -464,21 +502,33 @@ void ScsiHardDisk::read(uint32_t lba, uint16_t transfer_len, uint8_t cmd_len) {
     }
     transfer_size *= this->sector_size;
 
-    if (transfer_size > this->data_buf_size) {
-        while (transfer_size > this->data_buf_size)
-            this->data_buf_size <<= 1;
-        this->data_buf_obj = std::unique_ptr<uint8_t[]>(new uint8_t[this->data_buf_size]);
-        this->data_buf = this->data_buf_obj.get();
-    }
-    std::memset(this->data_buf, 0, transfer_size);
-
     uint64_t device_offset = (uint64_t)lba * this->sector_size;
 
-    this->disk_img.read(this->data_buf, device_offset, transfer_size);
-
     this->bytes_out = transfer_size;
 
-    this->switch_phase(ScsiPhase::DATA_IN);
+    if (!DiskIoWorker::get_instance()->is_async()) {
+        // defer reading until the host adapter provides the destination
+        this->direct_xfer   = true;
+        this->direct_offset = device_offset;
+        this->switch_phase(ScsiPhase::DATA_IN);
+        return;
+    }
+
+    this->grow_data_buf(transfer_size);
+    std::memset(this->data_buf, 0, transfer_size);
+
+    this->io_pending = DiskIoWorker::get_instance()->submit(this,
+        [this, device_offset, transfer_size]() {
+            this->disk_img.read(this->data_buf, device_offset, transfer_size);
+        },
+        this->seek_model.access_time(lba, transfer_size / this->sector_size,
+                                     this->sector_size),
+        [this]() {
+            this->resume_phase(ScsiPhase::DATA_IN);
+        });
+
+    if (!this->io_pending)
+        this->switch_phase(ScsiPhase::DATA_IN);
 }
 
 void ScsiHardDisk::write(uint32_t lba, uint16_t transfer_len, uint8_t cmd_len) {
@@ -488,24 +538,130 @@ void ScsiHardDisk::write(uint32_t lba, uint16_t transfer_len, uint8_t cmd_len) {
     }
     transfer_size *= this->sector_size;
 
-    if (transfer_size > this->data_buf_size) {
-        while (transfer_size > this->data_buf_size)
-            this->data_buf_size <<= 1;
-        this->data_buf_obj = std::unique_ptr<uint8_t[]>(new uint8_t[this->data_buf_size]);
-        this->data_buf = this->data_buf_obj.get();
-    }
+    this->grow_data_buf(transfer_size);
 
     uint64_t device_offset = (uint64_t)lba * this->sector_size;
 
     this->incoming_size = transfer_size;
 
-    this->post_xfer_action = [this, device_offset]() {
-        this->disk_img.write(this->data_buf, device_offset, this->incoming_size);
+    if (!DiskIoWorker::get_instance()->is_async()) {
+        // DMA data goes straight to the image, FIFO data is staged in data_buf
+        this->direct_xfer   = true;
+        this->direct_offset = device_offset;
+        this->staged_ranges.clear();
+        this->post_xfer_action = [this]() {
+            for (auto& range : this->staged_ranges)
+                this->disk_img.write(&this->data_buf[range.first],
+                                     this->direct_offset + range.first, range.second);
+            this->staged_ranges.clear();
+        };
+        this->switch_phase(ScsiPhase::DATA_OUT);
+        return;
+    }
+
+    this->post_xfer_action = [this, lba, device_offset]() {
+        uint32_t write_size = this->incoming_size;
+        this->io_pending = DiskIoWorker::get_instance()->submit(this,
+            [this, device_offset, write_size]() {
+                this->disk_img.write(this->data_buf, device_offset, write_size);
+            },
+            this->seek_model.access_time(lba, write_size / this->sector_size,
+                                         this->sector_size),
+            [this]() {
+                this->resume_phase(ScsiPhase::STATUS);
+            });
     };
 
     this->switch_phase(ScsiPhase::DATA_OUT);
 }
 
+void ScsiHardDisk::grow_data_buf(uint32_t size) {
+    if (size > this->data_buf_size) {
+        while (size > this->data_buf_size)
+            this->data_buf_size <<= 1;
+        this->data_buf_obj = std::unique_ptr<uint8_t[]>(new uint8_t[this->data_buf_size]);
+        this->data_buf = this->data_buf_obj.get();
+    }
+}
+
+int ScsiHardDisk::send_data(uint8_t* dst_ptr, int count) {
+    if (this->direct_xfer && this->cur_phase == ScsiPhase::DATA_IN) {
+        // FIFO access, read the remaining data into the buffer
+        this->direct_offset += this->bytes_out - this->data_size;
+        this->grow_data_buf(this->data_size);
+        uint64_t got = this->disk_img.read(this->data_buf, this->direct_offset, this->data_size);
+        if (got < (uint64_t)this->data_size)
+            std::memset(&this->data_buf[got], 0, this->data_size - got);
+        this->data_ptr    = this->data_buf;
+        this->direct_xfer = false;
+    }
+
+    return ScsiDevice::send_data(dst_ptr, count);
+}
+
+int ScsiHardDisk::send_data_dma(uint8_t* dst_ptr, int count) {
+    if (!this->direct_xfer || this->cur_phase != ScsiPhase::DATA_IN)
+        return this->send_data(dst_ptr, count);
+
+    if (dst_ptr == nullptr || !count)
+        return 0;
+
+    int actual_count = std::min(this->data_size, count);
+
+    uint64_t got = this->disk_img.read(dst_ptr, this->direct_offset + this->bytes_out -
+                                       this->data_size, actual_count);
+    if (got < (uint64_t)actual_count)
+        std::memset(&dst_ptr[got], 0, actual_count - got);
+    this->data_size -= actual_count;
+
+    return actual_count;
+}
+
+int ScsiHardDisk::rcv_data(const uint8_t* src_ptr, const int count) {
+    if (this->direct_xfer && this->cur_phase == ScsiPhase::DATA_OUT) {
+        // remember which parts of data_buf have to be written to the image
+        if (!this->staged_ranges.empty() &&
+            this->staged_ranges.back().first + this->staged_ranges.back().second ==
+            (uint32_t)this->data_size)
+            this->staged_ranges.back().second += count;
+        else
+            this->staged_ranges.push_back({this->data_size, count});
+    }
+
+    return ScsiDevice::rcv_data(src_ptr, count);
+}
+
+int ScsiHardDisk::rcv_data_dma(const uint8_t* src_ptr, const int count) {
+    if (!this->direct_xfer || this->cur_phase != ScsiPhase::DATA_OUT)
+        return this->rcv_data(src_ptr, count);
+
+    int actual_count = std::min(count, this->incoming_size - this->data_size);
+
+    this->disk_img.write(src_ptr, this->direct_offset + this->data_size, actual_count);
+    this->data_ptr  += actual_count;
+    this->data_size += actual_count;
+
+    return actual_count;
+}
+
+void ScsiHardDisk::sync_cache() {
+    if (!check_lun())
+        return;
+
+    // IMMED and the block range are ignored, the whole cache is written back
+    this->io_pending = DiskIoWorker::get_instance()->submit(this,
+        [this]() {
+            this->disk_img.flush();
+        },
+        0,
+        [this]() {
+            this->resume_phase(ScsiPhase::STATUS);
+        });
+
+    if (!this->io_pending)
+        this->switch_phase(ScsiPhase::STATUS);
+}
+
 void ScsiHardDisk::read_buffer() {
     uint8_t  mode = this->cmd_buf[1];
     uint32_t alloc_len = (this->cmd_buf[6] << 24) | (this->cmd_buf[7] << 16) |
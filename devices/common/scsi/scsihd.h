@@ -25,22 +25,30 @@ along with this program.  If not, see <https://www.gnu.org/licenses/>.
 #define SCSI_HD_H
 
 #include <devices/common/scsi/scsi.h>
+#include <devices/storage/diskioworker.h>
 #include <utils/imgfile.h>
 
 #include <cinttypes>
 #include <memory>
 #include <string>
+#include <utility>
+#include <vector>
 
 class ScsiHardDisk : public ScsiDevice {
 public:
     ScsiHardDisk(std::string name, int my_id);
-    ~ScsiHardDisk() = default;
+    ~ScsiHardDisk();
 
-    void insert_image(std::string filename);
+    void insert_image(std::string filename, std::string overlay = "");
     void process_command();
     bool prepare_data();
     bool get_more_data() { return false; };
 
+    int  send_data(uint8_t* dst_ptr, int count) override;
+    int  rcv_data(const uint8_t* src_ptr, const int count) override;
+    int  send_data_dma(uint8_t* dst_ptr, int count) override;
+    int  rcv_data_dma(const uint8_t* src_ptr, const int count) override;
+
 protected:
     int  test_unit_ready();
     int  req_sense(uint16_t alloc_len);
@@ -56,9 +64,14 @@ protected:
     void seek(uint32_t lba);
     void rewind();
     void read_buffer();
+    void sync_cache();
+
+    void grow_data_buf(uint32_t size);
 
 private:
     ImgFile         disk_img;
+    DiskSeekModel   seek_model;
+    uint32_t        flush_timer_id = 0;
     uint64_t        img_size;
     int             total_blocks;
     uint64_t        file_offset = 0;
@@ -70,6 +83,13 @@ private:
     uint8_t*        data_buf = nullptr;
     uint32_t        data_buf_size = 0;
 
+    // Direct data phase: READ/WRITE data is moved straight between the disk
+    // image and DMA buffers. Data transferred through the controller FIFO
+    // goes through data_buf instead.
+    bool            direct_xfer = false;
+    uint64_t        direct_offset = 0; // image offset of the first data byte
+    std::vector<std::pair<uint32_t, uint32_t>> staged_ranges; // FIFO data in data_buf
+
     uint8_t         error = ScsiError::NO_ERROR;
     uint8_t         msg_code = 0;
 
@@ -21,21 +21,50 @@ along with this program.  If not, see <https://www.gnu.org/licenses/>.
 
 /** @file BigMac Ethernet controller emulation. */
 
+#include <core/timermanager.h>
 #include <devices/deviceregistry.h>
 #include <devices/ethernet/bigmac.h>
 #include <loguru.hpp>
+#include <machines/machinebase.h>
+#include <machines/machineproperties.h>
+#include <memaccess.h>
+
+// how often the backend is checked for incoming frames
+constexpr uint64_t BMAC_RCV_POLL_INTERVAL = USECS_TO_NSECS(500);
 
 BigMac::BigMac(uint8_t id) {
     set_name("BigMac");
     supports_types(HWCompType::MMIO_DEV | HWCompType::ETHER_MAC);
 
     this->chip_id = id;
+    this->backend = NetBackEnd::create_from_props();
+    this->xmit_frame.reserve(NET_MAX_FRAME_SIZE);
     this->chip_reset();
 }
 
+BigMac::~BigMac() {
+    if (this->rcv_timer_id)
+        TimerManager::get_instance()->cancel_timer(this->rcv_timer_id);
+}
+
+int BigMac::device_postinit() {
+    this->int_ctrl = dynamic_cast<InterruptCtrl*>(
+        gMachineObj->get_comp_by_type(HWCompType::INT_CTRL));
+    this->irq_id = this->int_ctrl->register_dev_int(IntSrc::ETHERNET);
+
+    if (this->backend->can_receive())
+        this->rcv_timer_id = TimerManager::get_instance()->add_cyclic_timer(
+            BMAC_RCV_POLL_INTERVAL, [this]() { this->poll_rcv(); });
+
+    return 0;
+}
+
 void BigMac::chip_reset() {
     this->event_mask = 0xFFFFU; // disable HW events causing on-chip interrupts
     this->stat = 0;
+    this->xmit_frame.clear();
+    this->xmit_oversized = false;
+    this->update_irq();
 
     this->phy_reset();
     this->mii_reset();
@@ -53,6 +82,7 @@ uint16_t BigMac::read(uint16_t reg_offset) {
     case BigMacReg::GLOB_STAT: {
         uint16_t old_stat = this->stat;
         this->stat = 0; // clear-on-read
+        this->update_irq();
         return old_stat;
     }
     case BigMacReg::EVENT_MASK:
@@ -113,6 +143,7 @@ void BigMac::write(uint16_t reg_offset, uint16_t value) {
         break;
     case BigMacReg::EVENT_MASK:
         this->event_mask = value;
+        this->update_irq();
         break;
     case BigMacReg::SROM_CSR:
         if (value & Srom_Chip_Select) {
@@ -131,6 +162,9 @@ void BigMac::write(uint16_t reg_offset, uint16_t value) {
         }
         break;
     case BigMacReg::TX_CONFIG:
+        // resume a DMA transfer stalled by the disabled transmitter
+        if ((value & ~this->tx_config & Tx_Mac_Enable) && this->xmit_dma)
+            this->xmit_dma->notify(DmaMsg::DATA_AVAIL);
         this->tx_config = value;
         break;
     case BigMacReg::NC_CNT:
@@ -188,6 +222,95 @@ void BigMac::write(uint16_t reg_offset, uint16_t value) {
     }
 }
 
+void BigMac::update_irq() {
+    uint8_t new_level = !!(this->stat & ~this->event_mask);
+    if (this->int_ctrl && new_level != this->irq_level) {
+        this->irq_level = new_level;
+        this->int_ctrl->ack_int(this->irq_id, new_level);
+    }
+}
+
+// ============================ Frame data path ================================
+int BigMac::xfer_to(uint8_t *buf, int len) {
+    // the transmit FIFO doesn't drain while the transmitter is disabled
+    if (!(this->tx_config & Tx_Mac_Enable))
+        return len;
+
+    // a frame that won't fit is gathered no further and dropped at its end
+    if (this->xmit_frame.size() + len > NET_MAX_FRAME_SIZE)
+        this->xmit_oversized = true;
+
+    if (!this->xmit_dma->is_last_cmd()) {
+        if (!this->xmit_oversized)
+            this->xmit_frame.insert(this->xmit_frame.end(), buf, buf + len);
+        return 0;
+    }
+
+    // frames described by a single DMA command go straight from guest memory
+    if (this->xmit_oversized) {
+        LOG_F(WARNING, "%s: dropping oversized frame", this->name.c_str());
+        this->xmit_oversized = false;
+        this->xmit_frame.clear();
+    } else if (this->xmit_frame.empty()) {
+        this->backend->xmit_frame(buf, len);
+    } else {
+        this->xmit_frame.insert(this->xmit_frame.end(), buf, buf + len);
+        this->backend->xmit_frame(this->xmit_frame.data(), (int)this->xmit_frame.size());
+        this->xmit_frame.clear();
+    }
+
+    this->stat |= Stat_Frame_Sent;
+    this->update_irq();
+
+    return 0;
+}
+
+bool BigMac::addr_match(const uint8_t* dst_addr) {
+    if (this->rx_config & Rx_Promisc_Enable)
+        return true;
+
+    if (dst_addr[0] & 1) { // group address
+        if ((dst_addr[0] & dst_addr[1] & dst_addr[2] & dst_addr[3] &
+             dst_addr[4] & dst_addr[5]) == 0xFF)
+            return true; // broadcast
+        if (!(this->rx_config & Rx_Hash_Flt_Enable))
+            return false;
+        uint32_t hash = ether_crc32_le(dst_addr, 6) >> 26;
+        return (this->hash_table[hash >> 4] >> (hash & 0xF)) & 1;
+    }
+
+    return READ_WORD_BE_U(&dst_addr[0]) == this->mac_addr_flt[2] &&
+           READ_WORD_BE_U(&dst_addr[2]) == this->mac_addr_flt[1] &&
+           READ_WORD_BE_U(&dst_addr[4]) == this->mac_addr_flt[0];
+}
+
+void BigMac::poll_rcv() {
+    if (!(this->rx_config & Rx_Mac_Enable) || !this->rcv_dma)
+        return;
+
+    while (this->rcv_dma->is_in_active()) {
+        uint32_t buf_len;
+        uint8_t* buf = this->rcv_dma->get_in_buf(&buf_len);
+        if (!buf || buf_len < 16)
+            return;
+
+        // frames are received directly into the DMA buffer,
+        // leaving room for the status word appended to them
+        int len = this->backend->rcv_frame(buf, buf_len - 2);
+        if (!len)
+            return;
+        if (len < 14 || !this->addr_match(buf))
+            continue; // the buffer gets reused for the next frame
+
+        WRITE_WORD_BE_U(&buf[len], len);
+        this->rcv_frame_cnt++;
+        this->rcv_dma->end_in_packet(len + 2);
+
+        this->stat |= Stat_Frame_Received;
+        this->update_irq();
+    }
+}
+
 // ================ Media Independent Interface (MII) emulation ================
 bool BigMac::mii_rcv_value(uint16_t& var, uint8_t num_bits, uint8_t next_bit) {
     var = (var << 1) | (next_bit & 1);
@@ -443,12 +566,14 @@ void BigMac::srom_xmit_bit(const uint8_t bit_val) {
     }
 }
 
+static const PropMap BigMac_Properties = NetBackEnd::get_props();
+
 static const DeviceDescription BigMac_Heathrow_Descriptor = {
-    BigMac::create_for_heathrow, {}, {}
+    BigMac::create_for_heathrow, {}, BigMac_Properties
 };
 
 static const DeviceDescription BigMac_Paddington_Descriptor = {
-    BigMac::create_for_paddington, {}, {}
+    BigMac::create_for_paddington, {}, BigMac_Properties
 };
 
 REGISTER_DEVICE(BigMacHeathrow, BigMac_Heathrow_Descriptor);
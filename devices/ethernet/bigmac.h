@@ -24,10 +24,15 @@ along with this program.  If not, see <https://www.gnu.org/licenses/>.
 #ifndef BIG_MAC_H
 #define BIG_MAC_H
 
+#include <devices/common/dbdma.h>
+#include <devices/common/dmacore.h>
 #include <devices/common/hwcomponent.h>
+#include <devices/common/hwinterrupt.h>
+#include <devices/ethernet/netbackend.h>
 
 #include <cinttypes>
 #include <memory>
+#include <vector>
 
 /* Ethernet cell IDs for various MacIO ASICs. */
 enum EthernetCellId : uint8_t {
@@ -70,6 +75,24 @@ enum BigMacReg : uint16_t {
     HASH_TAB_0  = 0x730,
 };
 
+/* GLOB_STAT and EVENT_MASK bit definitions. */
+enum {
+    Stat_Frame_Received = 1 << 0,
+    Stat_Frame_Sent     = 1 << 8,
+};
+
+/* TX_CONFIG bit definitions. */
+enum {
+    Tx_Mac_Enable = 1 << 0,
+};
+
+/* RX_CONFIG bit definitions. */
+enum {
+    Rx_Mac_Enable       = 1 << 0,
+    Rx_Promisc_Enable   = 1 << 6,
+    Rx_Hash_Flt_Enable  = 1 << 11,
+};
+
 /* MIF_CSR bit definitions. */
 enum {
     Mif_Clock       = 1 << 0,
@@ -116,10 +139,10 @@ enum {
     PHY_ANAR    = 4,
 };
 
-class BigMac : public HWComponent {
+class BigMac : public DmaDevice, public HWComponent {
 public:
     BigMac(uint8_t id);
-    ~BigMac() = default;
+    ~BigMac();
 
     static std::unique_ptr<HWComponent> create_for_heathrow() {
         return std::unique_ptr<BigMac>(new BigMac(EthernetCellId::Heathrow));
@@ -133,8 +156,23 @@ public:
     uint16_t read(uint16_t reg_offset);
     void     write(uint16_t reg_offset, uint16_t value);
 
+    int device_postinit();
+
+    void set_dma_channels(DMAChannel* xmit_ch, DMAChannel* rcv_ch) {
+        this->xmit_dma = xmit_ch;
+        this->rcv_dma  = rcv_ch;
+    };
+
+    // DmaDevice methods
+    int xfer_to(uint8_t *buf, int len) override;
+
 protected:
     void chip_reset();
+    void update_irq();
+
+    // frame path
+    void poll_rcv();
+    bool addr_match(const uint8_t* dst_addr);
 
     // MII methods
     bool mii_rcv_value(uint16_t& var, uint8_t num_bits, uint8_t next_bit);
@@ -182,6 +220,17 @@ private:
     // Interrupt state
     uint16_t        event_mask = 0xFFFFU; // inverted mask: 0 - enabled, 1 - disabled
     uint16_t        stat = 0;
+    InterruptCtrl*  int_ctrl = nullptr;
+    uint64_t        irq_id = 0;
+    uint8_t         irq_level = 0;
+
+    // frame path state
+    DMAChannel*     xmit_dma = nullptr;
+    DMAChannel*     rcv_dma  = nullptr;
+    std::unique_ptr<NetBackEnd> backend;
+    std::vector<uint8_t>        xmit_frame; // frame collected from several DMA buffers
+    bool                        xmit_oversized = false;
+    uint32_t        rcv_timer_id = 0;
 
     // MII state
     uint8_t         mif_csr_old = 0;
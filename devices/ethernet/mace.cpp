@@ -21,25 +21,61 @@ along with this program.  If not, see <https://www.gnu.org/licenses/>.
 
 /** @file Media Access Controller for Ethernet (MACE) emulation. */
 
+#include <core/timermanager.h>
 #include <devices/deviceregistry.h>
 #include <devices/ethernet/mace.h>
 #include <loguru.hpp>
+#include <machines/machinebase.h>
+#include <machines/machineproperties.h>
 
+#include <algorithm>
 #include <cinttypes>
+#include <string>
+#include <vector>
 
 using namespace MaceEnet;
 
+// how often the backend is checked for incoming frames
+constexpr uint64_t MACE_RCV_POLL_INTERVAL = USECS_TO_NSECS(500);
+
+MaceController::~MaceController()
+{
+    if (this->rcv_timer_id)
+        TimerManager::get_instance()->cancel_timer(this->rcv_timer_id);
+}
+
+int MaceController::device_postinit()
+{
+    this->int_ctrl = dynamic_cast<InterruptCtrl*>(
+        gMachineObj->get_comp_by_type(HWCompType::INT_CTRL));
+    this->irq_id = this->int_ctrl->register_dev_int(IntSrc::ETHERNET);
+
+    if (this->backend->can_receive())
+        this->rcv_timer_id = TimerManager::get_instance()->add_cyclic_timer(
+            MACE_RCV_POLL_INTERVAL, [this]() { this->poll_rcv(); });
+
+    return 0;
+}
+
 uint8_t MaceController::read(uint8_t reg_offset)
 {
     switch(reg_offset) {
+    case MaceReg::Xmit_Frame_Stat: {
+        uint8_t ret_val = this->xmit_fs;
+        this->xmit_fs = 0;
+        return ret_val;
+    }
     case MaceReg::Rcv_Frame_Ctrl:
         return this->rcv_fc;
     case MaceReg::Interrupt: {
         uint8_t ret_val = this->int_stat;
         this->int_stat = 0;
+        this->update_irq();
         LOG_F(9, "%s: all interrupt flags cleared", this->name.c_str());
         return ret_val;
     }
+    case MaceReg::MAC_Config_Ctrl:
+        return this->mac_cfg;
     case MaceReg::Interrupt_Mask:
         return this->int_mask;
     case MaceReg::BIU_Config_Ctrl:
@@ -63,14 +99,20 @@ void MaceController::write(uint8_t reg_offset, uint8_t value)
         break;
     case MaceReg::Interrupt_Mask:
         this->int_mask = value;
+        this->update_irq();
         break;
     case MaceReg::MAC_Config_Ctrl:
+        // resume a DMA transfer stalled by the disabled transmitter
+        if ((value & ~this->mac_cfg & MACCC_ENXMT) && this->xmit_dma)
+            this->xmit_dma->notify(DmaMsg::DATA_AVAIL);
         this->mac_cfg = value;
         break;
     case MaceReg::BIU_Config_Ctrl:
         if (value & BIU_SWRST) {
             LOG_F(INFO, "%s: soft reset asserted", this->name.c_str());
             value &= ~BIU_SWRST; // acknowledge soft reset
+            this->xmit_frame.clear();
+            this->xmit_oversized = false;
         }
         this->biu_ctrl = value;
         break;
@@ -112,8 +154,117 @@ void MaceController::write(uint8_t reg_offset, uint8_t value)
     }
 }
 
+void MaceController::update_irq()
+{
+    uint8_t new_level = !!(this->int_stat & ~this->int_mask);
+    if (this->int_ctrl && new_level != this->irq_level) {
+        this->irq_level = new_level;
+        this->int_ctrl->ack_int(this->irq_id, new_level);
+    }
+}
+
+int MaceController::xfer_to(uint8_t *buf, int len)
+{
+    // the transmit FIFO doesn't drain while the transmitter is disabled
+    if (!(this->mac_cfg & MACCC_ENXMT) || !this->xmit_dma)
+        return len;
+
+    // a frame that won't fit is gathered no further and dropped at its end
+    if (this->xmit_frame.size() + len > NET_MAX_FRAME_SIZE)
+        this->xmit_oversized = true;
+
+    if (!this->xmit_dma->is_last_cmd()) {
+        if (!this->xmit_oversized)
+            this->xmit_frame.insert(this->xmit_frame.end(), buf, buf + len);
+        return 0;
+    }
+
+    // frames described by a single DMA command go straight from guest memory
+    if (this->xmit_oversized) {
+        LOG_F(WARNING, "%s: dropping oversized frame", this->name.c_str());
+        this->xmit_oversized = false;
+        this->xmit_frame.clear();
+    } else if (this->xmit_frame.empty()) {
+        this->backend->xmit_frame(buf, len);
+    } else {
+        this->xmit_frame.insert(this->xmit_frame.end(), buf, buf + len);
+        this->backend->xmit_frame(this->xmit_frame.data(), (int)this->xmit_frame.size());
+        this->xmit_frame.clear();
+    }
+
+    this->xmit_fs   = XMTFS_XMTSV;
+    this->int_stat |= INT_XMTINT;
+    this->update_irq();
+
+    return 0;
+}
+
+bool MaceController::addr_match(const uint8_t* dst_addr)
+{
+    if (this->mac_cfg & MACCC_PROM)
+        return true;
+
+    if (dst_addr[0] & 1) { // group address
+        if ((dst_addr[0] & dst_addr[1] & dst_addr[2] & dst_addr[3] &
+             dst_addr[4] & dst_addr[5]) == 0xFF)
+            return true; // broadcast
+        uint32_t hash = ether_crc32_le(dst_addr, 6) >> 26;
+        return (this->log_addr >> hash) & 1;
+    }
+
+    for (int i = 0; i < 6; i++)
+        if (dst_addr[i] != ((this->phys_addr >> (i * 8)) & 0xFFU))
+            return false;
+
+    return true;
+}
+
+void MaceController::poll_rcv()
+{
+    if (!(this->mac_cfg & MACCC_ENRCV) || !this->rcv_dma)
+        return;
+
+    while (this->rcv_dma->is_in_active()) {
+        uint32_t buf_len;
+        uint8_t* buf = this->rcv_dma->get_in_buf(&buf_len);
+        if (!buf || buf_len < 22)
+            return;
+
+        // frames are received directly into the DMA buffer,
+        // leaving room for the FCS and the receive status
+        int len = this->backend->rcv_frame(buf, buf_len - 8);
+        if (!len)
+            return;
+        if (len < 14 || !this->addr_match(buf))
+            continue; // the buffer gets reused for the next frame
+
+        // automatic pad stripping removes the FCS of IEEE 802.3 frames,
+        // Ethernet II frames are stored with it
+        uint16_t type_len = (buf[12] << 8) | buf[13];
+        if (type_len < 1536) {
+            len = std::min(len, 14 + type_len);
+        } else {
+            uint32_t fcs = ~ether_crc32_le(buf, len);
+            for (int i = 0; i < 4; i++)
+                buf[len++] = (fcs >> (i * 8)) & 0xFFU;
+        }
+
+        // append receive frame status: byte count, status, runt and collision counts
+        buf[len + 0] = len & 0xFFU;
+        buf[len + 1] = (len >> 8) & 0xFU;
+        buf[len + 2] = 0;
+        buf[len + 3] = 0;
+        this->rcv_dma->end_in_packet(len + 4);
+
+        this->int_stat |= INT_RCVINT;
+        this->update_irq();
+    }
+}
+
+static const PropMap Mace_Properties = NetBackEnd::get_props();
+
 static const DeviceDescription Mace_Descriptor = {
-    MaceController::create, {}, {}
+    MaceController::create, {}, Mace_Properties
 };
 
 REGISTER_DEVICE(Mace, Mace_Descriptor);
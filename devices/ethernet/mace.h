@@ -24,11 +24,15 @@ along with this program.  If not, see <https://www.gnu.org/licenses/>.
 #ifndef MACE_H
 #define MACE_H
 
+#include <devices/common/dbdma.h>
 #include <devices/common/dmacore.h>
 #include <devices/common/hwcomponent.h>
+#include <devices/common/hwinterrupt.h>
+#include <devices/ethernet/netbackend.h>
 
 #include <cinttypes>
 #include <memory>
+#include <vector>
 
 /** Known MACE chip IDs. */
 constexpr auto MACE_ID_REV_B0 = 0x0940;    // Darwin-0.3 source
@@ -72,6 +76,24 @@ namespace MaceEnet {
         BIU_SWRST   = 1 << 0,
     };
 
+    /** Bit definitions for Interrupt and Interrupt_Mask registers. */
+    enum {
+        INT_XMTINT  = 1 << 0,
+        INT_RCVINT  = 1 << 1,
+    };
+
+    /** Bit definitions for Xmit_Frame_Stat register. */
+    enum {
+        XMTFS_XMTSV = 1 << 7,
+    };
+
+    /** Bit definitions for MAC_Config_Ctrl register. */
+    enum {
+        MACCC_ENXMT = 1 << 1,
+        MACCC_ENRCV = 1 << 2,
+        MACCC_PROM  = 1 << 7,
+    };
+
     /** Bit definitions for the internal configuration register. */
     enum {
         IAC_LOGADDR = 1 << 1,
@@ -87,8 +109,10 @@ public:
         this->chip_id = id;
         this->set_name("MACE");
         this->supports_types(HWCompType::MMIO_DEV | HWCompType::ETHER_MAC);
+        this->backend = NetBackEnd::create_from_props();
+        this->xmit_frame.reserve(NET_MAX_FRAME_SIZE);
     };
-    ~MaceController() = default;
+    ~MaceController();
 
     static std::unique_ptr<HWComponent> create() {
         return std::unique_ptr<MaceController>(new MaceController(MACE_ID_REV_A2));
@@ -98,6 +122,22 @@ public:
     uint8_t read(uint8_t reg_offset);
     void    write(uint8_t reg_offset, uint8_t value);
 
+    int device_postinit();
+
+    // DBDMA channels, MACE cells without them don't transfer frames
+    void set_dma_channels(DMAChannel* xmit_ch, DMAChannel* rcv_ch) {
+        this->xmit_dma = xmit_ch;
+        this->rcv_dma  = rcv_ch;
+    };
+
+    // DmaDevice methods
+    int xfer_to(uint8_t *buf, int len) override;
+
+protected:
+    void update_irq();
+    void poll_rcv();
+    bool addr_match(const uint8_t* dst_addr);
+
 private:
     uint16_t    chip_id; // per-instance MACE Chip ID
     uint8_t     addr_cfg  = 0;
@@ -108,9 +148,22 @@ private:
     uint64_t    phys_addr = 0;
     uint64_t    log_addr  = 0;
 
+    uint8_t     xmit_fs   = 0;
+
     // interrupt stuff
-    uint8_t     int_stat  = 0;
-    uint8_t     int_mask  = 0;
+    uint8_t         int_stat  = 0;
+    uint8_t         int_mask  = 0;
+    InterruptCtrl*  int_ctrl  = nullptr;
+    uint64_t        irq_id    = 0;
+    uint8_t         irq_level = 0;
+
+    // frame path state
+    DMAChannel*     xmit_dma = nullptr;
+    DMAChannel*     rcv_dma  = nullptr;
+    std::unique_ptr<NetBackEnd> backend;
+    std::vector<uint8_t>        xmit_frame; // frame collected from several DMA buffers
+    bool                        xmit_oversized = false;
+    uint32_t        rcv_timer_id = 0;
 };
 
 #endif // MACE_H
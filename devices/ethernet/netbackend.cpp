@@ -0,0 +1,253 @@
+/*
+DingusPPC - The Experimental PowerPC Macintosh emulator
+Copyright (C) 2018-25 divingkatae and maximum
+                      (theweirdo)     spatium
+
+(Contact divingkatae#1017 or powermax#2286 on Discord for more info)
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+/** Ethernet frame backend implementations. */
+
+#include <devices/ethernet/netbackend.h>
+#include <loguru.hpp>
+#include <machines/machineproperties.h>
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cinttypes>
+#include <cstring>
+#include <memory>
+
+static_assert(std::atomic<uint32_t>::is_always_lock_free,
+              "shared memory transport requires lock-free atomics");
+
+std::unique_ptr<NetBackEnd> NetBackEnd::create_from_props()
+{
+    std::string backend_name = GET_STR_PROP("net_backend");
+    std::string path         = GET_STR_PROP("net_path");
+
+    if (backend_name != "null" && path.empty()) {
+        LOG_F(ERROR, "Net: backend %s requires net_path, falling back to null",
+              backend_name.c_str());
+        backend_name = "null";
+    }
+
+    if (backend_name == "pcap")
+        return std::unique_ptr<NetBackEnd>(new NetPcap(path));
+    if (backend_name == "shm")
+        return std::unique_ptr<NetBackEnd>(new NetShm(path, GET_INT_PROP("net_shm_side")));
+
+    return std::unique_ptr<NetBackEnd>(new NetNull());
+}
+
+PropMap NetBackEnd::get_props()
+{
+    return {
+        {"net_backend",
+            new StrProperty("null", std::vector<std::string>({"null", "pcap", "shm"}))},
+        {"net_path",
+            new StrProperty("")},
+        {"net_shm_side",
+            new IntProperty(0, std::vector<uint32_t>({0, 1}))},
+    };
+}
+
+//=========================== pcap capture backend ============================
+// Record layouts as described in the libpcap file format.
+struct PcapFileHeader {
+    uint32_t    magic;
+    uint16_t    version_major;
+    uint16_t    version_minor;
+    int32_t     thiszone;
+    uint32_t    sigfigs;
+    uint32_t    snaplen;
+    uint32_t    linktype;
+};
+
+struct PcapRecHeader {
+    uint32_t    ts_sec;
+    uint32_t    ts_usec;
+    uint32_t    incl_len;
+    uint32_t    orig_len;
+};
+
+NetPcap::NetPcap(const std::string& path)
+{
+    this->out_file = std::fopen(path.c_str(), "wb");
+    if (!this->out_file) {
+        LOG_F(ERROR, "Net: could not create capture file %s", path.c_str());
+        return;
+    }
+
+    // the file is written in host byte order, readers detect it by the magic
+    PcapFileHeader hdr = {0xA1B2C3D4U, 2, 4, 0, 0, 65535, 1 /* LINKTYPE_ETHERNET */};
+    std::fwrite(&hdr, sizeof(hdr), 1, this->out_file);
+
+    LOG_F(INFO, "Net: capturing transmitted frames to %s", path.c_str());
+}
+
+NetPcap::~NetPcap()
+{
+    if (this->out_file)
+        std::fclose(this->out_file);
+}
+
+void NetPcap::xmit_frame(const uint8_t* data, int len)
+{
+    if (!this->out_file)
+        return;
+
+    auto now = std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+
+    PcapRecHeader rec = {uint32_t(now / 1000000), uint32_t(now % 1000000),
+                         uint32_t(len), uint32_t(len)};
+
+    // stdio buffering batches the writes, no explicit flushing here
+    std::fwrite(&rec, sizeof(rec), 1, this->out_file);
+    std::fwrite(data, 1, len, this->out_file);
+}
+
+//========================= Shared memory backend =============================
+#ifdef _WIN32
+
+NetShm::NetShm(const std::string& path, int side)
+{
+    LOG_F(ERROR, "Net: shared memory backend isn't supported on this platform");
+}
+
+NetShm::~NetShm() {}
+
+#else
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+NetShm::NetShm(const std::string& path, int side)
+{
+    this->map_size = sizeof(NetShmRing) * 2;
+
+    int fd = open(path.c_str(), O_RDWR | O_CREAT, 0600);
+    if (fd < 0) {
+        LOG_F(ERROR, "Net: could not open %s", path.c_str());
+        return;
+    }
+
+    // a zero-extended file contains two empty rings
+    struct stat st;
+    if (fstat(fd, &st) || (st.st_size < (off_t)this->map_size &&
+                           ftruncate(fd, this->map_size))) {
+        LOG_F(ERROR, "Net: could not size %s", path.c_str());
+        close(fd);
+        return;
+    }
+
+    void* base = mmap(nullptr, this->map_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+
+    if (base == MAP_FAILED) {
+        LOG_F(ERROR, "Net: could not map %s", path.c_str());
+        return;
+    }
+
+    this->map_base = base;
+
+    NetShmRing* rings = static_cast<NetShmRing*>(base);
+    this->tx_ring = &rings[side & 1];
+    this->rx_ring = &rings[(side & 1) ^ 1];
+
+    // discard frames left over from a previous session
+    this->rx_ring->tail.store(this->rx_ring->head.load(std::memory_order_acquire),
+                              std::memory_order_release);
+
+    LOG_F(INFO, "Net: linked via %s as side %d", path.c_str(), side & 1);
+}
+
+NetShm::~NetShm()
+{
+    if (this->map_base)
+        munmap(this->map_base, this->map_size);
+}
+
+#endif // _WIN32
+
+void NetShm::xmit_frame(const uint8_t* data, int len)
+{
+    if (!this->tx_ring)
+        return;
+
+    uint32_t wr = this->tx_ring->head.load(std::memory_order_relaxed);
+    uint32_t rd = this->tx_ring->tail.load(std::memory_order_acquire);
+
+    // like a real wire, frames nobody picks up are lost
+    if (wr - rd >= NET_SHM_NUM_SLOTS || len > NET_MAX_FRAME_SIZE)
+        return;
+
+    auto& slot = this->tx_ring->slots[wr % NET_SHM_NUM_SLOTS];
+    slot.len = len;
+    std::memcpy(slot.data, data, len);
+
+    this->tx_ring->head.store(wr + 1, std::memory_order_release);
+}
+
+int NetShm::rcv_frame(uint8_t* buf, int buf_size)
+{
+    if (!this->rx_ring)
+        return 0;
+
+    while (true) {
+        uint32_t rd = this->rx_ring->tail.load(std::memory_order_relaxed);
+        uint32_t wr = this->rx_ring->head.load(std::memory_order_acquire);
+
+        if (rd == wr)
+            return 0;
+
+        const auto& slot = this->rx_ring->slots[rd % NET_SHM_NUM_SLOTS];
+        int len = std::min<uint32_t>(slot.len, NET_MAX_FRAME_SIZE);
+        if (len <= buf_size)
+            std::memcpy(buf, slot.data, len);
+
+        this->rx_ring->tail.store(rd + 1, std::memory_order_release);
+
+        if (len <= buf_size)
+            return len;
+
+        LOG_F(9, "Net: dropped %d byte frame, buffer holds %d bytes", len, buf_size);
+    }
+}
+
+//============================ Utility functions ==============================
+uint32_t ether_crc32_le(const uint8_t* data, int len)
+{
+    static const auto crc_table = [] {
+        std::array<uint32_t, 256> table;
+        for (uint32_t i = 0; i < 256; i++) {
+            uint32_t c = i;
+            for (int bit = 0; bit < 8; bit++)
+                c = (c & 1) ? (c >> 1) ^ 0xEDB88320U : c >> 1;
+            table[i] = c;
+        }
+        return table;
+    }();
+
+    uint32_t crc = 0xFFFFFFFFU;
+    while (len--)
+        crc = crc_table[(crc ^ *data++) & 0xFF] ^ (crc >> 8);
+    return crc;
+}
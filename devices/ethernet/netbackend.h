@@ -0,0 +1,138 @@
+/*
+DingusPPC - The Experimental PowerPC Macintosh emulator
+Copyright (C) 2018-25 divingkatae and maximum
+                      (theweirdo)     spatium
+
+(Contact divingkatae#1017 or powermax#2286 on Discord for more info)
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+/** @file Host backends for emulated Ethernet controllers.
+
+    Backends exchange whole Ethernet frames without the FCS. Frames are
+    passed by pointer straight from/into guest memory so the only copy
+    made is the one into the host-side transport.
+ */
+
+#ifndef NET_BACKEND_H
+#define NET_BACKEND_H
+
+#include <machines/machineproperties.h>
+
+#include <atomic>
+#include <cinttypes>
+#include <cstdio>
+#include <memory>
+#include <string>
+
+enum {
+    NET_BE_NULL = 0, // NULL backend: swallows everything, receives nothing
+    NET_BE_PCAP = 1, // pcap backend: logs transmitted frames to a capture file
+    NET_BE_SHM  = 2, // shared memory backend: links two local emulator instances
+};
+
+/** Largest frame exchanged with a backend (1514 bytes + VLAN tag, FCS excluded). */
+constexpr int NET_MAX_FRAME_SIZE = 1518;
+
+/** Interface for Ethernet frame backends. */
+class NetBackEnd {
+public:
+    NetBackEnd() = default;
+    virtual ~NetBackEnd() = default;
+
+    // Creates the backend selected by the "net_backend" machine property.
+    static std::unique_ptr<NetBackEnd> create_from_props();
+
+    // Returns the properties used by create_from_props() for device descriptors.
+    static PropMap get_props();
+
+    // Returns true if the backend can ever deliver frames.
+    virtual bool can_receive() { return false; };
+
+    // Sends one frame. The data pointer is only valid during the call.
+    virtual void xmit_frame(const uint8_t* data, int len) = 0;
+
+    // Stores the next pending frame into buf and returns its length.
+    // Returns 0 if no frame is pending. Frames not fitting into buf are dropped.
+    virtual int rcv_frame(uint8_t* buf, int buf_size) = 0;
+};
+
+/** Null backend. */
+class NetNull : public NetBackEnd {
+public:
+    NetNull()  = default;
+    ~NetNull() = default;
+
+    void xmit_frame(const uint8_t* data, int len) {};
+    int  rcv_frame(uint8_t* buf, int buf_size) { return 0; };
+};
+
+/** Backend writing transmitted frames to a pcap file. */
+class NetPcap : public NetBackEnd {
+public:
+    NetPcap(const std::string& path);
+    ~NetPcap();
+
+    void xmit_frame(const uint8_t* data, int len);
+    int  rcv_frame(uint8_t* buf, int buf_size) { return 0; };
+
+private:
+    FILE*   out_file = nullptr;
+};
+
+/** Frame slot geometry of the shared memory transport. */
+constexpr int NET_SHM_SLOT_SIZE = 2048;
+constexpr int NET_SHM_NUM_SLOTS = 256;
+
+/** One direction of the shared memory transport.
+
+    The producer owns head, the consumer owns tail. An all-zero ring is empty
+    so a freshly created file doesn't need any initialization.
+ */
+struct NetShmRing {
+    alignas(64) std::atomic<uint32_t> head; // number of frames written
+    alignas(64) std::atomic<uint32_t> tail; // number of frames read
+    struct {
+        uint32_t len;
+        uint8_t  data[NET_SHM_SLOT_SIZE - 4];
+    } slots[NET_SHM_NUM_SLOTS];
+};
+
+/** Backend exchanging frames with another instance over a shared file mapping.
+
+    Instance using side 0 sends on ring 0 and receives on ring 1,
+    instance using side 1 does it the other way round.
+ */
+class NetShm : public NetBackEnd {
+public:
+    NetShm(const std::string& path, int side);
+    ~NetShm();
+
+    bool can_receive() { return this->rx_ring != nullptr; };
+    void xmit_frame(const uint8_t* data, int len);
+    int  rcv_frame(uint8_t* buf, int buf_size);
+
+private:
+    void*       map_base = nullptr;
+    size_t      map_size = 0;
+    NetShmRing* tx_ring  = nullptr;
+    NetShmRing* rx_ring  = nullptr;
+};
+
+// Computes the Ethernet CRC-32 without the final inversion, i.e. the value
+// drivers use for hash filters. The FCS is its complement sent LSB first.
+extern uint32_t ether_crc32_le(const uint8_t* data, int len);
+
+#endif // NET_BACKEND_H
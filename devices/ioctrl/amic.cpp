@@ -600,9 +600,7 @@ void AmicSndOutDma::update_irq() {
     uint8_t new_level = !!((this->dma_out_ctrl >> 4) & this->dma_out_ctrl);
     if (new_level != this->irq_level) {
         this->irq_level = new_level;
-        TimerManager::get_instance()->add_immediate_timer([this] {
-            this->int_ctrl->ack_dma_int(this->snd_dma_irq_id, this->irq_level);
-        });
+        this->int_ctrl->post_dma_int(this->snd_dma_irq_id, this->irq_level);
     }
 }
 
@@ -141,6 +141,7 @@ GrandCentral::GrandCentral() : PCIDevice("mac-io_grandcentral"), InterruptCtrl()
     this->enet_tx_dma->connect(this->mace);
     this->enet_rx_dma->connect(this->mace);
     this->mace->connect(this->enet_rx_dma.get());
+    this->mace->set_dma_channels(this->enet_tx_dma.get(), this->enet_rx_dma.get());
 
     // connect floppy disk HW
     this->swim3 = dynamic_cast<Swim3::Swim3Ctrl*>(gMachineObj->get_comp_by_name("Swim3"));
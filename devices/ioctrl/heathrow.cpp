@@ -85,6 +85,20 @@ HeathrowIC::HeathrowIC() : PCIDevice("mac-io_heathrow"), InterruptCtrl()
     this->ide_0 = dynamic_cast<IdeChannel*>(gMachineObj->get_comp_by_name("Ide0"));
     this->ide_1 = dynamic_cast<IdeChannel*>(gMachineObj->get_comp_by_name("Ide1"));
 
+    // create bus master DMA channels for both IDE busses
+    this->ide0_dma = std::unique_ptr<DMAChannel> (new DMAChannel("ide0"));
+    this->ide0_dma->register_dma_int(this, this->register_dma_int(IntSrc::DMA_IDE0));
+    if (this->ide_0) {
+        this->ide0_dma->connect(this->ide_0);
+        this->ide_0->connect(this->ide0_dma.get());
+    }
+    this->ide1_dma = std::unique_ptr<DMAChannel> (new DMAChannel("ide1"));
+    this->ide1_dma->register_dma_int(this, this->register_dma_int(IntSrc::DMA_IDE1));
+    if (this->ide_1) {
+        this->ide1_dma->connect(this->ide_1);
+        this->ide_1->connect(this->ide1_dma.get());
+    }
+
     // connect serial HW
     this->escc = dynamic_cast<EsccController*>(gMachineObj->get_comp_by_name("Escc"));
 
@@ -101,6 +115,10 @@ HeathrowIC::HeathrowIC() : PCIDevice("mac-io_heathrow"), InterruptCtrl()
     this->bmac = dynamic_cast<BigMac*>(gMachineObj->get_comp_by_type(HWCompType::ETHER_MAC));
     this->enet_xmit_dma = std::unique_ptr<DMAChannel> (new DMAChannel("BmacTx"));
     this->enet_rcv_dma  = std::unique_ptr<DMAChannel> (new DMAChannel("BmacRx"));
+    this->enet_xmit_dma->register_dma_int(this, this->register_dma_int(IntSrc::DMA_ETHERNET_Tx));
+    this->enet_rcv_dma->register_dma_int(this, this->register_dma_int(IntSrc::DMA_ETHERNET_Rx));
+    this->enet_xmit_dma->connect(this->bmac);
+    this->bmac->set_dma_channels(this->enet_xmit_dma.get(), this->enet_rcv_dma.get());
 
     // set EMMO pin status (active low)
     this->emmo_pin = GET_BIN_PROP("emmo") ^ 1;
@@ -142,6 +160,10 @@ uint32_t HeathrowIC::dma_read(uint32_t offset, int size) {
         return this->escc_b_rcv_dma->reg_read(offset & 0xFF, size);
     case MIO_OHARE_DMA_AUDIO_OUT:
         return this->snd_out_dma->reg_read(offset & 0xFF, size);
+    case MIO_OHARE_DMA_IDE0:
+        return this->ide0_dma->reg_read(offset & 0xFF, size);
+    case MIO_OHARE_DMA_IDE1:
+        return this->ide1_dma->reg_read(offset & 0xFF, size);
     default:
         LOG_F(WARNING, "Unsupported DMA channel read, offset=0x%X", offset);
     }
@@ -169,6 +191,12 @@ void HeathrowIC::dma_write(uint32_t offset, uint32_t value, int size) {
     case MIO_OHARE_DMA_AUDIO_OUT:
         this->snd_out_dma->reg_write(offset & 0xFF, value, size);
         break;
+    case MIO_OHARE_DMA_IDE0:
+        this->ide0_dma->reg_write(offset & 0xFF, value, size);
+        break;
+    case MIO_OHARE_DMA_IDE1:
+        this->ide1_dma->reg_write(offset & 0xFF, value, size);
+        break;
     default:
         LOG_F(WARNING, "Unsupported DMA channel write, offset=0x%X, val=0x%X", offset, value);
     }
@@ -260,6 +260,7 @@ private:
     std::unique_ptr<DMAChannel>     mesh_dma;
     std::unique_ptr<DMAChannel>     floppy_dma;
     std::unique_ptr<DMAChannel>     snd_out_dma;
+    std::unique_ptr<DMAChannel>     ide0_dma;
 
     uint16_t unsupported_dma_channel_read = 0;
     uint16_t unsupported_dma_channel_write = 0;
@@ -432,6 +433,8 @@ private:
     std::unique_ptr<DMAChannel>     enet_rcv_dma;
     std::unique_ptr<DMAChannel>     escc_b_rcv_dma;
     std::unique_ptr<DMAChannel>     snd_out_dma;
+    std::unique_ptr<DMAChannel>     ide0_dma;
+    std::unique_ptr<DMAChannel>     ide1_dma;
 };
 
 #endif /* MACIO_H */
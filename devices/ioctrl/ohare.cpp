@@ -87,6 +87,12 @@ OHare::OHare() : PCIDevice("mac-io_ohare"), InterruptCtrl()
     // connect IDE HW
     this->ide_0 = dynamic_cast<IdeChannel*>(gMachineObj->get_comp_by_name("Ide0"));
     //this->ide_1 = dynamic_cast<IdeChannel*>(gMachineObj->get_comp_by_name("Ide1"));
+    this->ide0_dma = std::unique_ptr<DMAChannel> (new DMAChannel("ide0"));
+    this->ide0_dma->register_dma_int(this, this->register_dma_int(IntSrc::DMA_IDE0));
+    if (this->ide_0) {
+        this->ide0_dma->connect(this->ide_0);
+        this->ide_0->connect(this->ide0_dma.get());
+    }
 
     // connect serial HW
     this->escc = dynamic_cast<EsccController*>(gMachineObj->get_comp_by_name("Escc"));
@@ -317,6 +323,9 @@ uint32_t OHare::dma_read(uint32_t offset, int size)
     case MIO_OHARE_DMA_AUDIO_OUT:
         value = this->snd_out_dma->reg_read(offset & 0xFF, size);
         break;
+    case MIO_OHARE_DMA_IDE0:
+        value = this->ide0_dma->reg_read(offset & 0xFF, size);
+        break;
     default:
         if (!(unsupported_dma_channel_read & (1 << dma_channel))) {
             unsupported_dma_channel_read |= (1 << dma_channel);
@@ -341,6 +350,9 @@ void OHare::dma_write(uint32_t offset, uint32_t value, int size)
     case MIO_OHARE_DMA_AUDIO_OUT:
         this->snd_out_dma->reg_write(offset & 0xFF, value, size);
         break;
+    case MIO_OHARE_DMA_IDE0:
+        this->ide0_dma->reg_write(offset & 0xFF, value, size);
+        break;
     default:
         LOG_F(WARNING, "OHare: unsupported DMA channel write, offset=0x%X, val=0x%X", offset, value);
     }
@@ -74,9 +74,8 @@ PlatinumCtrl::PlatinumCtrl() : MemCtrlBase(), VideoCtrlBase() {
     this->dacula->cursor_ctrl_cb = [this](bool cursor_on) {
         if (cursor_on) {
             this->dacula->measure_hw_cursor(this->fb_ptr - 16);
-            this->cursor_ovl_cb = [this](uint8_t *dst_buf, int dst_pitch) {
-                this->dacula->draw_hw_cursor(this->fb_ptr - 16,
-                    dst_buf, dst_pitch);
+            this->cursor_ovl_cb = [this]() {
+                return this->dacula->capture_hw_cursor(this->fb_ptr - 16);
             };
         } else {
             this->cursor_ovl_cb = nullptr;
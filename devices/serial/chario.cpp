@@ -24,10 +24,21 @@ along with this program.  If not, see <https://www.gnu.org/licenses/>.
 #include <devices/serial/chario.h>
 #include <loguru.hpp>
 
+#include <algorithm>
 #include <cinttypes>
 #include <cstring>
 #include <memory>
 
+int CharIoBackEnd::rcv_chars(uint8_t *buf, int max_len)
+{
+    int len = 0;
+
+    while (len < max_len && this->rcv_char_available_now())
+        this->rcv_char(&buf[len++]);
+
+    return len;
+}
+
 bool CharIoNull::rcv_char_available()
 {
     return false;
@@ -262,10 +273,27 @@ int CharIoStdin::rcv_char(uint8_t *c)
 
 #else // non-Windows OS (Linux, mac OS etc.)
 
+#include <fcntl.h>
+#include <poll.h>
 #include <sys/socket.h>
 #include <sys/un.h>
 #include <sys/errno.h>
 
+#include <chrono>
+
+#ifdef MSG_NOSIGNAL
+#define SOCKET_SEND_FLAGS MSG_NOSIGNAL
+#else
+#define SOCKET_SEND_FLAGS 0
+#endif
+
+// minimum time between two socket polls while no input is buffered
+constexpr auto SOCKET_IDLE_POLL_PERIOD = std::chrono::milliseconds(1);
+
+static void set_nonblocking(int fd)
+{
+    fcntl(fd, F_SETFL, fcntl(fd, F_GETFL, 0) | O_NONBLOCK);
+}
 
 CharIoSocket::CharIoSocket()
 {
@@ -310,6 +338,9 @@ CharIoSocket::CharIoSocket()
             break;
         }
 
+        // accept() must never stall the emulated CPU
+        set_nonblocking(this->sockfd);
+
         LOG_F(INFO, "socket listen %d", sockfd);
 
     } while (0);
@@ -317,10 +348,16 @@ CharIoSocket::CharIoSocket()
 
 
 CharIoSocket::~CharIoSocket() {
+    this->flush_output();
+
     unlink(path);
     if (errno != ENOENT) {
         LOG_F(INFO, "socket unlink err: %s", strerror(errno));
     }
+    if (acceptfd != -1) {
+        close(acceptfd);
+        acceptfd = -1;
+    }
     if (sockfd != -1) {
         close(sockfd);
         sockfd = -1;
@@ -346,170 +383,150 @@ void CharIoSocket::rcv_disable()
     this->socket_inited = false;
 }
 
-bool CharIoSocket::rcv_char_available()
+void CharIoSocket::drop_client()
 {
-    if (consecutivechars >= 15) {
-        consecutivechars++;
-        if (consecutivechars >= 800)
-            consecutivechars = 0;
-        return 0;
-    }
-    return this->rcv_char_available_now();
+    LOG_F(INFO, "socket client disconnected");
+    close(this->acceptfd);
+    this->acceptfd = -1;
+    this->in_pos   = 0;
+    this->in_len   = 0;
 }
 
-bool CharIoSocket::rcv_char_available_now()
+void CharIoSocket::service()
 {
-    int sel_rv = 0;
-    bool havechars = false;
-    fd_set readfds;
-    fd_set writefds;
-    fd_set errorfds;
-
-    int sockmax = 0;
-    if (this->sockfd != -1) {
-        FD_ZERO(&readfds);
-        FD_SET(this->sockfd, &readfds);
-        if (this->sockfd > sockmax) sockmax = this->sockfd;
-        if (this->acceptfd != -1) {
-            FD_SET(this->acceptfd, &readfds);
-            if (this->acceptfd > sockmax) sockmax = this->acceptfd;
+    this->last_poll = std::chrono::steady_clock::now();
+
+    if (this->acceptfd == -1) {
+        if (this->sockfd == -1)
+            return;
+        this->acceptfd = accept(this->sockfd, nullptr, nullptr);
+        if (this->acceptfd == -1) {
+            if (errno != EAGAIN && errno != EWOULDBLOCK)
+                LOG_F(INFO, "socket accept err: %s", strerror(errno));
+            return;
         }
-        writefds = readfds;
-        errorfds = readfds;
+        set_nonblocking(this->acceptfd);
+#ifdef SO_NOSIGPIPE
+        int one = 1;
+        setsockopt(this->acceptfd, SOL_SOCKET, SO_NOSIGPIPE, &one, sizeof(one));
+#endif
+        LOG_F(INFO, "socket accept %d", this->acceptfd);
+    }
 
-        struct timeval timeout;
-        timeout.tv_sec = 0;
-        timeout.tv_usec = 0;
+    struct pollfd pfd;
+    pfd.fd      = this->acceptfd;
+    pfd.events  = POLLIN | (this->out_len ? POLLOUT : 0);
+    pfd.revents = 0;
 
-        sel_rv = select(sockmax + 1, &readfds, &writefds, &errorfds, &timeout);
-        if (sel_rv == -1) {
-            LOG_F(INFO, "socket select err: %s", strerror(errno));
-        }
+    if (poll(&pfd, 1, 0) <= 0)
+        return;
+
+    if (pfd.revents & (POLLOUT | POLLERR | POLLHUP))
+        this->flush_output();
+
+    if (this->acceptfd != -1 && (pfd.revents & (POLLIN | POLLHUP))) {
+        // refill the input buffer with as much data as fits in a single read
+        if (this->in_pos == this->in_len)
+            this->in_pos = this->in_len = 0;
+
+        ssize_t received = recv(this->acceptfd, &this->in_buf[this->in_len],
+                                sizeof(this->in_buf) - this->in_len, 0);
+        if (received > 0)
+            this->in_len += (int)received;
+        else if (!received || (errno != EAGAIN && errno != EWOULDBLOCK))
+            this->drop_client();
     }
+}
 
-    if (sel_rv > 0) {
-        if (this->sockfd != -1) {
-             if (FD_ISSET(this->sockfd, &readfds)) {
-                uint8_t c;
-                int received = (int)recv(this->sockfd, &c, 1, 0);
-                if (received == -1) {
-                    if (this->acceptfd == -1) {
-                        #if 0
-                            LOG_F(INFO, "socket sock read (not accepted yet) err: %s",
-                                strerror(errno)); // this happens once before accept
-                        #endif
-                    }
-                    else {
-                        LOG_F(INFO, "socket sock read err: %s", strerror(errno)); // should never happen
-                    }
-                }
-                else if (received == 1) {
-                    LOG_F(INFO, "socket sock read '%c'", c); // should never happen
-                }
-                else {
-                    LOG_F(INFO, "socket sock read %d", received); // should never happen
-                }
-
-                if (this->acceptfd == -1) {
-                    sockaddr_un acceptfdaddr;
-                    memset(&acceptfdaddr, 0, sizeof(acceptfdaddr));
-                    socklen_t len = sizeof(acceptfdaddr);
-                    this->acceptfd = accept(this->sockfd, (struct sockaddr *) &acceptfdaddr, &len);
-                    if (this->acceptfd == -1) {
-                        LOG_F(INFO, "socket accept err: %s", strerror(errno));
-                    }
-                    else {
-                        LOG_F(INFO, "socket accept %d", acceptfd);
-                    }
-                }
-            } // if read
-
-            if (FD_ISSET(this->sockfd, &writefds)) {
-                LOG_F(INFO, "socket sock write");
-            }
-
-            if (FD_ISSET(this->sockfd, &errorfds)) {
-                LOG_F(INFO, "socket sock error");
-            }
-        } // if this->sockfd
-
-        if (this->acceptfd != -1) {
-            if (FD_ISSET(this->acceptfd, &readfds)) {
-                // LOG_F(INFO, "socket accept read havechars");
-                havechars = true;
-                consecutivechars++;
-            } // if read
-
-            if (FD_ISSET(this->acceptfd, &writefds)) {
-                // LOG_F(INFO, "socket accept write"); // this is usually always true
-            }
-
-            if (FD_ISSET(this->acceptfd, &errorfds)) {
-                LOG_F(INFO, "socket accept error");
-            }
-        } // if this->acceptfd
+void CharIoSocket::flush_output()
+{
+    if (!this->out_len)
+        return;
+
+    // everything sent to the guest's serial port is echoed to the console
+    if (this->echo_len < this->out_len) {
+        write(STDOUT_FILENO, &this->out_buf[this->echo_len], this->out_len - this->echo_len);
+        this->echo_len = this->out_len;
+    }
+
+    if (this->acceptfd == -1) {
+        this->out_len = this->echo_len = 0; // nobody listens
+        return;
+    }
+
+    ssize_t sent = send(this->acceptfd, this->out_buf, this->out_len, SOCKET_SEND_FLAGS);
+    if (sent > 0) {
+        std::memmove(this->out_buf, &this->out_buf[sent], this->out_len - sent);
+        this->out_len  -= (int)sent;
+        this->echo_len -= (int)sent;
+    } else if (sent == -1 && errno != EAGAIN && errno != EWOULDBLOCK) {
+        LOG_F(INFO, "socket accept write err: %s", strerror(errno));
+        this->out_len = this->echo_len = 0;
+        this->drop_client();
     }
-    else
-        consecutivechars = 0;
-    return havechars;
 }
 
-int CharIoSocket::xmit_char(uint8_t c)
+bool CharIoSocket::rcv_char_available()
 {
-    write(STDOUT_FILENO, &c, 1);
+    if (this->in_pos < this->in_len)
+        return true;
 
-    if (this->acceptfd == -1)
-        this->rcv_char_available_now();
+    // the guest polls for input all the time, don't make a syscall every time
+    if (std::chrono::steady_clock::now() - this->last_poll < SOCKET_IDLE_POLL_PERIOD)
+        return false;
 
-    if (this->acceptfd != -1) {
-        int sent = (int)send(this->acceptfd, &c, 1, 0);
-        if (sent == -1) {
-            LOG_F(INFO, "socket accept write err: %s", strerror(errno));
-        }
-        if (sent == 1) {
-            /*
-            if (c < ' ') {
-                LOG_F(INFO, "socket accept write '\\x%02X'", c);
-            } else {
-                LOG_F(INFO, "socket accept write '%c'", c);
-            }
-            */
-        }
-        else {
-            LOG_F(INFO, "socket accept write %d", sent);
-        }
+    return this->rcv_char_available_now();
+}
+
+bool CharIoSocket::rcv_char_available_now()
+{
+    if (this->in_pos == this->in_len)
+        this->service();
+
+    return this->in_pos < this->in_len;
+}
+
+int CharIoSocket::xmit_char(uint8_t c)
+{
+    if (this->out_len == sizeof(this->out_buf)) {
+        this->flush_output();
+        if (this->out_len == sizeof(this->out_buf))
+            return 0; // the client doesn't keep up, lose the character
     }
+
+    this->out_buf[this->out_len++] = c;
+
+    // line ends make the output visible, everything else is batched
+    if (c == '\n' || this->out_len == sizeof(this->out_buf))
+        this->xmit_flush();
+
     return 0;
 }
 
-int CharIoSocket::rcv_char(uint8_t *c)
+void CharIoSocket::xmit_flush()
 {
     if (this->acceptfd == -1)
-        this->rcv_char_available_now();
+        this->service();
 
-    if (this->acceptfd != -1) {
-        int received = (int)recv(this->acceptfd, c, 1, 0);
-        if (received == -1) {
-            LOG_F(INFO, "socket accept read err: %s", strerror(errno));
-        }
-        else if (received == 1) {
-            /*
-            if (c) {
-                if (*c < ' ') {
-                    LOG_F(INFO, "socket accept write '\\x%02X'", *c);
-                } else {
-                    LOG_F(INFO, "socket accept read '%c'", *c);
-                }
-            } else {
-                LOG_F(INFO, "socket accept read %d", received);
-            }
-            */
-        }
-        else {
-            LOG_F(INFO, "socket accept read %d", received);
-        }
-    }
+    this->flush_output();
+}
+
+int CharIoSocket::rcv_char(uint8_t *c)
+{
+    // *c stays untouched when nothing has been received
+    this->rcv_chars(c, 1);
     return 0;
 }
 
+int CharIoSocket::rcv_chars(uint8_t *buf, int max_len)
+{
+    if (this->in_pos == this->in_len)
+        this->service();
+
+    int len = std::min(max_len, this->in_len - this->in_pos);
+    std::memcpy(buf, &this->in_buf[this->in_pos], len);
+    this->in_pos += len;
+    return len;
+}
+
 #endif
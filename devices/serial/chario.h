@@ -24,6 +24,7 @@ along with this program.  If not, see <https://www.gnu.org/licenses/>.
 #ifndef CHAR_IO_H
 #define CHAR_IO_H
 
+#include <chrono>
 #include <cinttypes>
 
 #ifdef _WIN32
@@ -50,6 +51,13 @@ public:
     virtual bool rcv_char_available_now() = 0;
     virtual int xmit_char(uint8_t c) = 0;
     virtual int rcv_char(uint8_t *c) = 0;
+
+    // Pushes buffered output to the host, called after bursts of xmit_char().
+    virtual void xmit_flush() {};
+
+    // Receives up to max_len characters that are available right now,
+    // returns the number of characters stored.
+    virtual int rcv_chars(uint8_t *buf, int max_len);
 };
 
 /** Null character I/O backend. */
@@ -83,7 +91,12 @@ private:
     int     consecutivechars = 0;
 };
 
-/** Socket character I/O backend. */
+/** Socket character I/O backend.
+
+    Data is exchanged in batches through input and output buffers over
+    a non-blocking UNIX domain socket. The socket is polled only when
+    the input buffer runs dry, at most once per millisecond while idle.
+ */
 class CharIoSocket : public CharIoBackEnd  {
 public:
     CharIoSocket();
@@ -95,13 +108,27 @@ public:
     bool rcv_char_available_now();
     int xmit_char(uint8_t c);
     int rcv_char(uint8_t *c);
+    void xmit_flush();
+    int rcv_chars(uint8_t *buf, int max_len);
 
 private:
+    void service();
+    void flush_output();
+    void drop_client();
+
     bool    socket_inited = false;
     int     sockfd = -1;
     int     acceptfd = -1;
     const char* path = 0;
-    int     consecutivechars = 0;
+
+    std::chrono::steady_clock::time_point last_poll;
+
+    uint8_t in_buf[4096];
+    int     in_pos = 0;     // next character to be delivered
+    int     in_len = 0;
+    uint8_t out_buf[4096];
+    int     out_len = 0;
+    int     echo_len = 0;   // number of buffered characters already echoed to stdout
 };
 
 #endif // CHAR_IO_H
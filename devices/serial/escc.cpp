@@ -29,11 +29,18 @@ along with this program.  If not, see <https://www.gnu.org/licenses/>.
 #include <loguru.hpp>
 #include <machines/machineproperties.h>
 
+#include <algorithm>
 #include <cinttypes>
 #include <memory>
 #include <string>
 #include <vector>
 
+// how often an idle backend is checked for data to be received via DMA
+constexpr uint64_t ESCC_RX_POLL_INTERVAL = MSECS_TO_NSECS(1);
+
+// how long characters written by the CPU are batched before they're pushed out
+constexpr uint64_t ESCC_TX_FLUSH_DELAY = USECS_TO_NSECS(500);
+
 /** Remap the compatible addressing scheme to MacRISC one. */
 const uint8_t compat_to_macrisc[6] = {
     EsccReg::Port_B_Cmd,    EsccReg::Port_A_Cmd,
@@ -344,12 +351,29 @@ uint8_t EsccChannel::read_reg(int reg_num)
     return this->read_regs[reg_num];
 }
 
+EsccChannel::~EsccChannel()
+{
+    for (uint32_t timer_id : {this->timer_id_tx, this->timer_id_rx, this->timer_id_flush})
+        if (timer_id)
+            TimerManager::get_instance()->cancel_timer(timer_id);
+}
+
 void EsccChannel::send_byte(uint8_t value)
 {
     // TODO: put one byte into the Data FIFO
 
     this->write_regs[WR8] = value;
     this->chario->xmit_char(value);
+
+    // prompts and echoed keystrokes don't end with a newline,
+    // push them out shortly after the CPU stops writing
+    if (!this->timer_id_flush) {
+        this->timer_id_flush = TimerManager::get_instance()->add_oneshot_timer(
+            ESCC_TX_FLUSH_DELAY, [this]() {
+                this->timer_id_flush = 0;
+                this->chario->xmit_flush();
+        });
+    }
 }
 
 uint8_t EsccChannel::receive_byte()
@@ -421,14 +445,32 @@ void EsccChannel::dma_in_tx()
 
 void EsccChannel::dma_in_rx()
 {
+    // pushing data may queue the next buffer and get us called recursively
+    if (this->timer_id_rx)
+        return;
+
     if (dma_ch[1]->get_push_data_remaining()) {
         this->timer_id_rx = TimerManager::get_instance()->add_oneshot_timer(
             0,
             [this]() {
                 this->timer_id_rx = 0;
-                char c = receive_byte();
-                dma_ch[1]->push_data(&c, 1);
-                this->dma_in_rx();
+
+                // deliver everything the backend has at once
+                uint8_t buf[256];
+                int len = std::min(dma_ch[1]->get_push_data_remaining(), (int)sizeof(buf));
+                len = this->chario->rcv_chars(buf, len);
+                if (len) {
+                    this->read_regs[RR8] = buf[len - 1];
+                    dma_ch[1]->push_data((char*)buf, len);
+                    this->dma_in_rx();
+                } else {
+                    this->timer_id_rx = TimerManager::get_instance()->add_oneshot_timer(
+                        ESCC_RX_POLL_INTERVAL,
+                        [this]() {
+                            this->timer_id_rx = 0;
+                            this->dma_in_rx();
+                    });
+                }
         });
     }
 }
@@ -447,6 +489,7 @@ void EsccChannel::dma_out_tx()
                     this->send_byte(*data++);
                     avail_len--;
                 }
+                this->chario->xmit_flush();
                 this->dma_out_tx();
             }
     });
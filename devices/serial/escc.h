@@ -73,7 +73,7 @@ enum DpllMode : uint8_t {
 class EsccChannel {
 public:
     EsccChannel(std::string name) { this->name = name; };
-    ~EsccChannel() = default;
+    ~EsccChannel();
 
     void attach_backend(int id);
     void reset(bool hw_reset);
@@ -118,6 +118,7 @@ public:
 private:
     uint32_t timer_id_tx = 0;
     uint32_t timer_id_rx = 0;
+    uint32_t timer_id_flush = 0;
 
     void dma_start_tx();
     void dma_stop_tx();
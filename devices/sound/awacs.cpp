@@ -57,15 +57,11 @@ void AwacsBase::set_sample_rate(int sr_id) {
 
 void AwacsBase::dma_out_start() {
     int     err;
-    bool    reopen = false;
 
-    if (this->out_stream_ready && this->out_sample_rate != this->cur_sample_rate)
-        reopen = true;
-
-    if (reopen) {
-        snd_server->close_out_stream();
-        this->out_stream_ready   = false;
-        this->out_stream_running = false;
+    // the sound server resamples so the stream can stay open
+    if (this->out_stream_ready && this->out_sample_rate != this->cur_sample_rate) {
+        snd_server->set_out_sample_rate(this->cur_sample_rate);
+        this->out_sample_rate = this->cur_sample_rate;
     }
 
     if (!this->out_stream_ready) {
@@ -83,7 +79,8 @@ void AwacsBase::dma_out_start() {
         if ((err = snd_server->start_out_stream())) {
             LOG_F(ERROR, "%s: could not start sound output stream: %d",
                   this->name.c_str(), err);
-        }
+        } else
+            this->out_stream_running = true;
     }
 }
 
@@ -0,0 +1,109 @@
+/*
+DingusPPC - The Experimental PowerPC Macintosh emulator
+Copyright (C) 2018-25 divingkatae and maximum
+                      (theweirdo)     spatium
+
+(Contact divingkatae#1017 or powermax#2286 on Discord for more info)
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+/** @file Sample rate converter for sound output. */
+
+#include <devices/sound/resampler.h>
+#include <endianswap.h>
+
+#include <algorithm>
+
+constexpr uint64_t FRAME_ONE = 1ULL << 32; // one source frame in 32.32 fixed point
+
+void AudioResampler::set_dst_rate(uint32_t dst_rate)
+{
+    this->dst_rate     = dst_rate;
+    this->cur_src_rate = 0; // force step recalculation
+}
+
+void AudioResampler::reset()
+{
+    this->phase     = 0;
+    this->cur[0]    = this->cur[1]  = 0;
+    this->next[0]   = this->next[1] = 0;
+    this->block_pos = 0;
+    this->block_len = 0;
+}
+
+void AudioResampler::set_src_rate(uint32_t src_rate)
+{
+    this->src_rate.store(src_rate, std::memory_order_release);
+}
+
+void AudioResampler::update_step()
+{
+    uint32_t rate = this->src_rate.load(std::memory_order_acquire);
+    if (rate == this->cur_src_rate)
+        return;
+
+    // buffered frames and the current position are kept across rate changes
+    this->cur_src_rate = rate;
+    this->step = (rate && this->dst_rate) ? ((uint64_t)rate << 32) / this->dst_rate : FRAME_ONE;
+}
+
+bool AudioResampler::fetch_frame(SpscRing<uint8_t>& src)
+{
+    if (this->block_pos >= this->block_len) {
+        int frames = (int)std::min(src.size() >> 2, (size_t)BLOCK_FRAMES);
+        if (!frames)
+            return false;
+
+        src.pop((uint8_t*)this->block, frames << 2);
+
+        // guest samples are big-endian, swap the whole block in one go
+        for (int i = 0; i < frames * 2; i++)
+            this->block[i] = BYTESWAP_16(this->block[i]);
+
+        this->block_pos = 0;
+        this->block_len = frames;
+    }
+
+    this->cur[0]  = this->next[0];
+    this->cur[1]  = this->next[1];
+    this->next[0] = this->block[this->block_pos * 2];
+    this->next[1] = this->block[this->block_pos * 2 + 1];
+    this->block_pos++;
+
+    return true;
+}
+
+int AudioResampler::process(SpscRing<uint8_t>& src, int16_t* dst, int dst_frames)
+{
+    this->update_step();
+
+    for (int out = 0; out < dst_frames; out++, dst += 2) {
+        // move the interpolation window to the current output position
+        while (this->phase >= FRAME_ONE) {
+            if (!this->fetch_frame(src))
+                return out;
+            this->phase -= FRAME_ONE;
+        }
+
+        // 15-bit fraction keeps the products within 32 bits
+        int32_t frac = (int32_t)(this->phase >> 17);
+        dst[0] = this->cur[0] + (((this->next[0] - this->cur[0]) * frac) >> 15);
+        dst[1] = this->cur[1] + (((this->next[1] - this->cur[1]) * frac) >> 15);
+
+        this->phase += this->step;
+    }
+
+    return dst_frames;
+}
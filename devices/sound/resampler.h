@@ -0,0 +1,78 @@
+/*
+DingusPPC - The Experimental PowerPC Macintosh emulator
+Copyright (C) 2018-25 divingkatae and maximum
+                      (theweirdo)     spatium
+
+(Contact divingkatae#1017 or powermax#2286 on Discord for more info)
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+/** @file Sample rate converter for sound output.
+
+    Converts big-endian 16-bit stereo guest samples into native-endian
+    samples at the host rate using linear interpolation. Byte swapping is
+    done while decoding source blocks so every sample is touched once.
+
+    The source rate may be changed from another thread at any time,
+    the new rate is picked up at the start of the next process() call.
+ */
+
+#ifndef AUDIO_RESAMPLER_H
+#define AUDIO_RESAMPLER_H
+
+#include <core/spscring.h>
+
+#include <atomic>
+#include <cinttypes>
+
+class AudioResampler {
+public:
+    AudioResampler()  = default;
+    ~AudioResampler() = default;
+
+    // must not be called while process() may be running
+    void set_dst_rate(uint32_t dst_rate);
+    void reset();
+
+    void set_src_rate(uint32_t src_rate);
+
+    // Fills dst with dst_frames stereo frames converted from the
+    // big-endian frames in src. Returns the number of frames produced,
+    // less than requested if the source ran dry.
+    int process(SpscRing<uint8_t>& src, int16_t* dst, int dst_frames);
+
+private:
+    bool fetch_frame(SpscRing<uint8_t>& src);
+    void update_step();
+
+    static constexpr int BLOCK_FRAMES = 256;
+
+    std::atomic<uint32_t> src_rate{0};
+    uint32_t    dst_rate = 0;
+    uint32_t    cur_src_rate = 0;
+
+    uint64_t    step  = 1ULL << 32; // source frames per output frame, 32.32 fixed point
+    uint64_t    phase = 0;          // position past the current frame, 32.32 fixed point
+
+    int16_t     cur[2] = {};        // frames surrounding the output position
+    int16_t     next[2] = {};
+
+    // source frames decoded to native byte order
+    int16_t     block[BLOCK_FRAMES * 2];
+    int         block_pos = 0;
+    int         block_len = 0;
+};
+
+#endif // AUDIO_RESAMPLER_H
@@ -36,8 +36,12 @@ along with this program.  If not, see <https://www.gnu.org/licenses/>.
 
 #include <devices/common/hwcomponent.h>
 
+#include <cinttypes>
 #include <memory>
 
+/** Set from the command line to tune the host audio buffering. */
+extern uint32_t audio_latency_ms;
+
 class DmaOutChannel;
 
 class SoundServer : public HWComponent {
@@ -49,6 +53,7 @@ public:
     void shutdown();
     int open_out_stream(uint32_t sample_rate, DmaOutChannel *dma_ch);
     int start_out_stream();
+    void set_out_sample_rate(uint32_t sample_rate);
     void close_out_stream();
 
 private:
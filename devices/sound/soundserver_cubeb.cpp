@@ -23,13 +23,16 @@ along with this program.  If not, see <https://www.gnu.org/licenses/>.
 #define NOMINMAX
 #endif // NOMINMAX
 
+#include <core/spscring.h>
 #include <core/timermanager.h>
 #include <cpu/ppc/ppcemu.h>
 #include <devices/common/dmacore.h>
+#include <devices/sound/resampler.h>
 #include <devices/sound/soundserver.h>
 #include <endianswap.h>
 
 #include <algorithm>
+#include <cstring>
 #include <functional>
 #include <loguru.hpp>
 #include <cubeb/cubeb.h>
@@ -37,6 +40,11 @@ along with this program.  If not, see <https://www.gnu.org/licenses/>.
 #include <objbase.h>
 #endif
 
+uint32_t audio_latency_ms = 40;
+
+// highest guest sample rate the output ring is sized for
+constexpr uint32_t MAX_GUEST_RATE = 48000;
+
 typedef enum {
     SND_SERVER_DOWN = 0,
     SND_API_READY,
@@ -53,8 +61,59 @@ public:
 
     uint32_t deterministic_poll_timer = 0;
     std::function<void()> deterministic_poll_cb;
+
+    // Sound samples are moved from the DMA channel into the ring by the
+    // CPU thread, the audio thread never touches guest state.
+    SpscRing<uint8_t>   out_ring;
+    AudioResampler      out_resampler;  // guest rate -> host rate, audio thread only
+    uint32_t            out_fill_target = 0; // ring fill level to maintain, in bytes
+    uint32_t            out_min_frames  = 0; // host backend latency, in host frames
+    uint32_t            out_host_rate   = 0;
+    DmaOutChannel*      out_dma_ch      = nullptr;
+    uint32_t            out_drain_timer = 0;
+
+    void drain_dma_out();
+    void set_fill_target(uint32_t sample_rate);
+
+    // cubeb callbacks, user_data points to the Impl instance
+    static long sound_out_callback(cubeb_stream *stream, void *user_data,
+                                   void const *input_buffer, void *output_buffer,
+                                   long req_frames);
 };
 
+void SoundServer::Impl::set_fill_target(uint32_t sample_rate)
+{
+    // buffer enough data to cover the requested latency but never less
+    // than what the host backend needs
+    uint32_t fill_frames = std::max(
+        (uint32_t)((uint64_t)sample_rate * audio_latency_ms / 1000),
+        (uint32_t)((uint64_t)this->out_min_frames * 2 * sample_rate / this->out_host_rate));
+
+    this->out_fill_target = std::min(fill_frames << 2, (uint32_t)this->out_ring.capacity());
+}
+
+void SoundServer::Impl::drain_dma_out()
+{
+    if (!this->out_dma_ch->is_out_active())
+        return;
+
+    size_t fill = this->out_ring.size();
+    if (fill >= this->out_fill_target)
+        return;
+
+    uint32_t req_len = this->out_fill_target - (uint32_t)fill;
+
+    while (req_len > 0) {
+        uint8_t* chunk;
+        uint32_t chunk_len;
+        if (this->out_dma_ch->pull_data(req_len, &chunk_len, &chunk) != DmaPullResult::MoreData ||
+            !chunk_len)
+            break;
+        this->out_ring.push(chunk, chunk_len);
+        req_len -= chunk_len;
+    }
+}
+
 SoundServer::SoundServer(): impl(std::make_unique<Impl>())
 {
     supports_types(HWCompType::SND_SERVER);
@@ -112,49 +171,20 @@ void SoundServer::shutdown()
     LOG_F(INFO, "Sound Server shut down.");
 }
 
-long sound_out_callback(cubeb_stream *stream, void *user_data,
-                        void const *input_buffer, void *output_buffer,
-                        long req_frames)
+long SoundServer::Impl::sound_out_callback(cubeb_stream *stream, void *user_data,
+                                           void const *input_buffer, void *output_buffer,
+                                           long req_frames)
 {
-    uint8_t *p_in;
-    int16_t* in_buf, * out_buf;
-    uint32_t got_len;
-    long frames, out_frames;
-    DmaOutChannel *dma_ch = static_cast<DmaOutChannel*>(user_data); /* C API baby! */
-
-    if (!dma_ch->is_out_active()) {
-        return 0;
-    }
-
-    out_buf = (int16_t*)output_buffer;
-
-    out_frames = 0;
+    Impl *impl = static_cast<Impl*>(user_data); /* C API baby! */
+    int16_t *out_buf = (int16_t*)output_buffer;
 
-    while (req_frames > 0) {
-        if (!dma_ch->pull_data((uint32_t)req_frames << 2, &got_len, &p_in)) {
-            if ((in_buf = (int16_t*)p_in)) {
-                frames = got_len >> 2;
+    long frames = impl->out_resampler.process(impl->out_ring, out_buf, (int)req_frames);
 
-                for (int i = (int)frames; i > 0; i--) {
-                    out_buf[0] = BYTESWAP_16(in_buf[0]);
-                    out_buf[1] = BYTESWAP_16(in_buf[1]);
-                    in_buf += 2;
-                    out_buf += 2;
-                }
+    // play silence on underrun, returning less would end the stream
+    if (frames < req_frames)
+        std::memset(out_buf + frames * 2, 0, (req_frames - frames) << 2);
 
-                req_frames -= frames;
-                out_frames += frames;
-            }
-            else {
-                LOG_F(ERROR, "Didn't get qdata");
-            }
-        }
-        else {
-            break;
-        }
-    }
-
-    return out_frames;
+    return req_frames;
 }
 
 static void status_callback(cubeb_stream *stream, void *user_data, cubeb_state state)
@@ -190,8 +220,14 @@ int SoundServer::open_out_stream(uint32_t sample_rate, DmaOutChannel *dma_ch)
     uint32_t latency_frames;
     cubeb_stream_params params;
 
+    // run the host stream at its native rate, guest rate changes are
+    // then handled by our resampler without reopening the stream
+    uint32_t host_rate;
+    if (cubeb_get_preferred_sample_rate(impl->cubeb_ctx, &host_rate) != CUBEB_OK || !host_rate)
+        host_rate = sample_rate;
+
     params.format = CUBEB_SAMPLE_S16NE;
-    params.rate = sample_rate;
+    params.rate = host_rate;
     params.channels = 2;
     params.layout = CUBEB_LAYOUT_STEREO;
     params.prefs = CUBEB_STREAM_PREF_NONE;
@@ -204,15 +240,24 @@ int SoundServer::open_out_stream(uint32_t sample_rate, DmaOutChannel *dma_ch)
         LOG_F(9, "Minimum sound latency: %d frames", latency_frames);
     }
 
+    impl->out_host_rate  = host_rate;
+    impl->out_min_frames = latency_frames;
+    impl->out_ring.resize((uint64_t)std::max(host_rate, MAX_GUEST_RATE) * 4 *
+                          std::max(audio_latency_ms, latency_frames * 2000 / host_rate + 1) / 1000);
+    impl->set_fill_target(sample_rate);
+    impl->out_resampler.set_dst_rate(host_rate);
+    impl->out_resampler.set_src_rate(sample_rate);
+    impl->out_dma_ch = dma_ch;
+
     res = cubeb_stream_init(impl->cubeb_ctx, &impl->out_stream, "SndOut stream",
                             NULL, NULL, NULL, &params, latency_frames,
-                            sound_out_callback, status_callback, dma_ch);
+                            Impl::sound_out_callback, status_callback, impl.get());
     if (res != CUBEB_OK) {
         LOG_F(ERROR, "Could not open sound output stream, error: %d", res);
         return -1;
     }
 
-    LOG_F(9, "Sound output stream opened.");
+    LOG_F(9, "Sound output stream opened, host rate %d Hz.", host_rate);
 
     impl->status = SND_STREAM_OPENED;
 
@@ -222,12 +267,43 @@ int SoundServer::open_out_stream(uint32_t sample_rate, DmaOutChannel *dma_ch)
 int SoundServer::start_out_stream()
 {
     if (is_deterministic) {
-        LOG_F(9, "Starting sound output deterministic polling.");
-        impl->deterministic_poll_timer =
-            TimerManager::get_instance()->add_cyclic_timer(MSECS_TO_NSECS(10), impl->deterministic_poll_cb);
+        if (!impl->deterministic_poll_timer) {
+            LOG_F(9, "Starting sound output deterministic polling.");
+            impl->deterministic_poll_timer =
+                TimerManager::get_instance()->add_cyclic_timer(MSECS_TO_NSECS(10), impl->deterministic_poll_cb);
+        }
+        return 0;
+    }
+
+    // the stream keeps running while the guest pauses DMA, leave the
+    // ring alone as the audio thread may be reading from it
+    if (impl->out_drain_timer)
         return 0;
+
+    impl->drain_dma_out(); // prime the ring before the host starts pulling
+
+    // refill often enough to stay ahead of the host
+    impl->out_drain_timer = TimerManager::get_instance()->add_cyclic_timer(
+        MSECS_TO_NSECS(std::max(audio_latency_ms / 4, 1U)),
+        [this]() { impl->drain_dma_out(); });
+
+    int res = cubeb_stream_start(impl->out_stream);
+    if (res != CUBEB_OK) {
+        TimerManager::get_instance()->cancel_timer(impl->out_drain_timer);
+        impl->out_drain_timer = 0;
     }
-    return cubeb_stream_start(impl->out_stream);
+
+    return res;
+}
+
+void SoundServer::set_out_sample_rate(uint32_t sample_rate)
+{
+    if (is_deterministic)
+        return;
+
+    impl->set_fill_target(sample_rate);
+    impl->out_resampler.set_src_rate(sample_rate);
+    LOG_F(9, "Sound output rate changed to %d Hz.", sample_rate);
 }
 
 void SoundServer::close_out_stream()
@@ -235,11 +311,21 @@ void SoundServer::close_out_stream()
     if (is_deterministic) {
         LOG_F(9, "Stopping sound output deterministic polling.");
         TimerManager::get_instance()->cancel_timer(impl->deterministic_poll_timer);
+        impl->deterministic_poll_timer = 0;
         impl->status = SND_STREAM_CLOSED;
         return;
     }
     cubeb_stream_stop(impl->out_stream);
+    if (impl->out_drain_timer) {
+        TimerManager::get_instance()->cancel_timer(impl->out_drain_timer);
+        impl->out_drain_timer = 0;
+    }
     cubeb_stream_destroy(impl->out_stream);
+
+    // the audio thread is gone, start over with empty buffers next time
+    impl->out_ring.clear();
+    impl->out_resampler.reset();
+
     impl->status = SND_STREAM_CLOSED;
     LOG_F(9, "Sound output stream closed.");
 }
@@ -22,7 +22,9 @@ along with this program.  If not, see <https://www.gnu.org/licenses/>.
 /** @file Block storage device implementation. */
 
 #include <devices/storage/blockstoragedevice.h>
+#include <devices/storage/diskioworker.h>
 
+#include <algorithm>
 #include <cstring>
 
 using namespace std;
@@ -40,13 +42,17 @@ BlockStorageDevice::BlockStorageDevice(const uint32_t cache_blocks,
 }
 
 BlockStorageDevice::~BlockStorageDevice() {
+    this->invalidate_cache();
     this->img_file.close();
 }
 
 int BlockStorageDevice::set_host_file(std::string file_path) {
     this->is_ready = false;
 
-    if (!this->img_file.open(file_path))
+    this->invalidate_cache();
+
+    // read-only images can be shared with other processes
+    if (!this->img_file.open(file_path, !this->is_writeable))
         return -1;
 
     this->size_bytes  = this->img_file.size();
@@ -59,6 +65,8 @@ int BlockStorageDevice::set_host_file(std::string file_path) {
 }
 
 int BlockStorageDevice::set_block_size(const int blk_size) {
+    this->invalidate_cache();
+
     this->raw_blk_size = blk_size;
 
     if (this->is_ready) {
@@ -80,23 +88,127 @@ int BlockStorageDevice::set_fpos(const uint32_t lba) {
     return 0;
 }
 
-void BlockStorageDevice::fill_cache(const int nblocks) {
-    uint32_t read_size = nblocks * this->raw_blk_size;
+void BlockStorageDevice::invalidate_cache() {
+    std::unique_lock<std::mutex> lk(this->cache_mtx);
 
-    this->img_file.read(this->data_cache.get(), this->cur_fpos, read_size);
-    this->cur_fpos += read_size;
+    // outstanding read-ahead jobs still use the current block layout
+    this->cache_cv.wait(lk, [this]() { return this->chunks_loading.empty(); });
+
+    this->chunk_map.clear();
+    this->chunk_lru.clear();
+    this->next_seq_lba = 0;
+}
+
+std::unique_ptr<char[]> BlockStorageDevice::load_chunk(uint64_t idx) {
+    uint64_t raw_size = (uint64_t)ReadAhead::CHUNK_BLOCKS * this->raw_blk_size;
+    uint64_t got;
+
+    auto data = std::unique_ptr<char[]>(new char[raw_size]);
+
+    {
+        std::lock_guard<std::mutex> lk(this->io_mtx);
+        got = this->img_file.read(data.get(), idx * raw_size, raw_size);
+    }
+
+    if (got < raw_size)
+        memset(&data[got], 0, raw_size - got);
 
     // extract block data from raw images while discarding anything else
     if (this->raw_blk_size > this->block_size) {
-        char *cache_ptr = this->data_cache.get();
+        char *chunk_ptr = data.get();
 
-        for (int blk = 0; blk < nblocks; blk++) {
-            memcpy(cache_ptr + blk * this->block_size,
-                   cache_ptr + blk * this->raw_blk_size + this->data_offset,
-                   this->block_size
+        for (uint32_t blk = 0; blk < ReadAhead::CHUNK_BLOCKS; blk++) {
+            memmove(chunk_ptr + blk * this->block_size,
+                    chunk_ptr + blk * this->raw_blk_size + this->data_offset,
+                    this->block_size
             );
         }
     }
+
+    return data;
+}
+
+// must be called with cache_mtx held
+void BlockStorageDevice::insert_chunk(uint64_t idx, std::unique_ptr<char[]> data) {
+    this->chunks_loading.erase(idx);
+
+    if (this->chunk_lru.size() >= ReadAhead::MAX_CHUNKS) {
+        this->chunk_map.erase(this->chunk_lru.back().idx);
+        this->chunk_lru.pop_back();
+    }
+
+    this->chunk_lru.push_front({idx, std::move(data)});
+    this->chunk_map[idx] = this->chunk_lru.begin();
+
+    this->cache_cv.notify_all();
+}
+
+void BlockStorageDevice::read_ahead(uint64_t first_idx) {
+    uint64_t num_chunks = (this->size_blocks + ReadAhead::CHUNK_BLOCKS - 1) /
+                          ReadAhead::CHUNK_BLOCKS;
+    uint64_t last_idx   = std::min(first_idx + ReadAhead::WINDOW, num_chunks);
+
+    for (uint64_t idx = first_idx; idx < last_idx; idx++) {
+        {
+            std::lock_guard<std::mutex> lk(this->cache_mtx);
+            if (this->chunk_map.count(idx) || this->chunks_loading.count(idx))
+                continue;
+            this->chunks_loading.insert(idx);
+        }
+
+        DiskIoWorker::get_instance()->post([this, idx]() {
+            auto data = this->load_chunk(idx);
+            std::lock_guard<std::mutex> lk(this->cache_mtx);
+            this->insert_chunk(idx, std::move(data));
+        });
+    }
+}
+
+void BlockStorageDevice::fill_cache(const int nblocks) {
+    uint64_t lba     = this->cur_fpos / this->raw_blk_size;
+    uint64_t end_lba = lba + nblocks;
+    char*    dst     = this->data_cache.get();
+    bool     is_seq  = lba == this->next_seq_lba;
+
+    this->cur_fpos    += (uint64_t)nblocks * this->raw_blk_size;
+    this->next_seq_lba = end_lba;
+
+    std::unique_lock<std::mutex> lk(this->cache_mtx);
+
+    for (uint64_t blk = lba; blk < end_lba; ) {
+        uint64_t idx = blk / ReadAhead::CHUNK_BLOCKS;
+
+        auto it = this->chunk_map.find(idx);
+        if (it == this->chunk_map.end()) {
+            if (this->chunks_loading.count(idx)) {
+                // chunk is being prefetched, wait for it
+                this->cache_cv.wait(lk);
+            } else {
+                this->chunks_loading.insert(idx);
+                lk.unlock();
+                auto data = this->load_chunk(idx);
+                lk.lock();
+                this->insert_chunk(idx, std::move(data));
+            }
+            continue;
+        }
+
+        this->chunk_lru.splice(this->chunk_lru.begin(), this->chunk_lru, it->second);
+
+        uint64_t chunk_lba = idx * ReadAhead::CHUNK_BLOCKS;
+        uint64_t count     = std::min(end_lba, chunk_lba + ReadAhead::CHUNK_BLOCKS) - blk;
+
+        memcpy(dst + (blk - lba) * this->block_size,
+               &it->second->data[(blk - chunk_lba) * this->block_size],
+               count * this->block_size);
+
+        blk += count;
+    }
+
+    lk.unlock();
+
+    if (is_seq)
+        this->read_ahead((end_lba + ReadAhead::CHUNK_BLOCKS - 1) / ReadAhead::CHUNK_BLOCKS);
 }
 
 int BlockStorageDevice::read_begin(int nblocks, uint32_t max_len) {
@@ -19,7 +19,14 @@ You should have received a copy of the GNU General Public License
 along with this program.  If not, see <https://www.gnu.org/licenses/>.
 */
 
-/** @file Block storage device definitions. */
+/** @file Block storage device definitions.
+
+    Image data is read in chunks of several blocks that are kept in a small
+    LRU cache. For raw images, block data is extracted when a chunk is
+    loaded so cache hits can be copied out directly. Sequential reads
+    trigger read-ahead of the following chunks, which is performed by the
+    disk I/O worker threads in asynchronous mode.
+ */
 
 #ifndef BLOCK_STORAGE_DEVICE_H
 #define BLOCK_STORAGE_DEVICE_H
@@ -27,8 +34,19 @@ along with this program.  If not, see <https://www.gnu.org/licenses/>.
 #include <utils/imgfile.h>
 
 #include <cinttypes>
+#include <condition_variable>
+#include <list>
 #include <memory>
+#include <mutex>
+#include <set>
 #include <string>
+#include <unordered_map>
+
+namespace ReadAhead {
+    constexpr uint32_t CHUNK_BLOCKS = 16; // blocks per cache entry
+    constexpr uint32_t MAX_CHUNKS   = 64; // cache capacity in chunks
+    constexpr uint32_t WINDOW       = 4;  // chunks to prefetch on sequential access
+};
 
 class BlockStorageDevice {
 public:
@@ -48,6 +66,9 @@ public:
 protected:
     void fill_cache(const int nblocks);
 
+    // drop all cached chunks, e.g. after changing the block layout
+    void invalidate_cache();
+
     ImgFile         img_file;
     uint64_t        size_bytes   = 0;   // image file size in bytes
     uint64_t        size_blocks  = 0;   // image file size in blocks
@@ -62,7 +83,27 @@ protected:
     bool            is_writeable = false;
     bool            is_ready     = false; // ready for operation
 
-    std::unique_ptr<char[]>  data_cache;
+    std::unique_ptr<char[]>  data_cache; // transfer buffer
+
+private:
+    struct CacheChunk {
+        uint64_t                idx;
+        std::unique_ptr<char[]> data; // extracted block data
+    };
+
+    typedef std::list<CacheChunk>::iterator chunk_iter;
+
+    std::unique_ptr<char[]> load_chunk(uint64_t idx);
+    void insert_chunk(uint64_t idx, std::unique_ptr<char[]> data);
+    void read_ahead(uint64_t first_idx);
+
+    std::mutex              io_mtx;     // serializes access to img_file
+    std::mutex              cache_mtx;  // protects the chunk cache
+    std::condition_variable cache_cv;   // signalled when a chunk finished loading
+    std::list<CacheChunk>   chunk_lru;  // most recently used first
+    std::unordered_map<uint64_t, chunk_iter> chunk_map;
+    std::set<uint64_t>      chunks_loading;
+    uint64_t                next_seq_lba = 0; // block following the last read
 };
 
 #endif // BLOCK_STORAGE_DEVICE_H
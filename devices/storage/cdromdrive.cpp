@@ -64,8 +64,8 @@ bool CdromDrive::detect_raw_image() {
 
     // for now, we only support Mode 1 images
     if (block_hdr[15] == 1) {
-        this->set_block_size(2352);
         this->data_offset = 16;
+        this->set_block_size(2352);
         return true;
     }
 
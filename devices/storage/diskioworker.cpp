@@ -0,0 +1,197 @@
+/*
+DingusPPC - The Experimental PowerPC Macintosh emulator
+Copyright (C) 2018-25 divingkatae and maximum
+                      (theweirdo)     spatium
+
+(Contact divingkatae#1017 or powermax#2286 on Discord for more info)
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+/** @file Asynchronous host I/O for disk devices. */
+
+#include <devices/storage/diskioworker.h>
+#include <loguru.hpp>
+
+#include <algorithm>
+
+extern bool is_deterministic;
+
+bool async_disk_io = false;
+
+DiskIoWorker* DiskIoWorker::disk_io_worker;
+
+PropMap add_hdd_cache_props(PropMap props) {
+    props["hdd_cache_size"]    = new IntProperty(16, 0, 1024);
+    props["hdd_write_through"] = new BinProperty(1);
+    props["hdd_flush_ms"]      = new IntProperty(1000, 0, 60000);
+    return props;
+}
+
+uint64_t DiskSeekModel::access_time(uint64_t lba, uint32_t num_blocks,
+                                    uint32_t block_size) {
+    uint64_t delay = (uint64_t)num_blocks * block_size * NS_PER_SEC /
+                     DiskTiming::MEDIA_RATE;
+
+    // sequential accesses don't require any head movement
+    if (lba != this->head_lba) {
+        uint64_t distance = lba > this->head_lba ? lba - this->head_lba :
+                                                   this->head_lba - lba;
+        uint64_t seek_ns  = DiskTiming::TRACK_TO_TRACK_NS;
+        if (this->total_blocks) {
+            distance = std::min(distance, this->total_blocks);
+            seek_ns += (DiskTiming::FULL_STROKE_NS - DiskTiming::TRACK_TO_TRACK_NS) *
+                       distance / this->total_blocks;
+        }
+        delay += seek_ns + DiskTiming::HALF_ROTATION_NS;
+    }
+
+    this->head_lba = lba + num_blocks;
+
+    return delay;
+}
+
+DiskIoWorker::~DiskIoWorker() {
+    {
+        std::lock_guard<std::mutex> lk(this->queue_mtx);
+        this->shutting_down = true;
+    }
+    this->queue_cv.notify_all();
+
+    for (auto& worker : this->workers)
+        worker.join();
+}
+
+bool DiskIoWorker::is_async() const {
+    return async_disk_io && !is_deterministic;
+}
+
+void DiskIoWorker::start_workers() {
+    int num_workers = std::clamp((int)std::thread::hardware_concurrency(), 1, 4);
+
+    LOG_F(INFO, "DiskIoWorker: starting %d I/O worker threads", num_workers);
+
+    for (int i = 0; i < num_workers; i++)
+        this->workers.emplace_back(&DiskIoWorker::worker_loop, this);
+}
+
+void DiskIoWorker::worker_loop() {
+    while (true) {
+        std::shared_ptr<IoJob> job;
+
+        {
+            std::unique_lock<std::mutex> lk(this->queue_mtx);
+            this->queue_cv.wait(lk, [this]() {
+                return this->shutting_down || !this->job_queue.empty();
+            });
+            if (this->job_queue.empty())
+                return;
+            job = this->job_queue.front();
+            this->job_queue.pop_front();
+        }
+
+        job->io_func();
+        job->done.store(true, std::memory_order_release);
+
+        {
+            std::lock_guard<std::mutex> lk(this->queue_mtx);
+            this->jobs_pending--;
+        }
+        this->idle_cv.notify_all();
+    }
+}
+
+bool DiskIoWorker::submit(const void* owner, io_job_cb io_func, uint64_t delay_ns,
+                          timer_cb done_cb) {
+    if (!this->is_async()) {
+        io_func();
+        return false;
+    }
+
+    if (this->workers.empty())
+        this->start_workers();
+
+    auto job = std::make_shared<IoJob>();
+    job->io_func = std::move(io_func);
+    job->owner   = owner;
+    job->done_cb = std::move(done_cb);
+
+    {
+        std::lock_guard<std::mutex> lk(this->queue_mtx);
+        this->job_queue.push_back(job);
+        this->jobs_pending++;
+    }
+    this->queue_cv.notify_one();
+
+    this->completions.push_back(job);
+    this->schedule_completion(job, delay_ns);
+
+    return true;
+}
+
+void DiskIoWorker::cancel_completions(const void* owner) {
+    auto it = this->completions.begin();
+    while (it != this->completions.end()) {
+        if ((*it)->owner == owner) {
+            TimerManager::get_instance()->cancel_timer((*it)->timer_id);
+            it = this->completions.erase(it);
+        } else
+            it++;
+    }
+}
+
+void DiskIoWorker::post(io_job_cb io_func) {
+    if (!this->is_async()) {
+        io_func();
+        return;
+    }
+
+    if (this->workers.empty())
+        this->start_workers();
+
+    auto job = std::make_shared<IoJob>();
+    job->io_func = std::move(io_func);
+
+    {
+        std::lock_guard<std::mutex> lk(this->queue_mtx);
+        this->job_queue.push_back(job);
+        this->jobs_pending++;
+    }
+    this->queue_cv.notify_one();
+}
+
+void DiskIoWorker::schedule_completion(std::shared_ptr<IoJob> job, uint64_t delay_ns) {
+    job->timer_id = TimerManager::get_instance()->add_oneshot_timer(delay_ns,
+        [this, job]() {
+            this->poll_completion(job);
+    });
+}
+
+void DiskIoWorker::poll_completion(std::shared_ptr<IoJob> job) {
+    if (job->done.load(std::memory_order_acquire)) {
+        auto it = std::find(this->completions.begin(), this->completions.end(), job);
+        if (it != this->completions.end())
+            this->completions.erase(it);
+        job->done_cb();
+        return;
+    }
+
+    // host I/O is slower than the modelled drive, keep the guest running
+    this->schedule_completion(job, DiskTiming::COMPLETION_POLL_NS);
+}
+
+void DiskIoWorker::wait_idle() {
+    std::unique_lock<std::mutex> lk(this->queue_mtx);
+    this->idle_cv.wait(lk, [this]() { return !this->jobs_pending; });
+}
@@ -0,0 +1,166 @@
+/*
+DingusPPC - The Experimental PowerPC Macintosh emulator
+Copyright (C) 2018-25 divingkatae and maximum
+                      (theweirdo)     spatium
+
+(Contact divingkatae#1017 or powermax#2286 on Discord for more info)
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+/** @file Asynchronous host I/O for disk devices.
+
+    Disk devices hand their host file operations over to a small pool
+    of worker threads so that a slow host disk doesn't stall the emulated
+    CPU. Completion is reported back on the emulator thread through the
+    TimerManager after a modelled mechanical delay, so the guest observes
+    a seek latency instead of a host stall.
+
+    Asynchronous operation is optional and is never used in deterministic
+    mode where all I/O is performed synchronously.
+ */
+
+#ifndef DISK_IO_WORKER_H
+#define DISK_IO_WORKER_H
+
+#include <core/timermanager.h>
+#include <machines/machineproperties.h>
+
+#include <atomic>
+#include <cinttypes>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/** Set from the command line to enable asynchronous disk I/O. */
+extern bool async_disk_io;
+
+/** Mechanical drive parameters used to model command latency. */
+namespace DiskTiming {
+    constexpr uint64_t TRACK_TO_TRACK_NS  = USECS_TO_NSECS(800);
+    constexpr uint64_t FULL_STROKE_NS     = MSECS_TO_NSECS(15);
+    constexpr uint64_t HALF_ROTATION_NS   = USECS_TO_NSECS(4167); // 7200 RPM
+    constexpr uint64_t MEDIA_RATE         = 10000000; // bytes per second
+    constexpr uint64_t COMPLETION_POLL_NS = USECS_TO_NSECS(100);
+};
+
+/** Tracks the head position of a single drive and estimates access times. */
+class DiskSeekModel {
+public:
+    DiskSeekModel() = default;
+    ~DiskSeekModel() = default;
+
+    void set_total_blocks(uint64_t total_blocks) {
+        this->total_blocks = total_blocks;
+        this->head_lba     = 0;
+    }
+
+    uint64_t access_time(uint64_t lba, uint32_t num_blocks, uint32_t block_size);
+
+private:
+    uint64_t    total_blocks = 0;
+    uint64_t    head_lba     = 0;
+};
+
+/** Adds the host cache properties of hard disk images (hdd_cache_size,
+    hdd_write_through, hdd_flush_ms) to the property map of a device.
+ */
+extern PropMap add_hdd_cache_props(PropMap props);
+
+typedef std::function<void()> io_job_cb;
+
+class DiskIoWorker {
+public:
+    static DiskIoWorker* get_instance() {
+        if (!disk_io_worker) {
+            disk_io_worker = new DiskIoWorker();
+        }
+        return disk_io_worker;
+    };
+
+    // for teardown paths that mustn't bring a shut down worker back
+    static DiskIoWorker* get_instance_if_running() {
+        return disk_io_worker;
+    };
+
+    // finish outstanding jobs and stop the worker threads
+    static void shutdown() {
+        delete disk_io_worker;
+        disk_io_worker = nullptr;
+    };
+
+    ~DiskIoWorker();
+
+    bool is_async() const;
+
+    /** Execute host I/O for a disk command.
+        In asynchronous mode, io_func runs on a worker thread and done_cb is
+        invoked on the emulator thread after at least delay_ns of virtual
+        time have passed and io_func has returned. Returns true in that case.
+        Otherwise, io_func is executed immediately, done_cb is dropped and
+        false is returned so the caller can continue synchronously.
+        The owner is used to cancel pending completions, see below.
+     */
+    bool submit(const void* owner, io_job_cb io_func, uint64_t delay_ns,
+                timer_cb done_cb);
+
+    /** Drop the completion callbacks of all commands submitted by owner.
+        Must be called by devices before they go away. Host I/O already
+        handed over to the workers isn't affected, use wait_idle() for that.
+     */
+    void cancel_completions(const void* owner);
+
+    /** Execute host I/O nobody is waiting for (e.g. read-ahead).
+        Runs io_func on a worker thread in asynchronous mode and
+        immediately otherwise.
+     */
+    void post(io_job_cb io_func);
+
+    // block until all submitted jobs have been processed
+    void wait_idle();
+
+private:
+    static DiskIoWorker* disk_io_worker;
+    DiskIoWorker() {}; // private constructor to implement a singleton
+
+    struct IoJob {
+        io_job_cb           io_func;
+        std::atomic<bool>   done{false};
+        const void*         owner = nullptr;
+        timer_cb            done_cb;
+        uint32_t            timer_id = 0;
+    };
+
+    void start_workers();
+    void worker_loop();
+    void schedule_completion(std::shared_ptr<IoJob> job, uint64_t delay_ns);
+    void poll_completion(std::shared_ptr<IoJob> job);
+
+    std::vector<std::thread>            workers;
+    std::deque<std::shared_ptr<IoJob>>  job_queue;
+    std::mutex                          queue_mtx;
+    std::condition_variable             queue_cv;
+    std::condition_variable             idle_cv;
+    int                                 jobs_pending = 0;
+    bool                                shutting_down = false;
+
+    // jobs waiting for their completion, only accessed on the emulator thread
+    std::vector<std::shared_ptr<IoJob>> completions;
+};
+
+#endif // DISK_IO_WORKER_H
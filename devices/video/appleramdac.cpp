@@ -26,6 +26,8 @@ along with this program.  If not, see <https://www.gnu.org/licenses/>.
 #include <loguru.hpp>
 #include <memaccess.h>
 
+#include <iterator>
+
 AppleRamdac::AppleRamdac(DacFlavour flavour) {
     this->flavour =  flavour;
 
@@ -225,10 +227,10 @@ void AppleRamdac::measure_hw_cursor(uint8_t *fb_ptr) {
     this->cursor_ypos   = cur_pos_y_start;
 }
 
-void AppleRamdac::draw_hw_cursor(uint8_t *src_buf, uint8_t *dst_buf, int dst_pitch) {
+std::function<void(uint8_t *dst_buf, int dst_pitch)> AppleRamdac::capture_hw_cursor(uint8_t *src_buf) {
     int num_pixels = this->video_width - this->cursor_xpos;
     if (num_pixels <= 0)
-        return;
+        return nullptr;
     if (num_pixels > 32)
         num_pixels = 32;
 
@@ -239,32 +241,41 @@ void AppleRamdac::draw_hw_cursor(uint8_t *src_buf, uint8_t *dst_buf, int dst_pit
     uint64_t mask0 = (~0LL) << ((num_pixels >= 16) ? 0 : ((16 - num_pixels) * 4));
     uint64_t mask1 = (num_pixels <= 16) ? 0LL : ((~0LL) << ((32 - num_pixels) * 4));
 
+    std::vector<uint64_t> cursor_data(this->cursor_height * num_words);
+
     uint8_t *src_row = src_buf + this->fb_pitch * this->cursor_ypos;
-    uint8_t *dst_row = dst_buf + this->cursor_ypos * dst_pitch +
-                           this->cursor_xpos * sizeof(uint32_t);
-    int src_pitch = this->fb_pitch;
-
-    uint32_t *color = &this->cursor_clut[0];
-
-    for (int h = this->cursor_height; h > 0; h--) {
-        uint8_t* dst_16 = dst_row;
-        for (int x = 0; x < num_words; x++) {
-            uint8_t* dst_1 = dst_16;
-            uint64_t pix_data = READ_QWORD_BE_A(src_row + x * sizeof(uint64_t)) & (x ? mask1 : mask0);
-            while (pix_data) {
-                uint8_t pix = pix_data >> 60; // each pixel is 4 bits wide
-                if (pix & 8) { // check control bit: 0 - transparent, 1 - opaque
-                    WRITE_DWORD_LE_A(dst_1, color[pix & 7]);
-                } else if (pix & 1) {
-                    uint32_t c = (((READ_DWORD_LE_A(dst_1) >> 7) & 0x010101) * 0xFFU) ^ 0xFFFFFFU;
-                    WRITE_DWORD_LE_A(dst_1, c);
+    for (int h = 0; h < this->cursor_height; h++, src_row += this->fb_pitch) {
+        for (int x = 0; x < num_words; x++)
+            cursor_data[h * num_words + x] =
+                READ_QWORD_BE_A(src_row + x * sizeof(uint64_t)) & (x ? mask1 : mask0);
+    }
+
+    int xpos = this->cursor_xpos;
+    int ypos = this->cursor_ypos;
+    std::vector<uint32_t> color(std::begin(this->cursor_clut), std::end(this->cursor_clut));
+
+    return [cursor_data, num_words, xpos, ypos, color](uint8_t *dst_buf, int dst_pitch) {
+        uint8_t *dst_row = dst_buf + ypos * dst_pitch + xpos * sizeof(uint32_t);
+
+        for (size_t row = 0; row < cursor_data.size(); row += num_words) {
+            uint8_t* dst_16 = dst_row;
+            for (int x = 0; x < num_words; x++) {
+                uint8_t* dst_1 = dst_16;
+                uint64_t pix_data = cursor_data[row + x];
+                while (pix_data) {
+                    uint8_t pix = pix_data >> 60; // each pixel is 4 bits wide
+                    if (pix & 8) { // check control bit: 0 - transparent, 1 - opaque
+                        WRITE_DWORD_LE_A(dst_1, color[pix & 7]);
+                    } else if (pix & 1) {
+                        uint32_t c = (((READ_DWORD_LE_A(dst_1) >> 7) & 0x010101) * 0xFFU) ^ 0xFFFFFFU;
+                        WRITE_DWORD_LE_A(dst_1, c);
+                    }
+                    pix_data <<= 4;
+                    dst_1 += sizeof(uint32_t);
                 }
-                pix_data <<= 4;
-                dst_1 += sizeof(uint32_t);
+                dst_16 += 16 * sizeof(uint32_t);
             }
-            dst_16 += 16 * sizeof(uint32_t);
+            dst_row += dst_pitch;
         }
-        src_row += src_pitch;
-        dst_row += dst_pitch;
-    }
+    };
 }
@@ -47,6 +47,7 @@ along with this program.  If not, see <https://www.gnu.org/licenses/>.
 
 #include <cinttypes>
 #include <functional>
+#include <vector>
 
 enum DacFlavour {
     RADACAL,
@@ -112,7 +113,10 @@ public:
     };
 
     void measure_hw_cursor(uint8_t *fb_ptr);
-    void draw_hw_cursor(uint8_t *src_buf, uint8_t *dst_buf, int dst_pitch);
+
+    // Snapshots the cursor plane and returns a function drawing it over
+    // a converted frame. The latter doesn't access the RAMDAC anymore.
+    std::function<void(uint8_t *dst_buf, int dst_pitch)> capture_hw_cursor(uint8_t *src_buf);
 
     GetClutEntryCallback get_clut_entry_cb = nullptr;
     SetClutEntryCallback set_clut_entry_cb = nullptr;
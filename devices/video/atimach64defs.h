@@ -457,10 +457,14 @@ enum {
     ATI_DST_HEIGHT_WIDTH      = 0x046, // 0x0118
     ATI_DST_X_WIDTH           = 0x047, // 0x011C
     ATI_DST_BRES_LNTH         = 0x048, // 0x0120
+        ATI_DST_BRES_LNTH_pos = 0, ATI_DST_BRES_LNTH_size = 15,
+
     ATI_DST_BRES_ERR          = 0x049, // 0x0124
     ATI_DST_BRES_INC          = 0x04A, // 0x0128
     ATI_DST_BRES_DEC          = 0x04B, // 0x012C
-    ATI_DST_CNTL              = 0x04C, // 0x0130
+        ATI_DST_BRES_size = 18, // signed Bresenham error terms
+
+    ATI_DST_CNTL              = 0x04C, // 0x0130, same bits as GUI_TRAJ_CNTL[15:0]
     ATI_DST_Y_X_ALIAS1        = 0x04D, // 0x0134
     ATI_TRAIL_BRES_ERR        = 0x04E, // 0x0138
     ATI_TRAIL_BRES_INC        = 0x04F, // 0x013C
@@ -483,6 +487,12 @@ enum {
     ATI_SRC_HEIGHT2           = 0x06B, // 0x01AC
     ATI_SRC_HEIGHT2_WIDTH2    = 0x06C, // 0x01B0
     ATI_SRC_CNTL              = 0x06D, // 0x01B4
+        ATI_SRC_CNTL_PATT_EN        = 0,
+        ATI_SRC_CNTL_PATT_ROT_EN    = 1,
+        ATI_SRC_CNTL_LINEAR_EN      = 2,
+        ATI_SRC_CNTL_BYTE_ALIGN     = 3,
+        ATI_SRC_CNTL_LINE_X_DIR     = 4,
+
     ATI_SCALE_OFF             = 0x070, // 0x01C0
     ATI_SCALE_WIDTH           = 0x077, // 0x01DC
     ATI_SCALE_HEIGHT          = 0x078, // 0x01E0
@@ -491,11 +501,19 @@ enum {
     ATI_SCALE_Y_INC           = 0x07D, // 0x01F4
     ATI_SCALE_VACC            = 0x07E, // 0x01F8
     ATI_SCALE_3D_CNTL         = 0x07F, // 0x01FC
+    ATI_HOST_DATA0            = 0x080, // 0x0200
+    ATI_HOST_DATAF            = 0x08F, // 0x023C
+
     ATI_HOST_CNTL             = 0x090, // 0x0240
+        ATI_HOST_CNTL_BYTE_ALIGN    = 0,
+        ATI_HOST_CNTL_BIG_ENDIAN_EN = 1,
 
     ATI_PAT_REG0              = 0x0A0, // 0x0280
     ATI_PAT_REG1              = 0x0A1, // 0x0284
     ATI_PAT_CNTL              = 0x0A2, // 0x0288
+        ATI_PAT_CNTL_MONO_EN        = 0,
+        ATI_PAT_CNTL_CLR_4x2_EN     = 1,
+        ATI_PAT_CNTL_CLR_8x1_EN     = 2,
 
     ATI_SC_LEFT               = 0x0A8, // 0x02A0
         ATI_SC_LEFT_pos = 0, ATI_SC_LEFT_size = 13,
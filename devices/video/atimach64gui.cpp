@@ -0,0 +1,614 @@
+/*
+DingusPPC - The Experimental PowerPC Macintosh emulator
+Copyright (C) 2018-25 divingkatae and maximum
+                      (theweirdo)     spatium
+
+(Contact divingkatae#1017 or powermax#2286 on Discord for more info)
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+/** @file Mach64 2D GUI drawing engine emulation. */
+
+#include <core/bitops.h>
+#include <devices/video/atimach64defs.h>
+#include <devices/video/atimach64gui.h>
+#include <endianswap.h>
+#include <loguru.hpp>
+#include <memaccess.h>
+
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+// bytes per pixel for DP_PIX_WIDTH codes, zero for unsupported depths
+static const int pix_width_bytes[16] = {
+    0, // monochrome
+    0, // 4bpp
+    1, // 8bpp
+    2, // 15bpp (RGB555)
+    2, // 16bpp (RGB565)
+    0, // 24bpp
+    4, // 32bpp (ARGB8888)
+    1, // 8bpp (RGB332)
+};
+
+static inline int32_t sign_extend(uint32_t val, int bits) {
+    return (int32_t)(val << (32 - bits)) >> (32 - bits);
+}
+
+static inline uint32_t apply_mix(int mix, uint32_t s, uint32_t d) {
+    switch (mix) {
+    case DP_MIX_NOT_D:
+        return ~d;
+    case DP_MIX_ZERO:
+        return 0;
+    case DP_MIX_ONE:
+        return 0xFFFFFFFFU;
+    case DP_MIX_D:
+        return d;
+    case DP_MIX_NOT_S:
+        return ~s;
+    case DP_MIX_D_XOR_S:
+        return d ^ s;
+    case DP_MIX_D_XNOR_S:
+        return ~(d ^ s);
+    case DP_MIX_S:
+        return s;
+    case DP_MIX_NOT_D_OR_NOT_S:
+        return ~d | ~s;
+    case DP_MIX_D_OR_NOT_S:
+        return d | ~s;
+    case DP_MIX_NOT_D_OR_S:
+        return ~d | s;
+    case DP_MIX_D_OR_S:
+        return d | s;
+    case DP_MIX_D_AND_S:
+        return d & s;
+    case DP_MIX_NOT_D_AND_S:
+        return ~d & s;
+    case DP_MIX_D_AND_NOT_S:
+        return d & ~s;
+    case DP_MIX_NOT_D_AND_NOT_S:
+        return ~d & ~s;
+    default:
+        LOG_F(9, "Mach64 GUI: unsupported mix function 0x%X", mix);
+        return s;
+    }
+}
+
+Mach64GuiEngine::Mach64GuiEngine(uint32_t* regs, uint8_t* vram, uint32_t vram_size)
+{
+    this->regs      = regs;
+    this->vram      = vram;
+    this->vram_size = vram_size;
+}
+
+void Mach64GuiEngine::reset()
+{
+    if (this->host_wait)
+        LOG_F(WARNING, "Mach64 GUI: host data transfer aborted");
+
+    this->host_wait = false;
+}
+
+bool Mach64GuiEngine::write_reg(uint32_t reg_num, uint32_t value)
+{
+    switch (reg_num) {
+    case ATI_DST_Y_X:
+        this->regs[ATI_DST_X] = extract_bits<uint32_t>(value, 16, ATI_DST_X_size);
+        this->regs[ATI_DST_Y] = extract_bits<uint32_t>(value,  0, ATI_DST_Y_size);
+        break;
+    case ATI_DST_X_Y:
+        this->regs[ATI_DST_X] = extract_bits<uint32_t>(value,  0, ATI_DST_X_size);
+        this->regs[ATI_DST_Y] = extract_bits<uint32_t>(value, 16, ATI_DST_Y_size);
+        break;
+    case ATI_DST_HEIGHT:
+        return this->draw_rect();
+    case ATI_DST_HEIGHT_WIDTH:
+        this->regs[ATI_DST_WIDTH]  = extract_bits<uint32_t>(value, 16, ATI_DST_WIDTH_size);
+        this->regs[ATI_DST_HEIGHT] = extract_bits<uint32_t>(value,  0, ATI_DST_HEIGHT_size);
+        return this->draw_rect();
+    case ATI_DST_WIDTH_HEIGHT:
+        this->regs[ATI_DST_WIDTH]  = extract_bits<uint32_t>(value,  0, ATI_DST_WIDTH_size);
+        this->regs[ATI_DST_HEIGHT] = extract_bits<uint32_t>(value, 16, ATI_DST_HEIGHT_size);
+        return this->draw_rect();
+    case ATI_DST_BRES_LNTH:
+        return this->draw_line();
+    case ATI_SRC_Y_X:
+        this->regs[ATI_SRC_X] = extract_bits<uint32_t>(value, 16, 13);
+        this->regs[ATI_SRC_Y] = extract_bits<uint32_t>(value,  0, 15);
+        break;
+    case ATI_SRC_HEIGHT1_WIDTH1:
+        this->regs[ATI_SRC_WIDTH1]  = extract_bits<uint32_t>(value, 16, 13);
+        this->regs[ATI_SRC_HEIGHT1] = extract_bits<uint32_t>(value,  0, 15);
+        break;
+    case ATI_SC_LEFT_RIGHT:
+        this->regs[ATI_SC_LEFT]  = extract_bits<uint32_t>(value,  0, ATI_SC_LEFT_size);
+        this->regs[ATI_SC_RIGHT] = extract_bits<uint32_t>(value, 16, ATI_SC_RIGHT_size);
+        break;
+    case ATI_SC_TOP_BOTTOM:
+        this->regs[ATI_SC_TOP]    = extract_bits<uint32_t>(value,  0, ATI_SC_TOP_size);
+        this->regs[ATI_SC_BOTTOM] = extract_bits<uint32_t>(value, 16, ATI_SC_BOTTOM_size);
+        break;
+    case ATI_GUI_TRAJ_CNTL:
+        // GUI_TRAJ_CNTL is a composite of DST_CNTL, SRC_CNTL, PAT_CNTL and HOST_CNTL
+        this->regs[ATI_DST_CNTL] = extract_bits<uint32_t>(value, 0, 16);
+        this->regs[ATI_SRC_CNTL] =
+            (bit_set(value, ATI_SRC_PATT_EN)     << ATI_SRC_CNTL_PATT_EN)     |
+            (bit_set(value, ATI_SRC_PATT_ROT_EN) << ATI_SRC_CNTL_PATT_ROT_EN) |
+            (bit_set(value, ATI_SRC_LINEAR_EN)   << ATI_SRC_CNTL_LINEAR_EN)   |
+            (bit_set(value, ATI_SRC_BYTE_ALIGN)  << ATI_SRC_CNTL_BYTE_ALIGN)  |
+            (bit_set(value, ATI_SRC_LINE_X_DIR)  << ATI_SRC_CNTL_LINE_X_DIR);
+        this->regs[ATI_PAT_CNTL] =
+            (bit_set(value, ATI_PAT_MONO_EN)    << ATI_PAT_CNTL_MONO_EN)    |
+            (bit_set(value, ATI_PAT_CLR_4x2_EN) << ATI_PAT_CNTL_CLR_4x2_EN) |
+            (bit_set(value, ATI_PAT_CLR_8x1_EN) << ATI_PAT_CNTL_CLR_8x1_EN);
+        this->regs[ATI_HOST_CNTL] =
+            (bit_set(value, ATI_HOST_BYTE_ALIGN)    << ATI_HOST_CNTL_BYTE_ALIGN) |
+            (bit_set(value, ATI_HOST_BIG_ENDIAN_EN) << ATI_HOST_CNTL_BIG_ENDIAN_EN);
+        break;
+    default:
+        if (reg_num >= ATI_HOST_DATA0 && reg_num <= ATI_HOST_DATAF)
+            return this->host_data(value);
+    }
+
+    return false;
+}
+
+bool Mach64GuiEngine::setup_op()
+{
+    uint32_t* regs = this->regs;
+    GuiOp&    op   = this->op;
+
+    uint32_t pix_width = regs[ATI_DP_PIX_WIDTH];
+
+    op.dst_bpp  = pix_width_bytes[extract_bits<uint32_t>(pix_width, ATI_DP_DST_PIX_WIDTH,
+                                                         ATI_DP_DST_PIX_WIDTH_size)];
+    op.src_bpp  = pix_width_bytes[extract_bits<uint32_t>(pix_width, ATI_DP_SRC_PIX_WIDTH,
+                                                         ATI_DP_SRC_PIX_WIDTH_size)];
+    op.host_bpp = pix_width_bytes[extract_bits<uint32_t>(pix_width, ATI_DP_HOST_PIX_WIDTH,
+                                                         ATI_DP_HOST_PIX_WIDTH_size)];
+    op.lsb_first = bit_set(pix_width, ATI_DP_BYTE_PIX_ORDER);
+
+    if (!op.dst_bpp) {
+        LOG_F(WARNING, "Mach64 GUI: unsupported destination pixel width %d",
+              extract_bits<uint32_t>(pix_width, ATI_DP_DST_PIX_WIDTH,
+                                     ATI_DP_DST_PIX_WIDTH_size));
+        return false;
+    }
+
+    if (!op.host_bpp)
+        op.host_bpp = op.dst_bpp;
+
+    op.pix_mask = op.dst_bpp == 4 ? 0xFFFFFFFFU : (1U << (op.dst_bpp * 8)) - 1;
+
+    uint32_t dst_off_pitch = regs[ATI_DST_OFF_PITCH];
+    op.dst_base  = extract_bits<uint32_t>(dst_off_pitch, ATI_DST_OFFSET, ATI_DST_OFFSET_size) * 8;
+    op.dst_pitch = extract_bits<uint32_t>(dst_off_pitch, ATI_DST_PITCH, ATI_DST_PITCH_size) * 8 *
+                   op.dst_bpp;
+
+    // source offset and pitch share the layout of the destination ones,
+    // the pitch of a monochrome source is kept in bits
+    uint32_t src_off_pitch = regs[ATI_SRC_OFF_PITCH];
+    op.src_base  = extract_bits<uint32_t>(src_off_pitch, ATI_DST_OFFSET, ATI_DST_OFFSET_size) * 8;
+    op.src_pitch = extract_bits<uint32_t>(src_off_pitch, ATI_DST_PITCH, ATI_DST_PITCH_size) * 8 *
+                   std::max(op.src_bpp, 1);
+
+    uint32_t dst_cntl = regs[ATI_DST_CNTL];
+    op.x      = extract_bits<uint32_t>(regs[ATI_DST_X], ATI_DST_X_pos, ATI_DST_X_size);
+    op.y      = extract_bits<uint32_t>(regs[ATI_DST_Y], ATI_DST_Y_pos, ATI_DST_Y_size);
+    op.x_step = bit_set(dst_cntl, ATI_DST_X_DIR) ? 1 : -1;
+    op.y_step = bit_set(dst_cntl, ATI_DST_Y_DIR) ? 1 : -1;
+    op.src_x  = extract_bits<uint32_t>(regs[ATI_SRC_X], 0, 13);
+    op.src_y  = extract_bits<uint32_t>(regs[ATI_SRC_Y], 0, 15);
+    op.width  = extract_bits<uint32_t>(regs[ATI_DST_WIDTH], ATI_DST_WIDTH_pos, ATI_DST_WIDTH_size);
+    op.height = extract_bits<uint32_t>(regs[ATI_DST_HEIGHT], ATI_DST_HEIGHT_pos,
+                                       ATI_DST_HEIGHT_size);
+    op.col    = 0;
+    op.row    = 0;
+
+    uint32_t dp_src = regs[ATI_DP_SRC];
+    op.frgd_src = extract_bits<uint32_t>(dp_src, ATI_DP_FRGD_SRC, ATI_DP_FRGD_SRC_size);
+    op.bkgd_src = extract_bits<uint32_t>(dp_src, ATI_DP_BKGD_SRC, ATI_DP_BKGD_SRC_size);
+    op.mono_src = extract_bits<uint32_t>(dp_src, ATI_DP_MONO_SRC, ATI_DP_MONO_SRC_size);
+
+    if ((op.frgd_src == DP_SRC_BLIT || op.bkgd_src == DP_SRC_BLIT) && !op.src_bpp) {
+        LOG_F(WARNING, "Mach64 GUI: unsupported source pixel width %d",
+              extract_bits<uint32_t>(pix_width, ATI_DP_SRC_PIX_WIDTH,
+                                     ATI_DP_SRC_PIX_WIDTH_size));
+        return false;
+    }
+
+    uint32_t dp_mix = regs[ATI_DP_MIX];
+    op.frgd_mix = extract_bits<uint32_t>(dp_mix, ATI_DP_FRGD_MIX, ATI_DP_FRGD_MIX_size);
+    op.bkgd_mix = extract_bits<uint32_t>(dp_mix, ATI_DP_BKGD_MIX, ATI_DP_BKGD_MIX_size);
+
+    op.frgd_clr   = regs[ATI_DP_FRGD_CLR]  & op.pix_mask;
+    op.bkgd_clr   = regs[ATI_DP_BKGD_CLR]  & op.pix_mask;
+    op.write_mask = regs[ATI_DP_WRITE_MSK] & op.pix_mask;
+
+    op.sc_left   = extract_bits<uint32_t>(regs[ATI_SC_LEFT], ATI_SC_LEFT_pos, ATI_SC_LEFT_size);
+    op.sc_right  = extract_bits<uint32_t>(regs[ATI_SC_RIGHT], ATI_SC_RIGHT_pos, ATI_SC_RIGHT_size);
+    op.sc_top    = extract_bits<uint32_t>(regs[ATI_SC_TOP], ATI_SC_TOP_pos, ATI_SC_TOP_size);
+    op.sc_bottom = extract_bits<uint32_t>(regs[ATI_SC_BOTTOM], ATI_SC_BOTTOM_pos,
+                                          ATI_SC_BOTTOM_size);
+
+    uint32_t cmp_cntl = regs[ATI_CLR_CMP_CNTL];
+    op.cmp_fcn  = extract_bits<uint32_t>(cmp_cntl, ATI_CLR_CMP_FCN, ATI_CLR_CMP_FCN_size);
+    op.cmp_src  = extract_bits<uint32_t>(cmp_cntl, ATI_CLR_CMP_SRC, ATI_CLR_CMP_SRC_size) == 1;
+    op.cmp_mask = regs[ATI_CLR_CMP_MSK] & op.pix_mask;
+    op.cmp_clr  = regs[ATI_CLR_CMP_CLR] & op.cmp_mask;
+
+    op.host_byte_align = bit_set(regs[ATI_HOST_CNTL], ATI_HOST_CNTL_BYTE_ALIGN);
+    op.host_big_endian = bit_set(regs[ATI_HOST_CNTL], ATI_HOST_CNTL_BIG_ENDIAN_EN);
+    op.host_acc        = 0;
+    op.host_acc_bytes  = 0;
+
+    return true;
+}
+
+bool Mach64GuiEngine::draw_rect()
+{
+    if (this->host_wait) {
+        LOG_F(WARNING, "Mach64 GUI: new operation started before host data was complete");
+        this->host_wait = false;
+    }
+
+    if (!this->setup_op())
+        return false;
+
+    GuiOp& op = this->op;
+
+    if (!op.width || !op.height)
+        return false;
+
+    if (op.frgd_src == DP_SRC_HOST || op.bkgd_src == DP_SRC_HOST ||
+        op.mono_src == DP_MONO_SRC_HOST) {
+        // wait for the pixels to arrive via HOST_DATA
+        this->host_wait = true;
+        return false;
+    }
+
+    bool is_plain = op.mono_src == DP_MONO_SRC_ONE && op.frgd_mix == DP_MIX_S &&
+                    op.write_mask == op.pix_mask && op.cmp_fcn == CLR_CMP_FALSE;
+
+    if (is_plain && op.frgd_src == DP_SRC_FRGD_CLR) {
+        this->fill_rect(op.frgd_clr);
+    } else if (is_plain && op.frgd_src == DP_SRC_BKGD_CLR) {
+        this->fill_rect(op.bkgd_clr);
+    } else if (is_plain && op.frgd_src == DP_SRC_BLIT && op.src_bpp == op.dst_bpp) {
+        this->copy_rect();
+    } else {
+        for (int row = 0; row < op.height; row++) {
+            int y  = op.y + row * op.y_step;
+            int sy = op.src_y + row * op.y_step;
+            for (int col = 0; col < op.width; col++)
+                this->plot(op.x + col * op.x_step, y, op.src_x + col * op.x_step, sy,
+                           false, 0);
+        }
+    }
+
+    this->finish_rect();
+
+    return true;
+}
+
+void Mach64GuiEngine::finish_rect()
+{
+    GuiOp& op = this->op;
+
+    // the engine leaves DST_Y and SRC_Y pointing to the next row
+    this->regs[ATI_DST_Y] = extract_bits<uint32_t>(op.y + op.height * op.y_step, 0,
+                                                   ATI_DST_Y_size);
+    if (op.frgd_src == DP_SRC_BLIT || op.bkgd_src == DP_SRC_BLIT ||
+        op.mono_src == DP_MONO_SRC_BLIT)
+        this->regs[ATI_SRC_Y] = extract_bits<uint32_t>(op.src_y + op.height * op.y_step, 0, 15);
+}
+
+bool Mach64GuiEngine::clip_rect(int& left, int& top, int& right, int& bottom)
+{
+    GuiOp& op = this->op;
+
+    left   = op.x_step > 0 ? op.x : op.x - op.width + 1;
+    top    = op.y_step > 0 ? op.y : op.y - op.height + 1;
+    right  = left + op.width - 1;
+    bottom = top + op.height - 1;
+
+    left   = std::max(left,   op.sc_left);
+    top    = std::max(top,    op.sc_top);
+    right  = std::min(right,  op.sc_right);
+    bottom = std::min(bottom, op.sc_bottom);
+
+    return left <= right && top <= bottom;
+}
+
+void Mach64GuiEngine::fill_rect(uint32_t color)
+{
+    GuiOp& op = this->op;
+    int left, top, right, bottom;
+
+    if (!this->clip_rect(left, top, right, bottom))
+        return;
+
+    uint32_t row_len = (right - left + 1) * op.dst_bpp;
+    uint32_t row_addr = op.dst_base + top * op.dst_pitch + left * op.dst_bpp;
+
+    // prepare one row in the big-endian VRAM layout and replicate it
+    std::vector<uint8_t> row_buf(row_len);
+    switch (op.dst_bpp) {
+    case 1:
+        std::memset(row_buf.data(), color, row_len);
+        break;
+    case 2:
+        for (uint32_t i = 0; i < row_len; i += 2)
+            WRITE_WORD_BE_A(&row_buf[i], color);
+        break;
+    default:
+        for (uint32_t i = 0; i < row_len; i += 4)
+            WRITE_DWORD_BE_A(&row_buf[i], color);
+    }
+
+    for (int y = top; y <= bottom; y++, row_addr += op.dst_pitch) {
+        if (row_addr + row_len > this->vram_size)
+            break;
+        std::memcpy(&this->vram[row_addr], row_buf.data(), row_len);
+    }
+}
+
+void Mach64GuiEngine::copy_rect()
+{
+    GuiOp& op = this->op;
+    int left, top, right, bottom;
+
+    if (!this->clip_rect(left, top, right, bottom))
+        return;
+
+    // shift the source rectangle by the amount clipped from the destination
+    int src_left = (op.x_step > 0 ? op.src_x : op.src_x - op.width + 1) +
+                   left - (op.x_step > 0 ? op.x : op.x - op.width + 1);
+    int src_top  = (op.y_step > 0 ? op.src_y : op.src_y - op.height + 1) +
+                   top - (op.y_step > 0 ? op.y : op.y - op.height + 1);
+
+    if (src_left < 0 || src_top < 0)
+        return;
+
+    int64_t row_len = (right - left + 1) * op.dst_bpp;
+
+    // process the rows in the direction requested by the driver so
+    // vertically overlapping rectangles are copied correctly,
+    // memmove takes care of horizontal overlaps
+    for (int i = 0; i <= bottom - top; i++) {
+        int row = op.y_step > 0 ? i : bottom - top - i;
+
+        int64_t dst_addr = op.dst_base + (int64_t)(top + row) * op.dst_pitch +
+                           left * op.dst_bpp;
+        int64_t src_addr = op.src_base + (int64_t)(src_top + row) * op.src_pitch +
+                           src_left * op.src_bpp;
+
+        if (dst_addr + row_len > this->vram_size || src_addr + row_len > this->vram_size)
+            continue;
+
+        std::memmove(&this->vram[dst_addr], &this->vram[src_addr], row_len);
+    }
+}
+
+bool Mach64GuiEngine::draw_line()
+{
+    if (!this->setup_op())
+        return false;
+
+    GuiOp& op = this->op;
+
+    if (op.frgd_src == DP_SRC_HOST || op.mono_src == DP_MONO_SRC_HOST) {
+        LOG_F(WARNING, "Mach64 GUI: host data lines not supported");
+        return false;
+    }
+
+    int  length  = extract_bits<uint32_t>(this->regs[ATI_DST_BRES_LNTH],
+                                          ATI_DST_BRES_LNTH_pos, ATI_DST_BRES_LNTH_size);
+    int  err     = sign_extend(this->regs[ATI_DST_BRES_ERR], ATI_DST_BRES_size);
+    int  inc     = sign_extend(this->regs[ATI_DST_BRES_INC], ATI_DST_BRES_size);
+    int  dec     = sign_extend(this->regs[ATI_DST_BRES_DEC], ATI_DST_BRES_size);
+    bool y_major = bit_set(this->regs[ATI_DST_CNTL], ATI_DST_Y_MAJOR);
+
+    int x = op.x, y = op.y;
+
+    for (; length > 0; length--) {
+        this->plot(x, y, x, y, false, 0);
+
+        if (err >= 0) {
+            err += dec;
+            if (y_major)
+                x += op.x_step;
+            else
+                y += op.y_step;
+        } else {
+            err += inc;
+        }
+
+        if (y_major)
+            y += op.y_step;
+        else
+            x += op.x_step;
+    }
+
+    this->regs[ATI_DST_X] = extract_bits<uint32_t>(x, 0, ATI_DST_X_size);
+    this->regs[ATI_DST_Y] = extract_bits<uint32_t>(y, 0, ATI_DST_Y_size);
+    this->regs[ATI_DST_BRES_ERR] = extract_bits<uint32_t>(err, 0, ATI_DST_BRES_size);
+
+    return true;
+}
+
+bool Mach64GuiEngine::host_data(uint32_t value)
+{
+    if (!this->host_wait) {
+        LOG_F(9, "Mach64 GUI: unexpected host data 0x%08X", value);
+        return false;
+    }
+
+    GuiOp& op = this->op;
+
+    // bytes are consumed in the order they appeared in host memory
+    if (op.host_big_endian)
+        value = BYTESWAP_32(value);
+
+    if (op.mono_src == DP_MONO_SRC_HOST) {
+        for (int i = 0; i < 4 && this->host_wait; i++) {
+            uint8_t byte = (value >> (i * 8)) & 0xFFU;
+            for (int bit = 0; bit < 8; bit++) {
+                this->plot_next((byte >> (op.lsb_first ? bit : 7 - bit)) & 1, 0);
+                // byte-aligned rows start with a fresh byte
+                if (!this->host_wait || (op.col == 0 && op.host_byte_align))
+                    break;
+            }
+        }
+    } else {
+        for (int i = 0; i < 4 && this->host_wait; i++) {
+            op.host_acc = (op.host_acc << 8) | ((value >> (i * 8)) & 0xFFU);
+            if (++op.host_acc_bytes == op.host_bpp) {
+                this->plot_next(true, op.host_acc & op.pix_mask);
+                op.host_acc       = 0;
+                op.host_acc_bytes = 0;
+            }
+        }
+    }
+
+    return true;
+}
+
+void Mach64GuiEngine::plot_next(bool mono_host, uint32_t host_clr)
+{
+    GuiOp& op = this->op;
+
+    this->plot(op.x + op.col * op.x_step, op.y + op.row * op.y_step,
+               op.src_x + op.col * op.x_step, op.src_y + op.row * op.y_step,
+               mono_host, host_clr);
+
+    if (++op.col >= op.width) {
+        op.col = 0;
+        if (++op.row >= op.height) {
+            this->host_wait = false;
+            this->finish_rect();
+        }
+    }
+}
+
+void Mach64GuiEngine::plot(int x, int y, int sx, int sy, bool mono_host, uint32_t host_clr)
+{
+    GuiOp& op = this->op;
+
+    if (x < op.sc_left || x > op.sc_right || y < op.sc_top || y > op.sc_bottom)
+        return;
+
+    int64_t addr = op.dst_base + (int64_t)y * op.dst_pitch + x * op.dst_bpp;
+    if (addr < 0 || addr + op.dst_bpp > this->vram_size)
+        return;
+
+    bool mono;
+    switch (op.mono_src) {
+    case DP_MONO_SRC_ONE:
+        mono = true;
+        break;
+    case DP_MONO_SRC_PATTERN:
+        mono = this->pattern_bit(x, y);
+        break;
+    case DP_MONO_SRC_HOST:
+        mono = mono_host;
+        break;
+    default:
+        mono = this->src_mono_bit(sx, sy);
+    }
+
+    uint32_t src;
+    switch (mono ? op.frgd_src : op.bkgd_src) {
+    case DP_SRC_BKGD_CLR:
+        src = op.bkgd_clr;
+        break;
+    case DP_SRC_FRGD_CLR:
+        src = op.frgd_clr;
+        break;
+    case DP_SRC_HOST:
+        src = host_clr;
+        break;
+    case DP_SRC_BLIT:
+        src = this->read_pixel(op.src_base + (int64_t)sy * op.src_pitch + sx * op.src_bpp,
+                               op.src_bpp) & op.pix_mask;
+        break;
+    default: // monochrome pattern
+        src = this->pattern_bit(x, y) ? op.frgd_clr : op.bkgd_clr;
+    }
+
+    uint32_t dst = this->read_pixel(addr, op.dst_bpp);
+
+    if (op.cmp_fcn != CLR_CMP_FALSE) {
+        bool match = ((op.cmp_src ? src : dst) & op.cmp_mask) == op.cmp_clr;
+        if (op.cmp_fcn == CLR_CMP_TRUE || (op.cmp_fcn == CLR_CMP_NEQUAL && !match) ||
+            (op.cmp_fcn == CLR_CMP_EQUAL && match))
+            return;
+    }
+
+    uint32_t res = apply_mix(mono ? op.frgd_mix : op.bkgd_mix, src, dst);
+    res = (dst & ~op.write_mask) | (res & op.write_mask);
+
+    this->write_pixel(addr, res & op.pix_mask, op.dst_bpp);
+}
+
+bool Mach64GuiEngine::pattern_bit(int x, int y)
+{
+    // 8x8 monochrome pattern, rows 0-3 in PAT_REG0, rows 4-7 in PAT_REG1
+    uint32_t pat_reg = this->regs[(y & 4) ? ATI_PAT_REG1 : ATI_PAT_REG0];
+    uint8_t  pat_row = (pat_reg >> ((y & 3) * 8)) & 0xFFU;
+    return (pat_row >> (this->op.lsb_first ? (x & 7) : 7 - (x & 7))) & 1;
+}
+
+bool Mach64GuiEngine::src_mono_bit(int sx, int sy)
+{
+    // monochrome sources are bit arrays, their pitch is in pixels (= bits)
+    int64_t bit_pos = (int64_t)this->op.src_base * 8 + (int64_t)sy * this->op.src_pitch + sx;
+    if (bit_pos < 0 || (bit_pos >> 3) >= this->vram_size)
+        return false;
+
+    uint8_t byte = this->vram[bit_pos >> 3];
+    return (byte >> (this->op.lsb_first ? (bit_pos & 7) : 7 - (bit_pos & 7))) & 1;
+}
+
+uint32_t Mach64GuiEngine::read_pixel(uint32_t addr, int bpp)
+{
+    if ((uint64_t)addr + bpp > this->vram_size)
+        return 0;
+
+    switch (bpp) {
+    case 1:
+        return this->vram[addr];
+    case 2:
+        return READ_WORD_BE_U(&this->vram[addr]);
+    default:
+        return READ_DWORD_BE_U(&this->vram[addr]);
+    }
+}
+
+void Mach64GuiEngine::write_pixel(uint32_t addr, uint32_t pix, int bpp)
+{
+    switch (bpp) {
+    case 1:
+        this->vram[addr] = pix;
+        break;
+    case 2:
+        WRITE_WORD_BE_U(&this->vram[addr], pix);
+        break;
+    default:
+        WRITE_DWORD_BE_U(&this->vram[addr], pix);
+    }
+}
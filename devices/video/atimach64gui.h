@@ -0,0 +1,153 @@
+/*
+DingusPPC - The Experimental PowerPC Macintosh emulator
+Copyright (C) 2018-25 divingkatae and maximum
+                      (theweirdo)     spatium
+
+(Contact divingkatae#1017 or powermax#2286 on Discord for more info)
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+/** @file Mach64 2D GUI drawing engine.
+
+    The engine operates on the register file and video memory of its host
+    controller. Drawing operations are executed synchronously when their
+    trigger register is written so the command FIFO never fills up.
+    Operations fed by the host via HOST_DATA keep the engine busy until
+    all their pixels have been supplied.
+ */
+
+#ifndef ATI_MACH64_GUI_H
+#define ATI_MACH64_GUI_H
+
+#include <cinttypes>
+
+/* DP_SRC values. */
+enum {
+    DP_SRC_BKGD_CLR = 0,
+    DP_SRC_FRGD_CLR = 1,
+    DP_SRC_HOST     = 2,
+    DP_SRC_BLIT     = 3,
+    DP_SRC_PATTERN  = 4,
+};
+
+/* DP_MONO_SRC values. */
+enum {
+    DP_MONO_SRC_ONE     = 0,
+    DP_MONO_SRC_PATTERN = 1,
+    DP_MONO_SRC_HOST    = 2,
+    DP_MONO_SRC_BLIT    = 3,
+};
+
+/* DP_MIX functions, D = destination, S = source. */
+enum {
+    DP_MIX_NOT_D        = 0x0,
+    DP_MIX_ZERO         = 0x1,
+    DP_MIX_ONE          = 0x2,
+    DP_MIX_D            = 0x3,
+    DP_MIX_NOT_S        = 0x4,
+    DP_MIX_D_XOR_S      = 0x5,
+    DP_MIX_D_XNOR_S     = 0x6,
+    DP_MIX_S            = 0x7,
+    DP_MIX_NOT_D_OR_NOT_S = 0x8,
+    DP_MIX_D_OR_NOT_S   = 0x9,
+    DP_MIX_NOT_D_OR_S   = 0xA,
+    DP_MIX_D_OR_S       = 0xB,
+    DP_MIX_D_AND_S      = 0xC,
+    DP_MIX_NOT_D_AND_S  = 0xD,
+    DP_MIX_D_AND_NOT_S  = 0xE,
+    DP_MIX_NOT_D_AND_NOT_S = 0xF,
+};
+
+/* CLR_CMP_FCN values. */
+enum {
+    CLR_CMP_FALSE   = 0, // always draw
+    CLR_CMP_TRUE    = 1, // never draw
+    CLR_CMP_NEQUAL  = 4, // don't draw pixels not matching CLR_CMP_CLR
+    CLR_CMP_EQUAL   = 5, // don't draw pixels matching CLR_CMP_CLR
+};
+
+class Mach64GuiEngine {
+public:
+    Mach64GuiEngine(uint32_t* regs, uint8_t* vram, uint32_t vram_size);
+    ~Mach64GuiEngine() = default;
+
+    // abort any operation in progress
+    void reset();
+
+    // process a register write after its value has been stored,
+    // returns true if video memory has been modified
+    bool write_reg(uint32_t reg_num, uint32_t value);
+
+    // a host data transfer is in progress
+    bool is_active() const { return this->host_wait; }
+
+private:
+    struct GuiOp {
+        int         x, y;           // first destination pixel
+        int         x_step, y_step;
+        int         src_x, src_y;   // first source pixel
+        int         width, height;
+        int         col, row;       // current position for host transfers
+
+        int         dst_bpp, src_bpp, host_bpp; // bytes per pixel
+        uint32_t    dst_base, dst_pitch;        // in bytes
+        uint32_t    src_base, src_pitch;
+        uint32_t    pix_mask;
+
+        int         frgd_src, bkgd_src, mono_src;
+        int         frgd_mix, bkgd_mix;
+        uint32_t    frgd_clr, bkgd_clr;
+        uint32_t    write_mask;
+        bool        lsb_first;      // bit order of monochrome data
+
+        int         sc_left, sc_right, sc_top, sc_bottom;
+
+        int         cmp_fcn;
+        bool        cmp_src;        // compare source instead of destination
+        uint32_t    cmp_clr, cmp_mask;
+
+        bool        host_byte_align;
+        bool        host_big_endian;
+        uint32_t    host_acc;       // partially received host pixel
+        int         host_acc_bytes;
+    };
+
+    bool setup_op();
+    bool draw_rect();
+    bool draw_line();
+    bool host_data(uint32_t value);
+    void finish_rect();
+
+    void fill_rect(uint32_t color);
+    void copy_rect();
+    bool clip_rect(int& left, int& top, int& right, int& bottom);
+
+    void plot(int x, int y, int sx, int sy, bool mono_host, uint32_t host_clr);
+    void plot_next(bool mono_host, uint32_t host_clr);
+
+    bool     pattern_bit(int x, int y);
+    bool     src_mono_bit(int sx, int sy);
+    uint32_t read_pixel(uint32_t addr, int bpp);
+    void     write_pixel(uint32_t addr, uint32_t pix, int bpp);
+
+    uint32_t*   regs;
+    uint8_t*    vram;
+    uint32_t    vram_size;
+
+    GuiOp       op = {};
+    bool        host_wait = false;
+};
+
+#endif // ATI_MACH64_GUI_H
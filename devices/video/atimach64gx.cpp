@@ -274,6 +274,15 @@ bool AtiMach64Gx::io_access_allowed(uint32_t offset) {
     return false;
 }
 
+void AtiMach64Gx::set_host(PCIHost* host_instance)
+{
+    PCIDevice::set_host(host_instance);
+
+    // registers are decoded at ISA-style sparse addresses instead of a BAR
+    for (uint32_t idx = 0; idx < 64; idx++)
+        host_instance->pci_register_io_region(SPARSE_IO_BASE + (idx << 10), 4, this);
+}
+
 bool AtiMach64Gx::pci_io_read(uint32_t offset, uint32_t size, uint32_t* res)
 {
     if (!this->io_access_allowed(offset)) {
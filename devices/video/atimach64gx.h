@@ -35,7 +35,7 @@ along with this program.  If not, see <https://www.gnu.org/licenses/>.
 class AtiMach64Gx : public PCIDevice, public VideoCtrlBase {
 public:
     AtiMach64Gx();
-    ~AtiMach64Gx() = default;
+    ~AtiMach64Gx() { this->stop_refresh_task(); };
 
     static std::unique_ptr<HWComponent> create() {
         return std::unique_ptr<AtiMach64Gx>(new AtiMach64Gx());
@@ -46,6 +46,8 @@ public:
         return true;
     };
 
+    void set_host(PCIHost* host_instance);
+
     // I/O space access methods
     bool pci_io_read(uint32_t offset, uint32_t size, uint32_t* res);
     bool pci_io_write(uint32_t offset, uint32_t value, uint32_t size);
@@ -76,7 +76,46 @@ static const std::map<uint16_t, std::string> mach64_reg_names = {
     one_reg_name(CUSTOM_MACRO_CNTL),
     one_reg_name(CONFIG_CHIP_ID),
     one_reg_name(CONFIG_STAT0),
+    one_reg_name(DST_OFF_PITCH),
+    one_reg_name(DST_X),
+    one_reg_name(DST_Y),
+    one_reg_name(DST_Y_X),
+    one_reg_name(DST_WIDTH),
+    one_reg_name(DST_HEIGHT),
+    one_reg_name(DST_HEIGHT_WIDTH),
+    one_reg_name(DST_BRES_LNTH),
+    one_reg_name(DST_BRES_ERR),
+    one_reg_name(DST_BRES_INC),
+    one_reg_name(DST_BRES_DEC),
+    one_reg_name(DST_CNTL),
+    one_reg_name(SRC_OFF_PITCH),
+    one_reg_name(SRC_X),
+    one_reg_name(SRC_Y),
+    one_reg_name(SRC_Y_X),
+    one_reg_name(SRC_HEIGHT1_WIDTH1),
     one_reg_name(SRC_CNTL),
+    one_reg_name(HOST_CNTL),
+    one_reg_name(PAT_REG0),
+    one_reg_name(PAT_REG1),
+    one_reg_name(PAT_CNTL),
+    one_reg_name(SC_LEFT),
+    one_reg_name(SC_RIGHT),
+    one_reg_name(SC_LEFT_RIGHT),
+    one_reg_name(SC_TOP),
+    one_reg_name(SC_BOTTOM),
+    one_reg_name(SC_TOP_BOTTOM),
+    one_reg_name(DP_BKGD_CLR),
+    one_reg_name(DP_FRGD_CLR),
+    one_reg_name(DP_WRITE_MSK),
+    one_reg_name(DP_PIX_WIDTH),
+    one_reg_name(DP_MIX),
+    one_reg_name(DP_SRC),
+    one_reg_name(DST_X_Y),
+    one_reg_name(DST_WIDTH_HEIGHT),
+    one_reg_name(CLR_CMP_CLR),
+    one_reg_name(CLR_CMP_MSK),
+    one_reg_name(CLR_CMP_CNTL),
+    one_reg_name(GUI_TRAJ_CNTL),
     one_reg_name(SCALE_3D_CNTL),
     one_reg_name(FIFO_STAT),
     one_reg_name(GUI_STAT),
@@ -100,6 +139,9 @@ ATIRage::ATIRage(uint16_t dev_id)
     // allocate video RAM
     this->vram_ptr = std::unique_ptr<uint8_t[]> (new uint8_t[this->vram_size]);
 
+    this->gui_engine = std::unique_ptr<Mach64GuiEngine> (
+        new Mach64GuiEngine(this->regs, this->vram_ptr.get(), this->vram_size));
+
     // ATI Rage driver needs to know ASIC ID (manufacturer's internal chip code)
     // to operate properly
     switch (dev_id) {
@@ -263,7 +305,8 @@ uint32_t ATIRage::read_reg(uint32_t reg_offset, uint32_t size) {
         }
         break;
     case ATI_GUI_STAT:
-        result = this->cmd_fifo_size << 16; // HACK: tell the guest the command FIFO is empty
+        // drawing commands complete immediately so the command FIFO is always empty
+        result = (this->cmd_fifo_size << 16) | (this->gui_engine->is_active() << ATI_GUI_ACTIVE);
         break;
     }
 
@@ -505,8 +548,10 @@ void ATIRage::write_reg(uint32_t reg_offset, uint32_t value, uint32_t size) {
             draw_fb = true;
         }
         if (bit_changed(old_value, new_value, ATI_GEN_GUI_RESETB)) {
-            if (!bit_set(new_value, ATI_GEN_GUI_RESETB))
+            if (!bit_set(new_value, ATI_GEN_GUI_RESETB)) {
                 LOG_F(9, "%s: reset GUI engine", this->name.c_str());
+                this->gui_engine->reset();
+            }
         }
         if (bit_changed(old_value, new_value, ATI_GEN_SOFT_RESET)) {
             if (bit_set(new_value, ATI_GEN_SOFT_RESET))
@@ -540,6 +585,10 @@ void ATIRage::write_reg(uint32_t reg_offset, uint32_t value, uint32_t size) {
     }
 
     WRITE_VALUE_AND_LOG(9);
+
+    // let the drawing engine process its composite and trigger registers
+    if (this->gui_engine->write_reg(reg_num, new_value))
+        draw_fb = true;
 }
 
 bool ATIRage::io_access_allowed(uint32_t offset) {
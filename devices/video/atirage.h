@@ -24,6 +24,7 @@ along with this program.  If not, see <https://www.gnu.org/licenses/>.
 
 #include <devices/common/pci/pcidevice.h>
 #include <devices/video/atimach64defs.h>
+#include <devices/video/atimach64gui.h>
 #include <devices/video/displayid.h>
 #include <devices/video/videoctrl.h>
 
@@ -45,7 +46,7 @@ enum {
 class ATIRage : public PCIDevice, public VideoCtrlBase {
 public:
     ATIRage(uint16_t dev_id);
-    ~ATIRage() = default;
+    ~ATIRage() { this->stop_refresh_task(); };
 
     static std::unique_ptr<HWComponent> create_gt() {
         return std::unique_ptr<ATIRage>(new ATIRage(ATI_RAGE_GT_DEV_ID));
@@ -108,6 +109,8 @@ private:
 
     std::unique_ptr<DisplayID>  disp_id;
 
+    std::unique_ptr<Mach64GuiEngine>    gui_engine;
+
     // DAC interface state
     uint8_t     dac_wr_index = 0;  // current DAC color index for writing
     uint8_t     dac_rd_index = 0;  // current DAC color index for reading
@@ -122,9 +122,8 @@ ControlVideo::ControlVideo()
     this->radacal->cursor_ctrl_cb = [this](bool cursor_on) {
         if (cursor_on) {
             this->radacal->measure_hw_cursor(this->fb_ptr - 16);
-            this->cursor_ovl_cb = [this](uint8_t *dst_buf, int dst_pitch) {
-                this->radacal->draw_hw_cursor(this->fb_ptr - 16,
-                    dst_buf, dst_pitch);
+            this->cursor_ovl_cb = [this]() {
+                return this->radacal->capture_hw_cursor(this->fb_ptr - 16);
             };
         } else {
             this->cursor_ovl_cb = nullptr;
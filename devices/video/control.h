@@ -112,7 +112,7 @@ enum {
 class ControlVideo : public PCIDevice, public VideoCtrlBase {
 public:
     ControlVideo();
-    ~ControlVideo() = default;
+    ~ControlVideo() { this->stop_refresh_task(); };
 
     static std::unique_ptr<HWComponent> create() {
         return std::unique_ptr<ControlVideo>(new ControlVideo());
@@ -29,6 +29,9 @@ along with this program.  If not, see <https://www.gnu.org/licenses/>.
 #include <functional>
 #include <memory>
 
+/** Set from the command line to run without showing the display window. */
+extern bool is_headless;
+
 class Display {
 public:
     Display();
@@ -45,16 +48,28 @@ public:
     // Update the host framebuffer display. If the display adapter does its own
     // dirty tracking, fb_known_to_be_changed will be set to true, so that the
     // implementation can take that into account.
+    // Returns right away, both callbacks are invoked later on the host thread
+    // and must not touch emulator state other than the guest framebuffer.
     void update(std::function<void(uint8_t *dst_buf, int dst_pitch)> convert_fb_cb,
                 std::function<void(uint8_t *dst_buf, int dst_pitch)> cursor_ovl_cb,
                 bool draw_hw_cursor, int cursor_x, int cursor_y,
                 bool fb_known_to_be_changed);
 
+    // Returns true while the last update() hasn't been presented yet.
+    bool is_busy();
+
+    // Waits until the last update() has been presented.
+    void wait_idle();
+
     // Called in cases where the framebuffer contents have not changed, so a
     // normal update() call is not happening. Allows implementations that need
     // to do per-frame bookkeeping to still do that.
     void update_skipped();
 
+    // Returns false if presented frames can't be seen because the display
+    // is hidden, minimized or we're running headless.
+    bool is_visible();
+
     void handle_events(const WindowEvent& wnd_event);
     void setup_hw_cursor(std::function<void(uint8_t *dst_buf, int dst_pitch)> draw_hw_cursor,
                          int cursor_width, int cursor_height);
@@ -23,6 +23,13 @@ along with this program.  If not, see <https://www.gnu.org/licenses/>.
 #include <SDL.h>
 #include <loguru.hpp>
 
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+
+bool is_headless = false;
+
+// All SDL calls below run on the host thread, see EventManager::post_host_task.
 class Display::Impl {
 public:
     bool            resizing = false;
@@ -34,160 +41,225 @@ public:
     SDL_Texture*    disp_texture = 0;
     SDL_Texture*    cursor_texture = 0;
     SDL_Rect        cursor_rect; // destination rectangle for cursor drawing
-};
 
-Display::Display(): impl(std::make_unique<Impl>()) {
-    SDL_SetHint(SDL_HINT_RENDER_SCALE_QUALITY, "nearest");
-}
+    std::atomic<bool> visible{false}; // read by the emulator thread
 
-Display::~Display() {
-    if (impl->cursor_texture)
-        SDL_DestroyTexture(impl->cursor_texture);
+    // an update is waiting for the host thread
+    std::atomic<bool>       busy{false};
+    std::mutex              idle_mtx;
+    std::condition_variable idle_cv;
 
-    if (impl->disp_texture)
-        SDL_DestroyTexture(impl->disp_texture);
+    ~Impl();
 
-    if (impl->renderer)
-        SDL_DestroyRenderer(impl->renderer);
+    bool configure(int width, int height);
+    void update_visibility();
+};
+
+Display::Impl::~Impl() {
+    if (this->cursor_texture)
+        SDL_DestroyTexture(this->cursor_texture);
+
+    if (this->disp_texture)
+        SDL_DestroyTexture(this->disp_texture);
 
-    if (impl->display_wnd)
-        SDL_DestroyWindow(impl->display_wnd);
+    if (this->renderer)
+        SDL_DestroyRenderer(this->renderer);
+
+    if (this->display_wnd)
+        SDL_DestroyWindow(this->display_wnd);
 }
 
-bool Display::configure(int width, int height) {
+bool Display::Impl::configure(int width, int height) {
     bool is_initialization = false;
 
-    if (!impl->display_wnd) { // create display window
-        impl->display_wnd = SDL_CreateWindow(
+    if (!this->display_wnd) { // create display window
+        this->display_wnd = SDL_CreateWindow(
             SDL_GetRelativeMouseMode() ?
                 "DingusPPC Display (Mouse Grabbed)" : "DingusPPC Display",
             SDL_WINDOWPOS_UNDEFINED,
             SDL_WINDOWPOS_UNDEFINED,
             width, height,
-            SDL_WINDOW_OPENGL | SDL_WINDOW_ALLOW_HIGHDPI
+            SDL_WINDOW_OPENGL | SDL_WINDOW_ALLOW_HIGHDPI |
+                (is_headless ? SDL_WINDOW_HIDDEN : 0)
         );
 
-        impl->disp_wnd_id = SDL_GetWindowID(impl->display_wnd);
-        if (impl->display_wnd == NULL)
+        this->disp_wnd_id = SDL_GetWindowID(this->display_wnd);
+        if (this->display_wnd == NULL)
             ABORT_F("Display: SDL_CreateWindow failed with %s", SDL_GetError());
 
-        impl->renderer = SDL_CreateRenderer(impl->display_wnd, -1, SDL_RENDERER_ACCELERATED);
-        if (impl->renderer == NULL)
+        this->renderer = SDL_CreateRenderer(this->display_wnd, -1, SDL_RENDERER_ACCELERATED);
+        if (this->renderer == NULL)
             ABORT_F("Display: SDL_CreateRenderer failed with %s", SDL_GetError());
 
         int drawable_width, drawable_height;
-        SDL_GetRendererOutputSize(impl->renderer, &drawable_width, &drawable_height);
-        impl->renderer_scale_x = static_cast<double>(drawable_width) / width;
-        impl->renderer_scale_y = static_cast<float>(drawable_height) / height;
+        SDL_GetRendererOutputSize(this->renderer, &drawable_width, &drawable_height);
+        this->renderer_scale_x = static_cast<double>(drawable_width) / width;
+        this->renderer_scale_y = static_cast<float>(drawable_height) / height;
 
         is_initialization = true;
     } else { // resize display window
-        SDL_SetWindowSize(impl->display_wnd, width, height);
+        SDL_SetWindowSize(this->display_wnd, width, height);
     }
 
-    if (impl->disp_texture)
-        SDL_DestroyTexture(impl->disp_texture);
+    if (this->disp_texture)
+        SDL_DestroyTexture(this->disp_texture);
 
-    impl->disp_texture = SDL_CreateTexture(
-        impl->renderer,
+    this->disp_texture = SDL_CreateTexture(
+        this->renderer,
         SDL_PIXELFORMAT_ARGB8888,
         SDL_TEXTUREACCESS_STREAMING,
         width, height
     );
 
-    if (impl->disp_texture == NULL)
+    if (this->disp_texture == NULL)
         ABORT_F("Display: SDL_CreateTexture failed with %s", SDL_GetError());
 
+    this->update_visibility();
+
+    return is_initialization;
+}
+
+void Display::Impl::update_visibility() {
+    this->visible = !is_headless && this->display_wnd &&
+        !(SDL_GetWindowFlags(this->display_wnd) & (SDL_WINDOW_HIDDEN | SDL_WINDOW_MINIMIZED));
+}
+
+Display::Display(): impl(std::make_unique<Impl>()) {
+    EventManager::get_instance()->post_host_task([] {
+        SDL_SetHint(SDL_HINT_RENDER_SCALE_QUALITY, "nearest");
+    });
+}
+
+Display::~Display() {
+    EventManager::get_instance()->run_host_task([this] {
+        impl.reset();
+    });
+}
+
+bool Display::configure(int width, int height) {
+    bool is_initialization = false;
+
+    EventManager::get_instance()->run_host_task([&] {
+        is_initialization = impl->configure(width, height);
+    });
+
     return is_initialization;
 }
 
+// Called on the host thread.
 void Display::handle_events(const WindowEvent& wnd_event) {
-    if (wnd_event.sub_type == SDL_WINDOWEVENT_SIZE_CHANGED &&
-        wnd_event.window_id == impl->disp_wnd_id)
+    if (wnd_event.window_id != impl->disp_wnd_id)
+        return;
+
+    if (wnd_event.sub_type == SDL_WINDOWEVENT_SIZE_CHANGED)
         impl->resizing = false;
-    if (wnd_event.sub_type == SDL_WINDOWEVENT_EXPOSED &&
-        wnd_event.window_id == impl->disp_wnd_id)
+    if (wnd_event.sub_type == SDL_WINDOWEVENT_EXPOSED)
         SDL_RenderPresent(impl->renderer);
-    if (wnd_event.sub_type == WINDOW_SCALE_QUALITY_TOGGLE &&
-        wnd_event.window_id == impl->disp_wnd_id) {
+    if (wnd_event.sub_type == WINDOW_SCALE_QUALITY_TOGGLE) {
         auto current_quality = SDL_GetHint(SDL_HINT_RENDER_SCALE_QUALITY);
         auto new_quality = current_quality == NULL || strcmp(current_quality, "nearest") == 0 ? "best" : "nearest";
         SDL_SetHint(SDL_HINT_RENDER_SCALE_QUALITY, new_quality);
         // We need the window/texture to be recreated to pick up the hint change.
         int width, height;
         SDL_GetWindowSize(impl->display_wnd, &width, &height);
-        this->configure(width, height);
+        impl->configure(width, height);
     }
+
+    impl->update_visibility();
 }
 
 void Display::blank() {
-    SDL_SetRenderDrawColor(impl->renderer, 0, 0, 0, 255);
-    SDL_RenderClear(impl->renderer);
-    SDL_RenderPresent(impl->renderer);
+    EventManager::get_instance()->post_host_task([this] {
+        SDL_SetRenderDrawColor(impl->renderer, 0, 0, 0, 255);
+        SDL_RenderClear(impl->renderer);
+        SDL_RenderPresent(impl->renderer);
+    });
 }
 
 void Display::update(std::function<void(uint8_t *dst_buf, int dst_pitch)> convert_fb_cb,
                      std::function<void(uint8_t *dst_buf, int dst_pitch)> cursor_ovl_cb,
                      bool draw_hw_cursor, int cursor_x, int cursor_y,
                      bool fb_known_to_be_changed) {
-    if (impl->resizing)
-        return;
+    impl->busy = true;
 
-    uint8_t*    dst_buf;
-    int         dst_pitch;
+    EventManager::get_instance()->post_host_task([=, this] {
+        if (!impl->resizing && impl->disp_texture) {
+            uint8_t*    dst_buf;
+            int         dst_pitch;
 
-    SDL_LockTexture(impl->disp_texture, NULL, (void **)&dst_buf, &dst_pitch);
+            SDL_LockTexture(impl->disp_texture, NULL, (void **)&dst_buf, &dst_pitch);
 
-    // texture update callback to get ARGB data from guest framebuffer
-    convert_fb_cb(dst_buf, dst_pitch);
+            // texture update callback to get ARGB data from guest framebuffer
+            convert_fb_cb(dst_buf, dst_pitch);
 
-    // overlay cursor data if requested
-    if (cursor_ovl_cb != nullptr)
-        cursor_ovl_cb(dst_buf, dst_pitch);
+            // overlay cursor data if requested
+            if (cursor_ovl_cb != nullptr)
+                cursor_ovl_cb(dst_buf, dst_pitch);
 
-    SDL_UnlockTexture(impl->disp_texture);
-    SDL_RenderClear(impl->renderer);
-    SDL_RenderCopy(impl->renderer, impl->disp_texture, NULL, NULL);
+            SDL_UnlockTexture(impl->disp_texture);
+            SDL_RenderClear(impl->renderer);
+            SDL_RenderCopy(impl->renderer, impl->disp_texture, NULL, NULL);
 
-    // draw HW cursor if enabled
-    if (draw_hw_cursor) {
-        impl->cursor_rect.x = cursor_x * impl->renderer_scale_x;
-        impl->cursor_rect.y = cursor_y * impl->renderer_scale_y;
-        SDL_RenderCopy(impl->renderer, impl->cursor_texture, NULL, &impl->cursor_rect);
-    }
+            // draw HW cursor if enabled
+            if (draw_hw_cursor) {
+                impl->cursor_rect.x = cursor_x * impl->renderer_scale_x;
+                impl->cursor_rect.y = cursor_y * impl->renderer_scale_y;
+                SDL_RenderCopy(impl->renderer, impl->cursor_texture, NULL, &impl->cursor_rect);
+            }
+
+            SDL_RenderPresent(impl->renderer);
+        }
 
-    SDL_RenderPresent(impl->renderer);
+        std::lock_guard<std::mutex> lk(impl->idle_mtx);
+        impl->busy = false;
+        impl->idle_cv.notify_all();
+    });
+}
+
+bool Display::is_busy() {
+    return impl->busy;
+}
+
+void Display::wait_idle() {
+    std::unique_lock<std::mutex> lk(impl->idle_mtx);
+    impl->idle_cv.wait(lk, [this] { return !impl->busy; });
 }
 
 void Display::update_skipped() {
     // SDL implementation does not care about skipped updates.
 }
 
+bool Display::is_visible() {
+    return impl->visible;
+}
+
 void Display::setup_hw_cursor(std::function<void(uint8_t *dst_buf, int dst_pitch)> draw_hw_cursor,
                               int cursor_width, int cursor_height) {
-    uint8_t*    dst_buf;
-    int         dst_pitch;
-
-    if (impl->cursor_texture)
-        SDL_DestroyTexture(impl->cursor_texture);
-
-    impl->cursor_texture = SDL_CreateTexture(
-        impl->renderer,
-        SDL_PIXELFORMAT_ARGB8888,
-        SDL_TEXTUREACCESS_STREAMING,
-        cursor_width, cursor_height
-    );
+    EventManager::get_instance()->run_host_task([&] {
+        uint8_t*    dst_buf;
+        int         dst_pitch;
+
+        if (impl->cursor_texture)
+            SDL_DestroyTexture(impl->cursor_texture);
+
+        impl->cursor_texture = SDL_CreateTexture(
+            impl->renderer,
+            SDL_PIXELFORMAT_ARGB8888,
+            SDL_TEXTUREACCESS_STREAMING,
+            cursor_width, cursor_height
+        );
 
-    if (impl->cursor_texture == NULL)
-        ABORT_F("SDL_CreateTexture for HW cursor failed with %s", SDL_GetError());
+        if (impl->cursor_texture == NULL)
+            ABORT_F("SDL_CreateTexture for HW cursor failed with %s", SDL_GetError());
 
-    SDL_LockTexture(impl->cursor_texture, NULL, (void **)&dst_buf, &dst_pitch);
-    SDL_SetTextureBlendMode(impl->cursor_texture, SDL_BLENDMODE_BLEND);
-    draw_hw_cursor(dst_buf, dst_pitch);
-    SDL_UnlockTexture(impl->cursor_texture);
+        SDL_LockTexture(impl->cursor_texture, NULL, (void **)&dst_buf, &dst_pitch);
+        SDL_SetTextureBlendMode(impl->cursor_texture, SDL_BLENDMODE_BLEND);
+        draw_hw_cursor(dst_buf, dst_pitch);
+        SDL_UnlockTexture(impl->cursor_texture);
 
-    impl->cursor_rect.x = 0;
-    impl->cursor_rect.y = 0;
-    impl->cursor_rect.w = cursor_width * impl->renderer_scale_x;
-    impl->cursor_rect.h = cursor_height * impl->renderer_scale_y;
+        impl->cursor_rect.x = 0;
+        impl->cursor_rect.y = 0;
+        impl->cursor_rect.w = cursor_width * impl->renderer_scale_x;
+        impl->cursor_rect.h = cursor_height * impl->renderer_scale_y;
+    });
 }
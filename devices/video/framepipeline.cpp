@@ -0,0 +1,134 @@
+/*
+DingusPPC - The Experimental PowerPC Macintosh emulator
+Copyright (C) 2018-25 divingkatae and maximum
+                      (theweirdo)     spatium
+
+(Contact divingkatae#1017 or powermax#2286 on Discord for more info)
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+/** @file Host side framebuffer conversion. */
+
+#include <devices/video/framepipeline.h>
+
+#include <algorithm>
+
+// upper limit for the number of render threads
+constexpr unsigned MAX_RENDER_THREADS = 4;
+
+FramePipeline* FramePipeline::frame_pipeline;
+
+FramePipeline::~FramePipeline()
+{
+    {
+        std::lock_guard<std::mutex> lk(this->job_mtx);
+        this->quit = true;
+    }
+    this->job_cv.notify_all();
+
+    for (auto& th : this->workers)
+        th.join();
+}
+
+void FramePipeline::start_workers()
+{
+    // leave at least one core to the emulated CPU, the host thread
+    // converts a band of its own
+    unsigned num_threads = std::thread::hardware_concurrency();
+    num_threads = std::clamp(num_threads > 2 ? num_threads - 2 : 0, 0U, MAX_RENDER_THREADS);
+
+    for (unsigned band = 1; band <= num_threads; band++)
+        this->workers.emplace_back(&FramePipeline::worker_main, this, (int)band);
+
+    this->num_bands = (int)this->workers.size() + 1;
+    this->workers_started = true;
+}
+
+void FramePipeline::convert(const FrameDesc& desc, uint8_t* dst_buf, int dst_pitch)
+{
+    this->job       = &desc;
+    this->job_dst   = dst_buf;
+    this->job_pitch = dst_pitch;
+
+    // 32bpp conversion is bound by memory bandwidth, splitting it gains nothing
+    if (desc.format == PixelConv::ARGB8888 || desc.format == PixelConv::ARGB8888_BE) {
+        this->convert_band(0, 1);
+        return;
+    }
+
+    if (!this->workers_started)
+        this->start_workers();
+
+    if (this->num_bands > 1) {
+        {
+            std::lock_guard<std::mutex> lk(this->job_mtx);
+            this->bands_left = this->num_bands - 1;
+            this->generation++;
+        }
+        this->job_cv.notify_all();
+    }
+
+    this->convert_band(0, this->num_bands);
+
+    if (this->num_bands > 1) {
+        std::unique_lock<std::mutex> lk(this->job_mtx);
+        this->done_cv.wait(lk, [this] { return !this->bands_left; });
+    }
+}
+
+void FramePipeline::convert_band(int band, int num_bands)
+{
+    const FrameDesc& desc = *this->job;
+
+    int first_row = desc.height * band / num_bands;
+    int last_row  = desc.height * (band + 1) / num_bands;
+
+    PixelConv::row_conv_fn conv_row = PixelConv::get_converter(desc.format);
+
+    // the guest may be writing to the framebuffer at the same time,
+    // this results in tearing just like on real hardware
+    const uint8_t* src_row = desc.fb_ptr + first_row * desc.fb_pitch;
+    uint8_t*       dst_row = this->job_dst + first_row * this->job_pitch;
+
+    for (int row = first_row; row < last_row; row++) {
+        conv_row(src_row, dst_row, desc.width, desc.palette);
+        src_row += desc.fb_pitch;
+        dst_row += this->job_pitch;
+    }
+}
+
+void FramePipeline::worker_main(int band)
+{
+    uint64_t last_gen = 0;
+
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lk(this->job_mtx);
+            this->job_cv.wait(lk, [&] { return this->quit || this->generation != last_gen; });
+            if (this->quit)
+                return;
+            last_gen = this->generation;
+        }
+
+        this->convert_band(band, this->num_bands);
+
+        {
+            std::lock_guard<std::mutex> lk(this->job_mtx);
+            if (--this->bands_left)
+                continue;
+        }
+        this->done_cv.notify_one();
+    }
+}
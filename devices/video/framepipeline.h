@@ -0,0 +1,98 @@
+/*
+DingusPPC - The Experimental PowerPC Macintosh emulator
+Copyright (C) 2018-25 divingkatae and maximum
+                      (theweirdo)     spatium
+
+(Contact divingkatae#1017 or powermax#2286 on Discord for more info)
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+/** @file Host side framebuffer conversion.
+
+    At vertical blank, the video controller captures a frame descriptor
+    holding everything needed to convert the guest framebuffer and hands it
+    over to the host thread. There it's converted straight into the display
+    texture. Formats that are expensive to convert are split into horizontal
+    bands processed by a small pool of render threads together with the host
+    thread. The pool is shared by all displays and only started once a frame
+    needs it, so hidden displays and 32bpp modes never create any threads.
+ */
+
+#ifndef FRAME_PIPELINE_H
+#define FRAME_PIPELINE_H
+
+#include <devices/video/pixelconv.h>
+
+#include <cinttypes>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+struct FrameDesc {
+    const uint8_t*      fb_ptr;
+    int                 fb_pitch;
+    int                 width;      // pixels to convert per row
+    int                 height;
+    PixelConv::Format   format;
+    uint32_t            palette[256]; // snapshot for indexed formats
+};
+
+class FramePipeline {
+public:
+    static FramePipeline* get_instance() {
+        if (!frame_pipeline) {
+            frame_pipeline = new FramePipeline();
+        }
+        return frame_pipeline;
+    };
+
+    // stop the render threads
+    static void shutdown() {
+        delete frame_pipeline;
+        frame_pipeline = nullptr;
+    };
+
+    ~FramePipeline();
+
+    // convert a frame into dst_buf, returns once all rows are done
+    void convert(const FrameDesc& desc, uint8_t* dst_buf, int dst_pitch);
+
+private:
+    static FramePipeline* frame_pipeline;
+    FramePipeline() {}; // private constructor to implement a singleton
+
+    void start_workers();
+    void worker_main(int band);
+    void convert_band(int band, int num_bands);
+
+    // job in progress, valid until all bands are done
+    const FrameDesc*    job       = nullptr;
+    uint8_t*            job_dst   = nullptr;
+    int                 job_pitch = 0;
+    int                 num_bands = 1; // render threads + host thread
+    int                 bands_left = 0;
+    bool                workers_started = false;
+
+    std::mutex              job_mtx;
+    std::condition_variable job_cv;
+    std::condition_variable done_cv;
+    uint64_t                generation = 0;
+    bool                    quit = false;
+
+    std::vector<std::thread> workers;
+};
+
+#endif // FRAME_PIPELINE_H
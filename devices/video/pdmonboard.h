@@ -48,7 +48,7 @@ enum PdmVideoMode : uint8_t {
 class PdmOnboardVideo : public VideoCtrlBase {
 public:
     PdmOnboardVideo();
-    ~PdmOnboardVideo() = default;
+    ~PdmOnboardVideo() { this->stop_refresh_task(); };
 
     uint8_t get_video_mode() const {
         return ((this->video_mode & 0x1F) | this->blanking);
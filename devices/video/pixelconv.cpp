@@ -0,0 +1,257 @@
+/*
+DingusPPC - The Experimental PowerPC Macintosh emulator
+Copyright (C) 2018-25 divingkatae and maximum
+                      (theweirdo)     spatium
+
+(Contact divingkatae#1017 or powermax#2286 on Discord for more info)
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+/** @file Scalar pixel conversion kernels and runtime kernel selection. */
+
+#include <devices/video/pixelconv.h>
+#include <devices/video/pixelconvimpl.h>
+#include <memaccess.h>
+
+#include <array>
+#include <cinttypes>
+
+using namespace PixelConv;
+
+static void conv_1bpp_indexed(const uint8_t* src, uint8_t* dst, int width,
+                              const uint32_t* palette)
+{
+    for (int x = 0; x < width; x++) {
+        uint8_t c = src[x >> 3];
+        WRITE_DWORD_LE_A(dst, palette[(c >> (7 - (x & 7))) & 1]);
+        dst += 4;
+    }
+}
+
+static void conv_2bpp_indexed(const uint8_t* src, uint8_t* dst, int width,
+                              const uint32_t* palette)
+{
+    for (int x = width >> 2; x > 0; x--) {
+        uint8_t c = *src++;
+        WRITE_DWORD_LE_A(dst,      palette[c >> 6]);
+        WRITE_DWORD_LE_A(dst +  4, palette[(c >> 4) & 3]);
+        WRITE_DWORD_LE_A(dst +  8, palette[(c >> 2) & 3]);
+        WRITE_DWORD_LE_A(dst + 12, palette[c & 3]);
+        dst += 16;
+    }
+}
+
+static void conv_4bpp_indexed(const uint8_t* src, uint8_t* dst, int width,
+                              const uint32_t* palette)
+{
+    for (int x = width >> 1; x > 0; x--) {
+        uint8_t c = *src++;
+        WRITE_DWORD_LE_A(dst,     palette[c >> 4]);
+        WRITE_DWORD_LE_A(dst + 4, palette[c & 15]);
+        dst += 8;
+    }
+}
+
+static void conv_8bpp_indexed(const uint8_t* src, uint8_t* dst, int width,
+                              const uint32_t* palette)
+{
+    for (int x = width; x > 0; x--) {
+        WRITE_DWORD_LE_A(dst, palette[*src++]);
+        dst += 4;
+    }
+}
+
+static inline uint32_t rgb332_to_argb(uint32_t c)
+{
+    uint32_t r = ((c << 16) & 0x00E00000) | ((c << 13) & 0x001C0000) | ((c << 10) & 0x00030000);
+    uint32_t g = ((c << 11) & 0x0000E000) | ((c <<  8) & 0x00001C00) | ((c <<  5) & 0x00000300);
+    uint32_t b = ((c <<  6) & 0x000000C0) | ((c <<  4) & 0x00000030) | ((c <<  2) & 0x0000000C) | (c & 0x00000003);
+    return r | g | b;
+}
+
+static void conv_rgb332(const uint8_t* src, uint8_t* dst, int width,
+                        const uint32_t* palette)
+{
+    for (int x = width; x > 0; x--) {
+        WRITE_DWORD_LE_A(dst, rgb332_to_argb(*src++));
+        dst += 4;
+    }
+}
+
+static inline uint32_t rgb555_to_argb(uint32_t c)
+{
+    uint32_t r = ((c << 9) & 0x00F80000) | ((c << 4) & 0x00070000);
+    uint32_t g = ((c << 6) & 0x0000F800) | ((c << 1) & 0x00000700);
+    uint32_t b = ((c << 3) & 0x000000F8) | ((c >> 2) & 0x00000007);
+    return r | g | b;
+}
+
+static void conv_rgb555(const uint8_t* src, uint8_t* dst, int width,
+                        const uint32_t* palette)
+{
+    for (int x = width; x > 0; x--) {
+        WRITE_DWORD_LE_A(dst, rgb555_to_argb(*((uint16_t*)(src))));
+        src += 2;
+        dst += 4;
+    }
+}
+
+static void conv_rgb555_be(const uint8_t* src, uint8_t* dst, int width,
+                           const uint32_t* palette)
+{
+    for (int x = width; x > 0; x--) {
+        WRITE_DWORD_LE_A(dst, rgb555_to_argb(READ_WORD_BE_A(src)));
+        src += 2;
+        dst += 4;
+    }
+}
+
+static void conv_rgb565(const uint8_t* src, uint8_t* dst, int width,
+                        const uint32_t* palette)
+{
+    for (int x = width; x > 0; x--) {
+        uint32_t c = *((uint16_t*)(src));
+        uint32_t r = ((c << 8) & 0x00F80000) | ((c << 3) & 0x00070000);
+        uint32_t g = ((c << 5) & 0x0000FC00) | ((c >> 1) & 0x00000300);
+        uint32_t b = ((c << 3) & 0x000000F8) | ((c >> 2) & 0x00000007);
+        WRITE_DWORD_LE_A(dst, r | g | b);
+        src += 2;
+        dst += 4;
+    }
+}
+
+static void conv_rgb888(const uint8_t* src, uint8_t* dst, int width,
+                        const uint32_t* palette)
+{
+    for (int x = width; x > 0; x--) {
+        WRITE_DWORD_LE_A(dst, (src[0] << 16) | (src[1] << 8) | src[2]);
+        src += 3;
+        dst += 4;
+    }
+}
+
+static void conv_argb8888(const uint8_t* src, uint8_t* dst, int width,
+                          const uint32_t* palette)
+{
+    for (int x = width; x > 0; x--) {
+        WRITE_DWORD_LE_A(dst, READ_DWORD_LE_A(src));
+        src += 4;
+        dst += 4;
+    }
+}
+
+static void conv_argb8888_be(const uint8_t* src, uint8_t* dst, int width,
+                             const uint32_t* palette)
+{
+    for (int x = width; x > 0; x--) {
+        WRITE_DWORD_LE_A(dst, READ_DWORD_BE_A(src));
+        src += 4;
+        dst += 4;
+    }
+}
+
+const row_conv_fn PixelConv::scalar_kernels[NUM_FORMATS] = {
+    conv_1bpp_indexed,
+    conv_2bpp_indexed,
+    conv_4bpp_indexed,
+    conv_8bpp_indexed,
+    conv_rgb332,
+    conv_rgb555,
+    conv_rgb555_be,
+    conv_rgb565,
+    conv_rgb888,
+    conv_argb8888,
+    conv_argb8888_be,
+};
+
+static const std::array<uint32_t, 256> rgb332_lut = [] {
+    std::array<uint32_t, 256> lut{};
+    for (uint32_t c = 0; c < 256; c++)
+        lut[c] = rgb332_to_argb(c);
+    return lut;
+}();
+
+const uint32_t* PixelConv::rgb332_palette = rgb332_lut.data();
+
+namespace {
+
+struct KernelTables {
+    row_conv_fn tbl[(int)Isa::NUM_ISAS][NUM_FORMATS] = {};
+    Isa         best = Isa::SCALAR;
+
+    KernelTables() {
+        for (int fmt = 0; fmt < NUM_FORMATS; fmt++)
+            tbl[(int)Isa::SCALAR][fmt] = scalar_kernels[fmt];
+
+        // ISA-specific tables start out as copies of the scalar one
+        // so that formats without a SIMD kernel fall back to it
+        auto try_isa = [this](Isa isa, bool (*init)(Isa, row_conv_fn*)) {
+            row_conv_fn kernels[NUM_FORMATS];
+            for (int fmt = 0; fmt < NUM_FORMATS; fmt++)
+                kernels[fmt] = scalar_kernels[fmt];
+            if (init(isa, kernels)) {
+                for (int fmt = 0; fmt < NUM_FORMATS; fmt++)
+                    tbl[(int)isa][fmt] = kernels[fmt];
+                best = isa;
+            }
+        };
+
+        // in order of increasing preference
+        try_isa(Isa::SSE2, init_x86_kernels);
+        try_isa(Isa::AVX2, init_x86_kernels);
+        try_isa(Isa::NEON, [](Isa, row_conv_fn* kernels) {
+            return init_neon_kernels(kernels);
+        });
+    }
+};
+
+const KernelTables& get_tables() {
+    static const KernelTables tables;
+    return tables;
+}
+
+} // anonymous namespace
+
+row_conv_fn PixelConv::get_converter(Format fmt)
+{
+    const KernelTables& tables = get_tables();
+    return tables.tbl[(int)tables.best][fmt];
+}
+
+row_conv_fn PixelConv::get_converter(Format fmt, Isa isa)
+{
+    return get_tables().tbl[(int)isa][fmt];
+}
+
+Isa PixelConv::best_isa()
+{
+    return get_tables().best;
+}
+
+const char* PixelConv::get_isa_name(Isa isa)
+{
+    switch (isa) {
+    case Isa::SCALAR:
+        return "scalar";
+    case Isa::SSE2:
+        return "SSE2";
+    case Isa::AVX2:
+        return "AVX2";
+    case Isa::NEON:
+        return "NEON";
+    default:
+        return "unknown";
+    }
+}
@@ -0,0 +1,76 @@
+/*
+DingusPPC - The Experimental PowerPC Macintosh emulator
+Copyright (C) 2018-25 divingkatae and maximum
+                      (theweirdo)     spatium
+
+(Contact divingkatae#1017 or powermax#2286 on Discord for more info)
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+/** @file Pixel format conversion kernels.
+
+    Each kernel converts one row of guest framebuffer pixels to
+    32-bit little-endian ARGB host pixels. The scalar kernels are the
+    reference implementation; SIMD variants (SSE2/AVX2 on x86, NEON on
+    AArch64) must produce bit-identical results. The fastest kernel
+    supported by the host CPU is selected once at runtime.
+ */
+
+#ifndef PIXEL_CONV_H
+#define PIXEL_CONV_H
+
+#include <cinttypes>
+
+namespace PixelConv {
+
+enum Format : int {
+    INDEXED_1BPP = 0,
+    INDEXED_2BPP,   // width must be a multiple of 4
+    INDEXED_4BPP,   // width must be a multiple of 2
+    INDEXED_8BPP,
+    RGB332,
+    RGB555,         // host byte order
+    RGB555_BE,
+    RGB565,         // host byte order
+    RGB888,
+    ARGB8888,
+    ARGB8888_BE,
+    NUM_FORMATS
+};
+
+enum class Isa : int {
+    SCALAR = 0,
+    SSE2,
+    AVX2,
+    NEON,
+    NUM_ISAS
+};
+
+// convert width pixels from src to dst using the palette for indexed formats
+typedef void (*row_conv_fn)(const uint8_t* src, uint8_t* dst, int width,
+                            const uint32_t* palette);
+
+// kernel for the given format, selected for the host CPU
+row_conv_fn get_converter(Format fmt);
+
+// kernel for the given format and ISA, nullptr if the host can't run it
+row_conv_fn get_converter(Format fmt, Isa isa);
+
+Isa         best_isa();
+const char* get_isa_name(Isa isa);
+
+}; // namespace PixelConv
+
+#endif // PIXEL_CONV_H
@@ -0,0 +1,153 @@
+/*
+DingusPPC - The Experimental PowerPC Macintosh emulator
+Copyright (C) 2018-25 divingkatae and maximum
+                      (theweirdo)     spatium
+
+(Contact divingkatae#1017 or powermax#2286 on Discord for more info)
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+/** @file NEON pixel conversion kernels for little-endian AArch64 hosts. */
+
+#include <devices/video/pixelconvimpl.h>
+
+#include <cinttypes>
+#include <cstring>
+
+using namespace PixelConv;
+
+#if (defined(__aarch64__) || defined(_M_ARM64)) && \
+    (!defined(__BYTE_ORDER__) || __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__)
+
+#include <arm_neon.h>
+
+static void conv_1bpp_indexed_neon(const uint8_t* src, uint8_t* dst, int width,
+                                   const uint32_t* palette)
+{
+    static const uint32_t hi_bits[4] = {0x80, 0x40, 0x20, 0x10};
+    static const uint32_t lo_bits[4] = {0x08, 0x04, 0x02, 0x01};
+
+    const uint32x4_t pal0    = vdupq_n_u32(palette[0]);
+    const uint32x4_t pal1    = vdupq_n_u32(palette[1]);
+    const uint32x4_t mask_hi = vld1q_u32(hi_bits);
+    const uint32x4_t mask_lo = vld1q_u32(lo_bits);
+
+    int x = 0;
+    for (; x + 8 <= width; x += 8, dst += 32) {
+        uint32x4_t c = vdupq_n_u32(*src++);
+        vst1q_u32((uint32_t*)dst,       vbslq_u32(vtstq_u32(c, mask_hi), pal1, pal0));
+        vst1q_u32((uint32_t*)(dst + 16), vbslq_u32(vtstq_u32(c, mask_lo), pal1, pal0));
+    }
+
+    scalar_kernels[INDEXED_1BPP](src, dst, width - x, palette);
+}
+
+// expand four RGB555/RGB565 pixels in c to ARGB
+template <bool is_565>
+static inline uint32x4_t expand_16bpp_neon(uint32x4_t c)
+{
+    uint32x4_t r, g, b;
+
+    if (is_565) {
+        r = vorrq_u32(vandq_u32(vshlq_n_u32(c, 8), vdupq_n_u32(0x00F80000)),
+                      vandq_u32(vshlq_n_u32(c, 3), vdupq_n_u32(0x00070000)));
+        g = vorrq_u32(vandq_u32(vshlq_n_u32(c, 5), vdupq_n_u32(0x0000FC00)),
+                      vandq_u32(vshrq_n_u32(c, 1), vdupq_n_u32(0x00000300)));
+    } else {
+        r = vorrq_u32(vandq_u32(vshlq_n_u32(c, 9), vdupq_n_u32(0x00F80000)),
+                      vandq_u32(vshlq_n_u32(c, 4), vdupq_n_u32(0x00070000)));
+        g = vorrq_u32(vandq_u32(vshlq_n_u32(c, 6), vdupq_n_u32(0x0000F800)),
+                      vandq_u32(vshlq_n_u32(c, 1), vdupq_n_u32(0x00000700)));
+    }
+    b = vorrq_u32(vandq_u32(vshlq_n_u32(c, 3), vdupq_n_u32(0x000000F8)),
+                  vandq_u32(vshrq_n_u32(c, 2), vdupq_n_u32(0x00000007)));
+
+    return vorrq_u32(vorrq_u32(r, g), b);
+}
+
+template <Format fmt>
+static void conv_16bpp_neon(const uint8_t* src, uint8_t* dst, int width,
+                            const uint32_t* palette)
+{
+    int x = 0;
+    for (; x + 8 <= width; x += 8, src += 16, dst += 32) {
+        uint8x16_t bytes = vld1q_u8(src);
+        if (fmt == RGB555_BE)
+            bytes = vrev16q_u8(bytes);
+        uint16x8_t v = vreinterpretq_u16_u8(bytes);
+        vst1q_u32((uint32_t*)dst,
+                  expand_16bpp_neon<fmt == RGB565>(vmovl_u16(vget_low_u16(v))));
+        vst1q_u32((uint32_t*)(dst + 16),
+                  expand_16bpp_neon<fmt == RGB565>(vmovl_u16(vget_high_u16(v))));
+    }
+
+    scalar_kernels[fmt](src, dst, width - x, palette);
+}
+
+static void conv_rgb888_neon(const uint8_t* src, uint8_t* dst, int width,
+                             const uint32_t* palette)
+{
+    int x = 0;
+    for (; x + 16 <= width; x += 16, src += 48, dst += 64) {
+        uint8x16x3_t rgb = vld3q_u8(src);
+        uint8x16x4_t argb;
+        argb.val[0] = rgb.val[2];
+        argb.val[1] = rgb.val[1];
+        argb.val[2] = rgb.val[0];
+        argb.val[3] = vdupq_n_u8(0);
+        vst4q_u8(dst, argb);
+    }
+
+    scalar_kernels[RGB888](src, dst, width - x, palette);
+}
+
+static void conv_argb8888_copy(const uint8_t* src, uint8_t* dst, int width,
+                               const uint32_t* palette)
+{
+    std::memcpy(dst, src, width * 4);
+}
+
+static void conv_argb8888_be_neon(const uint8_t* src, uint8_t* dst, int width,
+                                  const uint32_t* palette)
+{
+    int x = 0;
+    for (; x + 4 <= width; x += 4, src += 16, dst += 16)
+        vst1q_u8(dst, vrev32q_u8(vld1q_u8(src)));
+
+    scalar_kernels[ARGB8888_BE](src, dst, width - x, palette);
+}
+
+bool PixelConv::init_neon_kernels(row_conv_fn* tbl)
+{
+    // NEON has no 32-bit gathers, the remaining indexed formats
+    // stay with the scalar code
+    tbl[INDEXED_1BPP] = conv_1bpp_indexed_neon;
+    tbl[RGB555]       = conv_16bpp_neon<RGB555>;
+    tbl[RGB555_BE]    = conv_16bpp_neon<RGB555_BE>;
+    tbl[RGB565]       = conv_16bpp_neon<RGB565>;
+    tbl[RGB888]       = conv_rgb888_neon;
+    tbl[ARGB8888]     = conv_argb8888_copy;
+    tbl[ARGB8888_BE]  = conv_argb8888_be_neon;
+    return true;
+}
+
+#else
+
+bool PixelConv::init_neon_kernels(row_conv_fn* tbl)
+{
+    return false;
+}
+
+#endif
@@ -0,0 +1,405 @@
+/*
+DingusPPC - The Experimental PowerPC Macintosh emulator
+Copyright (C) 2018-25 divingkatae and maximum
+                      (theweirdo)     spatium
+
+(Contact divingkatae#1017 or powermax#2286 on Discord for more info)
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+/** @file SSE2 and AVX2 pixel conversion kernels.
+
+    The kernels are compiled with per-function target attributes so that
+    the rest of the program doesn't require AVX2. They're only installed
+    after the host CPU has been checked for the corresponding extension.
+ */
+
+#include <devices/video/pixelconvimpl.h>
+
+#include <cinttypes>
+#include <cstring>
+
+using namespace PixelConv;
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+
+#include <immintrin.h>
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#define TARGET_SSE2
+#define TARGET_AVX2
+#else
+#define TARGET_SSE2 __attribute__((target("sse2")))
+#define TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+
+static bool host_has_isa(Isa isa)
+{
+#ifdef _MSC_VER
+    int regs[4];
+
+    __cpuid(regs, 0);
+    int max_leaf = regs[0];
+
+    __cpuid(regs, 1);
+    bool has_sse2    = (regs[3] >> 26) & 1;
+    bool has_osxsave = (regs[2] >> 27) & 1;
+    bool has_avx     = (regs[2] >> 28) & 1;
+
+    if (isa == Isa::SSE2)
+        return has_sse2;
+
+    if (isa != Isa::AVX2 || !has_osxsave || !has_avx || max_leaf < 7)
+        return false;
+
+    // the OS must preserve the YMM state
+    if ((_xgetbv(0) & 6) != 6)
+        return false;
+
+    __cpuidex(regs, 7, 0);
+    return (regs[1] >> 5) & 1;
+#else
+    __builtin_cpu_init();
+    switch (isa) {
+    case Isa::SSE2:
+        return __builtin_cpu_supports("sse2");
+    case Isa::AVX2:
+        return __builtin_cpu_supports("avx2");
+    default:
+        return false;
+    }
+#endif
+}
+
+// ============================== SSE2 kernels ===============================
+
+TARGET_SSE2 static void conv_1bpp_indexed_sse2(const uint8_t* src, uint8_t* dst,
+                                               int width, const uint32_t* palette)
+{
+    const __m128i pal0    = _mm_set1_epi32(palette[0]);
+    const __m128i pal1    = _mm_set1_epi32(palette[1]);
+    const __m128i mask_hi = _mm_set_epi32(0x10, 0x20, 0x40, 0x80);
+    const __m128i mask_lo = _mm_set_epi32(0x01, 0x02, 0x04, 0x08);
+    const __m128i zero    = _mm_setzero_si128();
+
+    int x = 0;
+    for (; x + 8 <= width; x += 8) {
+        __m128i c  = _mm_set1_epi32(*src++);
+        __m128i m0 = _mm_cmpeq_epi32(_mm_and_si128(c, mask_hi), zero);
+        __m128i m1 = _mm_cmpeq_epi32(_mm_and_si128(c, mask_lo), zero);
+        _mm_storeu_si128((__m128i*)dst,
+            _mm_or_si128(_mm_and_si128(m0, pal0), _mm_andnot_si128(m0, pal1)));
+        _mm_storeu_si128((__m128i*)(dst + 16),
+            _mm_or_si128(_mm_and_si128(m1, pal0), _mm_andnot_si128(m1, pal1)));
+        dst += 32;
+    }
+
+    scalar_kernels[INDEXED_1BPP](src, dst, width - x, palette);
+}
+
+// expand eight RGB555/RGB565 pixels in v to ARGB
+template <bool is_565>
+TARGET_SSE2 static inline void expand_16bpp_sse2(__m128i v, uint8_t* dst)
+{
+    const __m128i zero = _mm_setzero_si128();
+    __m128i halves[2] = {_mm_unpacklo_epi16(v, zero), _mm_unpackhi_epi16(v, zero)};
+
+    for (int i = 0; i < 2; i++) {
+        __m128i c = halves[i];
+        __m128i r, g, b;
+        if (is_565) {
+            r = _mm_or_si128(_mm_and_si128(_mm_slli_epi32(c, 8), _mm_set1_epi32(0x00F80000)),
+                             _mm_and_si128(_mm_slli_epi32(c, 3), _mm_set1_epi32(0x00070000)));
+            g = _mm_or_si128(_mm_and_si128(_mm_slli_epi32(c, 5), _mm_set1_epi32(0x0000FC00)),
+                             _mm_and_si128(_mm_srli_epi32(c, 1), _mm_set1_epi32(0x00000300)));
+        } else {
+            r = _mm_or_si128(_mm_and_si128(_mm_slli_epi32(c, 9), _mm_set1_epi32(0x00F80000)),
+                             _mm_and_si128(_mm_slli_epi32(c, 4), _mm_set1_epi32(0x00070000)));
+            g = _mm_or_si128(_mm_and_si128(_mm_slli_epi32(c, 6), _mm_set1_epi32(0x0000F800)),
+                             _mm_and_si128(_mm_slli_epi32(c, 1), _mm_set1_epi32(0x00000700)));
+        }
+        b = _mm_or_si128(_mm_and_si128(_mm_slli_epi32(c, 3), _mm_set1_epi32(0x000000F8)),
+                         _mm_and_si128(_mm_srli_epi32(c, 2), _mm_set1_epi32(0x00000007)));
+        _mm_storeu_si128((__m128i*)(dst + i * 16), _mm_or_si128(_mm_or_si128(r, g), b));
+    }
+}
+
+TARGET_SSE2 static inline __m128i bswap16_sse2(__m128i v)
+{
+    return _mm_or_si128(_mm_slli_epi16(v, 8), _mm_srli_epi16(v, 8));
+}
+
+TARGET_SSE2 static void conv_rgb555_sse2(const uint8_t* src, uint8_t* dst, int width,
+                                         const uint32_t* palette)
+{
+    int x = 0;
+    for (; x + 8 <= width; x += 8, src += 16, dst += 32)
+        expand_16bpp_sse2<false>(_mm_loadu_si128((const __m128i*)src), dst);
+
+    scalar_kernels[RGB555](src, dst, width - x, palette);
+}
+
+TARGET_SSE2 static void conv_rgb555_be_sse2(const uint8_t* src, uint8_t* dst, int width,
+                                            const uint32_t* palette)
+{
+    int x = 0;
+    for (; x + 8 <= width; x += 8, src += 16, dst += 32)
+        expand_16bpp_sse2<false>(bswap16_sse2(_mm_loadu_si128((const __m128i*)src)), dst);
+
+    scalar_kernels[RGB555_BE](src, dst, width - x, palette);
+}
+
+TARGET_SSE2 static void conv_rgb565_sse2(const uint8_t* src, uint8_t* dst, int width,
+                                         const uint32_t* palette)
+{
+    int x = 0;
+    for (; x + 8 <= width; x += 8, src += 16, dst += 32)
+        expand_16bpp_sse2<true>(_mm_loadu_si128((const __m128i*)src), dst);
+
+    scalar_kernels[RGB565](src, dst, width - x, palette);
+}
+
+static void conv_argb8888_copy(const uint8_t* src, uint8_t* dst, int width,
+                               const uint32_t* palette)
+{
+    std::memcpy(dst, src, width * 4);
+}
+
+TARGET_SSE2 static void conv_argb8888_be_sse2(const uint8_t* src, uint8_t* dst, int width,
+                                              const uint32_t* palette)
+{
+    int x = 0;
+    for (; x + 4 <= width; x += 4, src += 16, dst += 16) {
+        __m128i v = _mm_loadu_si128((const __m128i*)src);
+        // swap the 16-bit halves of each dword, then the bytes of each half
+        v = _mm_shufflehi_epi16(_mm_shufflelo_epi16(v, 0xB1), 0xB1);
+        _mm_storeu_si128((__m128i*)dst, bswap16_sse2(v));
+    }
+
+    scalar_kernels[ARGB8888_BE](src, dst, width - x, palette);
+}
+
+// ============================== AVX2 kernels ===============================
+
+TARGET_AVX2 static void conv_1bpp_indexed_avx2(const uint8_t* src, uint8_t* dst,
+                                               int width, const uint32_t* palette)
+{
+    const __m256i pal0  = _mm256_set1_epi32(palette[0]);
+    const __m256i pal1  = _mm256_set1_epi32(palette[1]);
+    const __m256i masks = _mm256_setr_epi32(0x80, 0x40, 0x20, 0x10, 0x08, 0x04, 0x02, 0x01);
+    const __m256i zero  = _mm256_setzero_si256();
+
+    int x = 0;
+    for (; x + 8 <= width; x += 8, dst += 32) {
+        __m256i c = _mm256_set1_epi32(*src++);
+        __m256i m = _mm256_cmpeq_epi32(_mm256_and_si256(c, masks), zero);
+        _mm256_storeu_si256((__m256i*)dst, _mm256_blendv_epi8(pal1, pal0, m));
+    }
+
+    scalar_kernels[INDEXED_1BPP](src, dst, width - x, palette);
+}
+
+TARGET_AVX2 static void conv_2bpp_indexed_avx2(const uint8_t* src, uint8_t* dst,
+                                               int width, const uint32_t* palette)
+{
+    // pixel i of a 16-bit group lives in byte i / 4, most significant bits first
+    const __m256i shifts = _mm256_setr_epi32(6, 4, 2, 0, 14, 12, 10, 8);
+    const __m256i mask   = _mm256_set1_epi32(3);
+
+    int x = 0;
+    for (; x + 8 <= width; x += 8, src += 2, dst += 32) {
+        uint16_t c;
+        std::memcpy(&c, src, 2);
+        __m256i idx = _mm256_and_si256(_mm256_srlv_epi32(_mm256_set1_epi32(c), shifts), mask);
+        _mm256_storeu_si256((__m256i*)dst,
+                            _mm256_i32gather_epi32((const int*)palette, idx, 4));
+    }
+
+    scalar_kernels[INDEXED_2BPP](src, dst, width - x, palette);
+}
+
+TARGET_AVX2 static void conv_4bpp_indexed_avx2(const uint8_t* src, uint8_t* dst,
+                                               int width, const uint32_t* palette)
+{
+    const __m256i shifts = _mm256_setr_epi32(4, 0, 12, 8, 20, 16, 28, 24);
+    const __m256i mask   = _mm256_set1_epi32(15);
+
+    int x = 0;
+    for (; x + 8 <= width; x += 8, src += 4, dst += 32) {
+        uint32_t c;
+        std::memcpy(&c, src, 4);
+        __m256i idx = _mm256_and_si256(_mm256_srlv_epi32(_mm256_set1_epi32(c), shifts), mask);
+        _mm256_storeu_si256((__m256i*)dst,
+                            _mm256_i32gather_epi32((const int*)palette, idx, 4));
+    }
+
+    scalar_kernels[INDEXED_4BPP](src, dst, width - x, palette);
+}
+
+TARGET_AVX2 static void conv_8bpp_indexed_avx2(const uint8_t* src, uint8_t* dst,
+                                               int width, const uint32_t* palette)
+{
+    int x = 0;
+    for (; x + 8 <= width; x += 8, src += 8, dst += 32) {
+        __m256i idx = _mm256_cvtepu8_epi32(_mm_loadl_epi64((const __m128i*)src));
+        _mm256_storeu_si256((__m256i*)dst,
+                            _mm256_i32gather_epi32((const int*)palette, idx, 4));
+    }
+
+    scalar_kernels[INDEXED_8BPP](src, dst, width - x, palette);
+}
+
+TARGET_AVX2 static void conv_rgb332_avx2(const uint8_t* src, uint8_t* dst, int width,
+                                         const uint32_t* palette)
+{
+    conv_8bpp_indexed_avx2(src, dst, width, rgb332_palette);
+}
+
+// expand eight RGB555/RGB565 pixels in v to ARGB
+template <bool is_565>
+TARGET_AVX2 static inline void expand_16bpp_avx2(__m128i v, uint8_t* dst)
+{
+    __m256i c = _mm256_cvtepu16_epi32(v);
+    __m256i r, g, b;
+
+    if (is_565) {
+        r = _mm256_or_si256(_mm256_and_si256(_mm256_slli_epi32(c, 8), _mm256_set1_epi32(0x00F80000)),
+                            _mm256_and_si256(_mm256_slli_epi32(c, 3), _mm256_set1_epi32(0x00070000)));
+        g = _mm256_or_si256(_mm256_and_si256(_mm256_slli_epi32(c, 5), _mm256_set1_epi32(0x0000FC00)),
+                            _mm256_and_si256(_mm256_srli_epi32(c, 1), _mm256_set1_epi32(0x00000300)));
+    } else {
+        r = _mm256_or_si256(_mm256_and_si256(_mm256_slli_epi32(c, 9), _mm256_set1_epi32(0x00F80000)),
+                            _mm256_and_si256(_mm256_slli_epi32(c, 4), _mm256_set1_epi32(0x00070000)));
+        g = _mm256_or_si256(_mm256_and_si256(_mm256_slli_epi32(c, 6), _mm256_set1_epi32(0x0000F800)),
+                            _mm256_and_si256(_mm256_slli_epi32(c, 1), _mm256_set1_epi32(0x00000700)));
+    }
+    b = _mm256_or_si256(_mm256_and_si256(_mm256_slli_epi32(c, 3), _mm256_set1_epi32(0x000000F8)),
+                        _mm256_and_si256(_mm256_srli_epi32(c, 2), _mm256_set1_epi32(0x00000007)));
+
+    _mm256_storeu_si256((__m256i*)dst, _mm256_or_si256(_mm256_or_si256(r, g), b));
+}
+
+TARGET_AVX2 static void conv_rgb555_avx2(const uint8_t* src, uint8_t* dst, int width,
+                                         const uint32_t* palette)
+{
+    int x = 0;
+    for (; x + 8 <= width; x += 8, src += 16, dst += 32)
+        expand_16bpp_avx2<false>(_mm_loadu_si128((const __m128i*)src), dst);
+
+    scalar_kernels[RGB555](src, dst, width - x, palette);
+}
+
+TARGET_AVX2 static void conv_rgb555_be_avx2(const uint8_t* src, uint8_t* dst, int width,
+                                            const uint32_t* palette)
+{
+    const __m128i bswap16 = _mm_setr_epi8(1, 0, 3, 2, 5, 4, 7, 6, 9, 8, 11, 10, 13, 12, 15, 14);
+
+    int x = 0;
+    for (; x + 8 <= width; x += 8, src += 16, dst += 32)
+        expand_16bpp_avx2<false>(
+            _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)src), bswap16), dst);
+
+    scalar_kernels[RGB555_BE](src, dst, width - x, palette);
+}
+
+TARGET_AVX2 static void conv_rgb565_avx2(const uint8_t* src, uint8_t* dst, int width,
+                                         const uint32_t* palette)
+{
+    int x = 0;
+    for (; x + 8 <= width; x += 8, src += 16, dst += 32)
+        expand_16bpp_avx2<true>(_mm_loadu_si128((const __m128i*)src), dst);
+
+    scalar_kernels[RGB565](src, dst, width - x, palette);
+}
+
+TARGET_AVX2 static void conv_rgb888_avx2(const uint8_t* src, uint8_t* dst, int width,
+                                         const uint32_t* palette)
+{
+    // each 128-bit lane picks four RGB triplets and outputs them as XRGB
+    const __m256i shuf = _mm256_setr_epi8(
+        2, 1, 0, -128, 5, 4, 3, -128, 8, 7, 6, -128, 11, 10, 9, -128,
+        2, 1, 0, -128, 5, 4, 3, -128, 8, 7, 6, -128, 11, 10, 9, -128);
+
+    int x = 0;
+    // the second load reads 16 bytes at offset 12, i.e. four bytes past
+    // the eight pixels being converted, keep it within the row
+    for (; x + 10 <= width; x += 8, src += 24, dst += 32) {
+        __m256i v = _mm256_inserti128_si256(
+            _mm256_castsi128_si256(_mm_loadu_si128((const __m128i*)src)),
+            _mm_loadu_si128((const __m128i*)(src + 12)), 1);
+        _mm256_storeu_si256((__m256i*)dst, _mm256_shuffle_epi8(v, shuf));
+    }
+
+    scalar_kernels[RGB888](src, dst, width - x, palette);
+}
+
+TARGET_AVX2 static void conv_argb8888_be_avx2(const uint8_t* src, uint8_t* dst, int width,
+                                              const uint32_t* palette)
+{
+    const __m256i bswap32 = _mm256_setr_epi8(
+        3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12,
+        3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12);
+
+    int x = 0;
+    for (; x + 8 <= width; x += 8, src += 32, dst += 32)
+        _mm256_storeu_si256((__m256i*)dst,
+            _mm256_shuffle_epi8(_mm256_loadu_si256((const __m256i*)src), bswap32));
+
+    scalar_kernels[ARGB8888_BE](src, dst, width - x, palette);
+}
+
+bool PixelConv::init_x86_kernels(Isa isa, row_conv_fn* tbl)
+{
+    if (!host_has_isa(isa))
+        return false;
+
+    switch (isa) {
+    case Isa::SSE2:
+        // SSE2 lacks gathers and byte shuffles, indexed formats
+        // and RGB888 stay with the scalar code
+        tbl[INDEXED_1BPP] = conv_1bpp_indexed_sse2;
+        tbl[RGB555]       = conv_rgb555_sse2;
+        tbl[RGB555_BE]    = conv_rgb555_be_sse2;
+        tbl[RGB565]       = conv_rgb565_sse2;
+        tbl[ARGB8888]     = conv_argb8888_copy;
+        tbl[ARGB8888_BE]  = conv_argb8888_be_sse2;
+        return true;
+    case Isa::AVX2:
+        tbl[INDEXED_1BPP] = conv_1bpp_indexed_avx2;
+        tbl[INDEXED_2BPP] = conv_2bpp_indexed_avx2;
+        tbl[INDEXED_4BPP] = conv_4bpp_indexed_avx2;
+        tbl[INDEXED_8BPP] = conv_8bpp_indexed_avx2;
+        tbl[RGB332]       = conv_rgb332_avx2;
+        tbl[RGB555]       = conv_rgb555_avx2;
+        tbl[RGB555_BE]    = conv_rgb555_be_avx2;
+        tbl[RGB565]       = conv_rgb565_avx2;
+        tbl[RGB888]       = conv_rgb888_avx2;
+        tbl[ARGB8888]     = conv_argb8888_copy;
+        tbl[ARGB8888_BE]  = conv_argb8888_be_avx2;
+        return true;
+    default:
+        return false;
+    }
+}
+
+#else
+
+bool PixelConv::init_x86_kernels(Isa isa, row_conv_fn* tbl)
+{
+    return false;
+}
+
+#endif
@@ -0,0 +1,45 @@
+/*
+DingusPPC - The Experimental PowerPC Macintosh emulator
+Copyright (C) 2018-25 divingkatae and maximum
+                      (theweirdo)     spatium
+
+(Contact divingkatae#1017 or powermax#2286 on Discord for more info)
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+/** @file Internal interface between the pixel conversion dispatcher
+    and the ISA-specific kernel sets. */
+
+#ifndef PIXEL_CONV_IMPL_H
+#define PIXEL_CONV_IMPL_H
+
+#include <devices/video/pixelconv.h>
+
+namespace PixelConv {
+
+// scalar reference kernels, also used for the tails of SIMD loops
+extern const row_conv_fn scalar_kernels[NUM_FORMATS];
+
+// RGB332 expanded to ARGB so that it can be converted like 8bpp indexed
+extern const uint32_t* rgb332_palette;
+
+/* Each ISA-specific module overrides the entries it accelerates in tbl.
+   It returns false if the host can't run the ISA, leaving tbl untouched. */
+bool init_x86_kernels(Isa isa, row_conv_fn* tbl);
+bool init_neon_kernels(row_conv_fn* tbl);
+
+}; // namespace PixelConv
+
+#endif // PIXEL_CONV_IMPL_H
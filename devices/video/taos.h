@@ -170,7 +170,7 @@ private:
 class TaosVideo : public VideoCtrlBase, public MMIODevice {
 public:
     TaosVideo();
-    ~TaosVideo() = default;
+    ~TaosVideo() { this->stop_refresh_task(); };
 
     static std::unique_ptr<HWComponent> create() {
         return std::unique_ptr<TaosVideo>(new TaosVideo());
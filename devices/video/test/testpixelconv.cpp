@@ -0,0 +1,100 @@
+/*
+DingusPPC - The Experimental PowerPC Macintosh emulator
+Copyright (C) 2018-25 divingkatae and maximum
+                      (theweirdo)     spatium
+
+(Contact divingkatae#1017 or powermax#2286 on Discord for more info)
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+/** @file Compares SIMD pixel conversion kernels against the scalar ones. */
+
+#include <devices/video/pixelconv.h>
+
+#include <cinttypes>
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <vector>
+
+using namespace std;
+using namespace PixelConv;
+
+static const char* fmt_names[NUM_FORMATS] = {
+    "1bpp indexed", "2bpp indexed", "4bpp indexed", "8bpp indexed", "RGB332",
+    "RGB555", "RGB555 BE", "RGB565", "RGB888", "ARGB8888", "ARGB8888 BE"
+};
+
+static const int src_bits[NUM_FORMATS] = {1, 2, 4, 8, 8, 16, 16, 16, 24, 32, 32};
+
+int main(int argc, char** argv) {
+    mt19937 rng(0x1234);
+
+    uint32_t palette[256];
+    for (auto& c : palette)
+        c = rng();
+
+    int ntested = 0;
+    int nfailed = 0;
+
+    cout << "Best pixel conversion ISA: " << get_isa_name(best_isa()) << endl;
+
+    for (int isa = (int)Isa::SCALAR + 1; isa < (int)Isa::NUM_ISAS; isa++) {
+        for (int fmt = 0; fmt < NUM_FORMATS; fmt++) {
+            row_conv_fn ref  = get_converter((Format)fmt, Isa::SCALAR);
+            row_conv_fn test = get_converter((Format)fmt, (Isa)isa);
+
+            if (!test || test == ref)
+                continue;
+
+            // cover all vector loop tails, then some real-world widths
+            vector<int> widths;
+            for (int w = 0; w <= 72; w++)
+                widths.push_back(w);
+            widths.insert(widths.end(), {640, 832, 1024, 1152, 1280});
+
+            for (int width : widths) {
+                if ((fmt == INDEXED_2BPP && (width & 3)) ||
+                    (fmt == INDEXED_4BPP && (width & 1)))
+                    continue;
+
+                int src_len = (width * src_bits[fmt] + 7) >> 3;
+
+                // kernels may read ahead within the row but never past it
+                vector<uint32_t> src_store(src_len / 4 + 2);
+                vector<uint32_t> ref_out(width + 1, 0xDEADBEEF);
+                vector<uint32_t> test_out(width + 1, 0xDEADBEEF);
+
+                uint8_t* src = (uint8_t*)src_store.data();
+                for (int i = 0; i < src_len; i++)
+                    src[i] = rng();
+
+                ref((uint8_t*)src, (uint8_t*)ref_out.data(), width, palette);
+                test((uint8_t*)src, (uint8_t*)test_out.data(), width, palette);
+
+                ntested++;
+                if (ref_out != test_out) {
+                    cout << "Mismatch: " << get_isa_name((Isa)isa) << " "
+                         << fmt_names[fmt] << ", width=" << width << endl;
+                    nfailed++;
+                }
+            }
+        }
+    }
+
+    cout << "Tested conversions: " << ntested << ", failed: " << nfailed << endl;
+
+    return nfailed ? 1 : 0;
+}
@@ -23,10 +23,16 @@ along with this program.  If not, see <https://www.gnu.org/licenses/>.
 
 #include <core/timermanager.h>
 #include <devices/common/hwinterrupt.h>
+#include <devices/video/framepipeline.h>
+#include <devices/video/pixelconv.h>
 #include <devices/video/videoctrl.h>
 #include <memaccess.h>
 
+#include <chrono>
 #include <cinttypes>
+#include <cstring>
+
+uint32_t max_present_fps = 60;
 
 VideoCtrlBase::VideoCtrlBase(int width, int height)
 {
@@ -61,8 +67,34 @@ void VideoCtrlBase::blank_display() {
     this->display.blank();
 }
 
+bool VideoCtrlBase::present_due()
+{
+    if (!this->display.is_visible())
+        return false;
+
+    if (!max_present_fps)
+        return true;
+
+    uint64_t now = std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+
+    if (now < this->next_present_ns)
+        return false;
+
+    // keep a steady cadence but don't try to catch up after a stall
+    this->next_present_ns += NS_PER_SEC / max_present_fps;
+    if (this->next_present_ns <= now)
+        this->next_present_ns = now + NS_PER_SEC / max_present_fps;
+
+    return true;
+}
+
 void VideoCtrlBase::update_screen()
 {
+    // skipped frames stay dirty and get picked up by the next presented one
+    if (!this->present_due())
+        return;
+
     if (this->blank_on) {
         this->display.blank();
         return;
@@ -74,18 +106,43 @@ void VideoCtrlBase::update_screen()
         this->get_cursor_position(cursor_x, cursor_y);
     }
 
-    if (draw_fb) {
-        if (this->cursor_dirty) {
-            this->setup_hw_cursor();
-            this->cursor_dirty = false;
-        }
-        this->display.update(
-            this->convert_fb_cb, this->cursor_ovl_cb,
-            this->cursor_on, cursor_x, cursor_y,
-            this->draw_fb_is_dynamic);
-    } else if (this->draw_fb_is_dynamic) {
-        this->display.update_skipped();
+    if (this->cursor_dirty) {
+        this->setup_hw_cursor();
+        this->cursor_dirty = false;
     }
+
+    // frames are dropped while the host thread is still busy with the last one
+    if (!this->draw_fb || this->display.is_busy()) {
+        if (this->draw_fb_is_dynamic)
+            this->display.update_skipped();
+        return;
+    }
+
+    if (this->conv_buf_width != this->active_width ||
+        this->conv_buf_height != this->active_height) {
+        this->conv_buf_width  = this->active_width;
+        this->conv_buf_height = this->active_height;
+        this->conv_buf = std::unique_ptr<uint8_t[]>(
+            new uint8_t[this->active_width * this->active_height * 4]);
+    }
+
+    // capture the current frame, it's converted right before presentation
+    this->frame_captured = false;
+    this->convert_fb_cb(this->conv_buf.get(), this->active_width * 4);
+    if (!this->frame_captured) { // custom converter did the work
+        this->frame_desc.fb_ptr   = this->conv_buf.get();
+        this->frame_desc.fb_pitch = this->active_width * 4;
+        this->frame_desc.width    = this->active_width;
+        this->frame_desc.height   = this->active_height;
+        this->frame_desc.format   = PixelConv::ARGB8888;
+    }
+
+    this->display.update(
+        [desc = this->frame_desc](uint8_t *dst_buf, int dst_pitch) {
+            FramePipeline::get_instance()->convert(desc, dst_buf, dst_pitch);
+        },
+        this->cursor_ovl_cb ? this->cursor_ovl_cb() : nullptr,
+        this->cursor_on, cursor_x, cursor_y, this->draw_fb_is_dynamic);
 }
 
 void VideoCtrlBase::start_refresh_task() {
@@ -95,7 +152,8 @@ void VideoCtrlBase::start_refresh_task() {
     this->refresh_task_id = TimerManager::get_instance()->add_cyclic_timer(
         refresh_interval,
         [this]() {
-            // assert VBL interrupt
+            // assert VBL interrupt, guest timing is kept exact
+            // while host presentation may be throttled
             this->vbl_cb(1);
             this->update_screen();
         }
@@ -118,6 +176,9 @@ void VideoCtrlBase::start_refresh_task() {
 }
 
 void VideoCtrlBase::stop_refresh_task() {
+    // the framebuffer may go away once the display is off
+    this->display.wait_idle();
+
     if (this->refresh_task_id) {
         TimerManager::get_instance()->cancel_timer(this->refresh_task_id);
         this->refresh_task_id = 0;
@@ -152,304 +213,91 @@ void VideoCtrlBase::setup_hw_cursor(int cursor_width, int cursor_height)
     this->cursor_on = true;
 }
 
-void VideoCtrlBase::convert_frame_1bpp_indexed(uint8_t *dst_buf, int dst_pitch)
+void VideoCtrlBase::convert_frame(PixelConv::Format fmt, int width, uint8_t *dst_buf,
+                                  int dst_pitch)
 {
-    uint8_t *src_row, *dst_row;
-    int     src_pitch;
-
-    src_pitch = this->fb_pitch - ((this->active_width + 7) >> 3);
-    dst_pitch = dst_pitch - 4 * this->active_width;
-
-    src_row = this->fb_ptr - 1;
-    dst_row = dst_buf;
-    for (int h = this->active_height; h > 0; h--) {
-        uint8_t bit = 0x00;
-        uint8_t c;
-        for (int x = this->active_width; x > 0; x--) {
-            if (!bit) {
-                src_row += 1;
-                bit = 0x80;
-                c = *src_row;
-            }
-            WRITE_DWORD_LE_A(dst_row, this->palette[!!(c & bit)]);
-            bit >>= 1;
-            dst_row += 4;
-        }
-        src_row += src_pitch;
-        dst_row += dst_pitch;
+    if (dst_buf == this->conv_buf.get()) {
+        // hand the conversion over to the host thread
+        this->frame_desc.fb_ptr   = this->fb_ptr;
+        this->frame_desc.fb_pitch = this->fb_pitch;
+        this->frame_desc.width    = width;
+        this->frame_desc.height   = this->active_height;
+        this->frame_desc.format   = fmt;
+        std::memcpy(this->frame_desc.palette, this->palette, sizeof(this->palette));
+        this->frame_captured = true;
+        return;
     }
-}
 
-void VideoCtrlBase::convert_frame_2bpp_indexed(uint8_t *dst_buf, int dst_pitch)
-{
-    uint8_t *src_row, *dst_row;
-    int     src_pitch;
+    PixelConv::row_conv_fn conv_row = PixelConv::get_converter(fmt);
 
-    src_pitch = this->fb_pitch - (this->active_width >> 2);
-    dst_pitch = dst_pitch - 4 * this->active_width;
+    const uint8_t *src_row = this->fb_ptr;
+    uint8_t       *dst_row = dst_buf;
 
-    src_row = this->fb_ptr;
-    dst_row = dst_buf;
     for (int h = this->active_height; h > 0; h--) {
-        uint8_t c;
-        for (int x = this->active_width >> 2; x > 0; x--) {
-            c = *src_row;
-            WRITE_DWORD_LE_A(dst_row, this->palette[c >> 6]);
-            dst_row += 4;
-            WRITE_DWORD_LE_A(dst_row, this->palette[(c >> 4) & 3]);
-            dst_row += 4;
-            WRITE_DWORD_LE_A(dst_row, this->palette[(c >> 2) & 3]);
-            dst_row += 4;
-            WRITE_DWORD_LE_A(dst_row, this->palette[c & 3]);
-            dst_row += 4;
-            src_row += 1;
-        }
-        src_row += src_pitch;
+        conv_row(src_row, dst_row, width, this->palette);
+        src_row += this->fb_pitch;
         dst_row += dst_pitch;
     }
 }
 
-void VideoCtrlBase::convert_frame_4bpp_indexed(uint8_t *dst_buf, int dst_pitch)
+void VideoCtrlBase::convert_frame_1bpp_indexed(uint8_t *dst_buf, int dst_pitch)
 {
-    uint8_t *src_row, *dst_row;
-    int     src_pitch;
-
-    src_pitch = this->fb_pitch - (this->active_width >> 1);
-    dst_pitch = dst_pitch - 4 * this->active_width;
-
-    src_row = this->fb_ptr;
-    dst_row = dst_buf;
-    for (int h = this->active_height; h > 0; h--) {
-        uint8_t c;
-        for (int x = this->active_width >> 1; x > 0; x--) {
-            c = *src_row;
-            WRITE_DWORD_LE_A(dst_row, this->palette[c >> 4]);
-            dst_row += 4;
-            WRITE_DWORD_LE_A(dst_row, this->palette[c & 15]);
-            dst_row += 4;
-            src_row += 1;
-        }
-        src_row += src_pitch;
-        dst_row += dst_pitch;
-    }
+    this->convert_frame(PixelConv::INDEXED_1BPP, this->active_width, dst_buf, dst_pitch);
 }
 
-void VideoCtrlBase::convert_frame_8bpp_indexed(uint8_t *dst_buf, int dst_pitch)
+void VideoCtrlBase::convert_frame_2bpp_indexed(uint8_t *dst_buf, int dst_pitch)
 {
-    uint8_t *src_row, *dst_row;
-    int     src_pitch;
-
-    src_pitch = this->fb_pitch - this->active_width;
-    dst_pitch = dst_pitch - 4 * this->active_width;
-
-    src_row = this->fb_ptr;
-    dst_row = dst_buf;
-    for (int h = this->active_height; h > 0; h--) {
-        for (int x = this->active_width; x > 0; x--) {
-            WRITE_DWORD_LE_A(dst_row, this->palette[*src_row++]);
-            dst_row += 4;
-        }
-        src_row += src_pitch;
-        dst_row += dst_pitch;
-    }
+    this->convert_frame(PixelConv::INDEXED_2BPP, this->active_width & ~3, dst_buf, dst_pitch);
 }
 
-#if 0
-// alternative version to the above but only works for little endian host
-void VideoCtrlBase::convert_frame_8bpp_32LE_indexed(uint8_t *dst_buf, int dst_pitch)
+void VideoCtrlBase::convert_frame_4bpp_indexed(uint8_t *dst_buf, int dst_pitch)
 {
-    uint8_t *dst_row;
-    uint32_t *src_row;
-    int     src_pitch;
-
-    src_pitch = this->fb_pitch - this->active_width;
-    dst_pitch = dst_pitch - 4 * this->active_width;
+    this->convert_frame(PixelConv::INDEXED_4BPP, this->active_width & ~1, dst_buf, dst_pitch);
+}
 
-    src_row = (uint32_t*)this->fb_ptr;
-    dst_row = dst_buf;
-    for (int h = this->active_height; h > 0; h--) {
-        for (int x = this->active_width >> 2; x > 0; x--) {
-            uint32_t pixels = *src_row++;
-            WRITE_DWORD_LE_A(dst_row     , this->palette[(uint8_t)(pixels      )]);
-            WRITE_DWORD_LE_A(dst_row +  4, this->palette[(uint8_t)(pixels >>  8)]);
-            WRITE_DWORD_LE_A(dst_row +  8, this->palette[(uint8_t)(pixels >> 16)]);
-            WRITE_DWORD_LE_A(dst_row + 12, this->palette[(uint8_t)(pixels >> 24)]);
-            dst_row += 16;
-        }
-        src_row = (uint32_t*)((uint8_t*)src_row + src_pitch);
-        dst_row += dst_pitch;
-    }
+void VideoCtrlBase::convert_frame_8bpp_indexed(uint8_t *dst_buf, int dst_pitch)
+{
+    this->convert_frame(PixelConv::INDEXED_8BPP, this->active_width, dst_buf, dst_pitch);
 }
-#endif
 
 // RGB332
 void VideoCtrlBase::convert_frame_8bpp(uint8_t *dst_buf, int dst_pitch)
 {
-    uint8_t *src_row, *dst_row;
-    int     src_pitch;
-
-    src_pitch = this->fb_pitch - this->active_width;
-    dst_pitch = dst_pitch - 4 * this->active_width;
-
-    src_row = this->fb_ptr;
-    dst_row = dst_buf;
-    for (int h = this->active_height; h > 0; h--) {
-        for (int x = this->active_width; x > 0; x--) {
-            uint32_t c = *src_row++;
-            uint32_t r = ((c << 16) & 0x00E00000) | ((c << 13) & 0x001C0000) | ((c << 10) & 0x00030000);
-            uint32_t g = ((c << 11) & 0x0000E000) | ((c <<  8) & 0x00001C00) | ((c <<  5) & 0x00000300);
-            uint32_t b = ((c <<  6) & 0x000000C0) | ((c <<  4) & 0x00000030) | ((c <<  2) & 0x0000000C) | (c & 0x00000003);
-            WRITE_DWORD_LE_A(dst_row, r | g | b);
-            dst_row += 4;
-        }
-        src_row += src_pitch;
-        dst_row += dst_pitch;
-    }
+    this->convert_frame(PixelConv::RGB332, this->active_width, dst_buf, dst_pitch);
 }
 
 // RGB555
 void VideoCtrlBase::convert_frame_15bpp(uint8_t *dst_buf, int dst_pitch)
 {
-    uint8_t *src_row, *dst_row;
-    int     src_pitch;
-
-    src_pitch = this->fb_pitch - 2 * this->active_width;
-    dst_pitch = dst_pitch - 4 * this->active_width;
-
-    src_row = this->fb_ptr;
-    dst_row = dst_buf;
-    for (int h = this->active_height; h > 0; h--) {
-        for (int x = this->active_width; x > 0; x--) {
-            uint32_t c = *((uint16_t*)(src_row));
-            uint32_t r = ((c << 9) & 0x00F80000) | ((c << 4) & 0x00070000);
-            uint32_t g = ((c << 6) & 0x0000F800) | ((c << 1) & 0x00000700);
-            uint32_t b = ((c << 3) & 0x000000F8) | ((c >> 2) & 0x00000007);
-            WRITE_DWORD_LE_A(dst_row, r | g | b);
-            src_row += 2;
-            dst_row += 4;
-        }
-        src_row += src_pitch;
-        dst_row += dst_pitch;
-    }
+    this->convert_frame(PixelConv::RGB555, this->active_width, dst_buf, dst_pitch);
 }
 
 // RGB555_BE
 void VideoCtrlBase::convert_frame_15bpp_BE(uint8_t *dst_buf, int dst_pitch)
 {
-    uint8_t *src_row, *dst_row;
-    int     src_pitch;
-
-    src_pitch = this->fb_pitch - 2 * this->active_width;
-    dst_pitch = dst_pitch - 4 * this->active_width;
-
-    src_row = this->fb_ptr;
-    dst_row = dst_buf;
-    for (int h = this->active_height; h > 0; h--) {
-        for (int x = this->active_width; x > 0; x--) {
-            uint32_t c = READ_WORD_BE_A(src_row);
-            uint32_t r = ((c << 9) & 0x00F80000) | ((c << 4) & 0x00070000);
-            uint32_t g = ((c << 6) & 0x0000F800) | ((c << 1) & 0x00000700);
-            uint32_t b = ((c << 3) & 0x000000F8) | ((c >> 2) & 0x00000007);
-            WRITE_DWORD_LE_A(dst_row, r | g | b);
-            src_row += 2;
-            dst_row += 4;
-        }
-        src_row += src_pitch;
-        dst_row += dst_pitch;
-    }
+    this->convert_frame(PixelConv::RGB555_BE, this->active_width, dst_buf, dst_pitch);
 }
 
 // RGB565
 void VideoCtrlBase::convert_frame_16bpp(uint8_t *dst_buf, int dst_pitch)
 {
-    uint8_t *src_row, *dst_row;
-    int     src_pitch;
-
-    src_pitch = this->fb_pitch - 2 * this->active_width;
-    dst_pitch = dst_pitch - 4 * this->active_width;
-
-    src_row = this->fb_ptr;
-    dst_row = dst_buf;
-    for (int h = this->active_height; h > 0; h--) {
-        for (int x = this->active_width; x > 0; x--) {
-            uint32_t c = *((uint16_t*)(src_row));
-            uint32_t r = ((c << 8) & 0x00F80000) | ((c << 3) & 0x00070000);
-            uint32_t g = ((c << 5) & 0x0000FC00) | ((c >> 1) & 0x00000300);
-            uint32_t b = ((c << 3) & 0x000000F8) | ((c >> 2) & 0x00000007);
-            WRITE_DWORD_LE_A(dst_row, r | g | b);
-            src_row += 2;
-            dst_row += 4;
-        }
-        src_row += src_pitch;
-        dst_row += dst_pitch;
-    }
+    this->convert_frame(PixelConv::RGB565, this->active_width, dst_buf, dst_pitch);
 }
 
 // RGB888
 void VideoCtrlBase::convert_frame_24bpp(uint8_t *dst_buf, int dst_pitch)
 {
-    uint8_t *src_row, *dst_row;
-    int     src_pitch;
-
-    src_pitch = this->fb_pitch - 3 * this->active_width;
-    dst_pitch = dst_pitch - 4 * this->active_width;
-
-    src_row = this->fb_ptr;
-    dst_row = dst_buf;
-    for (int h = this->active_height; h > 0; h--) {
-        for (int x = this->active_width; x > 0; x--) {
-            uint32_t c = (src_row[0] << 16) | (src_row[1] << 8) | src_row[2];
-            WRITE_DWORD_LE_A(dst_row, c);
-            src_row += 3;
-            dst_row += 4;
-        }
-        src_row += src_pitch;
-        dst_row += dst_pitch;
-    }
+    this->convert_frame(PixelConv::RGB888, this->active_width, dst_buf, dst_pitch);
 }
 
 // ARGB8888
 void VideoCtrlBase::convert_frame_32bpp(uint8_t *dst_buf, int dst_pitch)
 {
-    uint32_t *src_row, *dst_row;
-    int     src_pitch;
-
-    src_pitch = this->fb_pitch - 4 * this->active_width;
-    dst_pitch = dst_pitch - 4 * this->active_width;
-
-    src_row = (uint32_t*)this->fb_ptr;
-    dst_row = (uint32_t*)dst_buf;
-    for (int h = this->active_height; h > 0; h--) {
-        for (int x = this->active_width; x > 0; x--) {
-            uint32_t c = READ_DWORD_LE_A(src_row);
-            WRITE_DWORD_LE_A(dst_row, c);
-            src_row++;
-            dst_row++;
-        }
-        src_row = (uint32_t*)((uint8_t*)src_row + src_pitch);
-        dst_row = (uint32_t*)((uint8_t*)dst_row + dst_pitch);
-    }
+    this->convert_frame(PixelConv::ARGB8888, this->active_width, dst_buf, dst_pitch);
 }
 
 // ARGB8888_BE
 void VideoCtrlBase::convert_frame_32bpp_BE(uint8_t *dst_buf, int dst_pitch)
 {
-    uint32_t *src_row, *dst_row;
-    int     src_pitch;
-
-    src_pitch = this->fb_pitch - 4 * this->active_width;
-    dst_pitch = dst_pitch - 4 * this->active_width;
-
-    src_row = (uint32_t*)this->fb_ptr;
-    dst_row = (uint32_t*)dst_buf;
-    for (int h = this->active_height; h > 0; h--) {
-        for (int x = this->active_width; x > 0; x--) {
-            uint32_t c = READ_DWORD_BE_A(src_row);
-            WRITE_DWORD_LE_A(dst_row, c);
-            src_row++;
-            dst_row++;
-        }
-        src_row = (uint32_t*)((uint8_t*)src_row + src_pitch);
-        dst_row = (uint32_t*)((uint8_t*)dst_row + dst_pitch);
-    }
+    this->convert_frame(PixelConv::ARGB8888_BE, this->active_width, dst_buf, dst_pitch);
 }
@@ -26,12 +26,18 @@ along with this program.  If not, see <https://www.gnu.org/licenses/>.
 
 #include <devices/common/hwinterrupt.h>
 #include <devices/video/display.h>
+#include <devices/video/framepipeline.h>
+#include <devices/video/pixelconv.h>
 
 #include <cinttypes>
 #include <functional>
+#include <memory>
 
 class WindowEvent;
 
+/** Upper limit for host display updates per second, 0 means no limit. */
+extern uint32_t max_present_fps;
+
 class VideoCtrlBase {
 public:
     VideoCtrlBase(int width = 640, int height = 480);
@@ -43,6 +49,8 @@ public:
     void update_screen(void);
 
     void start_refresh_task();
+    // derived controllers call it from their destructors before the framebuffer
+    // is freed since the host thread may still be converting from it
     void stop_refresh_task();
 
     void get_palette_color(uint8_t index, uint8_t& r, uint8_t& g, uint8_t& b,
@@ -59,9 +67,6 @@ public:
     virtual void convert_frame_2bpp_indexed(uint8_t *dst_buf, int dst_pitch);
     virtual void convert_frame_4bpp_indexed(uint8_t *dst_buf, int dst_pitch);
     virtual void convert_frame_8bpp_indexed(uint8_t *dst_buf, int dst_pitch);
-#if 0
-    virtual void convert_frame_8bpp_32LE_indexed(uint8_t *dst_buf, int dst_pitch);
-#endif
     virtual void convert_frame_8bpp(uint8_t *dst_buf, int dst_pitch);
     virtual void convert_frame_15bpp(uint8_t *dst_buf, int dst_pitch);
     virtual void convert_frame_15bpp_BE(uint8_t *dst_buf, int dst_pitch);
@@ -71,6 +76,12 @@ public:
     virtual void convert_frame_32bpp_BE(uint8_t *dst_buf, int dst_pitch);
 
 protected:
+    // host presentation is throttled independently of the guest refresh rate
+    bool present_due();
+
+    // convert the visible framebuffer area using the fastest available kernel
+    void convert_frame(PixelConv::Format fmt, int width, uint8_t *dst_buf, int dst_pitch);
+
     // CRT controller parameters
     bool        crtc_on = false;
     bool        blank_on = true;
@@ -110,10 +121,25 @@ protected:
     };
 
     std::function<void(uint8_t *dst_buf, int dst_pitch)> convert_fb_cb = nullptr;
-    std::function<void(uint8_t *dst_buf, int dst_pitch)> cursor_ovl_cb = nullptr;
+
+    // returns a snapshot of the software cursor, it's drawn over the frame
+    // later on the host thread
+    std::function<std::function<void(uint8_t *dst_buf, int dst_pitch)>()> cursor_ovl_cb = nullptr;
 
 private:
-    Display display;
+    Display         display;
+
+    // frame conversion happens on the host thread
+    FrameDesc       frame_desc = {};
+    bool            frame_captured = false;
+
+    // filled by converters that can't be described by a FrameDesc
+    std::unique_ptr<uint8_t[]> conv_buf;
+    int             conv_buf_width  = 0;
+    int             conv_buf_height = 0;
+
+    // host time at which the next frame may be presented
+    uint64_t        next_present_ns = 0;
 };
 
 #endif // VIDEO_CTRL_H
@@ -410,6 +410,11 @@ static const map<string, string> PropHelp = {
     {"fdd_wr_prot",     "toggles floppy disk's write protection"},
     {"hdd_img",         "specifies path(s) to hard disk image(s)"},
     {"hdd_img2",        "specifies path(s) to secondary hard disk image(s)"},
+    {"hdd_overlay",     "specifies copy-on-write overlay file(s) for hard disk image(s)"},
+    {"hdd_overlay2",    "specifies copy-on-write overlay file(s) for secondary hard disk image(s)"},
+    {"hdd_cache_size",  "specifies hard disk write cache size in MB, 0 disables caching"},
+    {"hdd_write_through", "toggles write-through of the hard disk cache, off enables write-back caching"},
+    {"hdd_flush_ms",    "specifies interval in ms for writing back cached disk data in write-back mode, 0 disables"},
     {"cdr_config",      "CD-ROM device path in [bus]:[device#] format"},
     {"cdr_img",         "specifies path(s) to CD-ROM image(s)"},
     {"cdr_img2",        "specifies path(s) to secondary CD-ROM image(s)"},
@@ -434,6 +439,9 @@ static const map<string, string> PropHelp = {
     {"vci_D",           "insert a VCI device 0x0D"},
     {"vci_E",           "insert a VCI device 0x0E"},
     {"serial_backend",  "specifies the backend for the serial port"},
+    {"net_backend",     "specifies the backend for the Ethernet controller"},
+    {"net_path",        "specifies the capture file or the shared memory file for net_backend"},
+    {"net_shm_side",    "specifies which side of the shared memory link this instance is"},
     {"emmo",            "enables/disables factory HW tests during startup"},
     {"cpu",             "specifies CPU"},
     {"adb_devices",     "specifies which ADB device(s) to attach"},
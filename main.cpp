@@ -27,11 +27,17 @@ along with this program.  If not, see <https://www.gnu.org/licenses/>.
 #include <cpu/ppc/ppcdisasm.h>
 #include <cpu/ppc/ppcemu.h>
 #include <cpu/ppc/ppcmmu.h>
+#include <cpu/ppc/ppcsampler.h>
+#include <cpu/ppc/ppctrace.h>
 #include <debugger/debugger.h>
 #include <devices/common/ofnvram.h>
+#include <devices/sound/soundserver.h>
+#include <devices/storage/diskioworker.h>
+#include <devices/video/videoctrl.h>
 #include <machines/machinebase.h>
 #include <machines/machinefactory.h>
 #include <utils/profiler.h>
+#include <utils/sparseimg.h>
 #include <main.h>
 
 #include <cinttypes>
@@ -132,6 +138,15 @@ int main(int argc, char** argv) {
         ->check(CLI::ExistingFile);
     app.add_flag("--deterministic", is_deterministic,
         "Make execution deterministic");
+    app.add_flag("--async-disk-io", async_disk_io,
+        "Perform disk I/O on worker threads (ignored in deterministic mode)");
+    app.add_flag("--headless", is_headless,
+        "Run without showing the display window");
+    app.add_option("--max-fps", max_present_fps,
+        "Limit host display updates per second, 0 = unlimited (default is 60)");
+    app.add_option("--audio-latency-ms", audio_latency_ms,
+        "Amount of sound output buffered ahead of the host (default is 40)")
+        ->check(CLI::Range(5, 1000));
 
     bool              log_to_stderr = false;
     loguru::Verbosity log_verbosity = loguru::Verbosity_INFO;
@@ -149,10 +164,49 @@ int main(int argc, char** argv) {
         ->take_all();
 
     uint32_t profiling_interval_ms = 0;
-#ifdef CPU_PROFILING
+    string   profile_json_path;
+    app.add_flag("--profile", profiling_enabled,
+        "Enable profiling counters from the start");
     app.add_option("--profiling-interval-ms", profiling_interval_ms,
         "Specifies periodic interval (in ms) at which to output CPU profiling information");
-#endif
+    app.add_option("--profile-json", profile_json_path,
+        "Write all profiles to the specified JSON file on exit");
+
+    string           trace_path;
+    uint32_t         trace_records = 4 * 1024 * 1024;
+    uint32_t         trace_start   = 0xFFFFFFFFUL;
+    uint32_t         trace_stop    = 0xFFFFFFFFUL;
+    uint64_t         trace_count   = UINT64_MAX;
+    std::vector<int> trace_gprs;
+    auto trace_opt = app.add_option("--trace", trace_path,
+        "Record executed instructions into the specified trace file");
+    app.add_option("--trace-records", trace_records,
+        "Size of the trace ring in 8-byte records (default is 4M)")
+        ->needs(trace_opt)->check(CLI::PositiveNumber);
+    app.add_option("--trace-start", trace_start,
+        "Start recording when this address is reached")->needs(trace_opt);
+    app.add_option("--trace-stop", trace_stop,
+        "Stop recording when this address is reached")->needs(trace_opt);
+    app.add_option("--trace-count", trace_count,
+        "Stop recording after this many instructions")->needs(trace_opt);
+    app.add_option("--trace-gprs", trace_gprs,
+        "Comma-separated list of GPRs whose changes are recorded")
+        ->needs(trace_opt)->delimiter(',')->check(CLI::Range(0, 31));
+
+    string           sample_path;
+    uint32_t         sample_interval_us = 1000;
+    int              sample_depth       = 32;
+    std::vector<string> sample_symbols;
+    auto sample_opt = app.add_option("--sample", sample_path,
+        "Sample guest call stacks and write them as folded stacks to the specified file");
+    app.add_option("--sample-interval-us", sample_interval_us,
+        "Sampling interval in microseconds of emulated time (default is 1000)")
+        ->needs(sample_opt)->check(CLI::PositiveNumber);
+    app.add_option("--sample-depth", sample_depth,
+        "Maximum number of stack frames to record per sample (default is 32)")
+        ->needs(sample_opt)->check(CLI::NonNegativeNumber);
+    app.add_option("--sample-symbols", sample_symbols,
+        "Symbol map(s) used for annotating samples")->check(CLI::ExistingFile);
 
     string       machine_str;
     CLI::Option* machine_opt = app.add_option("-m,--machine",
@@ -166,6 +220,27 @@ int main(int argc, char** argv) {
     list_cmd->add_option("machines", sub_arg, "List supported machines");
     list_cmd->add_option("properties", sub_arg, "List available properties");
 
+    auto mksparse_cmd = app.add_subcommand("mksparse",
+        "Convert a raw disk image into a sparse image and exit");
+
+    string raw_img_path, sparse_img_path;
+
+    mksparse_cmd->add_option("source", raw_img_path, "Raw disk image")
+        ->required()->check(CLI::ExistingFile);
+    mksparse_cmd->add_option("destination", sparse_img_path, "Sparse image to create")
+        ->required();
+
+    auto tracedump_cmd = app.add_subcommand("tracedump",
+        "Decode an execution trace file and exit");
+
+    string   trace_dump_path;
+    uint64_t trace_dump_count = UINT64_MAX;
+
+    tracedump_cmd->add_option("trace", trace_dump_path, "Trace file to decode")
+        ->required()->check(CLI::ExistingFile);
+    tracedump_cmd->add_option("-n,--count", trace_dump_count,
+        "Number of most recent records to show (default is all)");
+
     CLI11_PARSE(app, argc, argv);
 
     if (*list_cmd) {
@@ -179,6 +254,16 @@ int main(int argc, char** argv) {
         return 0;
     }
 
+    if (*mksparse_cmd) {
+        loguru::g_stderr_verbosity = loguru::Verbosity_INFO;
+        return SparseImage::convert_raw(raw_img_path, sparse_img_path) ? 0 : 1;
+    }
+
+    if (*tracedump_cmd) {
+        loguru::g_stderr_verbosity = loguru::Verbosity_INFO;
+        return ppc_trace_decode(trace_dump_path, trace_dump_count) ? 0 : 1;
+    }
+
     if (debugger_enabled) {
         execution_mode = debugger;
     }
@@ -280,30 +365,56 @@ int main(int argc, char** argv) {
 
     keyboard_id = kbd_map.at(keyboard_string);
 
-    while (true) {
-        run_machine(
-            machine_str,
-            &rom_data[0],
-            rom_size,
-            execution_mode,
-            env_vars,
-            profiling_interval_ms);
-        if (power_off_reason == po_restarting) {
-            LOG_F(INFO, "Restarting...");
-            power_on = true;
-            continue;
-        }
-        if (power_off_reason == po_shutting_down) {
-            if (execution_mode != debugger) {
-                LOG_F(INFO, "Shutdown.");
-                break;
+    if (!trace_path.empty()) {
+        uint32_t gpr_mask = 0;
+        for (int reg : trace_gprs)
+            gpr_mask |= 1U << reg;
+        if (!ppc_trace_open(trace_path, trace_records, gpr_mask, trace_start, trace_stop,
+                            trace_count))
+            return 1;
+    }
+
+    for (const auto& sym_path : sample_symbols)
+        ppc_sampler_load_symbols(sym_path);
+    if (!sample_path.empty())
+        ppc_sampler_configure(USECS_TO_NSECS(uint64_t(sample_interval_us)), sample_depth);
+
+    // the interpreter gets its own thread, the main thread stays with the
+    // host windowing layer (event pump and display presentation)
+    EventManager::get_instance()->run_host_loop(keyboard_id, [&]() {
+        while (true) {
+            run_machine(
+                machine_str,
+                &rom_data[0],
+                rom_size,
+                execution_mode,
+                env_vars,
+                profiling_interval_ms);
+            if (power_off_reason == po_restarting) {
+                LOG_F(INFO, "Restarting...");
+                power_on = true;
+                continue;
+            }
+            if (power_off_reason == po_shutting_down) {
+                if (execution_mode != debugger) {
+                    LOG_F(INFO, "Shutdown.");
+                    break;
+                }
+                LOG_F(INFO, "Shutdown...");
+                power_on = true;
+                continue;
             }
-            LOG_F(INFO, "Shutdown...");
-            power_on = true;
-            continue;
+            break;
         }
-        break;
-    }
+    });
+
+    ppc_trace_close();
+
+    if (!sample_path.empty())
+        ppc_sampler_write_folded(sample_path);
+
+    if (!profile_json_path.empty())
+        gProfilerObj->export_json(profile_json_path);
 
     cleanup();
 
@@ -314,10 +425,7 @@ void run_machine(std::string machine_str, char* rom_data,
     size_t rom_size,
     uint32_t execution_mode,
     const std::vector<std::string> &env_vars,
-    uint32_t
-#ifdef CPU_PROFILING
-     profiling_interval_ms
-#endif
+    uint32_t profiling_interval_ms
 ) {
     if (MachineFactory::create_machine_for_id(machine_str, rom_data, rom_size) < 0) {
         return;
@@ -363,17 +471,21 @@ void run_machine(std::string machine_str, char* rom_data,
     // set up system wide event polling using
     // default Macintosh polling rate of 11 ms
     uint32_t event_timer = TimerManager::get_instance()->add_cyclic_timer(MSECS_TO_NSECS(11), [] {
-        EventManager::get_instance()->poll_events(keyboard_id);
+        // host events are pumped on the main thread,
+        // only drain what it has queued so far
+        EventManager::get_instance()->dispatch_events();
     });
 
-#ifdef CPU_PROFILING
     uint32_t profiling_timer;
     if (profiling_interval_ms > 0) {
+        profiling_enabled = true;
         profiling_timer = TimerManager::get_instance()->add_cyclic_timer(MSECS_TO_NSECS(profiling_interval_ms), [] {
             gProfilerObj->print_profile("PPC_CPU");
         });
     }
-#endif
+
+    if (ppc_sampler_configured())
+        ppc_sampler_start();
 
     switch (execution_mode) {
     case interpreter:
@@ -395,14 +507,13 @@ void run_machine(std::string machine_str, char* rom_data,
 
     LOG_F(INFO, "Cleaning up...");
     TimerManager::get_instance()->cancel_timer(event_timer);
-#ifdef CPU_PROFILING
     if (profiling_interval_ms > 0) {
         TimerManager::get_instance()->cancel_timer(profiling_timer);
     }
-#endif
     if (is_deterministic) {
         TimerManager::get_instance()->cancel_timer(deterministic_timer);
     }
+    ppc_sampler_stop();
     EventManager::get_instance()->disconnect_handlers();
     delete gMachineObj.release();
 }
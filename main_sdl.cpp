@@ -22,6 +22,8 @@ along with this program.  If not, see <https://www.gnu.org/licenses/>.
 /** @file SDL-specific main functions. */
 
 #include <main.h>
+#include <devices/storage/diskioworker.h>
+#include <devices/video/framepipeline.h>
 #include <loguru.hpp>
 #include <SDL.h>
 
@@ -51,5 +53,7 @@ bool init() {
 }
 
 void cleanup() {
+    DiskIoWorker::shutdown();
+    FramePipeline::shutdown();
     SDL_Quit();
 }
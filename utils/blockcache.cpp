@@ -0,0 +1,213 @@
+/*
+DingusPPC - The Experimental PowerPC Macintosh emulator
+Copyright (C) 2018-25 divingkatae and maximum
+                      (theweirdo)     spatium
+
+(Contact divingkatae#1017 or powermax#2286 on Discord for more info)
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+/** @file LRU write-back block cache for disk images. */
+
+#include <utils/blockcache.h>
+#include <loguru.hpp>
+
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+// upper limit for a single coalesced write issued by flush()
+constexpr uint64_t MAX_FLUSH_RUN = 1 << 20;
+
+BlockCache::BlockCache(uint64_t disk_size, uint64_t cache_size, bool write_through,
+                       cache_read_cb read_fn, cache_write_cb write_fn,
+                       cache_sync_cb sync_fn)
+{
+    this->disk_size     = disk_size;
+    this->max_blocks    = std::max(cache_size / CACHE_BLOCK_SIZE, (uint64_t)1);
+    this->write_through = write_through;
+    this->read_fn       = read_fn;
+    this->write_fn      = write_fn;
+    this->sync_fn       = sync_fn;
+}
+
+uint64_t BlockCache::block_len(uint64_t blk) const {
+    return std::min((uint64_t)CACHE_BLOCK_SIZE, this->disk_size - blk * CACHE_BLOCK_SIZE);
+}
+
+BlockCache::CacheBlock* BlockCache::lookup(uint64_t blk) {
+    auto it = this->index.find(blk);
+    if (it == this->index.end())
+        return nullptr;
+
+    // move to the front of the LRU list
+    this->lru.splice(this->lru.begin(), this->lru, it->second);
+    return &this->lru.front();
+}
+
+BlockCache::CacheBlock* BlockCache::allocate(uint64_t blk) {
+    std::unique_ptr<char[]> data;
+
+    if (this->lru.size() >= this->max_blocks) {
+        // recycle the least recently used block
+        CacheBlock& victim = this->lru.back();
+        if (victim.dirty) {
+            this->write_back(victim.blk, victim.data.get(), this->block_len(victim.blk));
+            this->num_dirty--;
+        }
+        this->index.erase(victim.blk);
+        data = std::move(victim.data);
+        this->lru.pop_back();
+    } else {
+        data = std::unique_ptr<char[]>(new char[CACHE_BLOCK_SIZE]);
+    }
+
+    this->lru.push_front({blk, false, std::move(data)});
+    this->index[blk] = this->lru.begin();
+    return &this->lru.front();
+}
+
+void BlockCache::write_back(uint64_t blk, const char* data, uint64_t length) {
+    uint64_t offset = blk * CACHE_BLOCK_SIZE;
+
+    if (this->write_fn(data, offset, length) != length)
+        LOG_F(ERROR, "BlockCache: write back of %llu bytes at offset %llu failed",
+              (unsigned long long)length, (unsigned long long)offset);
+}
+
+uint64_t BlockCache::read(char* buf, uint64_t offset, uint64_t length) {
+    std::lock_guard<std::mutex> lk(this->cache_mtx);
+
+    if (offset >= this->disk_size)
+        return 0;
+
+    uint64_t end = std::min(offset + length, this->disk_size);
+    uint64_t pos = offset;
+
+    while (pos < end) {
+        uint64_t blk       = pos / CACHE_BLOCK_SIZE;
+        uint64_t blk_start = blk * CACHE_BLOCK_SIZE;
+        CacheBlock* cb     = this->lookup(blk);
+
+        if (cb) {
+            uint64_t count = std::min(end, blk_start + CACHE_BLOCK_SIZE) - pos;
+            std::memcpy(&buf[pos - offset], &cb->data[pos - blk_start], count);
+            pos += count;
+            continue;
+        }
+
+        // pass a run of uncached blocks through with a single read
+        uint64_t run_end = blk_start + CACHE_BLOCK_SIZE;
+        while (run_end < end && !this->index.count(run_end / CACHE_BLOCK_SIZE))
+            run_end += CACHE_BLOCK_SIZE;
+        run_end = std::min(run_end, end);
+
+        uint64_t count = run_end - pos;
+        uint64_t got   = this->read_fn(&buf[pos - offset], pos, count);
+        if (got < count)
+            std::memset(&buf[pos - offset + got], 0, count - got);
+
+        pos = run_end;
+    }
+
+    return end - offset;
+}
+
+uint64_t BlockCache::write(const char* buf, uint64_t offset, uint64_t length) {
+    std::lock_guard<std::mutex> lk(this->cache_mtx);
+
+    if (offset >= this->disk_size)
+        return 0;
+
+    uint64_t end = std::min(offset + length, this->disk_size);
+
+    for (uint64_t pos = offset; pos < end; ) {
+        uint64_t blk       = pos / CACHE_BLOCK_SIZE;
+        uint64_t blk_start = blk * CACHE_BLOCK_SIZE;
+        uint64_t blk_len   = this->block_len(blk);
+        uint64_t count     = std::min(end, blk_start + blk_len) - pos;
+        CacheBlock* cb     = this->lookup(blk);
+
+        if (!cb) {
+            cb = this->allocate(blk);
+            // partial block update requires the remaining data
+            if (count != blk_len) {
+                uint64_t got = this->read_fn(cb->data.get(), blk_start, blk_len);
+                if (got < blk_len)
+                    std::memset(&cb->data[got], 0, blk_len - got);
+            }
+        }
+
+        std::memcpy(&cb->data[pos - blk_start], &buf[pos - offset], count);
+
+        if (!this->write_through && !cb->dirty) {
+            cb->dirty = true;
+            this->num_dirty++;
+        }
+
+        pos += count;
+    }
+
+    if (this->write_through) {
+        if (this->write_fn(buf, offset, end - offset) != end - offset)
+            LOG_F(ERROR, "BlockCache: write through at offset %llu failed",
+                  (unsigned long long)offset);
+        this->sync_fn();
+    }
+
+    return end - offset;
+}
+
+void BlockCache::flush() {
+    std::lock_guard<std::mutex> lk(this->cache_mtx);
+
+    if (!this->num_dirty)
+        return;
+
+    std::vector<CacheBlock*> dirty_blocks;
+    dirty_blocks.reserve(this->num_dirty);
+    for (auto& cb : this->lru) {
+        if (cb.dirty)
+            dirty_blocks.push_back(&cb);
+    }
+
+    std::sort(dirty_blocks.begin(), dirty_blocks.end(),
+        [](const CacheBlock* a, const CacheBlock* b) { return a->blk < b->blk; });
+
+    // coalesce adjacent dirty blocks into larger host writes
+    std::vector<char> run_buf;
+    uint64_t          run_start = 0;
+
+    for (auto* cb : dirty_blocks) {
+        if (!run_buf.empty() && (cb->blk != run_start + run_buf.size() / CACHE_BLOCK_SIZE ||
+                                 run_buf.size() >= MAX_FLUSH_RUN)) {
+            this->write_back(run_start, run_buf.data(), run_buf.size());
+            run_buf.clear();
+        }
+        if (run_buf.empty())
+            run_start = cb->blk;
+
+        uint64_t len = this->block_len(cb->blk);
+        run_buf.insert(run_buf.end(), cb->data.get(), cb->data.get() + len);
+        cb->dirty = false;
+    }
+
+    if (!run_buf.empty())
+        this->write_back(run_start, run_buf.data(), run_buf.size());
+
+    this->num_dirty = 0;
+
+    this->sync_fn();
+}
@@ -0,0 +1,93 @@
+/*
+DingusPPC - The Experimental PowerPC Macintosh emulator
+Copyright (C) 2018-25 divingkatae and maximum
+                      (theweirdo)     spatium
+
+(Contact divingkatae#1017 or powermax#2286 on Discord for more info)
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+/** @file LRU write-back block cache for disk images.
+
+    Guest writes are collected in fixed-size cache blocks and only reach
+    the backing store when a block is evicted or when the cache is flushed
+    explicitly. Read misses are passed through to the backing store without
+    allocating cache blocks so that large sequential reads don't evict
+    dirty data. In write-through mode, every write is forwarded to the
+    backing store and synchronized immediately.
+
+    All methods are thread-safe; backing store callbacks are always
+    invoked with the cache lock held.
+ */
+
+#ifndef BLOCK_CACHE_H
+#define BLOCK_CACHE_H
+
+#include <cinttypes>
+#include <functional>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+
+constexpr uint32_t CACHE_BLOCK_SIZE = 4096;
+
+typedef std::function<uint64_t(char* buf, uint64_t offset, uint64_t length)> cache_read_cb;
+typedef std::function<uint64_t(const char* buf, uint64_t offset, uint64_t length)> cache_write_cb;
+typedef std::function<void()> cache_sync_cb;
+
+class BlockCache {
+public:
+    BlockCache(uint64_t disk_size, uint64_t cache_size, bool write_through,
+               cache_read_cb read_fn, cache_write_cb write_fn, cache_sync_cb sync_fn);
+    ~BlockCache() = default;
+
+    uint64_t read(char* buf, uint64_t offset, uint64_t length);
+    uint64_t write(const char* buf, uint64_t offset, uint64_t length);
+
+    // write all dirty blocks back and synchronize the backing store
+    void flush();
+
+    bool is_write_through() const { return this->write_through; }
+
+private:
+    struct CacheBlock {
+        uint64_t                blk;
+        bool                    dirty;
+        std::unique_ptr<char[]> data;
+    };
+
+    typedef std::list<CacheBlock>::iterator blk_iter;
+
+    uint64_t    block_len(uint64_t blk) const;
+    CacheBlock* lookup(uint64_t blk);
+    CacheBlock* allocate(uint64_t blk);
+    void        write_back(uint64_t blk, const char* data, uint64_t length);
+
+    std::mutex      cache_mtx;
+    uint64_t        disk_size;
+    uint64_t        max_blocks;
+    bool            write_through;
+    uint64_t        num_dirty = 0;
+
+    cache_read_cb   read_fn;
+    cache_write_cb  write_fn;
+    cache_sync_cb   sync_fn;
+
+    std::list<CacheBlock>                   lru; // most recently used first
+    std::unordered_map<uint64_t, blk_iter>  index;
+};
+
+#endif // BLOCK_CACHE_H
@@ -20,11 +20,30 @@ along with this program.  If not, see <https://www.gnu.org/licenses/>.
 */
 
 /** @file Image file abstraction for floppy, hard drive and CD-ROM images
- * (implemented on each platform). */
+ * (implemented on each platform).
+ *
+ * An image can optionally be opened through a copy-on-write overlay.
+ * The overlay is a sparse delta file with a block bitmap that receives all
+ * writes while the base image is opened read-only and can thus be shared
+ * between multiple emulator instances. Reads of untouched blocks are
+ * served by the base image.
+ *
+ * Sparse images (see sparseimg.h) are detected automatically and can be
+ * used everywhere a raw image is accepted.
+ *
+ * Writes can optionally be collected in a write-back block cache
+ * (see blockcache.h). Cached data is written to the image on flush(),
+ * when the cache runs full and when the image is closed.
+ *
+ * In deterministic mode, image files are memory-mapped read-only and
+ * never modified. Writes go to a private in-memory copy-on-write layer
+ * so that only the data the guest touches is loaded or copied.
+ */
 
 #ifndef IMGFILE_H
 #define IMGFILE_H
 
+#include <cinttypes>
 #include <cstddef>
 #include <memory>
 #include <string>
@@ -34,13 +53,18 @@ public:
     ImgFile();
     ~ImgFile();
 
-    bool open(const std::string& img_path);
+    bool open(const std::string& img_path, bool read_only = false);
+    bool open_overlay(const std::string& base_path, const std::string& overlay_path);
     void close();
 
     uint64_t size() const;
 
     uint64_t read(void* buf, uint64_t offset, uint64_t length) const;
     uint64_t write(const void* buf, uint64_t offset, uint64_t length);
+
+    // cache_size = 0 disables caching
+    void set_cache(uint64_t cache_size, bool write_through);
+    void flush();
 private:
     class Impl; // Holds private fields
     std::unique_ptr<Impl> impl;
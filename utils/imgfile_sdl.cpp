@@ -19,43 +19,562 @@ You should have received a copy of the GNU General Public License
 along with this program.  If not, see <https://www.gnu.org/licenses/>.
 */
 
+#include <utils/blockcache.h>
 #include <utils/imgfile.h>
+#include <utils/sparseimg.h>
 #include <loguru.hpp>
+#include <memaccess.h>
 
+#include <algorithm>
+#include <cstring>
 #include <fstream>
-#include <sstream>
 #include <memory>
+#include <streambuf>
+#include <unordered_map>
+#include <vector>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
 
 extern bool is_deterministic;
 
+/** Copy-on-write overlay file layout. */
+namespace Overlay {
+    constexpr char     MAGIC[8]    = {'D', 'P', 'P', 'C', 'O', 'V', 'L', '1'};
+    constexpr uint32_t VERSION     = 1;
+    constexpr uint32_t BLOCK_SIZE  = 4096;
+    constexpr uint64_t HDR_SIZE    = 512; // block bitmap follows the header
+
+    // header field offsets, all values are stored in little-endian format
+    enum : int {
+        HDR_MAGIC       = 0,
+        HDR_VERSION     = 8,
+        HDR_BLOCK_SIZE  = 12,
+        HDR_BASE_SIZE   = 16,
+        HDR_DATA_OFFSET = 24,
+    };
+};
+
+/** Read-only stream buffer backed by a memory-mapped file.
+    Pages are only brought in by the host OS when they are accessed.
+ */
+class MappedFileBuf : public std::streambuf {
+public:
+    MappedFileBuf() = default;
+    ~MappedFileBuf() {
+        if (!this->base)
+            return;
+#ifdef _WIN32
+        UnmapViewOfFile(this->base);
+#else
+        munmap(this->base, this->map_size);
+#endif
+    }
+
+    bool map(const std::string& path) {
+#ifdef _WIN32
+        HANDLE file_handle = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ,
+                                         nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL,
+                                         nullptr);
+        if (file_handle == INVALID_HANDLE_VALUE)
+            return false;
+
+        LARGE_INTEGER file_size;
+        HANDLE map_handle = nullptr;
+        if (GetFileSizeEx(file_handle, &file_size) && file_size.QuadPart > 0)
+            map_handle = CreateFileMappingA(file_handle, nullptr, PAGE_READONLY, 0, 0,
+                                            nullptr);
+        CloseHandle(file_handle);
+        if (!map_handle)
+            return false;
+
+        // the view keeps the mapping object alive
+        void* addr = MapViewOfFile(map_handle, FILE_MAP_READ, 0, 0, 0);
+        CloseHandle(map_handle);
+        if (!addr)
+            return false;
+
+        this->map_size = file_size.QuadPart;
+#else
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0)
+            return false;
+
+        struct stat st;
+        void* addr = MAP_FAILED;
+        if (!fstat(fd, &st) && st.st_size > 0)
+            addr = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        ::close(fd);
+        if (addr == MAP_FAILED)
+            return false;
+
+        this->map_size = st.st_size;
+#endif
+        this->base = (char *)addr;
+        this->setg(this->base, this->base, this->base + this->map_size);
+        return true;
+    }
+
+protected:
+    pos_type seekoff(off_type off, std::ios_base::seekdir dir,
+                     std::ios_base::openmode which) override {
+        if (which & std::ios_base::out)
+            return pos_type(off_type(-1));
+
+        off_type new_pos;
+        switch (dir) {
+        case std::ios_base::beg:
+            new_pos = off;
+            break;
+        case std::ios_base::cur:
+            new_pos = (this->gptr() - this->eback()) + off;
+            break;
+        default:
+            new_pos = off_type(this->map_size) + off;
+        }
+        if (new_pos < 0 || uint64_t(new_pos) > this->map_size)
+            return pos_type(off_type(-1));
+
+        this->setg(this->base, this->base + new_pos, this->base + this->map_size);
+        return pos_type(new_pos);
+    }
+
+    pos_type seekpos(pos_type pos, std::ios_base::openmode which) override {
+        return this->seekoff(off_type(pos), std::ios_base::beg, which);
+    }
+
+private:
+    char*       base     = nullptr;
+    uint64_t    map_size = 0;
+};
+
+class MappedStream : public std::iostream {
+public:
+    MappedStream() : std::iostream(nullptr) {};
+
+    bool map(const std::string& path) {
+        if (!this->buf.map(path))
+            return false;
+        this->rdbuf(&this->buf);
+        return true;
+    }
+
+private:
+    MappedFileBuf buf;
+};
+
+static std::unique_ptr<std::iostream> open_stream(const std::string& path, bool read_only)
+{
+    if (is_deterministic) {
+        // The underlying file is never written to, modified blocks
+        // are kept in memory by ImgFile::Impl::mem_write().
+        auto mapped_stream = std::make_unique<MappedStream>();
+        if (mapped_stream->map(path))
+            return mapped_stream;
+        read_only = true; // mapping is not possible, e.g. on 32-bit hosts
+    }
+
+    auto mode = read_only ? std::ios::in : std::ios::in | std::ios::out;
+    auto file_stream = std::make_unique<std::fstream>(path, mode | std::ios::binary);
+    if (!file_stream->is_open()) return nullptr;
+    return file_stream;
+}
+
 class ImgFile::Impl {
 public:
     std::unique_ptr<std::iostream> stream;
+    std::unique_ptr<SparseImage>   sparse; // set for sparse images
+    std::unique_ptr<BlockCache>    cache;  // set if write caching is enabled
+
+    // copy-on-write overlay state
+    std::unique_ptr<std::iostream> overlay;
+    std::vector<uint8_t>           block_map;
+    uint64_t                       base_size   = 0;
+    uint64_t                       data_offset = 0;
+    uint32_t                       block_size  = Overlay::BLOCK_SIZE;
+
+    // private in-memory copy-on-write layer used in deterministic mode
+    bool                           mem_cow  = false;
+    uint64_t                       mem_size = 0;
+    std::unordered_map<uint64_t, std::unique_ptr<char[]>> mem_blocks;
+
+    bool attach_overlay(const std::string& overlay_path);
+    bool create_overlay(const std::string& overlay_path);
+
+    bool block_present(uint64_t blk) const {
+        return !!(this->block_map[blk >> 3] & (1 << (blk & 7)));
+    }
+
+    uint64_t raw_read(std::iostream* s, void* buf, uint64_t offset, uint64_t length);
+    uint64_t base_read(void* buf, uint64_t offset, uint64_t length);
+    uint64_t overlay_read(char* buf, uint64_t offset, uint64_t length);
+    uint64_t overlay_write(const char* buf, uint64_t offset, uint64_t length);
+    uint64_t mem_read(char* buf, uint64_t offset, uint64_t length);
+    uint64_t mem_write(const char* buf, uint64_t offset, uint64_t length);
+
+    // access to the image files
+    uint64_t store_read(char* buf, uint64_t offset, uint64_t length);
+    uint64_t store_write(const char* buf, uint64_t offset, uint64_t length);
+
+    // image access bypassing the block cache
+    uint64_t direct_read(char* buf, uint64_t offset, uint64_t length);
+    uint64_t direct_write(const char* buf, uint64_t offset, uint64_t length);
+    void     sync();
 };
 
+uint64_t ImgFile::Impl::raw_read(std::iostream* s, void* buf, uint64_t offset,
+                                 uint64_t length)
+{
+    s->clear();
+    s->seekg(offset, std::ios::beg);
+    s->read((char *)buf, length);
+    return s->gcount();
+}
+
+uint64_t ImgFile::Impl::base_read(void* buf, uint64_t offset, uint64_t length)
+{
+    if (this->sparse)
+        return this->sparse->read((char *)buf, offset, length);
+    return this->raw_read(this->stream.get(), buf, offset, length);
+}
+
+bool ImgFile::Impl::create_overlay(const std::string& overlay_path)
+{
+    uint64_t num_blocks = (this->base_size + this->block_size - 1) / this->block_size;
+
+    this->block_map.assign((num_blocks + 7) >> 3, 0);
+    this->data_offset = ((Overlay::HDR_SIZE + this->block_map.size() + this->block_size - 1) /
+                         this->block_size) * this->block_size;
+
+    auto file_stream = std::make_unique<std::fstream>(overlay_path, std::ios::in |
+        std::ios::out | std::ios::trunc | std::ios::binary);
+    if (!file_stream->is_open()) {
+        LOG_F(ERROR, "ImgFile: could not create overlay %s", overlay_path.c_str());
+        return false;
+    }
+    this->overlay = std::move(file_stream);
+
+    char hdr[Overlay::HDR_SIZE] = {};
+    std::memcpy(&hdr[Overlay::HDR_MAGIC], Overlay::MAGIC, sizeof(Overlay::MAGIC));
+    WRITE_DWORD_LE_U(&hdr[Overlay::HDR_VERSION],     Overlay::VERSION);
+    WRITE_DWORD_LE_U(&hdr[Overlay::HDR_BLOCK_SIZE],  this->block_size);
+    WRITE_QWORD_LE_U(&hdr[Overlay::HDR_BASE_SIZE],   this->base_size);
+    WRITE_QWORD_LE_U(&hdr[Overlay::HDR_DATA_OFFSET], this->data_offset);
+
+    // the data area is left unallocated, it will be populated on demand
+    this->overlay->seekp(0, std::ios::beg);
+    this->overlay->write(hdr, sizeof(hdr));
+    this->overlay->write((const char *)this->block_map.data(), this->block_map.size());
+    this->overlay->flush();
+
+    LOG_F(INFO, "ImgFile: created overlay %s", overlay_path.c_str());
+
+    return this->overlay->good();
+}
+
+bool ImgFile::Impl::attach_overlay(const std::string& overlay_path)
+{
+    this->overlay = open_stream(overlay_path, false);
+    if (!this->overlay) {
+        // writes are kept in memory in deterministic mode, nothing to create
+        if (is_deterministic)
+            return true;
+        return this->create_overlay(overlay_path);
+    }
+
+    char hdr[Overlay::HDR_SIZE] = {};
+    if (this->raw_read(this->overlay.get(), hdr, 0, sizeof(hdr)) != sizeof(hdr) ||
+        std::memcmp(&hdr[Overlay::HDR_MAGIC], Overlay::MAGIC, sizeof(Overlay::MAGIC))) {
+        LOG_F(ERROR, "ImgFile: %s is not an overlay file", overlay_path.c_str());
+        return false;
+    }
+
+    if (READ_DWORD_LE_U(&hdr[Overlay::HDR_VERSION]) != Overlay::VERSION) {
+        LOG_F(ERROR, "ImgFile: unsupported overlay version %d",
+              READ_DWORD_LE_U(&hdr[Overlay::HDR_VERSION]));
+        return false;
+    }
+
+    if (READ_QWORD_LE_U(&hdr[Overlay::HDR_BASE_SIZE]) != this->base_size) {
+        LOG_F(ERROR, "ImgFile: overlay %s doesn't match the size of its base image",
+              overlay_path.c_str());
+        return false;
+    }
+
+    this->block_size  = READ_DWORD_LE_U(&hdr[Overlay::HDR_BLOCK_SIZE]);
+    this->data_offset = READ_QWORD_LE_U(&hdr[Overlay::HDR_DATA_OFFSET]);
+
+    if (!this->block_size) {
+        LOG_F(ERROR, "ImgFile: invalid overlay block size");
+        return false;
+    }
+
+    uint64_t num_blocks = (this->base_size + this->block_size - 1) / this->block_size;
+
+    this->block_map.resize((num_blocks + 7) >> 3);
+    if (this->raw_read(this->overlay.get(), this->block_map.data(), Overlay::HDR_SIZE,
+                       this->block_map.size()) != this->block_map.size()) {
+        LOG_F(ERROR, "ImgFile: overlay %s is truncated", overlay_path.c_str());
+        return false;
+    }
+
+    return true;
+}
+
+uint64_t ImgFile::Impl::overlay_read(char* buf, uint64_t offset, uint64_t length)
+{
+    if (offset >= this->base_size)
+        return 0;
+
+    uint64_t end = std::min(offset + length, this->base_size);
+    uint64_t pos = offset;
+
+    while (pos < end) {
+        uint64_t blk    = pos / this->block_size;
+        bool     in_ovl = this->block_present(blk);
+
+        // coalesce neighbour blocks living in the same file
+        uint64_t run_end = (blk + 1) * this->block_size;
+        while (run_end < end && this->block_present(run_end / this->block_size) == in_ovl)
+            run_end += this->block_size;
+        run_end = std::min(run_end, end);
+
+        uint64_t count = run_end - pos;
+        uint64_t got;
+
+        if (in_ovl)
+            got = this->raw_read(this->overlay.get(), &buf[pos - offset],
+                                 this->data_offset + pos, count);
+        else
+            got = this->base_read(&buf[pos - offset], pos, count);
+
+        if (got < count)
+            std::memset(&buf[pos - offset + got], 0, count - got);
+
+        pos = run_end;
+    }
+
+    return end - offset;
+}
+
+uint64_t ImgFile::Impl::overlay_write(const char* buf, uint64_t offset, uint64_t length)
+{
+    if (offset >= this->base_size)
+        return 0;
+
+    uint64_t end = std::min(offset + length, this->base_size);
+    uint64_t pos = offset;
+
+    std::unique_ptr<char[]> blk_buf;
+
+    while (pos < end) {
+        uint64_t blk       = pos / this->block_size;
+        uint64_t blk_start = blk * this->block_size;
+        uint64_t count     = std::min(end, blk_start + this->block_size) - pos;
+
+        if (!this->block_present(blk) && count != this->block_size) {
+            // partial write to a clean block: copy it from the base image first
+            if (!blk_buf)
+                blk_buf = std::unique_ptr<char[]>(new char[this->block_size]);
+            uint64_t blk_len = std::min((uint64_t)this->block_size,
+                                        this->base_size - blk_start);
+            uint64_t got = this->base_read(blk_buf.get(), blk_start, blk_len);
+            if (got < blk_len)
+                std::memset(&blk_buf[got], 0, blk_len - got);
+            std::memcpy(&blk_buf[pos - blk_start], &buf[pos - offset], count);
+            this->overlay->seekp(this->data_offset + blk_start, std::ios::beg);
+            this->overlay->write(blk_buf.get(), blk_len);
+        } else {
+            this->overlay->seekp(this->data_offset + pos, std::ios::beg);
+            this->overlay->write(&buf[pos - offset], count);
+        }
+
+        if (!this->block_present(blk)) {
+            // data must be in place before the block is marked as present
+            this->block_map[blk >> 3] |= 1 << (blk & 7);
+            this->overlay->seekp(Overlay::HDR_SIZE + (blk >> 3), std::ios::beg);
+            this->overlay->write((const char *)&this->block_map[blk >> 3], 1);
+        }
+
+        pos += count;
+    }
+
+    return end - offset;
+}
+
+uint64_t ImgFile::Impl::mem_read(char* buf, uint64_t offset, uint64_t length)
+{
+    if (offset >= this->mem_size)
+        return 0;
+
+    uint64_t end = std::min(offset + length, this->mem_size);
+    uint64_t pos = offset;
+
+    while (pos < end) {
+        uint64_t blk       = pos / Overlay::BLOCK_SIZE;
+        uint64_t blk_start = blk * Overlay::BLOCK_SIZE;
+
+        auto it = this->mem_blocks.find(blk);
+        if (it != this->mem_blocks.end()) {
+            uint64_t count = std::min(end, blk_start + Overlay::BLOCK_SIZE) - pos;
+            std::memcpy(&buf[pos - offset], &it->second[pos - blk_start], count);
+            pos += count;
+            continue;
+        }
+
+        // pass a run of unmodified blocks to the image with a single read
+        uint64_t run_end = blk_start + Overlay::BLOCK_SIZE;
+        while (run_end < end && !this->mem_blocks.count(run_end / Overlay::BLOCK_SIZE))
+            run_end += Overlay::BLOCK_SIZE;
+        run_end = std::min(run_end, end);
+
+        uint64_t count = run_end - pos;
+        uint64_t got   = this->store_read(&buf[pos - offset], pos, count);
+        if (got < count)
+            std::memset(&buf[pos - offset + got], 0, count - got);
+
+        pos = run_end;
+    }
+
+    return end - offset;
+}
+
+uint64_t ImgFile::Impl::mem_write(const char* buf, uint64_t offset, uint64_t length)
+{
+    if (offset >= this->mem_size)
+        return 0;
+
+    uint64_t end = std::min(offset + length, this->mem_size);
+
+    for (uint64_t pos = offset; pos < end; ) {
+        uint64_t blk       = pos / Overlay::BLOCK_SIZE;
+        uint64_t blk_start = blk * Overlay::BLOCK_SIZE;
+        uint64_t blk_len   = std::min((uint64_t)Overlay::BLOCK_SIZE, this->mem_size - blk_start);
+        uint64_t count     = std::min(end, blk_start + blk_len) - pos;
+
+        auto& data = this->mem_blocks[blk];
+        if (!data) {
+            data = std::unique_ptr<char[]>(new char[Overlay::BLOCK_SIZE]());
+            // partial write to an unmodified block: copy it from the image first
+            if (count != blk_len)
+                this->store_read(data.get(), blk_start, blk_len);
+        }
+
+        std::memcpy(&data[pos - blk_start], &buf[pos - offset], count);
+        pos += count;
+    }
+
+    return end - offset;
+}
+
+uint64_t ImgFile::Impl::store_read(char* buf, uint64_t offset, uint64_t length)
+{
+    if (this->overlay)
+        return this->overlay_read(buf, offset, length);
+    return this->base_read(buf, offset, length);
+}
+
+uint64_t ImgFile::Impl::direct_read(char* buf, uint64_t offset, uint64_t length)
+{
+    if (this->mem_cow)
+        return this->mem_read(buf, offset, length);
+    return this->store_read(buf, offset, length);
+}
+
+uint64_t ImgFile::Impl::direct_write(const char* buf, uint64_t offset, uint64_t length)
+{
+    if (this->mem_cow)
+        return this->mem_write(buf, offset, length);
+    return this->store_write(buf, offset, length);
+}
+
+uint64_t ImgFile::Impl::store_write(const char* buf, uint64_t offset, uint64_t length)
+{
+    if (this->overlay)
+        return this->overlay_write(buf, offset, length);
+    if (this->sparse)
+        return this->sparse->write(buf, offset, length);
+    this->stream->clear();
+    this->stream->seekp(offset, std::ios::beg);
+    this->stream->write(buf, length);
+    if (this->stream->fail()) {
+        LOG_F(ERROR, "ImgFile: write error at offset %llu", (unsigned long long)offset);
+        this->stream->clear();
+        return 0;
+    }
+    return length;
+}
+
+void ImgFile::Impl::sync()
+{
+    if (this->mem_cow)
+        return;
+
+    #if defined(WIN32) || defined(__APPLE__) || defined(__linux)
+        if (this->overlay)
+            this->overlay->flush();
+        else
+            this->stream->flush();
+    #endif
+}
+
 ImgFile::ImgFile(): impl(std::make_unique<Impl>())
 {
 
 }
 
-ImgFile::~ImgFile() = default;
+ImgFile::~ImgFile()
+{
+    if (impl->stream)
+        this->close();
+}
 
-bool ImgFile::open(const std::string &img_path)
+bool ImgFile::open(const std::string &img_path, bool read_only)
 {
+    impl->stream = open_stream(img_path, read_only);
+    if (!impl->stream || !impl->stream->good())
+        return false;
+
+    if (SparseImage::probe(impl->stream.get())) {
+        impl->sparse = std::make_unique<SparseImage>();
+        if (!impl->sparse->attach(impl->stream.get())) {
+            LOG_F(ERROR, "ImgFile: could not open sparse image %s", img_path.c_str());
+            this->close();
+            return false;
+        }
+    }
+
     if (is_deterministic) {
-        // Avoid writes to the underlying file by reading it all in memory and
-        // only operating on that.
-        auto mem_stream = std::make_unique<std::stringstream>();
-        std::ifstream temp(img_path, std::ios::in | std::ios::binary);
-        if (!temp) return false;
-        *mem_stream << temp.rdbuf();
-        impl->stream = std::move(mem_stream);
-    } else {
-        auto file_stream = std::make_unique<std::fstream>(img_path, std::ios::in | std::ios::out | std::ios::binary);
-        if (!file_stream->is_open()) return false;
-        impl->stream = std::move(file_stream);
+        impl->mem_cow  = true;
+        impl->mem_size = this->size();
     }
-    return impl->stream && impl->stream->good();
+
+    return true;
+}
+
+bool ImgFile::open_overlay(const std::string& base_path, const std::string& overlay_path)
+{
+    // base image is never written to when an overlay is in use
+    if (!this->open(base_path, true))
+        return false;
+
+    impl->base_size = this->size();
+
+    if (!impl->attach_overlay(overlay_path)) {
+        this->close();
+        return false;
+    }
+
+    return true;
 }
 
 void ImgFile::close()
@@ -64,7 +583,16 @@ void ImgFile::close()
         LOG_F(WARNING, "ImgFile::close before disk was opened, ignoring.");
         return;
     }
+    if (impl->cache) {
+        impl->cache->flush();
+        impl->cache.reset();
+    }
+    impl->sparse.reset();
     impl->stream.reset();
+    impl->overlay.reset();
+    impl->block_map.clear();
+    impl->mem_blocks.clear();
+    impl->mem_cow = false;
 }
 
 uint64_t ImgFile::size() const
@@ -73,6 +601,10 @@ uint64_t ImgFile::size() const
         LOG_F(WARNING, "ImgFile::size before disk was opened, ignoring.");
         return 0;
     }
+    if (impl->overlay)
+        return impl->base_size;
+    if (impl->sparse)
+        return impl->sparse->size();
     impl->stream->seekg(0, impl->stream->end);
     return impl->stream->tellg();
 }
@@ -83,9 +615,9 @@ uint64_t ImgFile::read(void* buf, uint64_t offset, uint64_t length) const
         LOG_F(WARNING, "ImgFile::read before disk was opened, ignoring.");
         return 0;
     }
-    impl->stream->seekg(offset, std::ios::beg);
-    impl->stream->read((char *)buf, length);
-    return impl->stream->gcount();
+    if (impl->cache)
+        return impl->cache->read((char *)buf, offset, length);
+    return impl->direct_read((char *)buf, offset, length);
 }
 
 uint64_t ImgFile::write(const void* buf, uint64_t offset, uint64_t length)
@@ -94,10 +626,43 @@ uint64_t ImgFile::write(const void* buf, uint64_t offset, uint64_t length)
         LOG_F(WARNING, "ImgFile::write before disk was opened, ignoring.");
         return 0;
     }
-    impl->stream->seekp(offset, std::ios::beg);
-    impl->stream->write((const char *)buf, length);
-    #if defined(WIN32) || defined(__APPLE__) || defined(__linux)
-        impl->stream->flush();
-    #endif
-    return uint64_t(impl->stream->tellp()) - offset;
+    if (impl->cache)
+        return impl->cache->write((const char *)buf, offset, length);
+    uint64_t written = impl->direct_write((const char *)buf, offset, length);
+    impl->sync();
+    return written;
+}
+
+void ImgFile::set_cache(uint64_t cache_size, bool write_through)
+{
+    if (!impl->stream) {
+        LOG_F(WARNING, "ImgFile::set_cache before disk was opened, ignoring.");
+        return;
+    }
+    if (impl->cache) {
+        impl->cache->flush();
+        impl->cache.reset();
+    }
+    if (!cache_size)
+        return;
+
+    Impl* p = impl.get();
+    impl->cache = std::make_unique<BlockCache>(this->size(), cache_size, write_through,
+        [p](char* buf, uint64_t offset, uint64_t length) {
+            return p->direct_read(buf, offset, length);
+        },
+        [p](const char* buf, uint64_t offset, uint64_t length) {
+            return p->direct_write(buf, offset, length);
+        },
+        [p]() { p->sync(); });
+}
+
+void ImgFile::flush()
+{
+    if (!impl->stream)
+        return;
+    if (impl->cache)
+        impl->cache->flush();
+    else
+        impl->sync();
 }
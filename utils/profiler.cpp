@@ -20,6 +20,8 @@ along with this program.  If not, see <https://www.gnu.org/licenses/>.
 */
 
 #include "profiler.h"
+#include <cstdio>
+#include <fstream>
 #include <iomanip>
 #include <iostream>
 #include <vector>
@@ -27,6 +29,9 @@ along with this program.  If not, see <https://www.gnu.org/licenses/>.
 /** global profiler object */
 std::unique_ptr<Profiler> gProfilerObj = 0;
 
+/** profiling counters are off unless explicitly requested */
+bool profiling_enabled = false;
+
 Profiler::Profiler()
 {
     this->profiles_map.clear();
@@ -103,3 +108,66 @@ void Profiler::reset_profile(std::string name)
 
     this->profiles_map.find(name)->second->reset();
 }
+
+void Profiler::list_profiles()
+{
+    for (auto& prof : this->profiles_map) {
+        std::cout << prof.first << std::endl;
+    }
+}
+
+static std::string json_escape(const std::string& str)
+{
+    std::string out;
+
+    for (char c : str) {
+        if (c == '"' || c == '\\') {
+            out += '\\';
+            out += c;
+        } else if (static_cast<unsigned char>(c) < 0x20) {
+            char buf[8];
+            snprintf(buf, sizeof(buf), "\\u%04x", c);
+            out += buf;
+        } else {
+            out += c;
+        }
+    }
+
+    return out;
+}
+
+void Profiler::export_json(std::ostream& out)
+{
+    out << "{" << std::endl;
+
+    for (auto prof_it = this->profiles_map.begin(); prof_it != this->profiles_map.end();) {
+        std::vector<ProfileVar> vars;
+
+        prof_it->second->populate_variables(vars);
+
+        out << "  \"" << json_escape(prof_it->first) << "\": {" << std::endl;
+        for (size_t i = 0; i < vars.size(); i++) {
+            out << "    \"" << json_escape(vars[i].name) << "\": " << std::dec
+                << vars[i].value << (i + 1 < vars.size() ? "," : "") << std::endl;
+        }
+
+        ++prof_it;
+        out << "  }" << (prof_it != this->profiles_map.end() ? "," : "") << std::endl;
+    }
+
+    out << "}" << std::endl;
+}
+
+bool Profiler::export_json(const std::string& path)
+{
+    std::ofstream out(path);
+    if (!out) {
+        std::cout << "Could not create " << path << std::endl;
+        return false;
+    }
+
+    // no thousands separators in JSON numbers
+    out.imbue(std::locale::classic());
+    this->export_json(out);
+    return true;
+}
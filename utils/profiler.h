@@ -28,9 +28,16 @@ along with this program.  If not, see <https://www.gnu.org/licenses/>.
 #include <cinttypes>
 #include <map>
 #include <memory>
+#include <ostream>
 #include <string>
 #include <vector>
 
+/** Runtime switch for the counters placed on hot emulation paths.
+    A disabled counter costs one well-predicted branch. */
+extern bool profiling_enabled;
+
+#define PROF_INC(cnt) do { if (profiling_enabled) [[unlikely]] (cnt)++; } while (0)
+
 enum class ProfileVarFmt { DEC, HEX, COUNT };
 
 /** Define a special data type for profile variables. */
@@ -69,6 +76,13 @@ public:
 
     void reset_profile(std::string name);
 
+    void list_profiles();
+
+    // write all profiles as a JSON object keyed by profile name
+    void export_json(std::ostream& out);
+
+    bool export_json(const std::string& path);
+
 private:
     std::map<std::string, std::unique_ptr<BaseProfile>> profiles_map;
 };
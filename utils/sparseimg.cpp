@@ -0,0 +1,336 @@
+/*
+DingusPPC - The Experimental PowerPC Macintosh emulator
+Copyright (C) 2018-25 divingkatae and maximum
+                      (theweirdo)     spatium
+
+(Contact divingkatae#1017 or powermax#2286 on Discord for more info)
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+/** @file Thin-provisioned sparse disk image format. */
+
+#include <utils/sparseimg.h>
+#include <loguru.hpp>
+#include <memaccess.h>
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <memory>
+
+namespace Sparse {
+    constexpr char     MAGIC[8] = {'D', 'P', 'P', 'C', 'S', 'P', 'R', '1'};
+    constexpr uint32_t VERSION  = 1;
+    constexpr uint64_t HDR_SIZE = 512; // BAT follows the header
+
+    // header field offsets, all values are stored in little-endian format
+    enum : int {
+        HDR_MAGIC       = 0,
+        HDR_VERSION     = 8,
+        HDR_BLOCK_SIZE  = 12,
+        HDR_DISK_SIZE   = 16,
+        HDR_BAT_OFFSET  = 24,
+        HDR_DATA_OFFSET = 32,
+    };
+};
+
+static bool is_zero_filled(const char* buf, uint64_t len)
+{
+    return !len || (!buf[0] && !std::memcmp(buf, buf + 1, len - 1));
+}
+
+bool SparseImage::probe(std::iostream* s)
+{
+    char magic[sizeof(Sparse::MAGIC)] = {};
+
+    s->clear();
+    s->seekg(0, std::ios::beg);
+    s->read(magic, sizeof(magic));
+    bool is_sparse = s->gcount() == sizeof(magic) &&
+                     !std::memcmp(magic, Sparse::MAGIC, sizeof(magic));
+    s->clear();
+
+    return is_sparse;
+}
+
+bool SparseImage::create(std::iostream* s, uint64_t disk_size, uint32_t block_size)
+{
+    uint64_t num_blocks  = (disk_size + block_size - 1) / block_size;
+    uint64_t data_offset = ((Sparse::HDR_SIZE + num_blocks * 4 + block_size - 1) /
+                            block_size) * block_size;
+
+    char hdr[Sparse::HDR_SIZE] = {};
+    std::memcpy(&hdr[Sparse::HDR_MAGIC], Sparse::MAGIC, sizeof(Sparse::MAGIC));
+    WRITE_DWORD_LE_U(&hdr[Sparse::HDR_VERSION],     Sparse::VERSION);
+    WRITE_DWORD_LE_U(&hdr[Sparse::HDR_BLOCK_SIZE],  block_size);
+    WRITE_QWORD_LE_U(&hdr[Sparse::HDR_DISK_SIZE],   disk_size);
+    WRITE_QWORD_LE_U(&hdr[Sparse::HDR_BAT_OFFSET],  Sparse::HDR_SIZE);
+    WRITE_QWORD_LE_U(&hdr[Sparse::HDR_DATA_OFFSET], data_offset);
+
+    s->seekp(0, std::ios::beg);
+    s->write(hdr, sizeof(hdr));
+
+    // empty BAT
+    std::vector<char> zeroes(std::min(num_blocks * 4, (uint64_t)block_size), 0);
+    for (uint64_t left = num_blocks * 4; left; ) {
+        uint64_t len = std::min(left, (uint64_t)zeroes.size());
+        s->write(zeroes.data(), len);
+        left -= len;
+    }
+
+    s->flush();
+
+    return s->good();
+}
+
+bool SparseImage::attach(std::iostream* s)
+{
+    char hdr[Sparse::HDR_SIZE] = {};
+
+    this->stream = s;
+
+    s->clear();
+    s->seekg(0, std::ios::beg);
+    s->read(hdr, sizeof(hdr));
+    if (s->gcount() != sizeof(hdr) ||
+        std::memcmp(&hdr[Sparse::HDR_MAGIC], Sparse::MAGIC, sizeof(Sparse::MAGIC))) {
+        LOG_F(ERROR, "SparseImage: invalid header");
+        return false;
+    }
+
+    if (READ_DWORD_LE_U(&hdr[Sparse::HDR_VERSION]) != Sparse::VERSION) {
+        LOG_F(ERROR, "SparseImage: unsupported version %d",
+              READ_DWORD_LE_U(&hdr[Sparse::HDR_VERSION]));
+        return false;
+    }
+
+    this->block_size  = READ_DWORD_LE_U(&hdr[Sparse::HDR_BLOCK_SIZE]);
+    this->disk_size   = READ_QWORD_LE_U(&hdr[Sparse::HDR_DISK_SIZE]);
+    this->bat_offset  = READ_QWORD_LE_U(&hdr[Sparse::HDR_BAT_OFFSET]);
+    this->data_offset = READ_QWORD_LE_U(&hdr[Sparse::HDR_DATA_OFFSET]);
+
+    if (!this->block_size) {
+        LOG_F(ERROR, "SparseImage: invalid block size");
+        return false;
+    }
+
+    uint64_t num_blocks = (this->disk_size + this->block_size - 1) / this->block_size;
+
+    std::vector<char> raw_bat(num_blocks * 4);
+    s->seekg(this->bat_offset, std::ios::beg);
+    s->read(raw_bat.data(), raw_bat.size());
+    if ((uint64_t)s->gcount() != raw_bat.size()) {
+        LOG_F(ERROR, "SparseImage: truncated block allocation table");
+        return false;
+    }
+
+    this->bat.resize(num_blocks);
+    this->next_pbn = 0;
+    for (uint64_t blk = 0; blk < num_blocks; blk++) {
+        this->bat[blk] = READ_DWORD_LE_U(&raw_bat[blk * 4]);
+        this->next_pbn = std::max(this->next_pbn, this->bat[blk]);
+    }
+
+    // collect holes left by released blocks
+    std::vector<bool> in_use(this->next_pbn, false);
+    for (auto ent : this->bat) {
+        if (ent)
+            in_use[ent - 1] = true;
+    }
+    this->free_pbns.clear();
+    for (uint32_t pbn = 0; pbn < this->next_pbn; pbn++) {
+        if (!in_use[pbn])
+            this->free_pbns.push_back(pbn);
+    }
+
+    this->blk_buf.resize(this->block_size);
+
+    return true;
+}
+
+uint32_t SparseImage::alloc_block()
+{
+    if (!this->free_pbns.empty()) {
+        uint32_t pbn = this->free_pbns.back();
+        this->free_pbns.pop_back();
+        return pbn;
+    }
+    return this->next_pbn++;
+}
+
+bool SparseImage::set_bat_entry(uint64_t blk, uint32_t val)
+{
+    char ent[4];
+
+    WRITE_DWORD_LE_U(ent, val);
+    this->stream->clear();
+    this->stream->seekp(this->bat_offset + blk * 4, std::ios::beg);
+    this->stream->write(ent, sizeof(ent));
+    if (!this->stream->good())
+        return false;
+
+    this->bat[blk] = val;
+    return true;
+}
+
+// Pads the file with zeroes up to new_end so that a new block never leaves
+// a gap behind the current end, e.g. before the aligned data area.
+void SparseImage::extend_to(uint64_t new_end)
+{
+    this->stream->clear();
+    this->stream->seekp(0, std::ios::end);
+    uint64_t cur_end = this->stream->tellp();
+
+    std::memset(this->blk_buf.data(), 0, this->block_size);
+    while (cur_end < new_end) {
+        uint64_t len = std::min(new_end - cur_end, (uint64_t)this->block_size);
+        this->stream->write(this->blk_buf.data(), len);
+        cur_end += len;
+    }
+}
+
+uint64_t SparseImage::read(char* buf, uint64_t offset, uint64_t length)
+{
+    if (offset >= this->disk_size)
+        return 0;
+
+    uint64_t end = std::min(offset + length, this->disk_size);
+
+    for (uint64_t pos = offset; pos < end; ) {
+        uint64_t blk       = pos / this->block_size;
+        uint64_t blk_start = blk * this->block_size;
+        uint64_t count     = std::min(end, blk_start + this->block_size) - pos;
+        char*    dst       = &buf[pos - offset];
+
+        if (!this->bat[blk]) {
+            std::memset(dst, 0, count); // no host I/O for unallocated blocks
+        } else {
+            this->stream->clear();
+            this->stream->seekg(this->data_offset + uint64_t(this->bat[blk] - 1) *
+                                this->block_size + (pos - blk_start), std::ios::beg);
+            this->stream->read(dst, count);
+            uint64_t got = this->stream->gcount();
+            if (got < count)
+                std::memset(&dst[got], 0, count - got);
+        }
+
+        pos += count;
+    }
+
+    return end - offset;
+}
+
+uint64_t SparseImage::write(const char* buf, uint64_t offset, uint64_t length)
+{
+    if (offset >= this->disk_size)
+        return 0;
+
+    uint64_t end = std::min(offset + length, this->disk_size);
+    uint64_t pos;
+
+    for (pos = offset; pos < end; ) {
+        uint64_t    blk       = pos / this->block_size;
+        uint64_t    blk_start = blk * this->block_size;
+        uint64_t    count     = std::min(end, blk_start + this->block_size) - pos;
+        const char* src       = &buf[pos - offset];
+        bool        is_zero   = is_zero_filled(src, count);
+
+        if (!this->bat[blk]) {
+            if (!is_zero) {
+                uint32_t pbn     = this->alloc_block();
+                uint64_t blk_pos = this->data_offset + uint64_t(pbn) * this->block_size;
+                this->extend_to(blk_pos); // clobbers blk_buf
+                const char* blk_data = src;
+                if (count != this->block_size) {
+                    std::memset(this->blk_buf.data(), 0, this->block_size);
+                    std::memcpy(&this->blk_buf[pos - blk_start], src, count);
+                    blk_data = this->blk_buf.data();
+                }
+                this->stream->seekp(blk_pos, std::ios::beg);
+                this->stream->write(blk_data, this->block_size);
+                // data must be in place before the block becomes visible
+                if (!this->stream->good() || !this->set_bat_entry(blk, pbn + 1)) {
+                    this->free_pbns.push_back(pbn);
+                    break;
+                }
+            }
+        } else if (is_zero && count == this->block_size) {
+            uint32_t pbn = this->bat[blk] - 1;
+            if (!this->set_bat_entry(blk, 0))
+                break;
+            this->free_pbns.push_back(pbn);
+        } else {
+            this->stream->clear();
+            this->stream->seekp(this->data_offset + uint64_t(this->bat[blk] - 1) *
+                                this->block_size + (pos - blk_start), std::ios::beg);
+            this->stream->write(src, count);
+            if (!this->stream->good())
+                break;
+        }
+
+        pos += count;
+    }
+
+    if (pos < end)
+        LOG_F(ERROR, "SparseImage: write error at offset %llu", (unsigned long long)pos);
+
+    return pos - offset;
+}
+
+bool SparseImage::convert_raw(const std::string& raw_path, const std::string& sparse_path)
+{
+    std::ifstream raw_file(raw_path, std::ios::in | std::ios::binary);
+    if (!raw_file) {
+        LOG_F(ERROR, "SparseImage: could not open %s", raw_path.c_str());
+        return false;
+    }
+
+    raw_file.seekg(0, std::ios::end);
+    uint64_t disk_size = raw_file.tellg();
+    raw_file.seekg(0, std::ios::beg);
+
+    std::fstream sparse_file(sparse_path, std::ios::in | std::ios::out |
+                             std::ios::trunc | std::ios::binary);
+    if (!sparse_file.is_open()) {
+        LOG_F(ERROR, "SparseImage: could not create %s", sparse_path.c_str());
+        return false;
+    }
+
+    SparseImage img;
+
+    if (!create(&sparse_file, disk_size) || !img.attach(&sparse_file))
+        return false;
+
+    auto buf = std::unique_ptr<char[]>(new char[SPARSE_BLOCK_SIZE]);
+
+    for (uint64_t pos = 0; pos < disk_size; pos += SPARSE_BLOCK_SIZE) {
+        uint64_t len = std::min((uint64_t)SPARSE_BLOCK_SIZE, disk_size - pos);
+        raw_file.read(buf.get(), len);
+        if ((uint64_t)raw_file.gcount() != len) {
+            LOG_F(ERROR, "SparseImage: error reading %s", raw_path.c_str());
+            return false;
+        }
+        // zero-filled blocks are skipped by SparseImage::write()
+        if (img.write(buf.get(), pos, len) != len) {
+            LOG_F(ERROR, "SparseImage: error writing %s", sparse_path.c_str());
+            return false;
+        }
+    }
+
+    LOG_F(INFO, "SparseImage: %s converted, %u of %llu blocks allocated",
+          sparse_path.c_str(), img.next_pbn, (unsigned long long)img.bat.size());
+
+    return sparse_file.good();
+}
@@ -0,0 +1,82 @@
+/*
+DingusPPC - The Experimental PowerPC Macintosh emulator
+Copyright (C) 2018-25 divingkatae and maximum
+                      (theweirdo)     spatium
+
+(Contact divingkatae#1017 or powermax#2286 on Discord for more info)
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+/** @file Thin-provisioned sparse disk image format.
+
+    A sparse image consists of a header, a block allocation table (BAT)
+    and a data area. The BAT maps every virtual block of the emulated disk
+    to a physical block in the data area. Unallocated blocks read back as
+    zeroes without touching the host file. Writes of zero-filled data
+    don't allocate new blocks and release already allocated ones when
+    they cover a whole block.
+ */
+
+#ifndef SPARSE_IMG_H
+#define SPARSE_IMG_H
+
+#include <cinttypes>
+#include <iostream>
+#include <string>
+#include <vector>
+
+constexpr uint32_t SPARSE_BLOCK_SIZE = 65536;
+
+class SparseImage {
+public:
+    SparseImage()  = default;
+    ~SparseImage() = default;
+
+    // check if the stream contains a sparse image
+    static bool probe(std::iostream* s);
+
+    // write an empty sparse image for a disk of the given size
+    static bool create(std::iostream* s, uint64_t disk_size,
+                       uint32_t block_size = SPARSE_BLOCK_SIZE);
+
+    // convert a raw image into a sparse one, skipping zero-filled blocks
+    static bool convert_raw(const std::string& raw_path, const std::string& sparse_path);
+
+    bool attach(std::iostream* s);
+
+    uint64_t size() const { return this->disk_size; }
+
+    uint64_t read(char* buf, uint64_t offset, uint64_t length);
+    // returns the number of bytes written before the first host I/O error,
+    // the caller is responsible for flushing the stream
+    uint64_t write(const char* buf, uint64_t offset, uint64_t length);
+
+private:
+    uint32_t alloc_block();
+    bool     set_bat_entry(uint64_t blk, uint32_t val);
+    void     extend_to(uint64_t new_end);
+
+    std::iostream*          stream      = nullptr;
+    uint64_t                disk_size   = 0;
+    uint64_t                bat_offset  = 0;
+    uint64_t                data_offset = 0;
+    uint32_t                block_size  = SPARSE_BLOCK_SIZE;
+    uint32_t                next_pbn    = 0; // first never used physical block
+    std::vector<uint32_t>   bat;             // 0 = unallocated, else physical block + 1
+    std::vector<uint32_t>   free_pbns;       // released physical blocks
+    std::vector<char>       blk_buf;
+};
+
+#endif // SPARSE_IMG_H
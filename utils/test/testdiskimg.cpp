@@ -0,0 +1,242 @@
+/*
+DingusPPC - The Experimental PowerPC Macintosh emulator
+Copyright (C) 2018-25 divingkatae and maximum
+                      (theweirdo)     spatium
+
+(Contact divingkatae#1017 or powermax#2286 on Discord for more info)
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+/** @file Round-trip tests for sparse, overlay and cached disk images. */
+
+#include <utils/imgfile.h>
+#include <utils/sparseimg.h>
+
+#include <cinttypes>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace std;
+namespace fs = std::filesystem;
+
+bool is_deterministic = false;
+
+constexpr uint64_t DISK_SIZE = 1 << 20;
+
+static int ntested = 0;
+static int nfailed = 0;
+
+static mt19937 rng(0x1234);
+
+static void check(bool cond, const string& what) {
+    ntested++;
+    if (!cond) {
+        cout << "Failed: " << what << endl;
+        nfailed++;
+    }
+}
+
+static vector<char> random_data(size_t len) {
+    vector<char> data(len);
+    for (auto& b : data)
+        b = (char)rng();
+    return data;
+}
+
+static void create_raw(const string& path, const vector<char>& contents) {
+    ofstream f(path, ios::out | ios::trunc | ios::binary);
+    f.write(contents.data(), contents.size());
+}
+
+static bool read_back(ImgFile& img, const vector<char>& ref) {
+    vector<char> buf(ref.size());
+    return img.read(buf.data(), 0, buf.size()) == buf.size() && buf == ref;
+}
+
+// writes that start and end inside blocks, span blocks and cover whole ones
+static void write_pattern(ImgFile& img, vector<char>& ref) {
+    const uint64_t offsets[] = {0, 1000, SPARSE_BLOCK_SIZE - 100, 5 * SPARSE_BLOCK_SIZE,
+                                DISK_SIZE - 700};
+    const uint64_t lengths[] = {512, 3000, 200, SPARSE_BLOCK_SIZE, 700};
+
+    for (int i = 0; i < 5; i++) {
+        auto data = random_data(lengths[i]);
+        check(img.write(data.data(), offsets[i], data.size()) == data.size(),
+              "write at " + to_string(offsets[i]));
+        memcpy(&ref[offsets[i]], data.data(), data.size());
+    }
+}
+
+static void test_sparse(const string& dir) {
+    string raw_path    = dir + "/raw.img";
+    string sparse_path = dir + "/sparse.img";
+
+    vector<char> ref(DISK_SIZE, 0);
+    auto head = random_data(SPARSE_BLOCK_SIZE / 2);
+    memcpy(ref.data(), head.data(), head.size());
+    create_raw(raw_path, ref);
+
+    check(SparseImage::convert_raw(raw_path, sparse_path), "sparse: convert");
+    check(fs::file_size(sparse_path) < DISK_SIZE / 2, "sparse: zero blocks skipped");
+
+    {
+        ImgFile img;
+        check(img.open(sparse_path), "sparse: open");
+        check(img.size() == DISK_SIZE, "sparse: size");
+        check(read_back(img, ref), "sparse: converted data");
+        write_pattern(img, ref);
+        check(read_back(img, ref), "sparse: read back");
+    }
+
+    uint64_t file_size = fs::file_size(sparse_path);
+
+    // a short read from a truncated file mustn't break later writes
+    fs::resize_file(sparse_path, file_size - 16);
+    {
+        ImgFile img;
+        check(img.open(sparse_path), "sparse: open truncated");
+        vector<char> buf(DISK_SIZE);
+        img.read(buf.data(), 0, buf.size());
+        auto data = random_data(100);
+        check(img.write(data.data(), 1000, data.size()) == data.size(),
+              "sparse: write after short read");
+        check(img.read(buf.data(), 1000, data.size()) == data.size() &&
+              !memcmp(buf.data(), data.data(), data.size()), "sparse: read after short read");
+        memcpy(&ref[1000], data.data(), data.size());
+    }
+    fs::resize_file(sparse_path, file_size);
+
+    // restore the bytes lost to the truncation
+    {
+        ImgFile img;
+        check(img.open(sparse_path), "sparse: open restored");
+        img.write(ref.data(), 0, ref.size());
+    }
+
+    {
+        ImgFile img;
+        check(img.open(sparse_path), "sparse: reopen");
+        check(read_back(img, ref), "sparse: data after reopen");
+
+        // zeroing a whole block releases it, the next new block reuses it
+        vector<char> zeroes(SPARSE_BLOCK_SIZE, 0);
+        img.write(zeroes.data(), 5 * SPARSE_BLOCK_SIZE, zeroes.size());
+        memset(&ref[5 * SPARSE_BLOCK_SIZE], 0, SPARSE_BLOCK_SIZE);
+        auto data = random_data(SPARSE_BLOCK_SIZE);
+        img.write(data.data(), 12 * SPARSE_BLOCK_SIZE, data.size());
+        memcpy(&ref[12 * SPARSE_BLOCK_SIZE], data.data(), data.size());
+        check(read_back(img, ref), "sparse: read back after free");
+    }
+
+    check(fs::file_size(sparse_path) == file_size, "sparse: freed block reused");
+
+    {
+        ImgFile img;
+        check(img.open(sparse_path), "sparse: reopen after free");
+        check(read_back(img, ref), "sparse: data after free and reopen");
+    }
+
+    // deterministic mode keeps all writes in memory
+    is_deterministic = true;
+    {
+        ImgFile img;
+        check(img.open(sparse_path), "sparse: open in deterministic mode");
+        vector<char> mem_ref = ref;
+        write_pattern(img, mem_ref);
+        check(read_back(img, mem_ref), "sparse: deterministic read back");
+    }
+    is_deterministic = false;
+
+    {
+        ImgFile img;
+        check(img.open(sparse_path), "sparse: reopen after deterministic run");
+        check(read_back(img, ref), "sparse: file untouched in deterministic mode");
+    }
+}
+
+static void test_overlay(const string& dir) {
+    string base_path    = dir + "/base.img";
+    string overlay_path = dir + "/base.ovl";
+
+    auto base = random_data(DISK_SIZE);
+    create_raw(base_path, base);
+
+    vector<char> ref = base;
+
+    {
+        ImgFile img;
+        check(img.open_overlay(base_path, overlay_path), "overlay: create");
+        check(read_back(img, ref), "overlay: base data");
+        write_pattern(img, ref);
+        check(read_back(img, ref), "overlay: read back");
+    }
+
+    {
+        ImgFile img;
+        check(img.open_overlay(base_path, overlay_path), "overlay: reopen");
+        check(read_back(img, ref), "overlay: data after reopen");
+    }
+
+    {
+        ImgFile img;
+        check(img.open(base_path, true), "overlay: open base");
+        check(read_back(img, base), "overlay: base untouched");
+    }
+}
+
+static void test_cache(const string& dir, bool write_through) {
+    string path = dir + "/cached.img";
+    string name = write_through ? "write-through cache: " : "write-back cache: ";
+
+    vector<char> ref(DISK_SIZE, 0);
+    create_raw(path, ref);
+
+    {
+        ImgFile img;
+        check(img.open(path), name + "open");
+        img.set_cache(256 << 10, write_through);
+        write_pattern(img, ref);
+        check(read_back(img, ref), name + "read back");
+        img.flush();
+        write_pattern(img, ref);
+    }
+
+    {
+        ImgFile img;
+        check(img.open(path), name + "reopen");
+        check(read_back(img, ref), name + "data after reopen");
+    }
+}
+
+int main(int argc, char** argv) {
+    fs::path dir = fs::temp_directory_path() / ("testdiskimg-" + to_string(rng()));
+    fs::create_directories(dir);
+
+    test_sparse(dir.string());
+    test_overlay(dir.string());
+    test_cache(dir.string(), false);
+    test_cache(dir.string(), true);
+
+    fs::remove_all(dir);
+
+    cout << "Tested disk image checks: " << ntested << ", failed: " << nfailed << endl;
+
+    return nfailed ? 1 : 0;
+}